@@ -0,0 +1,57 @@
+#ifndef ARCH_CACHE_H
+#define ARCH_CACHE_H
+#include <types.h>
+#include <stddef.h>
+
+/**
+ * arch_dcache_clean_range
+ * 
+ * writes back dirty inner data cache lines within a virtual range
+ * to the point of coherency.
+ * 
+ * @start	virtual start address
+ * @size	size (in bytes) of range
+ **/
+extern void arch_dcache_clean_range(addr_t start, size_t size);
+
+/**
+ * arch_dcache_inval_range
+ * 
+ * discards inner data cache lines within a virtual range.
+ * lines only partially covered by the range must be written back
+ * rather than discarded.
+ * 
+ * @start	virtual start address
+ * @size	size (in bytes) of range
+ **/
+extern void arch_dcache_inval_range(addr_t start, size_t size);
+
+/**
+ * arch_dcache_clean_inval_range
+ * 
+ * writes back & discards inner data cache lines within a virtual range.
+ * 
+ * @start	virtual start address
+ * @size	size (in bytes) of range
+ **/
+extern void arch_dcache_clean_inval_range(addr_t start, size_t size);
+
+/**
+ * arch_icache_sync_range
+ * 
+ * makes instructions written within a virtual range visible
+ * to instruction fetch.
+ * 
+ * @start	virtual start address
+ * @size	size (in bytes) of range
+ **/
+extern void arch_icache_sync_range(addr_t start, size_t size);
+
+/**
+ * arch_dcache_flush_all
+ * 
+ * writes back & discards every inner data cache line of the calling cpu.
+ **/
+extern void arch_dcache_flush_all(void);
+
+#endif
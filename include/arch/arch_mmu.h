@@ -75,6 +75,37 @@ extern int arch_mmu_create_new_entry(addr_t pg_base, struct mmu_entry *entry);
  **/
 extern void arch_mmu_invalidate(void);
 
+/**
+ * arch_mmu_invalidate_page
+ * 
+ * invalidates the calling cpu's tlb entries (including any cached
+ * page walk entries) for the page containing virt_addr.
+ * 
+ * @virt_addr	virtual address within the page
+ **/
+extern void arch_mmu_invalidate_page(addr_t virt_addr);
+
+/**
+ * arch_mmu_invalidate_bcast
+ * 
+ * invalidates the tlb of every cpu sharing the calling cpu's
+ * translation tables without interrupting them.
+ * on uniprocessor systems this is equivalent to arch_mmu_invalidate.
+ **/
+extern void arch_mmu_invalidate_bcast(void);
+
+/**
+ * arch_mmu_invalidate_page_bcast
+ * 
+ * invalidates the tlb entries for the page containing virt_addr on
+ * every cpu sharing the calling cpu's translation tables without
+ * interrupting them.
+ * on uniprocessor systems this is equivalent to arch_mmu_invalidate_page.
+ * 
+ * @virt_addr	virtual address within the page
+ **/
+extern void arch_mmu_invalidate_page_bcast(addr_t virt_addr);
+
 /**
  * arch_mmu_get_pgtb_reg_sz
  * 
@@ -109,6 +140,79 @@ extern size_t arch_mmu_get_kern_pgtb_reg_sz(void);
  **/
 extern unsigned int arch_mmu_get_pgtb_alignment(void);
 
+/**
+ * arch_mmu_get_pgtb_sz
+ * 
+ * returns the size (in bytes) of a single page table,
+ * i.e., the table referenced by one page directory entry.
+ * 
+ * @return size (in bytes) of page table
+ **/
+extern size_t arch_mmu_get_pgtb_sz(void);
+
+/**
+ * arch_mmu_get_pgtb_entry_cnt
+ * 
+ * returns the number of entries (pages) within a single page table
+ * 
+ * @return entries per page table
+ **/
+extern size_t arch_mmu_get_pgtb_entry_cnt(void);
+
+/**
+ * arch_mmu_pgtb_get_phy
+ * 
+ * returns the physical page mapped by an entry of a page table
+ * 
+ * @pgtb_addr	physical address of page table
+ * @idx		entry index (< arch_mmu_get_pgtb_entry_cnt())
+ * @return physical address of page or 0x0 if the entry is invalid
+ **/
+extern addr_t arch_mmu_pgtb_get_phy(addr_t pgtb_addr, unsigned int idx);
+
+/**
+ * arch_mmu_pgtb_wrprotect
+ * 
+ * makes every user writable (USER) entry of a page table read only
+ * (KERN_USER).  it is the responsibility of caller to invalidate tlbs.
+ * 
+ * @pgtb_addr	physical address of page table
+ **/
+extern void arch_mmu_pgtb_wrprotect(addr_t pgtb_addr);
+
+/**
+ * arch_mmu_get_pgtb
+ * 
+ * returns the page table mapping a virtual address within
+ * the active page directories.
+ * 
+ * @virt_addr	virtual address
+ * @return physical address of page table or 0x0 if none
+ **/
+extern addr_t arch_mmu_get_pgtb(addr_t virt_addr);
+
+/**
+ * arch_mmu_pgd_get_pgtb
+ * 
+ * returns the page table mapping a virtual address within a
+ * (not necessarily active) page directory.
+ * 
+ * @pgd_addr	physical address of page directory
+ * @virt_addr	virtual address
+ * @return physical address of page table or 0x0 if none
+ **/
+extern addr_t arch_mmu_pgd_get_pgtb(addr_t pgd_addr, addr_t virt_addr);
+
+/**
+ * arch_mmu_pgtb_is_empty
+ * 
+ * determines if a page table contains no valid entries
+ * 
+ * @pgtb_addr	physical address of page table
+ * @return true if empty
+ **/
+extern bool arch_mmu_pgtb_is_empty(addr_t pgtb_addr);
+
 /**
  * arch_mmu_get_user_pgd_sz
  * 
@@ -142,6 +246,18 @@ extern bool arch_mmu_user_pgd_requires_alignment(void);
  **/
 extern unsigned int arch_mmu_get_user_pgd_alignment(void);
 
+#if defined(CONFIG_VM_SPLIT) && !defined(CONFIG_VM_SPLIT_GENERIC)
+/**
+ * arch_mmu_get_kern_vaddr
+ * 
+ * returns the beginning of the kernel virtual address space,
+ * fixed at build time (see CONFIG_VM_SPLIT).
+ * @return base of kernel virtual address space.
+ **/
+inline addr_t arch_mmu_get_kern_vaddr(void) {
+    return (addr_t)CONFIG_VM_SPLIT;
+}
+#else
 /**
  * arch_mmu_get_kern_vaddr
  * 
@@ -149,5 +265,16 @@ extern unsigned int arch_mmu_get_user_pgd_alignment(void);
  * @return base of kernel virtual address space.
  **/
 extern addr_t arch_mmu_get_kern_vaddr(void);
+#endif
+
+#ifdef CONFIG_MMU_DUMP
+/**
+ * arch_mmu_dump
+ * 
+ * prints the active translation tables as merged ranges, along
+ * with a binary export of them for host analysis (see tools/ptdump.py).
+ **/
+extern void arch_mmu_dump(void);
+#endif
 
 #endif
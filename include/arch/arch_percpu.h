@@ -0,0 +1,20 @@
+#ifndef ARCH_PERCPU_H
+#define ARCH_PERCPU_H
+
+/*
+ * the calling cpu's per cpu offset (see percpu.h), held within a
+ * register so it's read without a memory access.
+ * arch_percpu_get_offset()		returns the offset
+ * arch_percpu_set_offset(offset)	sets the offset
+ */
+#if defined(ARCH_ARMV7)
+#include <arch/arm/armv7/armv7_syscntl.h>
+
+/* TPIDRPRW isn't accessible from user mode */
+#define arch_percpu_get_offset()	((addr_t)armv7_get_tpidrprw())
+#define arch_percpu_set_offset(offset)	armv7_set_tpidrprw((unsigned int)(offset))
+#else
+#error "per cpu offsets aren't provided for this arch"
+#endif
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef ARCH_PMU_H
+#define ARCH_PMU_H
+
+/**
+ * arch_pmu_cycle_enable
+ * 
+ * enables (and resets) the calling cpu's cycle counter.
+ **/
+extern void arch_pmu_cycle_enable(void);
+
+/**
+ * arch_pmu_get_cycles
+ * 
+ * returns the calling cpu's cycle counter; it wraps, so only
+ * differences are meaningful.
+ * 
+ * @return cycle count
+ **/
+extern unsigned int arch_pmu_get_cycles(void);
+
+#endif
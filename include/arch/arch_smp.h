@@ -0,0 +1,63 @@
+#ifndef ARCH_SMP_H
+#define ARCH_SMP_H
+#include <types.h>
+
+/* largest number of cpus supported */
+#ifdef CONFIG_SMP
+#ifndef NR_CPUS
+#define NR_CPUS		4
+#endif
+#else
+#define NR_CPUS		1
+#endif
+
+/* coherency granule; data written by different cpus is kept apart by it */
+#ifndef SMP_CACHE_LINE_SZ
+#define SMP_CACHE_LINE_SZ	32
+#endif
+
+#define __cacheline_aligned	__attribute__((aligned(SMP_CACHE_LINE_SZ)))
+
+/**
+ * ipi_t
+ * 
+ * defines the inter-processor interrupts raised by the kernel;
+ * each must fit within the arch's software interrupt range.
+ **/
+typedef enum {
+    IPI_WAKEUP		= 0,	/* no action; wakes a waiting cpu */
+    IPI_TLB_SHOOTDOWN	= 1,
+    IPI_CALL_FUNC	= 2	/* runs the calls queued upon a cpu (see smp_call.h) */
+} ipi_t;
+
+/**
+ * arch_smp_get_cpu_id
+ * 
+ * returns the id of the calling cpu, in the range [0, NR_CPUS).
+ * 
+ * @return cpu id
+ **/
+extern unsigned int arch_smp_get_cpu_id(void);
+
+/**
+ * arch_smp_send_ipi
+ * 
+ * raises an inter-processor interrupt on each cpu in cpu_mask.
+ * prior memory accesses must be visible to the targets before the
+ * interrupt is delivered.
+ * 
+ * @cpu_mask	bitmask of target cpu ids
+ * @ipi	interrupt to raise
+ **/
+extern void arch_smp_send_ipi(unsigned int cpu_mask, ipi_t ipi);
+
+/**
+ * arch_smp_idle
+ * 
+ * waits for an interrupt & services it.
+ * irqs must be masked by the caller; they're unmasked only briefly,
+ * once the wait completes, so no wakeup is lost.
+ **/
+extern void arch_smp_idle(void);
+
+#endif
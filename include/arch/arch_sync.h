@@ -0,0 +1,56 @@
+#ifndef ARCH_SYNC_H
+#define ARCH_SYNC_H
+#include <types.h>
+#include <stdbool.h>
+
+struct spinlock;
+
+/**
+ * arch_spin_lock
+ * 
+ * takes a ticket & waits until it's served; accesses within the
+ * critical section can't be observed before the lock is acquired.
+ * 
+ * @lock	lock
+ **/
+extern void arch_spin_lock(struct spinlock *lock);
+
+/**
+ * arch_spin_trylock
+ * 
+ * acquires a lock only if it's free (no ticket is outstanding).
+ * 
+ * @lock	lock
+ * @return true if acquired
+ **/
+extern bool arch_spin_trylock(struct spinlock *lock);
+
+/**
+ * arch_spin_unlock
+ * 
+ * serves the next ticket & wakes the cpus waiting upon it; accesses
+ * within the critical section are observed before the release.
+ * 
+ * @lock	lock
+ **/
+extern void arch_spin_unlock(struct spinlock *lock);
+
+/**
+ * arch_irq_save
+ * 
+ * masks irqs on the calling cpu.
+ * 
+ * @return previous irq state, for arch_irq_restore
+ **/
+extern unsigned int arch_irq_save(void);
+
+/**
+ * arch_irq_restore
+ * 
+ * restores the irq state returned by arch_irq_save.
+ * 
+ * @flags	previous irq state
+ **/
+extern void arch_irq_restore(unsigned int flags);
+
+#endif
@@ -5,10 +5,76 @@
 #define dmb() asm volatile("dmb" : : : "memory")
 #define dsb() asm volatile("dsb" : : : "memory")
 #define isb() asm volatile("isb" : : : "memory")
+/* inner shareable domain (the cpus); ishst orders stores only */
+#define dmb_ish() asm volatile("dmb ish" : : : "memory")
+#define dmb_ishst() asm volatile("dmb ishst" : : : "memory")
+#define dsb_ish() asm volatile("dsb ish" : : : "memory")
+#define dsb_ishst() asm volatile("dsb ishst" : : : "memory")
+#define sev() asm volatile("sev" : : : "memory")
+#define wfe() asm volatile("wfe" : : : "memory")
+#define yield() asm volatile("yield" : : : "memory")
 
 /* opcodes */
 #define ARMV7_LDR_PC	0xE59FF000
 
+/* cpsr */
+#define ARMV7_CPSR_MODE_MASK	0x1F
+#define ARMV7_CPSR_MODE_USR	0x10
+#define ARMV7_CPSR_MODE_IRQ	0x12
+#define ARMV7_CPSR_MODE_SVC	0x13
+#define ARMV7_CPSR_MODE_ABT	0x17
+#define ARMV7_CPSR_MODE_UND	0x1B
+
+/**
+ * armv7_regs
+ * 
+ * register state saved upon exception entry (see armv7_ivt_hand.s);
+ * the layout must match the order in which it is pushed.
+ * 
+ * @r		r0 - r12
+ * @sp		user mode sp
+ * @lr		user mode lr
+ * @pc		address of the faulting instruction
+ * @cpsr	cpsr of the interrupted mode
+ **/
+struct armv7_regs {
+    unsigned int	r[13];
+    unsigned int	sp;
+    unsigned int	lr;
+    unsigned int	pc;
+    unsigned int	cpsr;
+};
+
+/**
+ * armv7_irq_save
+ * 
+ * masks irqs on the current cpu
+ * 
+ * @return previous cpsr, for armv7_irq_restore
+ **/
+inline unsigned int armv7_irq_save(void) {
+    unsigned int ret = 0;
+    
+    asm volatile("mrs %0, cpsr\n\t"
+		 "cpsid i" : "=r" (ret) : : "memory");
+    
+    return ret;
+}
+
+/**
+ * armv7_irq_restore
+ * 
+ * restores the irq mask saved by armv7_irq_save
+ * 
+ * @flags	cpsr returned from armv7_irq_save
+ **/
+inline void armv7_irq_restore(unsigned int flags) {
+    asm volatile("msr cpsr_c, %0" : : "r" (flags) : "memory");
+}
+
+/* armv7_arch.s */
+extern void armv7_set_mode_sp(unsigned int mode, addr_t sp);
+
 /* experimental */
 inline unsigned int ldrex(unsigned int *ptr) {
     unsigned int ret = 0;
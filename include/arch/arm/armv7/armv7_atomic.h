@@ -0,0 +1,446 @@
+#ifndef ARMV7_ATOMIC_H
+#define ARMV7_ATOMIC_H
+#include <arch/arm/armv7/armv7.h>
+#include <types.h>
+#include <stdbool.h>
+
+/*
+ * atomic operations (see sync/atomic.h) using ldrex/strex(d); each
+ * retries until its store-exclusive succeeds.
+ * only the _relaxed forms are written out, the ordered forms wrap them
+ * with dmb ish (ARMV7_ATOMIC_ORDERED).
+ */
+
+#define ATOMIC_INIT(i)		{ .counter = (i) }
+#define ATOMIC64_INIT(i)	{ .counter = (i) }
+
+#define ATOMIC_BITS_SHIFT	5
+#define ATOMIC_BITS_MASK	0x1F
+
+/**
+ * atomic_t
+ * 
+ * @counter	value
+ **/
+typedef struct {
+    volatile int	counter;
+} atomic_t;
+
+/**
+ * atomic64_t
+ * 
+ * must be doubleword aligned for ldrexd/strexd.
+ * 
+ * @counter	value
+ **/
+typedef struct {
+    volatile long long	counter;
+} __attribute__((aligned(8))) atomic64_t;
+
+/**
+ * ARMV7_ATOMIC_ORDERED
+ * 
+ * defines the _acquire (later accesses follow), _release (earlier
+ * accesses precede) & fully ordered forms of name##_relaxed.
+ **/
+#define ARMV7_ATOMIC_ORDERED(ret_t, name, params, args)	\
+inline ret_t name##_acquire params {			\
+    ret_t ret = name##_relaxed args;			\
+							\
+    dmb_ish();						\
+							\
+    return ret;						\
+}							\
+							\
+inline ret_t name##_release params {			\
+    dmb_ish();						\
+							\
+    return name##_relaxed args;				\
+}							\
+							\
+inline ret_t name params {				\
+    ret_t ret = 0;					\
+							\
+    dmb_ish();						\
+    ret = name##_relaxed args;				\
+    dmb_ish();						\
+							\
+    return ret;						\
+}
+
+/**
+ * atomic_read
+ * 
+ * @v		atomic
+ * @return value
+ **/
+inline int atomic_read(atomic_t *v) {
+    return v->counter;
+}
+
+/**
+ * atomic_set
+ * 
+ * @v		atomic
+ * @i		value
+ **/
+inline void atomic_set(atomic_t *v, int i) {
+    v->counter = i;
+}
+
+/**
+ * atomic_add_return_relaxed
+ * 
+ * @i		addend
+ * @v		atomic
+ * @return new value
+ **/
+inline int atomic_add_return_relaxed(int i, atomic_t *v) {
+    int			ret	= 0;
+    unsigned int	fail	= 0;
+    
+    asm volatile("1:\n\t"
+		 "ldrex %0, [%2]\n\t"
+		 "add %0, %0, %3\n\t"
+		 "strex %1, %0, [%2]\n\t"
+		 "teq %1, #0\n\t"
+		 "bne 1b"
+		 : "=&r" (ret), "=&r" (fail)
+		 : "r" (&v->counter), "r" (i)
+		 : "cc", "memory");
+    
+    return ret;
+}
+
+/**
+ * atomic_fetch_add_relaxed
+ * 
+ * @i		addend
+ * @v		atomic
+ * @return previous value
+ **/
+inline int atomic_fetch_add_relaxed(int i, atomic_t *v) {
+    int			ret	= 0;
+    int			val	= 0;
+    unsigned int	fail	= 0;
+    
+    asm volatile("1:\n\t"
+		 "ldrex %0, [%3]\n\t"
+		 "add %1, %0, %4\n\t"
+		 "strex %2, %1, [%3]\n\t"
+		 "teq %2, #0\n\t"
+		 "bne 1b"
+		 : "=&r" (ret), "=&r" (val), "=&r" (fail)
+		 : "r" (&v->counter), "r" (i)
+		 : "cc", "memory");
+    
+    return ret;
+}
+
+/**
+ * atomic_xchg_relaxed
+ * 
+ * @v		atomic
+ * @i		new value
+ * @return previous value
+ **/
+inline int atomic_xchg_relaxed(atomic_t *v, int i) {
+    int			ret	= 0;
+    unsigned int	fail	= 0;
+    
+    asm volatile("1:\n\t"
+		 "ldrex %0, [%2]\n\t"
+		 "strex %1, %3, [%2]\n\t"
+		 "teq %1, #0\n\t"
+		 "bne 1b"
+		 : "=&r" (ret), "=&r" (fail)
+		 : "r" (&v->counter), "r" (i)
+		 : "cc", "memory");
+    
+    return ret;
+}
+
+/**
+ * atomic_cmpxchg_relaxed
+ * 
+ * replaces the value only if it's old.
+ * 
+ * @v		atomic
+ * @old		expected value
+ * @i		new value
+ * @return previous value (old if replaced)
+ **/
+inline int atomic_cmpxchg_relaxed(atomic_t *v, int old, int i) {
+    int			ret	= 0;
+    unsigned int	fail	= 0;
+    
+    do {
+	asm volatile("ldrex %1, [%2]\n\t"
+		     "mov %0, #0\n\t"
+		     "teq %1, %3\n\t"
+		     "strexeq %0, %4, [%2]"
+		     : "=&r" (fail), "=&r" (ret)
+		     : "r" (&v->counter), "r" (old), "r" (i)
+		     : "cc", "memory");
+    } while (fail != 0);
+    
+    return ret;
+}
+
+/**
+ * atomic64_read
+ * 
+ * ldrd isn't single-copy atomic without lpae, so ldrexd is used.
+ * 
+ * @v		atomic
+ * @return value
+ **/
+inline long long atomic64_read(atomic64_t *v) {
+    long long ret = 0;
+    
+    asm volatile("ldrexd %0, %H0, [%1]"
+		 : "=&r" (ret)
+		 : "r" (&v->counter)
+		 : "memory");
+    
+    return ret;
+}
+
+/**
+ * atomic64_add_return_relaxed
+ * 
+ * @i		addend
+ * @v		atomic
+ * @return new value
+ **/
+inline long long atomic64_add_return_relaxed(long long i, atomic64_t *v) {
+    long long		ret	= 0;
+    unsigned int	fail	= 0;
+    
+    asm volatile("1:\n\t"
+		 "ldrexd %0, %H0, [%2]\n\t"
+		 "adds %Q0, %Q0, %Q3\n\t"
+		 "adc %R0, %R0, %R3\n\t"
+		 "strexd %1, %0, %H0, [%2]\n\t"
+		 "teq %1, #0\n\t"
+		 "bne 1b"
+		 : "=&r" (ret), "=&r" (fail)
+		 : "r" (&v->counter), "r" (i)
+		 : "cc", "memory");
+    
+    return ret;
+}
+
+/**
+ * atomic64_fetch_add_relaxed
+ * 
+ * @i		addend
+ * @v		atomic
+ * @return previous value
+ **/
+inline long long atomic64_fetch_add_relaxed(long long i, atomic64_t *v) {
+    long long		ret	= 0;
+    long long		val	= 0;
+    unsigned int	fail	= 0;
+    
+    asm volatile("1:\n\t"
+		 "ldrexd %0, %H0, [%3]\n\t"
+		 "adds %Q1, %Q0, %Q4\n\t"
+		 "adc %R1, %R0, %R4\n\t"
+		 "strexd %2, %1, %H1, [%3]\n\t"
+		 "teq %2, #0\n\t"
+		 "bne 1b"
+		 : "=&r" (ret), "=&r" (val), "=&r" (fail)
+		 : "r" (&v->counter), "r" (i)
+		 : "cc", "memory");
+    
+    return ret;
+}
+
+/**
+ * atomic64_xchg_relaxed
+ * 
+ * @v		atomic
+ * @i		new value
+ * @return previous value
+ **/
+inline long long atomic64_xchg_relaxed(atomic64_t *v, long long i) {
+    long long		ret	= 0;
+    unsigned int	fail	= 0;
+    
+    asm volatile("1:\n\t"
+		 "ldrexd %0, %H0, [%2]\n\t"
+		 "strexd %1, %3, %H3, [%2]\n\t"
+		 "teq %1, #0\n\t"
+		 "bne 1b"
+		 : "=&r" (ret), "=&r" (fail)
+		 : "r" (&v->counter), "r" (i)
+		 : "cc", "memory");
+    
+    return ret;
+}
+
+/**
+ * atomic64_cmpxchg_relaxed
+ * 
+ * replaces the value only if it's old.
+ * 
+ * @v		atomic
+ * @old		expected value
+ * @i		new value
+ * @return previous value (old if replaced)
+ **/
+inline long long atomic64_cmpxchg_relaxed(atomic64_t *v, long long old, long long i) {
+    long long		ret	= 0;
+    unsigned int	fail	= 0;
+    
+    do {
+	asm volatile("ldrexd %1, %H1, [%2]\n\t"
+		     "mov %0, #0\n\t"
+		     "teq %1, %3\n\t"
+		     "teqeq %H1, %H3\n\t"
+		     "strexdeq %0, %4, %H4, [%2]"
+		     : "=&r" (fail), "=&r" (ret)
+		     : "r" (&v->counter), "r" (old), "r" (i)
+		     : "cc", "memory");
+    } while (fail != 0);
+    
+    return ret;
+}
+
+/**
+ * atomic64_set
+ * 
+ * strd isn't single-copy atomic without lpae, so the value is exchanged.
+ * 
+ * @v		atomic
+ * @i		value
+ **/
+inline void atomic64_set(atomic64_t *v, long long i) {
+    atomic64_xchg_relaxed(v, i);
+}
+
+/**
+ * atomic_test_and_set_bit_relaxed
+ * 
+ * @nr		bit number, from the first word of addr
+ * @addr	bitmap
+ * @return true if the bit was already set
+ **/
+inline bool atomic_test_and_set_bit_relaxed(unsigned int nr, volatile unsigned int *addr) {
+    volatile unsigned int	*word	= addr + (nr >> ATOMIC_BITS_SHIFT);
+    unsigned int		mask	= 1u << (nr & ATOMIC_BITS_MASK);
+    unsigned int		prev	= 0;
+    unsigned int		val	= 0;
+    unsigned int		fail	= 0;
+    
+    asm volatile("1:\n\t"
+		 "ldrex %0, [%3]\n\t"
+		 "orr %1, %0, %4\n\t"
+		 "strex %2, %1, [%3]\n\t"
+		 "teq %2, #0\n\t"
+		 "bne 1b"
+		 : "=&r" (prev), "=&r" (val), "=&r" (fail)
+		 : "r" (word), "r" (mask)
+		 : "cc", "memory");
+    
+    return ((prev & mask) != 0);
+}
+
+/**
+ * atomic_test_and_clear_bit_relaxed
+ * 
+ * @nr		bit number, from the first word of addr
+ * @addr	bitmap
+ * @return true if the bit was set
+ **/
+inline bool atomic_test_and_clear_bit_relaxed(unsigned int nr, volatile unsigned int *addr) {
+    volatile unsigned int	*word	= addr + (nr >> ATOMIC_BITS_SHIFT);
+    unsigned int		mask	= 1u << (nr & ATOMIC_BITS_MASK);
+    unsigned int		prev	= 0;
+    unsigned int		val	= 0;
+    unsigned int		fail	= 0;
+    
+    asm volatile("1:\n\t"
+		 "ldrex %0, [%3]\n\t"
+		 "bic %1, %0, %4\n\t"
+		 "strex %2, %1, [%3]\n\t"
+		 "teq %2, #0\n\t"
+		 "bne 1b"
+		 : "=&r" (prev), "=&r" (val), "=&r" (fail)
+		 : "r" (word), "r" (mask)
+		 : "cc", "memory");
+    
+    return ((prev & mask) != 0);
+}
+
+/**
+ * arch_xchg_relaxed
+ * 
+ * @ptr		word
+ * @val		new value
+ * @return previous value
+ **/
+inline addr_t arch_xchg_relaxed(volatile addr_t *ptr, addr_t val) {
+    return (addr_t)atomic_xchg_relaxed((atomic_t *)ptr, (int)val);
+}
+
+/**
+ * arch_cmpxchg_relaxed
+ * 
+ * replaces a word only if it holds old.
+ * 
+ * @ptr		word
+ * @old		expected value
+ * @val		new value
+ * @return previous value (old if replaced)
+ **/
+inline addr_t arch_cmpxchg_relaxed(volatile addr_t *ptr, addr_t old, addr_t val) {
+    return (addr_t)atomic_cmpxchg_relaxed((atomic_t *)ptr, (int)old, (int)val);
+}
+
+ARMV7_ATOMIC_ORDERED(int, atomic_add_return, (int i, atomic_t *v), (i, v))
+ARMV7_ATOMIC_ORDERED(int, atomic_fetch_add, (int i, atomic_t *v), (i, v))
+ARMV7_ATOMIC_ORDERED(int, atomic_xchg, (atomic_t *v, int i), (v, i))
+ARMV7_ATOMIC_ORDERED(int, atomic_cmpxchg, (atomic_t *v, int old, int i), (v, old, i))
+ARMV7_ATOMIC_ORDERED(long long, atomic64_add_return, (long long i, atomic64_t *v), (i, v))
+ARMV7_ATOMIC_ORDERED(long long, atomic64_fetch_add, (long long i, atomic64_t *v), (i, v))
+ARMV7_ATOMIC_ORDERED(long long, atomic64_xchg, (atomic64_t *v, long long i), (v, i))
+ARMV7_ATOMIC_ORDERED(long long, atomic64_cmpxchg, (atomic64_t *v, long long old, long long i), (v, old, i))
+ARMV7_ATOMIC_ORDERED(bool, atomic_test_and_set_bit, (unsigned int nr, volatile unsigned int *addr), (nr, addr))
+ARMV7_ATOMIC_ORDERED(bool, atomic_test_and_clear_bit, (unsigned int nr, volatile unsigned int *addr), (nr, addr))
+ARMV7_ATOMIC_ORDERED(addr_t, arch_xchg, (volatile addr_t *ptr, addr_t val), (ptr, val))
+ARMV7_ATOMIC_ORDERED(addr_t, arch_cmpxchg, (volatile addr_t *ptr, addr_t old, addr_t val), (ptr, old, val))
+
+/**
+ * arch_wait_event
+ * 
+ * waits (in wfe) for an event raised by arch_send_event or an
+ * interrupt; it may also return spuriously.
+ **/
+inline void arch_wait_event(void) {
+    wfe();
+}
+
+/**
+ * arch_send_event
+ * 
+ * completes prior stores & wakes every cpu within arch_wait_event.
+ **/
+inline void arch_send_event(void) {
+    dsb_ishst();
+    sev();
+}
+
+/**
+ * arch_cpu_relax
+ * 
+ * hints that the cpu is spinning upon memory another is about to
+ * write, where waiting for an event isn't possible (the writer
+ * raises none); it lets a hardware thread sharing the core run.
+ **/
+inline void arch_cpu_relax(void) {
+    yield();
+}
+
+#endif
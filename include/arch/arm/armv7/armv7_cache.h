@@ -0,0 +1,30 @@
+#ifndef ARMV7_CACHE_H
+#define ARMV7_CACHE_H
+#include <arch/arm/armv7/armv7_syscntl.h>
+#include <types.h>
+#include <stddef.h>
+
+/**
+ * armv7_cache_op
+ * 
+ * defines set/way & virtual address cache maintenance operations
+ **/
+typedef enum {
+    ARMV7_CACHE_INVAL		= 0x0,
+    ARMV7_CACHE_CLEAN		= 0x1,
+    ARMV7_CACHE_CLEAN_INVAL	= 0x2
+} armv7_cache_op;
+
+/* armv7_cache.c */
+void armv7_dcache_inval_all(void);
+void armv7_dcache_clean_all(void);
+void armv7_dcache_clean_inval_all(void);
+void armv7_icache_inval_all(void);
+void armv7_dcache_range(addr_t start, size_t size, armv7_cache_op op);
+void armv7_icache_sync_range(addr_t start, size_t size);
+size_t armv7_dcache_get_line_sz(void);
+size_t armv7_dcache_get_sz(void);
+void armv7_cache_enable(unsigned int sctlr_bits);
+void armv7_cache_disable(unsigned int sctlr_bits);
+
+#endif
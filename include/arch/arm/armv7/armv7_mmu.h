@@ -14,17 +14,39 @@
 #define PGD_DOMAIN_SHIFT	5
 #define PGD_DOMAIN_MASK		(0xF << PGD_DOMAIN_SHIFT)
 #define PGD_AP_MASK		(0x3 << PGD_SECT_AP_SHIFT)
+#define PGD_SECT_APX		0x8000
 #define PGD_TYPE_MASK		0x3
 #define PGD_SECT_MASK		0xFFF00000
+#define PGD_SUPER_SECT_MASK	0xFF000000
 #define PGD_TABLE_MASK		0xFFFFFC00
 
 #define PGTB_SZ			0x400
 #define PGTB_AP_SHIFT		4
+#define PGTB_APX		0x200
 #define PGTB_IDX_SHIFT		12
 #define PGTB_IDX_MASK		0xFF
 #define PGTB_LG_PG_MASK		0xFFFF0000
 #define PGTB_SM_PG_MASK		0xFFFFF000
 #define PGTB_TYPE_MASK		0x3
+/* memory attributes (TEX remap disabled) */
+#define PGD_SECT_B		0x4
+#define PGD_SECT_C		0x8
+#define PGD_SECT_TEX_SHIFT	12
+#define PGD_SECT_S		0x10000
+#define PGD_SECT_SUPER		0x40000
+#define PGTB_B			0x4
+#define PGTB_C			0x8
+#define PGTB_TEX_SHIFT		6
+#define PGTB_S			0x400
+/* normal: outer & inner write-back, write-allocate, shareable */
+#define ARMV7_MMU_PGD_SECT_NORMAL	((0x1 << PGD_SECT_TEX_SHIFT) | PGD_SECT_C | PGD_SECT_B | PGD_SECT_S)
+#define ARMV7_MMU_PGTB_NORMAL		((0x1 << PGTB_TEX_SHIFT) | PGTB_C | PGTB_B | PGTB_S)
+/* device: shareable device */
+#define ARMV7_MMU_PGD_SECT_DEVICE	(PGD_SECT_B)
+#define ARMV7_MMU_PGTB_DEVICE		(PGTB_B)
+/* translation table walks: write-back, write-allocate, shareable */
+#define ARMV7_MMU_TTBR_FLAGS		(ARMV7_TTBR_ME_WB_WA_CACHE | ARMV7_TTBR_SHAREABLE | \
+					ARMV7_TTBR_REG_WB_WA_CACHE)
 /* domains */
 #define USER_DOMAIN		0
 #define KERN_DOMAIN		1
@@ -35,6 +57,23 @@
 #define TTBCR_N_MASK		0x7
 /* ttbr */
 #define TTBR_ALIGN 		14
+
+/*
+ * the vm split (TTBCR.N) is fixed at build time by CONFIG_VM_SPLIT, the
+ * lowest virtual address of the kernel half: TTBR1 translates from
+ * 1 << (32 - N).  CONFIG_VM_SPLIT_GENERIC instead reads N back from
+ * TTBCR at run time; CONFIG_VM_SPLIT is then only programmed at boot.
+ */
+#if defined(CONFIG_VM_SPLIT)
+#if (CONFIG_VM_SPLIT & (CONFIG_VM_SPLIT - 1)) || (CONFIG_VM_SPLIT != 0 && CONFIG_VM_SPLIT < 0x2000000)
+#error "CONFIG_VM_SPLIT must be 0 or a power of two of at least 32MiB"
+#endif
+#define ARMV7_MMU_PG_DIV	((CONFIG_VM_SPLIT) ? (__builtin_clz(CONFIG_VM_SPLIT) + 1) : 0)
+#elif defined(CONFIG_VM_SPLIT_GENERIC)
+#define ARMV7_MMU_PG_DIV	ARMV7_TTBCR_2G_2G
+#else
+#error "CONFIG_VM_SPLIT (or CONFIG_VM_SPLIT_GENERIC) is required"
+#endif
 #define TTBR_MASK		0xFFFFC000
 
 /**
@@ -60,16 +99,23 @@ typedef enum {
     ARMV7_MMU_PGTB_SMALL_PG	= 0x2
 } armv7_mmu_pgtb_type;
 
+/* armv7_mmu_acc_perm */
+#define ARMV7_MMU_ACC_AP_MASK	0x3
+#define ARMV7_MMU_ACC_APX	0x4
+
 /**
  * armv7_mmu_acc_perm
  * 
- * defines access permissions for mmu entries
+ * defines access permissions for mmu entries as AP[2:0].
+ * the access flag is enabled (SCTLR.AFE), so AP[0] is the access flag
+ * & is always set; AP[1:0] are written to the entry's AP field and
+ * AP[2] to its APX bit.
  **/
 typedef enum {
-    ARMV7_MMU_ACC_KRW_NOU	= 0x0,
-    ARMV7_MMU_ACC_KRW_URW	= 0x1,
-    ARMV7_MMU_ACC_KRO_NOU	= 0x2,
-    ARMV7_MMU_ACC_KRO_URO	= 0x3
+    ARMV7_MMU_ACC_KRW_NOU	= 0x1,
+    ARMV7_MMU_ACC_KRW_URW	= 0x3,
+    ARMV7_MMU_ACC_KRO_NOU	= 0x5,
+    ARMV7_MMU_ACC_KRO_URO	= 0x7
 } armv7_mmu_acc_perm;
 
 /**
@@ -205,11 +251,60 @@ inline bool armv7_mmu_is_enabled(void) {
 /**
  * armv7_mmu_get_pg_div
  * 
- * returns the mmu page div
+ * returns the mmu page div (TTBCR.N); a constant unless
+ * CONFIG_VM_SPLIT_GENERIC is selected.
  * @return pg_div
  **/
 inline int armv7_mmu_get_pg_div(void) {
+#ifdef CONFIG_VM_SPLIT_GENERIC
     return (armv7_get_ttbcr() & TTBCR_N_MASK);
+#else
+    return ARMV7_MMU_PG_DIV;
+#endif
+}
+
+/**
+ * armv7_mmu_get_kern_vaddr
+ * 
+ * returns the lowest virtual address translated by ttbr1
+ * @return kernel virtual base or 0x0 if ttbr1 is unused (N == 0)
+ **/
+inline addr_t armv7_mmu_get_kern_vaddr(void) {
+    int pg_div = armv7_mmu_get_pg_div();
+    
+    return (pg_div > 0) ? ((addr_t)1 << (32 - pg_div)) : 0x0;
+}
+
+/**
+ * armv7_mmu_is_higher_half
+ * 
+ * determines whether an address is higher half (i.e., uses ttbr1)
+ * 
+ * @virt_addr	address to check
+ * @return true if higher
+ **/
+inline bool armv7_mmu_is_higher_half(addr_t virt_addr) {
+    return (armv7_mmu_get_pg_div() > 0 && virt_addr >= armv7_mmu_get_kern_vaddr());
+}
+
+/**
+ * armv7_mmu_get_user_pgd_entry_cnt
+ * 
+ * returns the number of entries of a (ttbr0) user page directory
+ * @return entry count
+ **/
+inline unsigned int armv7_mmu_get_user_pgd_entry_cnt(void) {
+    return (PGD_ENTRY_CNT >> armv7_mmu_get_pg_div());
+}
+
+/**
+ * armv7_mmu_get_user_pgd_align
+ * 
+ * returns the alignment (in bytes) required of a user page directory
+ * @return alignment
+ **/
+inline unsigned int armv7_mmu_get_user_pgd_align(void) {
+    return (1 << (TTBR_ALIGN - armv7_mmu_get_pg_div()));
 }
 
 
@@ -226,6 +321,14 @@ int armv7_mmu_map_new_pgd(addr_t pgd_addr, struct armv7_mmu_pgd_entry *pgd_ent);
 int armv7_mmu_map_new_pgtb(addr_t pgtb_addr, struct armv7_mmu_pgtb_entry *pgtb_ent);
 
 addr_t armv7_mmu_virt_to_phy(addr_t virt_addr);
+addr_t armv7_mmu_virt_to_phy_user(addr_t virt_addr);
+addr_t armv7_mmu_virt_to_phy_sw(addr_t virt_addr);
+addr_t armv7_mmu_walk(addr_t pgd_addr, addr_t virt_addr);
+addr_t armv7_mmu_get_pgtb(addr_t virt_addr);
+addr_t armv7_mmu_pgd_get_pgtb(addr_t pgd_addr, addr_t virt_addr);
+bool armv7_mmu_pgtb_is_empty(addr_t pgtb_addr);
+addr_t armv7_mmu_pgtb_get_phy(addr_t pgtb_addr, unsigned int idx);
+void armv7_mmu_pgtb_wrprotect(addr_t pgtb_addr);
 
 
 #endif
@@ -0,0 +1,79 @@
+#ifndef ARMV7_MMU_DUMP_H
+#define ARMV7_MMU_DUMP_H
+#include <types.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/* descriptor types of a range */
+#define ARMV7_MMU_DESC_SUPER_SECT	0
+#define ARMV7_MMU_DESC_SECT		1
+#define ARMV7_MMU_DESC_LARGE_PG		2
+#define ARMV7_MMU_DESC_SMALL_PG		3
+#define ARMV7_MMU_DESC_CNT		4
+
+/* memory types of a range (TEX remap disabled) */
+#define ARMV7_MMU_MEM_STRONG		0	/* strongly-ordered			*/
+#define ARMV7_MMU_MEM_DEVICE		1	/* device				*/
+#define ARMV7_MMU_MEM_NORMAL_NC		2	/* normal, non-cacheable		*/
+#define ARMV7_MMU_MEM_NORMAL_WT		3	/* normal, write-through		*/
+#define ARMV7_MMU_MEM_NORMAL_WB		4	/* normal, write-back			*/
+#define ARMV7_MMU_MEM_NORMAL_WBWA	5	/* normal, write-back write-allocate	*/
+#define ARMV7_MMU_MEM_OTHER		6	/* normal, differing inner & outer	*/
+
+/* range flags */
+#define ARMV7_MMU_RANGE_XN		0x1
+#define ARMV7_MMU_RANGE_SHARED		0x2
+#define ARMV7_MMU_RANGE_NG		0x4
+
+/* size (in bytes) of a range record within the binary export */
+#define ARMV7_MMU_DUMP_REC_SZ		20
+
+/**
+ * armv7_mmu_range
+ * 
+ * a run of descriptors of the same type & attributes translating
+ * contiguous virtual addresses to contiguous physical addresses.
+ * 
+ * @virt_addr	first virtual address
+ * @phy_addr	first physical address
+ * @size	size (in bytes)
+ * @ttbr	translation table (0 or 1)
+ * @type	ARMV7_MMU_DESC_*
+ * @ap		AP[2:0] (see armv7_mmu_acc_perm)
+ * @domain	domain
+ * @mem		ARMV7_MMU_MEM_*
+ * @flags	ARMV7_MMU_RANGE_*
+ **/
+struct armv7_mmu_range {
+    addr_t	virt_addr;
+    addr_t	phy_addr;
+    size_t	size;
+    uint8_t	ttbr;
+    uint8_t	type;
+    uint8_t	ap;
+    uint8_t	domain;
+    uint8_t	mem;
+    uint8_t	flags;
+};
+
+/**
+ * armv7_mmu_dump_stats
+ * 
+ * totals of a walk
+ * 
+ * @desc_cnt	descriptors of each ARMV7_MMU_DESC_* type
+ * @pgtb_cnt	page tables
+ * @range_cnt	merged ranges
+ **/
+struct armv7_mmu_dump_stats {
+    unsigned int	desc_cnt[ARMV7_MMU_DESC_CNT];
+    unsigned int	pgtb_cnt;
+    unsigned int	range_cnt;
+};
+
+/* armv7_mmu_dump.c */
+void armv7_mmu_dump_walk(void (*emit)(struct armv7_mmu_range *range, void *arg), void *arg,
+    struct armv7_mmu_dump_stats *stats);
+void armv7_mmu_dump(void);
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef ARMV7_PMU_H
+#define ARMV7_PMU_H
+#include <types.h>
+
+/* pmcr */
+#define ARMV7_PMCR_ENB			0x1
+#define ARMV7_PMCR_CYCLE_RESET		0x4
+/* pmcntenset */
+#define ARMV7_PMCNTEN_CYCLE		0x80000000
+
+/**
+ * armv7_get_pmcr
+ * 
+ * returns the current Performance Monitors Control Register
+ * @return Performance Monitors Control Register
+ **/
+inline unsigned int armv7_get_pmcr(void) {
+    unsigned int ret = 0;
+	
+    asm volatile("mrc p15, 0, %0, c9, c12, 0" : "=r" (ret));
+	
+    return ret;
+}
+
+/**
+ * armv7_set_pmcr
+ * 
+ * sets the Performance Monitors Control Register to specified value
+ * @val	specified value
+ **/
+inline void armv7_set_pmcr(unsigned int val) {
+    asm volatile("mcr p15, 0, %0, c9, c12, 0" : : "r" (val));
+}
+
+/**
+ * armv7_pmu_cycle_enable
+ * 
+ * enables (and resets) the cycle counter
+ **/
+inline void armv7_pmu_cycle_enable(void) {
+    armv7_set_pmcr(armv7_get_pmcr() | ARMV7_PMCR_ENB | ARMV7_PMCR_CYCLE_RESET);
+    
+    /* PMCNTENSET */
+    asm volatile("mcr p15, 0, %0, c9, c12, 1" : : "r" (ARMV7_PMCNTEN_CYCLE));
+}
+
+/**
+ * armv7_pmu_get_cycles
+ * 
+ * returns the current value of the cycle counter
+ * @return cycle count
+ **/
+inline unsigned int armv7_pmu_get_cycles(void) {
+    unsigned int ret = 0;
+	
+    asm volatile("mrc p15, 0, %0, c9, c13, 0" : "=r" (ret));
+	
+    return ret;
+}
+
+#endif
@@ -4,7 +4,21 @@
 
 /* sctlr */
 #define ARMV7_SCTLR_MMU_ENB 		0x1
+#define ARMV7_SCTLR_DCACHE_ENB		0x4
+#define ARMV7_SCTLR_BPRED_ENB		0x800
+#define ARMV7_SCTLR_ICACHE_ENB		0x1000
 #define ARMV7_SCTLR_AFE			0x20000000
+/* clidr */
+#define ARMV7_CLIDR_LOC_SHIFT		24
+#define ARMV7_CLIDR_LOC_MASK		0x7
+#define ARMV7_CLIDR_CTYPE_MASK		0x7
+#define ARMV7_CLIDR_CTYPE_DCACHE	0x2
+/* ccsidr */
+#define ARMV7_CCSIDR_LINE_MASK		0x7
+#define ARMV7_CCSIDR_WAYS_SHIFT		3
+#define ARMV7_CCSIDR_WAYS_MASK		0x3FF
+#define ARMV7_CCSIDR_SETS_SHIFT		13
+#define ARMV7_CCSIDR_SETS_MASK		0x7FFF
 /* dacr */
 #define ARMV7_DACR_NO_ACC		0x0
 #define ARMV7_DACR_CLIENT		0x1
@@ -27,6 +41,28 @@
 #define ARMV7_TTBR_REG_WB_WA_CACHE	0x8
 #define ARMV7_TTBR_REG_WT_CACHE		0x10
 #define ARMV7_TTBR_REG_WB_NO_WA_CACHE	0x18
+/* par */
+#define ARMV7_PAR_FAULT			0x1
+#define ARMV7_PAR_SUPER_SECT		0x2
+#define ARMV7_PAR_PA_MASK		0xFFFFF000
+#define ARMV7_PAR_SS_PA_MASK		0xFF000000
+
+#define ARMV7_MPIDR_CPU_MASK		0x3
+#define ARMV7_TLBI_MVA_MASK		0xFFFFF000
+
+/* dfsr/ifsr (short descriptor) */
+#define ARMV7_FSR_FS_MASK		0xF
+#define ARMV7_FSR_FS4			0x400
+#define ARMV7_FSR_WNR			0x800
+#define ARMV7_FSR_ALIGN			0x01
+#define ARMV7_FSR_ACC_FLAG_SECT		0x03
+#define ARMV7_FSR_TRANS_SECT		0x05
+#define ARMV7_FSR_ACC_FLAG_PG		0x06
+#define ARMV7_FSR_TRANS_PG		0x07
+#define ARMV7_FSR_DOMAIN_SECT		0x09
+#define ARMV7_FSR_DOMAIN_PG		0x0B
+#define ARMV7_FSR_PERM_SECT		0x0D
+#define ARMV7_FSR_PERM_PG		0x0F
 
 /**
  * armv7_get_config_base
@@ -255,6 +291,200 @@ inline unsigned int armv7_get_mpidr(void) {
     return ret;
 }
 
+/**
+ * armv7_get_tpidrprw
+ * 
+ * returns the PL1 only Thread ID Register
+ * @return PL1 only Thread ID Register
+ **/
+inline unsigned int armv7_get_tpidrprw(void) {
+    unsigned int ret = 0;
+	
+    asm volatile("mrc p15, 0, %0, c13, c0, 4" : "=r" (ret));
+	
+    return ret;
+}
+
+/**
+ * armv7_set_tpidrprw
+ * 
+ * sets the PL1 only Thread ID Register to specified value
+ * @val	specified value
+ **/
+inline void armv7_set_tpidrprw(unsigned int val) {
+    asm volatile("mcr p15, 0, %0, c13, c0, 4" : : "r" (val) : "memory");
+}
+
+/**
+ * armv7_get_dfsr
+ * 
+ * returns the Data Fault Status Register
+ * @return Data Fault Status Register
+ **/
+inline unsigned int armv7_get_dfsr(void) {
+    unsigned int ret = 0;
+	
+    asm volatile("mrc p15, 0, %0, c5, c0, 0" : "=r" (ret));
+	
+    return ret;
+}
+
+/**
+ * armv7_get_dfar
+ * 
+ * returns the Data Fault Address Register
+ * @return Data Fault Address Register
+ **/
+inline unsigned int armv7_get_dfar(void) {
+    unsigned int ret = 0;
+	
+    asm volatile("mrc p15, 0, %0, c6, c0, 0" : "=r" (ret));
+	
+    return ret;
+}
+
+/**
+ * armv7_get_ifsr
+ * 
+ * returns the Instruction Fault Status Register
+ * @return Instruction Fault Status Register
+ **/
+inline unsigned int armv7_get_ifsr(void) {
+    unsigned int ret = 0;
+	
+    asm volatile("mrc p15, 0, %0, c5, c0, 1" : "=r" (ret));
+	
+    return ret;
+}
+
+/**
+ * armv7_get_ifar
+ * 
+ * returns the Instruction Fault Address Register
+ * @return Instruction Fault Address Register
+ **/
+inline unsigned int armv7_get_ifar(void) {
+    unsigned int ret = 0;
+	
+    asm volatile("mrc p15, 0, %0, c6, c0, 2" : "=r" (ret));
+	
+    return ret;
+}
+
+/**
+ * armv7_get_fsr_status
+ * 
+ * extracts the fault status (FS[4:0]) from a DFSR/IFSR value
+ * @fsr		DFSR or IFSR
+ * @return fault status
+ **/
+inline unsigned int armv7_get_fsr_status(unsigned int fsr) {
+    unsigned int ret = fsr & ARMV7_FSR_FS_MASK;
+    
+    if (fsr & ARMV7_FSR_FS4) {
+	ret |= 0x10;
+    }
+    
+    return ret;
+}
+
+/**
+ * armv7_get_clidr
+ * 
+ * returns the current Cache Level ID Register
+ * @return Cache Level ID Register
+ **/
+inline unsigned int armv7_get_clidr(void) {
+    unsigned int ret = 0;
+	
+    asm volatile("mrc p15, 1, %0, c0, c0, 1" : "=r" (ret));
+	
+    return ret;
+}
+
+/**
+ * armv7_get_ccsidr
+ * 
+ * returns the Cache Size ID Register of the cache
+ * currently selected by the Cache Size Selection Register
+ * @return Cache Size ID Register
+ **/
+inline unsigned int armv7_get_ccsidr(void) {
+    unsigned int ret = 0;
+	
+    asm volatile("mrc p15, 1, %0, c0, c0, 0" : "=r" (ret));
+	
+    return ret;
+}
+
+/**
+ * armv7_set_csselr
+ * 
+ * sets the Cache Size Selection Register to specified value
+ * @val	specified value
+ **/
+inline void armv7_set_csselr(unsigned int val) {
+    asm volatile("mcr p15, 2, %0, c0, c0, 0" : : "r" (val));
+}
+
+/**
+ * armv7_invalidate_icache
+ * 
+ * invalidates all instruction caches to the point of unification
+ **/
+inline void armv7_invalidate_icache(void) {
+    asm volatile("mcr p15, 0, %0, c7, c5, 0" : : "r" (0));
+}
+
+/**
+ * armv7_invalidate_bpred
+ * 
+ * invalidates all branch predictor entries
+ **/
+inline void armv7_invalidate_bpred(void) {
+    asm volatile("mcr p15, 0, %0, c7, c5, 6" : : "r" (0));
+}
+
+/**
+ * armv7_ats1cpr
+ * 
+ * performs a stage 1 translation of a virtual address with privileged
+ * read permission checks; the result is written to the Physical Address
+ * Register & must be read after an isb.
+ * 
+ * @virt_addr	virtual address to translate
+ **/
+inline void armv7_ats1cpr(addr_t virt_addr) {
+    asm volatile("mcr p15, 0, %0, c7, c8, 0" : : "r" (virt_addr));
+}
+
+/**
+ * armv7_ats1cur
+ * 
+ * performs a stage 1 translation of a virtual address with unprivileged
+ * read permission checks; the result is written to the Physical Address
+ * Register & must be read after an isb.
+ * 
+ * @virt_addr	virtual address to translate
+ **/
+inline void armv7_ats1cur(addr_t virt_addr) {
+    asm volatile("mcr p15, 0, %0, c7, c8, 2" : : "r" (virt_addr));
+}
+
+/**
+ * armv7_get_par
+ * 
+ * returns the Physical Address Register
+ * @return Physical Address Register
+ **/
+inline unsigned int armv7_get_par(void) {
+    unsigned int ret = 0;
+	
+    asm volatile("mrc p15, 0, %0, c7, c4, 0" : "=r" (ret));
+	
+    return ret;
+}
+
 /**
  * armv7_invalidate_unified_tlb
  * 
@@ -264,5 +494,38 @@ inline void armv7_invalidate_unified_tlb(void) {
     asm volatile("mcr p15, 0, %0, c8, c7, 0" : : "r" (0));
 }
 
+/**
+ * armv7_invalidate_unified_tlb_mva
+ * 
+ * invalidates the local unified tlb entries for a single page (TLBIMVA)
+ * 
+ * @virt_addr	virtual address within the page
+ **/
+inline void armv7_invalidate_unified_tlb_mva(addr_t virt_addr) {
+    asm volatile("mcr p15, 0, %0, c8, c7, 1" : : "r" (virt_addr & ARMV7_TLBI_MVA_MASK));
+}
+
+/**
+ * armv7_invalidate_unified_tlb_is
+ * 
+ * invalidates the unified tlb of every cpu within the
+ * inner shareable domain (TLBIALLIS)
+ **/
+inline void armv7_invalidate_unified_tlb_is(void) {
+    asm volatile("mcr p15, 0, %0, c8, c3, 0" : : "r" (0));
+}
+
+/**
+ * armv7_invalidate_unified_tlb_mva_is
+ * 
+ * invalidates the unified tlb entries for a single page on every
+ * cpu within the inner shareable domain (TLBIMVAIS)
+ * 
+ * @virt_addr	virtual address within the page
+ **/
+inline void armv7_invalidate_unified_tlb_mva_is(addr_t virt_addr) {
+    asm volatile("mcr p15, 0, %0, c8, c3, 1" : : "r" (virt_addr & ARMV7_TLBI_MVA_MASK));
+}
+
 #endif
 
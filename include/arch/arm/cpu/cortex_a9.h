@@ -1,5 +1,7 @@
 #ifndef CORTEX_A9_H
 #define CORTEX_A9_H
+#include <arch/arm/armv7/armv7_syscntl.h>
+#include <mm/mem.h>
 
 /* private memory region offsets */
 #define CORTEX_A9_SCU_OFFSET		0x0000
@@ -8,6 +10,26 @@
 #define CORTEX_A9_PRIVATE_TIMER_OFFSET	0x0600
 #define CORTEX_A9_GICD_OFFSET		0x1000
 
+/* scu registers */
+#define CORTEX_A9_SCU_CNTL		0x00
+#define CORTEX_A9_SCU_CONFIG		0x04
+#define CORTEX_A9_SCU_INVAL_ALL		0x0C
+#define CORTEX_A9_SCU_CNTL_ENB		0x1
+#define CORTEX_A9_SCU_CONFIG_CPU_MASK	0x3
+#define CORTEX_A9_SCU_INVAL_ALL_WAYS	0xFFFF
+
+/* actlr */
+#define CORTEX_A9_ACTLR_FW		0x1
+#define CORTEX_A9_ACTLR_SMP		0x40
+
+/* cortex_a9_cache_init flags */
+#define CORTEX_A9_CACHE_DCACHE		0x1
+#define CORTEX_A9_CACHE_ICACHE		0x2
+#define CORTEX_A9_CACHE_BPRED		0x4
+#define CORTEX_A9_CACHE_SCU		0x8
+#define CORTEX_A9_CACHE_ALL		(CORTEX_A9_CACHE_DCACHE | CORTEX_A9_CACHE_ICACHE | \
+					CORTEX_A9_CACHE_BPRED | CORTEX_A9_CACHE_SCU)
+
 /**
  * cortex_a9_get_cpuid
  * 
@@ -23,4 +45,41 @@ inline unsigned int cortex_a9_get_cpuid(void) {
     return (ret & 0x3);
 }
 
+/**
+ * cortex_a9_get_scu_base
+ * 
+ * returns the base address of the snoop control unit
+ * 
+ * @return scu base address
+ **/
+inline addr_t cortex_a9_get_scu_base(void) {
+    return (armv7_get_config_base() + CORTEX_A9_SCU_OFFSET);
+}
+
+/**
+ * cortex_a9_scu_is_enabled
+ * 
+ * determines if the snoop control unit is enabled
+ * 
+ * @return true if enabled
+ **/
+inline bool cortex_a9_scu_is_enabled(void) {
+    return (memr(cortex_a9_get_scu_base() + CORTEX_A9_SCU_CNTL) & CORTEX_A9_SCU_CNTL_ENB);
+}
+
+/**
+ * cortex_a9_get_cpu_cnt
+ * 
+ * returns the number of cpus within the cluster
+ * 
+ * @return cpu count
+ **/
+inline unsigned int cortex_a9_get_cpu_cnt(void) {
+    return (memr(cortex_a9_get_scu_base() + CORTEX_A9_SCU_CONFIG) & CORTEX_A9_SCU_CONFIG_CPU_MASK) + 1;
+}
+
+/* cortex_a9_cache.c */
+void cortex_a9_scu_enable(void);
+void cortex_a9_cache_init(unsigned int flags);
+
 #endif
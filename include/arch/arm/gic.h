@@ -0,0 +1,43 @@
+#ifndef GIC_H
+#define GIC_H
+#include <types.h>
+
+/* distributor registers */
+#define GICD_CTLR			0x000
+#define GICD_TYPER			0x004
+#define GICD_ISENABLER			0x100
+#define GICD_ICENABLER			0x180
+#define GICD_IPRIORITYR			0x400
+#define GICD_SGIR			0xF00
+/* cpu interface registers */
+#define GICC_CTLR			0x000
+#define GICC_PMR			0x004
+#define GICC_IAR			0x00C
+#define GICC_EOIR			0x010
+
+/* ctlr */
+#define GICD_CTLR_ENB			0x1
+#define GICC_CTLR_ENB			0x1
+/* pmr; lowest priority accepted */
+#define GICC_PMR_ALL			0xF0
+/* sgir */
+#define GICD_SGIR_TARGET_SHIFT		16
+#define GICD_SGIR_TARGET_MASK		0xFF
+#define GICD_SGIR_ID_MASK		0xF
+/* iar */
+#define GICC_IAR_ID_MASK		0x3FF
+#define GICC_IAR_SPURIOUS		1023
+
+/* interrupt ids below this are software generated */
+#define GIC_SGI_CNT			16
+
+#define GIC_COMPATIBLE			"arm,cortex-a9-gic"
+
+/* gic.c */
+int gic_init(addr_t fdt_base);
+void gic_cpu_init(void);
+void gic_send_sgi(unsigned int cpu_mask, unsigned int sgi_id);
+unsigned int gic_ack(void);
+void gic_eoi(unsigned int iar);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef PL310_H
+#define PL310_H
+#include <types.h>
+
+/* registers */
+#define PL310_CNTL			0x100
+#define PL310_AUX_CNTL			0x104
+#define PL310_CACHE_SYNC		0x730
+#define PL310_INVAL_PA			0x770
+#define PL310_INVAL_WAY			0x77C
+#define PL310_CLEAN_PA			0x7B0
+#define PL310_CLEAN_WAY			0x7BC
+#define PL310_CLEAN_INVAL_PA		0x7F0
+#define PL310_CLEAN_INVAL_WAY		0x7FC
+
+/* cntl */
+#define PL310_CNTL_ENB			0x1
+/* aux cntl */
+#define PL310_AUX_ASSOC_16		0x10000
+#define PL310_AUX_WAY_SZ_SHIFT		17
+#define PL310_AUX_WAY_SZ_MASK		(0x7 << PL310_AUX_WAY_SZ_SHIFT)
+#define PL310_AUX_SHARE_OVERRIDE	0x400000
+#define PL310_AUX_INST_PREFETCH		0x20000000
+#define PL310_AUX_DATA_PREFETCH		0x10000000
+#define PL310_AUX_EARLY_BRESP		0x40000000
+
+#define PL310_LINE_SZ			32
+#define PL310_WAY_MASK_8		0xFF
+#define PL310_WAY_MASK_16		0xFFFF
+
+#define PL310_COMPATIBLE		"arm,pl310-cache"
+
+/* pl310.c */
+int pl310_init(addr_t fdt_base, unsigned int aux_val, unsigned int aux_mask);
+
+#endif
@@ -9,6 +9,7 @@
 #define EALIGN		5
 #define ENOTENB		6
 #define ESIZE		7
+#define ENOMEM		8
 
 
 #endif
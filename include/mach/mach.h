@@ -21,6 +21,64 @@
 extern void mach_early_kprintf(const char *fmt, ...);
 #endif
 
+#ifdef CONFIG_OUTER_CACHE
 
+/**
+ * mach_init_outer_cache
+ * 
+ * this function discovers, configures & enables the machine's outer
+ * (L2) cache controller and registers it with mm/cache.
+ * 
+ * @atag_fdt_base	base address of fdt
+ * @return errno
+ **/
+extern int mach_init_outer_cache(addr_t atag_fdt_base);
+#endif
+
+#ifdef CONFIG_SMP
+
+/**
+ * mach_init_irq_cntl
+ * 
+ * this function discovers & enables the machine's interrupt controller
+ * so that inter-processor interrupts may be raised & received
+ * (see arch_smp_send_ipi).
+ * 
+ * @atag_fdt_base	base address of fdt
+ * @return errno
+ **/
+extern int mach_init_irq_cntl(addr_t atag_fdt_base);
+
+/**
+ * mach_init_irq_cntl_cpu
+ * 
+ * this function enables the calling (secondary) cpu's interface to the
+ * interrupt controller; mach_init_irq_cntl must have completed.
+ **/
+extern void mach_init_irq_cntl_cpu(void);
+
+/**
+ * mach_smp_get_cpu_cnt
+ * 
+ * this function returns the number of cpus present.
+ * 
+ * @return cpu count
+ **/
+extern unsigned int mach_smp_get_cpu_cnt(void);
+
+/**
+ * mach_smp_boot_cpu
+ * 
+ * this function releases a secondary cpu, which enables its mmu (with the
+ * calling cpu's translation tables) & caches on its own stack and then
+ * calls entry.  it returns once the cpu has been released, not once it
+ * has reached entry.
+ * 
+ * @cpu		cpu id
+ * @entry	kernel entry of the cpu, passed its id; mustn't return
+ * @return errno
+ **/
+extern int mach_smp_boot_cpu(unsigned int cpu, void (*entry)(unsigned int));
+#endif
 
 #endif
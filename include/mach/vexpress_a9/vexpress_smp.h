@@ -0,0 +1,45 @@
+#ifndef VEXPRESS_SMP_H
+#define VEXPRESS_SMP_H
+#include <arch/arch_smp.h>
+#include <types.h>
+
+/* motherboard system registers (ca9x4 tile memory map) */
+#define VEXPRESS_SYS_BASE		0x10000000
+#define VEXPRESS_SYS_FLAGSSET		0x30
+#define VEXPRESS_SYS_FLAGSCLR		0x34
+
+/* svc stack of each secondary cpu */
+#define VEXPRESS_SMP_STACK_SZ		0x2000
+
+/**
+ * vexpress_smp_boot
+ * 
+ * state handed to the secondary cpus by mach_smp_boot_cpu; it's read with
+ * their mmu & caches disabled, so it must be written back to memory before
+ * a cpu is released.
+ * _vexpress_secondary relies upon stack being the first member.
+ * 
+ * @stack	physical top of each cpu's svc stack; 0 until it's released
+ * @entry	kernel entry of the cpus
+ * @ttbcr	ttbcr of the boot cpu
+ * @ttbr0	boot identity page directory (see mlay_get_boot_pgd)
+ * @ttbr1	ttbr1 of the boot cpu
+ * @dacr	dacr of the boot cpu
+ **/
+struct vexpress_smp_boot {
+    volatile addr_t	stack[NR_CPUS];
+    addr_t		entry;
+    unsigned int	ttbcr;
+    unsigned int	ttbr0;
+    unsigned int	ttbr1;
+    unsigned int	dacr;
+};
+
+/* vexpress_boot.s */
+extern void _vexpress_secondary(void);
+
+/* vexpress_boot_init.c */
+extern struct vexpress_smp_boot vexpress_smp_boot;
+addr_t vexpress_secondary_init(unsigned int cpu);
+
+#endif
@@ -4,6 +4,39 @@
 #include <stddef.h>
 #include <types.h>
 
+/*
+ * the kernel half spans [CONFIG_VM_SPLIT, 4GiB) & is laid out in
+ * proportion to its size; it must be at least 1GiB.
+ * a split read back at run time (CONFIG_VM_SPLIT_GENERIC) is laid out
+ * as 2G/2G.
+ */
+#ifdef CONFIG_VM_SPLIT
+#if (CONFIG_VM_SPLIT) == 0 || (CONFIG_VM_SPLIT) > 0xC0000000
+#error "CONFIG_VM_SPLIT must leave a kernel half of at least 1GiB"
+#endif
+#define MLAY_KERN_SZ		(0x0U - (CONFIG_VM_SPLIT))
+#else
+#define MLAY_KERN_SZ		0x80000000U
+#endif
+
+/*
+ * all ram from kp_start is mapped linearly at kv_start (the kernel image
+ * being the start of it), up to MLAY_LINEAR_MAX_SZ (three quarters of
+ * the kernel half); the remainder is left for other mappings.
+ */
+#define MLAY_LINEAR_MAX_SZ	((MLAY_KERN_SZ >> 2) * 3)
+#define MLAY_SECT_SZ		0x100000
+
+/*
+ * the kernel vmalloc & ioremap range directly follows the linear map;
+ * the final 16MiB of the address space is left for the vectors.
+ */
+#define MLAY_VECTORS_SZ		0x1000000
+#define MLAY_VMALLOC_SZ		((MLAY_KERN_SZ >> 2) - MLAY_VECTORS_SZ)
+
+#define __pa(x)			kvm_to_phy((addr_t)(x))
+#define __va(x)			phy_to_kvm((addr_t)(x))
+
 /* kernel.ld */
 extern addr_t kp_start;		/* kernel physical start	*/
 extern addr_t kv_start; 	/* kernel virtual start		*/
@@ -20,7 +53,9 @@ extern addr_t hmi_bss_end;	/* hmi bss end			*/
 extern addr_t k_start;		/* kernel start			*/
 extern addr_t k_end;		/* kernel end			*/
 extern addr_t k_bss_start;	/* kernel bss start		*/
-extern addr_t k_bss_end;	/* kernel bss end		*/		
+extern addr_t k_bss_end;	/* kernel bss end		*/
+extern addr_t percpu_start;	/* per cpu template start	*/
+extern addr_t percpu_end;	/* per cpu template end		*/		
 
 /**
  * mlay_get_kern_phy_start
@@ -45,6 +80,26 @@ inline addr_t mlay_get_kern_virt_start() {
     return (addr_t)&kv_start;
 }
 
+/**
+ * mlay_get_vmalloc_start
+ * 
+ * returns the virtual start address of the vmalloc & ioremap range
+ * @return starting virtual address of vmalloc range
+ **/
+inline addr_t mlay_get_vmalloc_start() {
+    return (addr_t)&kv_start + MLAY_LINEAR_MAX_SZ;
+}
+
+/**
+ * mlay_get_vmalloc_end
+ * 
+ * returns the virtual address past the end of the vmalloc & ioremap range
+ * @return ending virtual address of vmalloc range
+ **/
+inline addr_t mlay_get_vmalloc_end() {
+    return mlay_get_vmalloc_start() + MLAY_VMALLOC_SZ;
+}
+
 /**
  * mlay_get_kern_stack
  * 
@@ -67,6 +122,18 @@ inline addr_t mlay_get_kern_pgd() {
     return (addr_t)&k_pgd;
 }
 
+/**
+ * mlay_get_boot_pgd
+ * 
+ * returns the physical address of the boot identity page directory;
+ * the user (ttbr0) half of k_pgd, which maps low memory 1:1 for the
+ * mmu to be enabled from (see vexpress_boot_init).
+ * @return boot identity page directory
+ **/
+inline addr_t mlay_get_boot_pgd() {
+    return (addr_t)&k_pgd;
+}
+
 /**
  * mlay_get_lmi_start
  * 
@@ -193,32 +260,53 @@ inline size_t mlay_get_kern_bss_region_sz() {
  * kvm_to_phy
  * Kernel Virtual Memory to Physical
  * 
- * converts a kernel virtual address to it's corresponding physical
- * address.
- * NOTE:  this is only useful in the context of initialization.
+ * converts an address within the kernel linear map to it's corresponding
+ * physical address (see __pa).
  * 
  * @address	virtual address to convert
  * @return	physical address
  **/
 inline addr_t kvm_to_phy(addr_t address) {
-    return ((address & ~mlay_get_kern_virt_start()) |
-	mlay_get_kern_phy_start());
+    return (address - mlay_get_kern_virt_start()) + mlay_get_kern_phy_start();
 }
 
 /**
  * phy_to_kvm
  * Physical to Kernel Virtual Memory
  * 
- * converts a kernel physical address to it's corresponding virtual 
- * address.
- * NOTE:  this is only useful in the context of initialization.
+ * converts a physical address of ram to it's corresponding address
+ * within the kernel linear map (see __va).
  * 
  * @address	physical address to convert
  * @return	virtual address
  **/
 inline addr_t phy_to_kvm(addr_t address) {
-    return ((address & ~mlay_get_kern_phy_start()) |
-	mlay_get_kern_virt_start());
+    return (address - mlay_get_kern_phy_start()) + mlay_get_kern_virt_start();
+}
+
+/**
+ * mlay_clip_linear_reg
+ * 
+ * clips a physical region of ram to the portion covered
+ * by the kernel linear map.
+ * 
+ * @reg	physical region; updated in place (size 0 if not covered)
+ **/
+inline void mlay_clip_linear_reg(struct mm_reg *reg) {
+    addr_t start	= mlay_get_kern_phy_start();
+    addr_t end		= start + MLAY_LINEAR_MAX_SZ;
+    addr_t reg_end	= reg->base + reg->size;
+    
+    if (reg->base > start) {
+	start = reg->base;
+    }
+    
+    if (reg_end < end) {
+	end = reg_end;
+    }
+    
+    reg->base = start;
+    reg->size = (end > start) ? (end - start) : 0;
 }
 
 /* memlayout.c */
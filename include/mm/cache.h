@@ -0,0 +1,44 @@
+#ifndef CACHE_H
+#define CACHE_H
+#include <types.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * outer_cache_ops
+ * 
+ * defines the maintenance operations of an outer (i.e., level 2)
+ * cache controller.  all ranges are physical.
+ * 
+ * @clean_range		writes back dirty lines in range
+ * @inval_range		discards lines in range
+ * @clean_inval_range	writes back & discards lines in range
+ * @clean_inval_all	writes back & discards the whole cache
+ * @sync		drains the controller's buffers
+ * @disable		cleans, invalidates & disables the controller
+ **/
+struct outer_cache_ops {
+    void	(*clean_range)(addr_t phy_start, size_t size);
+    void	(*inval_range)(addr_t phy_start, size_t size);
+    void	(*clean_inval_range)(addr_t phy_start, size_t size);
+    void	(*clean_inval_all)(void);
+    void	(*sync)(void);
+    void	(*disable)(void);
+};
+
+/* cache.c */
+void dcache_clean_range(addr_t start, size_t size);
+void dcache_inval_range(addr_t start, size_t size);
+void dcache_clean_inval_range(addr_t start, size_t size);
+void icache_sync_range(addr_t start, size_t size);
+void dcache_flush_all(void);
+int outer_cache_register(const struct outer_cache_ops *ops);
+bool outer_cache_is_enabled(void);
+void outer_clean_range(addr_t phy_start, size_t size);
+void outer_inval_range(addr_t phy_start, size_t size);
+void outer_clean_inval_range(addr_t phy_start, size_t size);
+void outer_clean_inval_all(void);
+void outer_sync(void);
+void outer_disable(void);
+
+#endif
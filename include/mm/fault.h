@@ -0,0 +1,24 @@
+#ifndef FAULT_H
+#define FAULT_H
+#include <types.h>
+
+/* fault flags */
+#define MM_FAULT_WRITE	0x1	/* access was a write */
+#define MM_FAULT_EXEC	0x2	/* access was an instruction fetch */
+#define MM_FAULT_USER	0x4	/* access was made by user mode */
+#define MM_FAULT_PROT	0x8	/* a valid translation denied the access */
+
+/*
+ * resident pages mapped around a fault (see mm_handle_fault); a power of two
+ * whose window never crosses a page table (1MiB)
+ */
+#define MM_FAULT_AROUND_PAGES	16
+
+#if ((MM_FAULT_AROUND_PAGES * PG_SZ) > 0x100000)
+#error "MM_FAULT_AROUND_PAGES must not span more than a single page table"
+#endif
+
+/* fault.c */
+int mm_handle_fault(addr_t fault_addr, unsigned int flags);
+
+#endif
@@ -1,7 +1,9 @@
 #ifndef MMU_H
 #define MMU_H
 #include <mm/mm.h>
+#include <mm/tlb.h>
 #include <types.h>
+#include <stdbool.h>
 
 /**
  * mmu_acc_flags_t
@@ -40,7 +42,19 @@ struct mmu_entry {
     mmu_acc_flags_t	acc_flags;
 };
 
+/* mmu.c */
 int mmu_interface_enable(struct mm_resv_reg *pg_tbs);
+int mmu_set_user_page_dir(addr_t page_dir);
+int mmu_switch_vm_space(struct vm_space *prev, struct vm_space *next);
+int mmu_map_page(addr_t virt_addr, addr_t phy_addr, mmu_acc_flags_t acc_flags);
+int mmu_map_region(addr_t virt_addr, addr_t *phy_pages, int pg_cnt, mmu_acc_flags_t acc_flags);
+bool mmu_is_mapped(addr_t virt_addr);
+int mmu_remap_page(addr_t virt_addr, addr_t phy_addr, mmu_acc_flags_t acc_flags);
+int mmu_unshare_pgtb(addr_t virt_addr);
+int mmu_fork_user(addr_t pgd_addr);
+int mmu_unmap_page(addr_t virt_addr);
+int mmu_invalidate_page(addr_t virt_addr);
+int mmu_invalidate_region(addr_t virt_addr, int pg_cnt);
 
 #endif
 
@@ -0,0 +1,26 @@
+#ifndef PGTB_H
+#define PGTB_H
+#include <types.h>
+#include <stddef.h>
+
+/* largest number of frames held by the page table pool */
+#define PGTB_POOL_MAX_FRAMES	256
+
+/* freed tables cached per cpu before being returned to their frames */
+#define PGTB_QUICKLIST_MAX	16
+
+/* freed user page directories cached per cpu before being returned to the pmm */
+#define PGD_QUICKLIST_MAX	2
+
+/* pgtb.c */
+addr_t pgtb_alloc(void);
+void pgtb_free(addr_t pgtb_addr);
+void pgtb_free_bulk(addr_t *pgtbs, unsigned int cnt);
+void pgtb_get(addr_t pgtb_addr);
+unsigned int pgtb_get_refcnt(addr_t pgtb_addr);
+size_t pgtb_get_frame_cnt(void);
+void pgtb_trim(void);
+addr_t pgd_alloc(void);
+void pgd_free(addr_t pgd_addr);
+
+#endif
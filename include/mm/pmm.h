@@ -1,8 +1,10 @@
 #ifndef PMM_H
 #define PMM_H
 #include <util/bits.h>
+#include <mm/mm.h>
 #include <types.h>
 #include <stddef.h>
+#include <stdbool.h>
 
 #define PMM_ERR_NOT_ENOUGH_MEM	-1
 
@@ -15,6 +17,8 @@
 #define PG_USED			1
 #define PG_UNUSED		0
 #define PG_SZ			4096 /* 0x1000 */
+/* largest amount of memory tracked by the pmm bitmap */
+#define PMM_MAX_MEM		0x40000000
 
 struct mm_region {
 	addr_t		start;
@@ -74,6 +78,16 @@ inline unsigned int bitmap_oh_pg_cnt(size_t mem_sz) {
 	
     return ret >> DIV_PG;
 }
-int pmm_init_test(struct mm_region phy_mem, addr_t bm_phy_start, addr_t bm_vir_start, struct mm_region *used, int used_cnt);
+/* pmm.c */
+int pmm_init(struct mm_reg *mem_reg);
+int pmm_reserve_region(struct mm_reg *reg);
+addr_t pmm_alloc_page(void);
+addr_t pmm_alloc_pages(unsigned int pg_cnt, size_t align);
+void pmm_free_page(addr_t pg_addr);
+void pmm_free_pages(addr_t pg_addr, unsigned int pg_cnt);
+void pmm_page_get(addr_t pg_addr);
+void pmm_page_put(addr_t pg_addr);
+unsigned int pmm_get_page_refcnt(addr_t pg_addr);
+size_t pmm_get_free_pg_cnt(void);
 bool is_page_allocated(addr_t pg_addr);
 #endif
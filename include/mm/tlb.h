@@ -0,0 +1,49 @@
+#ifndef TLB_H
+#define TLB_H
+#include <mm/vma.h>
+#include <types.h>
+#include <stdbool.h>
+
+/* pages tracked individually by a batch; past this the entire tlb is flushed */
+#define TLB_BATCH_MAX_PAGES	32
+/* batches of at most this many pages are broadcast rather than sent as an ipi */
+#define TLB_BATCH_BCAST_PAGES	8
+/* page tables held by a batch until flushed */
+#define TLB_BATCH_MAX_PGTBS	8
+
+/**
+ * tlb_batch
+ * 
+ * gathers the invalidations of a single mmu operation so that they
+ * may be performed (and other cpus notified) once.
+ * 
+ * @space	address space the invalidated pages belong to (NULL if local only)
+ * @pages	pages to invalidate
+ * @pgtbs	page tables to return to the pool once flushed
+ * @pg_cnt	number of pages
+ * @pgtb_cnt	number of page tables
+ * @flush_all	too many pages were added; invalidate the entire tlb
+ **/
+struct tlb_batch {
+    struct vm_space	*space;
+    addr_t		pages[TLB_BATCH_MAX_PAGES];
+    addr_t		pgtbs[TLB_BATCH_MAX_PGTBS];
+    int			pg_cnt;
+    int			pgtb_cnt;
+    bool		flush_all;
+};
+
+extern struct vm_space kern_vm_space;
+
+/* tlb.c */
+void vm_space_enter(struct vm_space *space);
+void vm_space_leave(struct vm_space *space);
+struct vm_space *vm_space_get_current(void);
+void tlb_batch_init(struct tlb_batch *batch, struct vm_space *space);
+void tlb_batch_add_page(struct tlb_batch *batch, addr_t virt_addr);
+void tlb_batch_add_all(struct tlb_batch *batch);
+void tlb_batch_add_pgtb(struct tlb_batch *batch, addr_t virt_addr, addr_t pgtb_addr);
+void tlb_batch_flush(struct tlb_batch *batch);
+void tlb_shootdown_hand(void);
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef VMA_H
+#define VMA_H
+#include <arch/arch_smp.h>
+#include <util/rbtree.h>
+#include <types.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* vma flags */
+#define VMA_READ	0x1
+#define VMA_WRITE	0x2
+#define VMA_EXEC	0x4
+#define VMA_ANON	0x8
+#define VMA_PHYS	0x10	/* backed by resident, physically contiguous memory */
+
+/**
+ * vma
+ * 
+ * a virtual memory area; a page aligned range of an address space
+ * sharing the same access & backing.
+ * vmas are indexed by an interval tree (a red-black tree keyed by start);
+ * each node also describes the subtree beneath it so that lookups &
+ * searches for unmapped ranges are O(log n).
+ * 
+ * @start	base virtual address
+ * @end		virtual address past the last byte
+ * @flags	VMA_* flags
+ * @phy_base	physical address backing start (VMA_PHYS)
+ * @rb		node within vm_space->vmas
+ * @sub_start	lowest start within the subtree
+ * @sub_end	highest end within the subtree
+ * @sub_gap	largest unmapped range between vmas of the subtree
+ **/
+struct vma {
+    addr_t		start;
+    addr_t		end;
+    unsigned int	flags;
+    addr_t		phy_base;
+    struct rb_node	rb;
+    addr_t		sub_start;
+    addr_t		sub_end;
+    size_t		sub_gap;
+};
+
+/**
+ * vm_space
+ * 
+ * defines an address space & the cpus currently translating through it.
+ * the kernel space (kern_vm_space) is entered by each cpu as it comes online.
+ * 
+ * @pg_dir	physical address of the page directory (unused by the kernel space)
+ * @vmas	vmas of the space, indexed by address
+ * @cpu_active	per cpu flag; only ever written by the cpu it belongs to
+ **/
+struct vm_space {
+    addr_t		pg_dir;
+    struct rb_root	vmas;
+    volatile bool	cpu_active[NR_CPUS];
+};
+
+/**
+ * vma_allows
+ * 
+ * determines if a vma permits an access
+ * 
+ * @vma		vma
+ * @flags	VMA_READ, VMA_WRITE and/or VMA_EXEC
+ * @return true if permitted
+ **/
+inline bool vma_allows(struct vma *vma, unsigned int flags) {
+    return ((vma->flags & flags) == flags);
+}
+
+/**
+ * vma_first
+ * 
+ * @space	address space
+ * @return lowest vma of space or NULL if none
+ **/
+inline struct vma *vma_first(struct vm_space *space) {
+    struct rb_node *node = rb_first(&space->vmas);
+    
+    return (node != NULL) ? rb_entry(node, struct vma, rb) : NULL;
+}
+
+/**
+ * vma_next
+ * 
+ * @vma		vma
+ * @return next vma by address or NULL if last
+ **/
+inline struct vma *vma_next(struct vma *vma) {
+    struct rb_node *node = rb_next(&vma->rb);
+    
+    return (node != NULL) ? rb_entry(node, struct vma, rb) : NULL;
+}
+
+/* vma.c */
+void vma_space_init(struct vm_space *space);
+int vma_reserve(struct vm_space *space, addr_t start, size_t size, unsigned int flags);
+int vma_reserve_phys(struct vm_space *space, addr_t start, size_t size, unsigned int flags, addr_t phy_base);
+int vma_release(struct vm_space *space, addr_t start, size_t size);
+int vma_split(struct vm_space *space, struct vma *vma, addr_t addr);
+struct vma *vma_merge(struct vm_space *space, struct vma *vma);
+struct vma *vma_find(struct vm_space *space, addr_t virt_addr);
+int vma_find_gap(struct vm_space *space, size_t size, addr_t lo, addr_t hi, addr_t *start);
+void vma_clear(struct vm_space *space);
+
+/* vm_space.c */
+int vm_space_create(struct vm_space *space);
+int vm_space_destroy(struct vm_space *space);
+int vm_space_fork(struct vm_space *parent, struct vm_space *child);
+
+#endif
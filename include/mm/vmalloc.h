@@ -0,0 +1,16 @@
+#ifndef VMALLOC_H
+#define VMALLOC_H
+#include <types.h>
+#include <stddef.h>
+
+/* unmapped pages surrounding each vmalloc/ioremap region */
+#define VMALLOC_GUARD_SZ	PG_SZ
+
+/* vmalloc.c */
+void vmalloc_init(void);
+void *vmalloc(size_t size);
+void vfree(void *virt_addr);
+void *ioremap(addr_t phy_addr, size_t size);
+void iounmap(void *virt_addr);
+
+#endif
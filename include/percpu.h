@@ -0,0 +1,37 @@
+#ifndef PERCPU_H
+#define PERCPU_H
+#include <arch/arch_percpu.h>
+#include <arch/arch_smp.h>
+#include <types.h>
+
+/*
+ * per cpu variables are linked into the .data.percpu template, which
+ * percpu_init copies for each cpu.  a variable is never accessed
+ * directly, but through the offset of a cpu's copy from the template;
+ * the calling cpu's offset is held by the arch (arch_percpu_get_offset).
+ * each copy is cache line aligned & padded, so the data of different
+ * cpus never shares a line.
+ */
+
+/* largest per cpu template */
+#define PERCPU_AREA_SZ		0x1000
+
+#define DEFINE_PER_CPU(type, name)	__attribute__((section(".data.percpu"))) __typeof__(type) name
+#define DECLARE_PER_CPU(type, name)	extern __attribute__((section(".data.percpu"))) __typeof__(type) name
+
+/* pointer to a cpu's copy of var */
+#define per_cpu_ptr(var, cpu)		((__typeof__(&(var)))((addr_t)&(var) + percpu_offset[(cpu)]))
+/* a cpu's copy of var */
+#define per_cpu(var, cpu)		(*per_cpu_ptr(var, cpu))
+/* pointer to the calling cpu's copy of var */
+#define this_cpu_ptr(var)		((__typeof__(&(var)))((addr_t)&(var) + arch_percpu_get_offset()))
+/* the calling cpu's copy of var */
+#define this_cpu(var)			(*this_cpu_ptr(var))
+
+/* percpu.c */
+extern addr_t percpu_offset[NR_CPUS];
+
+int percpu_init(void);
+void percpu_cpu_init(unsigned int cpu);
+
+#endif
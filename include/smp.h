@@ -0,0 +1,32 @@
+#ifndef SMP_H
+#define SMP_H
+#include <arch/arch_smp.h>
+#include <types.h>
+#include <stdbool.h>
+
+/* spins waited for a released cpu to come online */
+#define SMP_BOOT_TIMEOUT	0x1000000
+
+/* smp.c */
+extern volatile bool smp_cpu_online[NR_CPUS];
+
+void smp_init(void);
+void smp_secondary_start(unsigned int cpu);
+void smp_idle(void);
+void smp_poll_ipis(void);
+unsigned int smp_get_online_mask(void);
+unsigned int smp_get_online_cnt(void);
+
+/**
+ * smp_cpu_is_online
+ * 
+ * determines if a cpu has come online.
+ * 
+ * @cpu	cpu id
+ * @return true if online
+ **/
+inline bool smp_cpu_is_online(unsigned int cpu) {
+    return (cpu < NR_CPUS && smp_cpu_online[cpu]);
+}
+
+#endif
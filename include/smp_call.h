@@ -0,0 +1,46 @@
+#ifndef SMP_CALL_H
+#define SMP_CALL_H
+#include <arch/arch_smp.h>
+#include <types.h>
+#include <stdbool.h>
+
+/*
+ * cross calls; a function is run upon other cpus from IPI_CALL_FUNC.
+ * each cpu has a lock-free queue of calls, pushed by any sender & taken
+ * whole by the cpu itself.  a sender only raises the sgi when it finds
+ * the queue empty, so the calls queued before the target gets to them
+ * are delivered by a single sgi, as is a call made upon several cpus.
+ * calls run with irqs masked, either from the irq handler or while the
+ * target waits upon a call of its own, and must be brief.
+ */
+
+/**
+ * smp_call
+ * 
+ * a call queued upon a cpu
+ * 
+ * @next	next call queued
+ * @func	function called
+ * @arg	argument passed to func
+ * @wait	true if the sender waits upon func returning
+ * @busy	set while queued (or running, if wait); the call mustn't
+ * 		be altered until it's cleared by the target
+ **/
+struct smp_call {
+    struct smp_call	*next;
+    void		(*func)(void *arg);
+    void		*arg;
+    bool		wait;
+    volatile bool	busy;
+};
+
+#define SMP_CALL_INIT(f, a)	{ .next = NULL, .func = (f), .arg = (a), .wait = false, .busy = false }
+
+/* smp_call.c */
+int smp_call_function_single(unsigned int cpu, void (*func)(void *arg), void *arg, bool wait);
+int smp_call_function_many(unsigned int cpu_mask, void (*func)(void *arg), void *arg, bool wait);
+int smp_call_function(void (*func)(void *arg), void *arg, bool wait);
+int smp_call_function_async(unsigned int cpu, struct smp_call *call);
+void smp_call_hand(void);
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef SMP_CALL_BENCH_H
+#define SMP_CALL_BENCH_H
+
+/* calls made upon each cpu per measurement */
+#define SMP_CALL_BENCH_ITER	256
+/* asynchronous calls outstanding at once */
+#define SMP_CALL_BENCH_BATCH	16
+
+/* smp_call_bench.c */
+void smp_call_bench(void);
+
+#endif
@@ -0,0 +1,183 @@
+#ifndef ATOMIC_H
+#define ATOMIC_H
+#include <types.h>
+#include <stdbool.h>
+
+/*
+ * atomic operations upon atomic_t, atomic64_t, bitmaps & words, inlined.
+ * operations returning a value are fully ordered; the _relaxed forms
+ * are unordered, _acquire forms are ordered before later accesses and
+ * _release forms after earlier accesses.
+ * operations returning nothing (atomic_add, atomic_set_bit, ...) are
+ * unordered.
+ */
+#if defined(ARCH_ARMV7)
+#include <arch/arm/armv7/armv7_atomic.h>
+#else
+#error "atomic operations aren't provided for this arch"
+#endif
+
+/**
+ * atomic_add
+ * 
+ * @i		addend
+ * @v		atomic
+ **/
+inline void atomic_add(int i, atomic_t *v) {
+    atomic_add_return_relaxed(i, v);
+}
+
+/**
+ * atomic_sub
+ * 
+ * @i		subtrahend
+ * @v		atomic
+ **/
+inline void atomic_sub(int i, atomic_t *v) {
+    atomic_add_return_relaxed(-i, v);
+}
+
+/**
+ * atomic_inc
+ * 
+ * @v		atomic
+ **/
+inline void atomic_inc(atomic_t *v) {
+    atomic_add_return_relaxed(1, v);
+}
+
+/**
+ * atomic_dec
+ * 
+ * @v		atomic
+ **/
+inline void atomic_dec(atomic_t *v) {
+    atomic_add_return_relaxed(-1, v);
+}
+
+/**
+ * atomic_sub_return
+ * 
+ * @i		subtrahend
+ * @v		atomic
+ * @return new value
+ **/
+inline int atomic_sub_return(int i, atomic_t *v) {
+    return atomic_add_return(-i, v);
+}
+
+/**
+ * atomic_inc_return
+ * 
+ * @v		atomic
+ * @return new value
+ **/
+inline int atomic_inc_return(atomic_t *v) {
+    return atomic_add_return(1, v);
+}
+
+/**
+ * atomic_dec_return
+ * 
+ * @v		atomic
+ * @return new value
+ **/
+inline int atomic_dec_return(atomic_t *v) {
+    return atomic_add_return(-1, v);
+}
+
+/**
+ * atomic_sub_and_test
+ * 
+ * @i		subtrahend
+ * @v		atomic
+ * @return true if the new value is 0
+ **/
+inline bool atomic_sub_and_test(int i, atomic_t *v) {
+    return (atomic_add_return(-i, v) == 0);
+}
+
+/**
+ * atomic_inc_and_test
+ * 
+ * @v		atomic
+ * @return true if the new value is 0
+ **/
+inline bool atomic_inc_and_test(atomic_t *v) {
+    return (atomic_add_return(1, v) == 0);
+}
+
+/**
+ * atomic_dec_and_test
+ * 
+ * i.e., dropping the last reference.
+ * 
+ * @v		atomic
+ * @return true if the new value is 0
+ **/
+inline bool atomic_dec_and_test(atomic_t *v) {
+    return (atomic_add_return(-1, v) == 0);
+}
+
+/**
+ * atomic64_add
+ * 
+ * @i		addend
+ * @v		atomic
+ **/
+inline void atomic64_add(long long i, atomic64_t *v) {
+    atomic64_add_return_relaxed(i, v);
+}
+
+/**
+ * atomic64_inc_return
+ * 
+ * @v		atomic
+ * @return new value
+ **/
+inline long long atomic64_inc_return(atomic64_t *v) {
+    return atomic64_add_return(1, v);
+}
+
+/**
+ * atomic64_dec_and_test
+ * 
+ * @v		atomic
+ * @return true if the new value is 0
+ **/
+inline bool atomic64_dec_and_test(atomic64_t *v) {
+    return (atomic64_add_return(-1, v) == 0);
+}
+
+/**
+ * atomic_set_bit
+ * 
+ * @nr		bit number, from the first word of addr
+ * @addr	bitmap
+ **/
+inline void atomic_set_bit(unsigned int nr, volatile unsigned int *addr) {
+    atomic_test_and_set_bit_relaxed(nr, addr);
+}
+
+/**
+ * atomic_clear_bit
+ * 
+ * @nr		bit number, from the first word of addr
+ * @addr	bitmap
+ **/
+inline void atomic_clear_bit(unsigned int nr, volatile unsigned int *addr) {
+    atomic_test_and_clear_bit_relaxed(nr, addr);
+}
+
+/**
+ * atomic_test_bit
+ * 
+ * @nr		bit number, from the first word of addr
+ * @addr	bitmap
+ * @return true if set
+ **/
+inline bool atomic_test_bit(unsigned int nr, volatile unsigned int *addr) {
+    return ((addr[nr >> ATOMIC_BITS_SHIFT] >> (nr & ATOMIC_BITS_MASK)) & 1);
+}
+
+#endif
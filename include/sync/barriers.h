@@ -1,8 +1,24 @@
 #ifndef BARRIERS_H
 #define BARRIERS_H
 
-extern void arch_dsb(void);
+/*
+ * memory barriers, inlined.
+ * arch_dsb/arch_dmb/arch_isb apply to the full system (devices
+ * included); the _ish variants only order accesses between cpus
+ * (the inner shareable domain) & _ishst variants only order stores.
+ */
+#if defined(ARCH_ARMV7)
+#include <arch/arm/armv7/armv7.h>
 
-extern void arch_dmb(void);
+#define arch_dsb()		dsb()
+#define arch_dmb()		dmb()
+#define arch_isb()		isb()
+#define arch_dsb_ish()		dsb_ish()
+#define arch_dmb_ish()		dmb_ish()
+#define arch_dsb_ishst()	dsb_ishst()
+#define arch_dmb_ishst()	dmb_ishst()
+#else
+#error "barriers aren't provided for this arch"
+#endif
 
 #endif
@@ -0,0 +1,13 @@
+#ifndef LOCK_BENCH_H
+#define LOCK_BENCH_H
+
+/* acquisitions made by each cpu per lock */
+#define LOCK_BENCH_ITER		1024
+/* cache lines written by each holder */
+#define LOCK_BENCH_LINES	8
+
+/* lock_bench.c */
+void lock_bench(void);
+void lock_bench_join(void);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef LOCKSTAT_H
+#define LOCKSTAT_H
+#include <types.h>
+#include <stdbool.h>
+
+/* locks reported by the boot-time dump */
+#define LOCKSTAT_DUMP_CNT	8
+
+#define LOCKSTAT_STR(x)		#x
+#define LOCKSTAT_LINE(x)	LOCKSTAT_STR(x)
+/* names a lock by where it's initialized (see SPINLOCK_INIT, RWLOCK_INIT) */
+#define LOCKSTAT_INIT		{ .name = __FILE__ ":" LOCKSTAT_LINE(__LINE__) }
+
+/**
+ * lockstat
+ * 
+ * contention statistics of a spinlock_t (or the writers of a rwlock_t),
+ * in cycles of the cpu's cycle counter; updated by the holder.
+ * a lock is registered upon its first acquisition & must then never
+ * be freed (every kernel lock is static).
+ * 
+ * @next	next registered lock
+ * @name	where the lock was initialized (NULL if at run time)
+ * @registered	true once linked into the registered locks
+ * @acquired	count of acquisitions
+ * @contended	count of acquisitions that had to wait
+ * @wait_total	cycles waited
+ * @wait_max	longest wait
+ * @hold_total	cycles held
+ * @hold_max	longest hold
+ * @hold_start	cycle count at the current acquisition
+ **/
+struct lockstat {
+    struct lockstat	*next;
+    const char		*name;
+    bool		registered;
+    unsigned int	acquired;
+    unsigned int	contended;
+    unsigned long long	wait_total;
+    unsigned int	wait_max;
+    unsigned long long	hold_total;
+    unsigned int	hold_max;
+    unsigned int	hold_start;
+};
+
+/* lockstat.c */
+void lockstat_acquired(struct lockstat *stat, unsigned int start, bool contended);
+void lockstat_released(struct lockstat *stat);
+void lockstat_cpu_init(void);
+void lockstat_dump(unsigned int cnt);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef MCS_LOCK_H
+#define MCS_LOCK_H
+#include <arch/arch_smp.h>
+#include <types.h>
+#include <stdbool.h>
+
+/* mcs locks a cpu may hold (or wait upon) at once, irqs included */
+#define MCS_NODE_CNT		4
+
+#define MCS_LOCK_INIT		{ .tail = 0x0 }
+
+/**
+ * mcs_node
+ * 
+ * queue entry of a cpu holding or waiting upon an mcs lock; each is
+ * within its own cache line, so waiters spin only upon their own line.
+ * 
+ * @next	next waiter, set by it once queued
+ * @locked	set by the previous holder as the lock is handed over
+ **/
+struct mcs_node {
+    struct mcs_node * volatile	next;
+    volatile bool		locked;
+} __cacheline_aligned;
+
+/**
+ * mcs_lock_t
+ * 
+ * queued (mcs) lock; cpus are granted the lock in the order they
+ * queued, each handing it directly to the next.
+ * unlike spinlock_t, waiters don't contend upon the lock's line, which
+ * suits locks whose holders touch many lines.
+ * 
+ * @tail	last queued mcs_node, 0x0 if released
+ **/
+typedef struct mcs_lock {
+    volatile addr_t	tail;
+} mcs_lock_t;
+
+/* mcs_lock.c */
+void mcs_lock_init(mcs_lock_t *lock);
+void mcs_lock(mcs_lock_t *lock);
+bool mcs_trylock(mcs_lock_t *lock);
+void mcs_unlock(mcs_lock_t *lock);
+unsigned int mcs_lock_irqsave(mcs_lock_t *lock);
+void mcs_unlock_irqrestore(mcs_lock_t *lock, unsigned int flags);
+
+/**
+ * mcs_is_locked
+ * 
+ * determines if a lock is held (or waited upon).
+ * 
+ * @lock	lock
+ * @return true if held
+ **/
+inline bool mcs_is_locked(mcs_lock_t *lock) {
+    return (lock->tail != 0x0);
+}
+
+#endif
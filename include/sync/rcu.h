@@ -0,0 +1,80 @@
+#ifndef RCU_H
+#define RCU_H
+#include <sync/barriers.h>
+#include <types.h>
+#include <stdbool.h>
+
+/*
+ * read-copy-update; readers take no lock & execute no atomics, while
+ * writers publish a new version (rcu_assign_pointer) & defer freeing
+ * the old one until every cpu has passed through a quiescent state,
+ * where it can no longer hold a reference obtained beforehand.
+ * the kernel isn't preemptible, so a cpu passes through a quiescent
+ * state only when idle (or, once there is one, switching context);
+ * read-side critical sections therefore need only keep the compiler
+ * from moving accesses out of them & mustn't sleep or idle.
+ */
+
+/**
+ * rcu_head
+ * 
+ * embedded within an object whose reclamation is deferred (see call_rcu)
+ * 
+ * @next	next queued callback
+ * @func	callback, invoked after a grace period
+ **/
+struct rcu_head {
+    struct rcu_head	*next;
+    void		(*func)(struct rcu_head *head);
+};
+
+/**
+ * rcu_dereference
+ * 
+ * loads a pointer published by rcu_assign_pointer, once; the
+ * address dependency orders the accesses made through it.
+ * 
+ * @p		pointer
+ * @return value of p
+ **/
+#define rcu_dereference(p)	(*(volatile __typeof__(p) *)&(p))
+
+/**
+ * rcu_assign_pointer
+ * 
+ * publishes v through p; the initialization of *v is visible to
+ * any cpu seeing v.
+ * 
+ * @p		pointer
+ * @v		new value
+ **/
+#define rcu_assign_pointer(p, v) do {			\
+    arch_dmb_ishst();					\
+    *(volatile __typeof__(p) *)&(p) = (v);		\
+} while (0)
+
+/* rcu.c */
+void rcu_init(void);
+void call_rcu(struct rcu_head *head, void (*func)(struct rcu_head *head));
+void synchronize_rcu(void);
+void rcu_quiescent_state(void);
+
+/**
+ * rcu_read_lock
+ * 
+ * begins a read-side critical section; they may nest.
+ **/
+inline void rcu_read_lock(void) {
+    asm volatile("" : : : "memory");
+}
+
+/**
+ * rcu_read_unlock
+ * 
+ * ends a read-side critical section.
+ **/
+inline void rcu_read_unlock(void) {
+    asm volatile("" : : : "memory");
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef RWLOCK_H
+#define RWLOCK_H
+#include <sync/lockstat.h>
+#include <types.h>
+#include <stdbool.h>
+
+/* set in cnt once a writer holds (or waits upon) the lock */
+#define RWLOCK_WRITER		0x80000000
+
+#ifdef CONFIG_LOCKSTAT
+#define RWLOCK_INIT		{ .cnt = 0, .stat = LOCKSTAT_INIT }
+#else
+#define RWLOCK_INIT		{ .cnt = 0 }
+#endif
+
+/**
+ * rwlock_t
+ * 
+ * reader-writer spinlock; readers share the lock, writers hold it
+ * alone.  a waiting writer holds off new readers, so writers aren't
+ * starved by a stream of readers.
+ * 
+ * @cnt	readers holding the lock, with RWLOCK_WRITER
+ * @stat	contention statistics of writers (CONFIG_LOCKSTAT); readers
+ * 		hold the lock together, so aren't recorded
+ **/
+typedef struct rwlock {
+    volatile addr_t	cnt;
+#ifdef CONFIG_LOCKSTAT
+    struct lockstat	stat;
+#endif
+} rwlock_t;
+
+/* rwlock.c */
+void rwlock_init(rwlock_t *lock);
+void read_lock(rwlock_t *lock);
+void read_unlock(rwlock_t *lock);
+void write_lock(rwlock_t *lock);
+void write_unlock(rwlock_t *lock);
+unsigned int read_lock_irqsave(rwlock_t *lock);
+void read_unlock_irqrestore(rwlock_t *lock, unsigned int flags);
+unsigned int write_lock_irqsave(rwlock_t *lock);
+void write_unlock_irqrestore(rwlock_t *lock, unsigned int flags);
+
+#endif
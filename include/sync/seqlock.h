@@ -0,0 +1,69 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+#include <sync/barriers.h>
+#include <sync/spinlock.h>
+#include <types.h>
+#include <stdbool.h>
+
+#define SEQLOCK_INIT		{ .seq = 0, .lock = SPINLOCK_INIT }
+
+/**
+ * seqlock_t
+ * 
+ * sequence lock; writers are serialized by lock & bump seq on either
+ * side of their update, while readers take no lock at all, retrying
+ * if seq changed (or was odd) over their read.
+ * readers mustn't follow pointers that a writer may free.
+ * 
+ * @seq		generation; odd while a write is in progress
+ * @lock	serializes writers
+ **/
+typedef struct seqlock {
+    volatile unsigned int	seq;
+    spinlock_t			lock;
+} seqlock_t;
+
+/* seqlock.c */
+void seqlock_init(seqlock_t *sl);
+void write_seqlock(seqlock_t *sl);
+void write_sequnlock(seqlock_t *sl);
+unsigned int write_seqlock_irqsave(seqlock_t *sl);
+void write_sequnlock_irqrestore(seqlock_t *sl, unsigned int flags);
+
+/**
+ * read_seqbegin
+ * 
+ * begins a read, waiting out a write in progress.
+ * 
+ * @sl		lock
+ * @return generation, for read_seqretry
+ **/
+inline unsigned int read_seqbegin(seqlock_t *sl) {
+    unsigned int seq = sl->seq;
+    
+    while (seq & 1) {
+	seq = sl->seq;
+    }
+    
+    arch_dmb();
+    
+    return seq;
+}
+
+/**
+ * read_seqretry
+ * 
+ * ends a read; the data read must be discarded (and read again)
+ * if a write overlapped it.
+ * 
+ * @sl		lock
+ * @seq		generation returned by read_seqbegin
+ * @return true if the read must be retried
+ **/
+inline bool read_seqretry(seqlock_t *sl, unsigned int seq) {
+    arch_dmb();
+    
+    return (sl->seq != seq);
+}
+
+#endif
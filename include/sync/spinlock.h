@@ -1,9 +1,64 @@
 #ifndef SPINLOCK_H
 #define SPINLOCK_H
+#include <sync/lockstat.h>
+#include <types.h>
+#include <stdbool.h>
 
-typedef unsigned int spinlock_t;
+/* the next ticket is held in the upper half of tickets */
+#define SPIN_TICKET_SHIFT	16
+#define SPIN_TICKET_MASK	0xFFFF
 
-#define SPINLOCK_UNLOCKED	0
-#define SPINLOCK_LOCKED		1
+#ifdef CONFIG_LOCKSTAT
+#define SPINLOCK_INIT		{ .tickets = 0, .stat = LOCKSTAT_INIT }
+#else
+#define SPINLOCK_INIT		{ .tickets = 0 }
+#endif
+
+/**
+ * spinlock_t
+ * 
+ * ticket lock; cpus take the next ticket & are granted the lock in
+ * the order taken, once owner reaches their ticket.
+ * only the holder writes owner (little endian; owner is the lower half).
+ * 
+ * @tickets	next & owner as a single word
+ * @owner	ticket being served
+ * @next	next ticket to be taken
+ * @stat	contention statistics (CONFIG_LOCKSTAT)
+ **/
+typedef struct spinlock {
+    union {
+	volatile uint32_t	tickets;
+	struct {
+	    volatile uint16_t	owner;
+	    volatile uint16_t	next;
+	};
+    };
+#ifdef CONFIG_LOCKSTAT
+    struct lockstat		stat;
+#endif
+} spinlock_t;
+
+/* spinlock.c */
+void spin_lock_init(spinlock_t *lock);
+void spin_lock(spinlock_t *lock);
+bool spin_trylock(spinlock_t *lock);
+void spin_unlock(spinlock_t *lock);
+unsigned int spin_lock_irqsave(spinlock_t *lock);
+void spin_unlock_irqrestore(spinlock_t *lock, unsigned int flags);
+
+/**
+ * spin_is_locked
+ * 
+ * determines if a lock is held (or waited upon).
+ * 
+ * @lock	lock
+ * @return true if held
+ **/
+inline bool spin_is_locked(spinlock_t *lock) {
+    uint32_t tickets = lock->tickets;
+    
+    return ((tickets >> SPIN_TICKET_SHIFT) != (tickets & SPIN_TICKET_MASK));
+}
 
 #endif
@@ -96,6 +96,35 @@ inline bool is_power_of_two(unsigned int x) {
     return ((x != 0) && !(x & (x - 1)));
 }
 
+/**
+ * udiv32
+ * Unsigned Divide 32bit
+ * 
+ * divides n by d using shift & subtract; the targets we support
+ * lack a hardware divider (and we don't link libgcc).
+ * 
+ * @n		dividend
+ * @d		divisor
+ * @return n / d or 0 if d == 0
+ **/
+inline uint32_t udiv32(uint32_t n, uint32_t d) {
+    uint32_t ret = 0;
+    uint32_t rem = 0;
+    
+    if (d != 0) {
+	for (int i = 31; i >= 0; i--) {
+	    rem = (rem << 1) | ((n >> i) & 0x1);
+	    
+	    if (rem >= d) {
+		rem -= d;
+		ret |= (1U << i);
+	    }
+	}
+    }
+    
+    return ret;
+}
+
 /**
  * is_little_endian
  * 
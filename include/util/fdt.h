@@ -90,6 +90,8 @@ inline bool is_using_fdt(addr_t fdt_base) {
 struct fdt_property *fdt_get_property(addr_t fdt_base, struct fdt_node *node, const char *property);
 struct fdt_property *fdt_get_next_property(struct fdt_property *prop);
 struct fdt_node *fdt_get_node(const char *name, addr_t fdt_base);
+struct fdt_node *fdt_get_compatible_node(const char *compat, addr_t fdt_base);
+bool fdt_is_compatible(addr_t fdt_base, struct fdt_node *node, const char *compat);
 struct fdt_node *fdt_get_next_node(struct fdt_node *node);
 struct fdt_node *fdt_get_root_node(addr_t fdt_base);
 fdt32_t fdt_get_cell_size(addr_t fdt_base, struct fdt_node *node);
@@ -0,0 +1,105 @@
+#ifndef RBTREE_H
+#define RBTREE_H
+#include <stddef.h>
+#include <stdbool.h>
+
+#define RB_RED		0
+#define RB_BLACK	1
+
+/**
+ * rb_entry
+ * 
+ * returns the structure an rb_node is embedded within
+ * 
+ * @ptr		rb_node
+ * @type	type of the containing structure
+ * @member	name of the rb_node within type
+ **/
+#define rb_entry(ptr, type, member) \
+    ((type *)((char *)(ptr) - offsetof(type, member)))
+
+/**
+ * rb_node
+ * 
+ * a node of a red-black tree; embedded within the structure
+ * being indexed (see rb_entry).
+ * 
+ * @parent	parent node or NULL if root
+ * @left	left child
+ * @right	right child
+ * @color	RB_RED or RB_BLACK
+ **/
+struct rb_node {
+    struct rb_node	*parent;
+    struct rb_node	*left;
+    struct rb_node	*right;
+    int			color;
+};
+
+/**
+ * rb_root
+ * 
+ * a red-black tree.
+ * update, when non NULL, is invoked on a node whenever its children
+ * (or the nodes beneath them) change; it allows per subtree values
+ * to be kept (i.e., interval trees), recomputed from the node & its children.
+ * 
+ * @node	root node or NULL if empty
+ * @update	augmentation callback
+ **/
+struct rb_root {
+    struct rb_node	*node;
+    void		(*update)(struct rb_node *node);
+};
+
+/**
+ * rb_init
+ * 
+ * initializes an empty tree
+ * 
+ * @root	tree
+ * @update	augmentation callback (or NULL)
+ **/
+inline void rb_init(struct rb_root *root, void (*update)(struct rb_node *node)) {
+    root->node		= NULL;
+    root->update	= update;
+}
+
+/**
+ * rb_empty
+ * 
+ * @root	tree
+ * @return true if the tree has no nodes
+ **/
+inline bool rb_empty(struct rb_root *root) {
+    return (root->node == NULL);
+}
+
+/**
+ * rb_link_node
+ * 
+ * links node into the position found by the caller's search;
+ * rb_insert_color must follow to rebalance the tree.
+ * 
+ * @node	node to link
+ * @parent	parent of the position
+ * @link	child pointer of parent (or root->node) to link into
+ **/
+inline void rb_link_node(struct rb_node *node, struct rb_node *parent, struct rb_node **link) {
+    node->parent	= parent;
+    node->left		= NULL;
+    node->right		= NULL;
+    node->color		= RB_RED;
+    *link		= node;
+}
+
+/* rbtree.c */
+void rb_insert_color(struct rb_root *root, struct rb_node *node);
+void rb_erase(struct rb_root *root, struct rb_node *node);
+void rb_propagate(struct rb_root *root, struct rb_node *node);
+struct rb_node *rb_first(struct rb_root *root);
+struct rb_node *rb_last(struct rb_root *root);
+struct rb_node *rb_next(struct rb_node *node);
+struct rb_node *rb_prev(struct rb_node *node);
+
+#endif
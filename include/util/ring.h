@@ -0,0 +1,155 @@
+#ifndef RING_H
+#define RING_H
+#include <arch/arch_smp.h>
+#include <types.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * bounded, lock-free rings of pointers.
+ * the size is a power of 2 & the indices run freely (wrapping with
+ * addr_t), a slot being found by masking; head & tail are each kept
+ * on a cache line of their own, so producers & consumers only share
+ * the lines of the slots they hand over.
+ * 
+ * ring_spsc allows a single producer & a single consumer, which may
+ * run concurrently on different cpus; ring_mpmc allows any number of
+ * either, producers (or consumers) reserving slots by cmpxchg upon
+ * their head & publishing them, in order, through their tail.
+ * neither masks irqs; a ring used from an irq handler & the code it
+ * interrupts must be protected by the caller.
+ */
+
+/**
+ * ring_spsc
+ * 
+ * single producer, single consumer ring.
+ * each side caches the other's index, only reading it again when
+ * the cached value shows the ring full (or empty).
+ * 
+ * @mask	size - 1
+ * @slots	storage of size pointers
+ * @head	index of the next slot written (producer)
+ * @tail_cache	producer's copy of tail
+ * @tail	index of the next slot read (consumer)
+ * @head_cache	consumer's copy of head
+ **/
+struct ring_spsc {
+    addr_t		mask;
+    void		**slots;
+
+    volatile addr_t	head __cacheline_aligned;
+    addr_t		tail_cache;
+
+    volatile addr_t	tail __cacheline_aligned;
+    addr_t		head_cache;
+} __cacheline_aligned;
+
+/**
+ * ring_mpmc_idx
+ * 
+ * one side of a ring_mpmc
+ * 
+ * @head	index of the next slot to be reserved
+ * @tail	index up to which reservations have completed
+ **/
+struct ring_mpmc_idx {
+    volatile addr_t	head;
+    volatile addr_t	tail;
+} __cacheline_aligned;
+
+/**
+ * ring_mpmc
+ * 
+ * multiple producer, multiple consumer ring.
+ * 
+ * @mask	size - 1
+ * @slots	storage of size pointers
+ * @prod	producers' indices
+ * @cons	consumers' indices
+ **/
+struct ring_mpmc {
+    addr_t		mask;
+    void		**slots;
+
+    struct ring_mpmc_idx	prod;
+    struct ring_mpmc_idx	cons;
+} __cacheline_aligned;
+
+/* ring.c */
+int ring_spsc_init(struct ring_spsc *ring, void **slots, size_t size);
+size_t ring_spsc_enqueue_batch(struct ring_spsc *ring, void * const *objs, size_t cnt);
+size_t ring_spsc_dequeue_batch(struct ring_spsc *ring, void **objs, size_t cnt);
+int ring_mpmc_init(struct ring_mpmc *ring, void **slots, size_t size);
+size_t ring_mpmc_enqueue_batch(struct ring_mpmc *ring, void * const *objs, size_t cnt);
+size_t ring_mpmc_dequeue_batch(struct ring_mpmc *ring, void **objs, size_t cnt);
+
+/**
+ * ring_spsc_enqueue
+ * 
+ * @ring	ring
+ * @obj		pointer to enqueue
+ * @return true if enqueued, false if the ring was full
+ **/
+inline bool ring_spsc_enqueue(struct ring_spsc *ring, void *obj) {
+    return (ring_spsc_enqueue_batch(ring, &obj, 1) == 1);
+}
+
+/**
+ * ring_spsc_dequeue
+ * 
+ * @ring	ring
+ * @obj		receives the pointer dequeued
+ * @return true if dequeued, false if the ring was empty
+ **/
+inline bool ring_spsc_dequeue(struct ring_spsc *ring, void **obj) {
+    return (ring_spsc_dequeue_batch(ring, obj, 1) == 1);
+}
+
+/**
+ * ring_spsc_count
+ * 
+ * a snapshot only, if either side is running.
+ * 
+ * @ring	ring
+ * @return count of pointers held
+ **/
+inline size_t ring_spsc_count(struct ring_spsc *ring) {
+    return (size_t)(ring->head - ring->tail);
+}
+
+/**
+ * ring_mpmc_enqueue
+ * 
+ * @ring	ring
+ * @obj		pointer to enqueue
+ * @return true if enqueued, false if the ring was full
+ **/
+inline bool ring_mpmc_enqueue(struct ring_mpmc *ring, void *obj) {
+    return (ring_mpmc_enqueue_batch(ring, &obj, 1) == 1);
+}
+
+/**
+ * ring_mpmc_dequeue
+ * 
+ * @ring	ring
+ * @obj		receives the pointer dequeued
+ * @return true if dequeued, false if the ring was empty
+ **/
+inline bool ring_mpmc_dequeue(struct ring_mpmc *ring, void **obj) {
+    return (ring_mpmc_dequeue_batch(ring, obj, 1) == 1);
+}
+
+/**
+ * ring_mpmc_count
+ * 
+ * a snapshot only, if either side is running.
+ * 
+ * @ring	ring
+ * @return count of pointers held
+ **/
+inline size_t ring_mpmc_count(struct ring_mpmc *ring) {
+    return (size_t)(ring->prod.tail - ring->cons.tail);
+}
+
+#endif
@@ -19,17 +19,23 @@
  * THE SOFTWARE.
  */
 
-.global arch_dsb
-arch_dsb:
-    dsb
-    bx lr
-
-.global arch_dmb
-arch_dmb:
-    dmb
-    bx lr
-
 .global arch_set_sp
 arch_set_sp:
     mov r0, sp
     bx lr
+
+/*
+ * armv7_set_mode_sp
+ *
+ * sets the banked sp of a privileged mode (ARMV7_CPSR_MODE_xxx)
+ * r0 = mode, r1 = sp
+ */
+.global armv7_set_mode_sp
+armv7_set_mode_sp:
+    mrs r2, cpsr
+    bic r3, r2, #0x1F
+    orr r3, r3, r0
+    msr cpsr_c, r3
+    mov sp, r1
+    msr cpsr_c, r2
+    bx lr
@@ -0,0 +1,46 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * armv7_arch_cache.c provides the arch_cache interface.
+ */
+#include <arch/arm/armv7/armv7_cache.h>
+#include <arch/arch_cache.h>
+#include <types.h>
+#include <stddef.h>
+
+void arch_dcache_clean_range(addr_t start, size_t size) {
+    armv7_dcache_range(start, size, ARMV7_CACHE_CLEAN);
+}
+
+void arch_dcache_inval_range(addr_t start, size_t size) {
+    armv7_dcache_range(start, size, ARMV7_CACHE_INVAL);
+}
+
+void arch_dcache_clean_inval_range(addr_t start, size_t size) {
+    armv7_dcache_range(start, size, ARMV7_CACHE_CLEAN_INVAL);
+}
+
+void arch_icache_sync_range(addr_t start, size_t size) {
+    armv7_icache_sync_range(start, size);
+}
+
+void arch_dcache_flush_all(void) {
+    armv7_dcache_clean_inval_all();
+}
@@ -0,0 +1,378 @@
+/* Copyright (C) 2016 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <arch/arm/armv7/armv7.h>
+#include <arch/arm/armv7/armv7_cache.h>
+#include <arch/arm/armv7/armv7_syscntl.h>
+#include <types.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define CSSELR_LEVEL_SHIFT	1
+#define CLIDR_CTYPE_BITS	3
+#define LINE_SZ_BASE_SHIFT	4
+
+/* helper functions */
+static void armv7_dcache_all(armv7_cache_op op);
+static void armv7_dcache_level(unsigned int level, armv7_cache_op op);
+static void armv7_dcache_sw(unsigned int set_way, armv7_cache_op op);
+static void armv7_dcache_mva(addr_t addr, armv7_cache_op op);
+static void armv7_dcache_geometry(void);
+
+/* level 1 data cache geometry; filled in on first use */
+static size_t l1d_line_sz	= 0;
+static size_t l1d_sz		= 0;
+
+/**
+ * armv7_dcache_inval_all
+ * 
+ * invalidates every data/unified cache level (up to the level
+ * of coherency) by set/way.
+ * this discards any dirty lines and is only intended for
+ * bring-up, prior to the data cache being enabled.
+ **/
+void armv7_dcache_inval_all(void) {
+    armv7_dcache_all(ARMV7_CACHE_INVAL);
+}
+
+/**
+ * armv7_dcache_clean_all
+ * 
+ * cleans every data/unified cache level (up to the level
+ * of coherency) by set/way.
+ **/
+void armv7_dcache_clean_all(void) {
+    armv7_dcache_all(ARMV7_CACHE_CLEAN);
+}
+
+/**
+ * armv7_dcache_clean_inval_all
+ * 
+ * cleans & invalidates every data/unified cache level (up to
+ * the level of coherency) by set/way.
+ **/
+void armv7_dcache_clean_inval_all(void) {
+    armv7_dcache_all(ARMV7_CACHE_CLEAN_INVAL);
+}
+
+/**
+ * armv7_icache_inval_all
+ * 
+ * invalidates the instruction cache & branch predictor
+ **/
+void armv7_icache_inval_all(void) {
+    armv7_invalidate_icache();
+    armv7_invalidate_bpred();
+    
+    dsb();
+    isb();
+}
+
+/**
+ * armv7_dcache_range
+ * 
+ * performs a cache maintenance operation, to the point of coherency,
+ * on every data cache line within [start, start + size).
+ * the range is always walked by mva, however large; only operations by
+ * mva are broadcast to the other cpus of an mp cluster, whereas set/way
+ * operations reach the calling cpu's cache alone.
+ * for ARMV7_CACHE_INVAL, partial lines at either end of the range are
+ * cleaned & invalidated.
+ * 
+ * @start	virtual start address
+ * @size	size (in bytes) of range
+ * @op		maintenance operation
+ **/
+void armv7_dcache_range(addr_t start, size_t size, armv7_cache_op op) {
+    addr_t	end	= start + size;
+    size_t	line_sz	= armv7_dcache_get_line_sz();
+    
+    if (size > 0) {
+	if (op == ARMV7_CACHE_INVAL) {
+	    if (start & (line_sz - 1)) {
+		start &= ~(line_sz - 1);
+		armv7_dcache_mva(start, ARMV7_CACHE_CLEAN_INVAL);
+		start += line_sz;
+	    }
+	    
+	    if ((end & (line_sz - 1)) && (end > start)) {
+		end &= ~(line_sz - 1);
+		armv7_dcache_mva(end, ARMV7_CACHE_CLEAN_INVAL);
+	    }
+	}
+	
+	for (start &= ~(line_sz - 1); start < end; start += line_sz) {
+	    armv7_dcache_mva(start, op);
+	}
+	
+	dsb();
+    }
+}
+
+/**
+ * armv7_icache_sync_range
+ * 
+ * makes instructions written through the data cache within
+ * [start, start + size) visible to instruction fetch;
+ * the data cache is cleaned to the point of unification, then the
+ * instruction cache & branch predictor are invalidated; the caches
+ * are maintained by mva, however large the range, so the other cpus
+ * are reached as well (see armv7_dcache_range).
+ * 
+ * @start	virtual start address
+ * @size	size (in bytes) of range
+ **/
+void armv7_icache_sync_range(addr_t start, size_t size) {
+    addr_t	end	= start + size;
+    addr_t	addr	= 0x0;
+    size_t	line_sz	= armv7_dcache_get_line_sz();
+    
+    if (size > 0) {
+	start &= ~(line_sz - 1);
+	
+	for (addr = start; addr < end; addr += line_sz) {
+	    asm volatile("mcr p15, 0, %0, c7, c11, 1" : : "r" (addr));	/* DCCMVAU */
+	}
+	
+	dsb();
+	
+	for (addr = start; addr < end; addr += line_sz) {
+	    asm volatile("mcr p15, 0, %0, c7, c5, 1" : : "r" (addr));	/* ICIMVAU */
+	}
+	
+	armv7_invalidate_bpred();
+	
+	dsb();
+	isb();
+    }
+}
+
+/**
+ * armv7_dcache_get_line_sz
+ * 
+ * returns the level 1 data cache line size, as reported by CCSIDR.
+ * 
+ * @return line size (in bytes)
+ **/
+size_t armv7_dcache_get_line_sz(void) {
+    if (l1d_line_sz == 0) {
+	armv7_dcache_geometry();
+    }
+    
+    return l1d_line_sz;
+}
+
+/**
+ * armv7_dcache_get_sz
+ * 
+ * returns the total level 1 data cache size, as reported by CCSIDR.
+ * 
+ * @return cache size (in bytes)
+ **/
+size_t armv7_dcache_get_sz(void) {
+    if (l1d_sz == 0) {
+	armv7_dcache_geometry();
+    }
+    
+    return l1d_sz;
+}
+
+/**
+ * armv7_cache_enable
+ * 
+ * sets the specified cache enable bits in the
+ * System Control Register.
+ * 
+ * @sctlr_bits	ARMV7_SCTLR_DCACHE_ENB, ARMV7_SCTLR_ICACHE_ENB and/or
+ * 		ARMV7_SCTLR_BPRED_ENB
+ **/
+void armv7_cache_enable(unsigned int sctlr_bits) {
+    unsigned int reg = armv7_get_sctlr();
+    
+    dsb();
+    
+    reg |= sctlr_bits;
+    armv7_set_sctlr(reg);
+    
+    isb();
+}
+
+/**
+ * armv7_cache_disable
+ * 
+ * clears the specified cache enable bits in the
+ * System Control Register.
+ * if the data cache is being disabled, it is cleaned & invalidated
+ * after being disabled.
+ * 
+ * @sctlr_bits	ARMV7_SCTLR_DCACHE_ENB, ARMV7_SCTLR_ICACHE_ENB and/or
+ * 		ARMV7_SCTLR_BPRED_ENB
+ **/
+void armv7_cache_disable(unsigned int sctlr_bits) {
+    unsigned int reg = armv7_get_sctlr();
+    
+    reg &= ~sctlr_bits;
+    armv7_set_sctlr(reg);
+    isb();
+    
+    if (sctlr_bits & ARMV7_SCTLR_DCACHE_ENB) {
+	armv7_dcache_clean_inval_all();
+    }
+}
+
+/**
+ * armv7_dcache_all
+ * 
+ * performs a set/way operation on every data/unified cache level
+ * up to the level of coherency reported by CLIDR.
+ * 
+ * @op	set/way operation
+ **/
+static void armv7_dcache_all(armv7_cache_op op) {
+    unsigned int clidr	= armv7_get_clidr();
+    unsigned int loc	= (clidr >> ARMV7_CLIDR_LOC_SHIFT) & ARMV7_CLIDR_LOC_MASK;
+    unsigned int ctype	= 0;
+    
+    dmb();
+    
+    for (unsigned int level = 0; level < loc; level++) {
+	ctype = (clidr >> (level * CLIDR_CTYPE_BITS)) & ARMV7_CLIDR_CTYPE_MASK;
+	
+	/* only data or unified caches hold lines */
+	if (ctype >= ARMV7_CLIDR_CTYPE_DCACHE) {
+	    armv7_dcache_level(level, op);
+	}
+    }
+    
+    /* select level 1 again */
+    armv7_set_csselr(0);
+    
+    dsb();
+    isb();
+}
+
+/**
+ * armv7_dcache_level
+ * 
+ * performs a set/way operation on every line of a single
+ * cache level.
+ * 
+ * @level	cache level (zero based)
+ * @op		set/way operation
+ **/
+static void armv7_dcache_level(unsigned int level, armv7_cache_op op) {
+    unsigned int ccsidr		= 0;
+    unsigned int line_shift	= 0;
+    unsigned int way_shift	= 0;
+    unsigned int max_way	= 0;
+    unsigned int max_set	= 0;
+    
+    /* select level & read its geometry */
+    armv7_set_csselr(level << CSSELR_LEVEL_SHIFT);
+    isb();
+    ccsidr = armv7_get_ccsidr();
+    
+    line_shift	= (ccsidr & ARMV7_CCSIDR_LINE_MASK) + LINE_SZ_BASE_SHIFT;
+    max_way	= (ccsidr >> ARMV7_CCSIDR_WAYS_SHIFT) & ARMV7_CCSIDR_WAYS_MASK;
+    max_set	= (ccsidr >> ARMV7_CCSIDR_SETS_SHIFT) & ARMV7_CCSIDR_SETS_MASK;
+    
+    /* the way lives in the top bits of the operand */
+    if (max_way > 0) {
+	way_shift = __builtin_clz(max_way);
+    }
+    
+    for (int way = max_way; way >= 0; way--) {
+	for (int set = max_set; set >= 0; set--) {
+	    unsigned int sw = (level << CSSELR_LEVEL_SHIFT) | (set << line_shift);
+	    
+	    if (max_way > 0) {
+		sw |= (way << way_shift);
+	    }
+	    
+	    armv7_dcache_sw(sw, op);
+	}
+    }
+}
+
+/**
+ * armv7_dcache_sw
+ * 
+ * performs a single set/way operation
+ * 
+ * @set_way	set/way/level operand
+ * @op		set/way operation
+ **/
+static void armv7_dcache_sw(unsigned int set_way, armv7_cache_op op) {
+    switch (op) {
+	case ARMV7_CACHE_INVAL:
+	    asm volatile("mcr p15, 0, %0, c7, c6, 2" : : "r" (set_way));	/* DCISW */
+	    break;
+	case ARMV7_CACHE_CLEAN:
+	    asm volatile("mcr p15, 0, %0, c7, c10, 2" : : "r" (set_way));	/* DCCSW */
+	    break;
+	case ARMV7_CACHE_CLEAN_INVAL:
+	    asm volatile("mcr p15, 0, %0, c7, c14, 2" : : "r" (set_way));	/* DCCISW */
+	    break;
+    }
+}
+
+/**
+ * armv7_dcache_mva
+ * 
+ * performs a single operation by virtual address to
+ * the point of coherency.
+ * 
+ * @addr	virtual address
+ * @op		maintenance operation
+ **/
+static void armv7_dcache_mva(addr_t addr, armv7_cache_op op) {
+    switch (op) {
+	case ARMV7_CACHE_INVAL:
+	    asm volatile("mcr p15, 0, %0, c7, c6, 1" : : "r" (addr));	/* DCIMVAC */
+	    break;
+	case ARMV7_CACHE_CLEAN:
+	    asm volatile("mcr p15, 0, %0, c7, c10, 1" : : "r" (addr));	/* DCCMVAC */
+	    break;
+	case ARMV7_CACHE_CLEAN_INVAL:
+	    asm volatile("mcr p15, 0, %0, c7, c14, 1" : : "r" (addr));	/* DCCIMVAC */
+	    break;
+    }
+}
+
+/**
+ * armv7_dcache_geometry
+ * 
+ * reads the level 1 data cache geometry from CCSIDR
+ **/
+static void armv7_dcache_geometry(void) {
+    unsigned int ccsidr	= 0;
+    unsigned int ways	= 0;
+    unsigned int sets	= 0;
+    
+    armv7_set_csselr(0);
+    isb();
+    ccsidr = armv7_get_ccsidr();
+    
+    ways	= ((ccsidr >> ARMV7_CCSIDR_WAYS_SHIFT) & ARMV7_CCSIDR_WAYS_MASK) + 1;
+    sets	= ((ccsidr >> ARMV7_CCSIDR_SETS_SHIFT) & ARMV7_CCSIDR_SETS_MASK) + 1;
+    
+    l1d_line_sz	= 1 << ((ccsidr & ARMV7_CCSIDR_LINE_MASK) + LINE_SZ_BASE_SHIFT);
+    l1d_sz	= l1d_line_sz * ways * sets;
+}
@@ -20,6 +20,13 @@
  */
 #include <arch/arm/armv7/armv7.h>
 #include <arch/arm/armv7/armv7_syscntl.h>
+#include <arch/arm/gic.h>
+#include <arch/arch_smp.h>
+#include <mm/tlb.h>
+#include <mm/fault.h>
+#include <smp_call.h>
+#include <errno.h>
+#include <stdbool.h>
 #include <mach/mach.h> /* TODO: tmp */
 
 extern void armv7_irq_hand(void);
@@ -27,6 +34,16 @@ extern void armv7_undef_hand(void);
 extern void armv7_dat_abt_hand(void);
 extern void armv7_pref_abt_hand(void);
 
+static bool armv7_is_mm_fault(unsigned int fsr);
+static unsigned int armv7_fault_flags(unsigned int fsr, struct armv7_regs *regs);
+static void armv7_abt_die(const char *desc, unsigned int fsr, unsigned int far, int err, struct armv7_regs *regs);
+
+/* exception mode stacks (irq, abort & undefined) of each cpu */
+#define ARMV7_MODE_STACK_SZ	0x1000
+#define ARMV7_MODE_STACK_CNT	3
+
+static unsigned char mode_stacks[NR_CPUS][ARMV7_MODE_STACK_CNT][ARMV7_MODE_STACK_SZ] __attribute__((aligned(8)));
+
 static unsigned int ivt[16] __attribute__((aligned(128))) = {
     ARMV7_LDR_PC | 0x18,
     ARMV7_LDR_PC | 0x18,
@@ -46,7 +63,20 @@ static unsigned int ivt[16] __attribute__((aligned(128))) = {
     16
 };
 
+/**
+ * install_ivt
+ * 
+ * installs the vector table & exception mode stacks of the calling cpu;
+ * each cpu must do so before taking any exceptions.
+ **/
 void install_ivt(void) {
+    addr_t stacks = (addr_t)mode_stacks[arch_smp_get_cpu_id()];
+    
+    /* stacks grow down from the end of each */
+    armv7_set_mode_sp(ARMV7_CPSR_MODE_IRQ, stacks + ARMV7_MODE_STACK_SZ);
+    armv7_set_mode_sp(ARMV7_CPSR_MODE_ABT, stacks + (2 * ARMV7_MODE_STACK_SZ));
+    armv7_set_mode_sp(ARMV7_CPSR_MODE_UND, stacks + (3 * ARMV7_MODE_STACK_SZ));
+
 	/*
 	for (int i = 0; i < 8; i++) {
 		ivt[i] = ARMV7_LDR_PC | 0x18;
@@ -71,35 +101,147 @@ void dump_undef_except(unsigned int addr) {
 	mach_early_kprintf("[ERROR] Undefined Instruction at 0x%x\n", addr);
 }
 
-void dump_data_abt(unsigned int addr) {
-	unsigned int type = 0;
-	
-	asm volatile ("mrc p15, 0, %0, c5, c0, 0\n" : "=r" (type));
-	mach_early_kprintf("[ERROR] Data Abort at 0x%x, reason: 0x%x\n", addr, type);
+/**
+ * armv7_dat_abt
+ * 
+ * data abort handler; translation & permission faults are passed
+ * to mm_handle_fault.  unresolved faults are fatal.
+ * 
+ * @regs	register state of the aborted mode
+ **/
+void armv7_dat_abt(struct armv7_regs *regs) {
+    unsigned int	dfsr	= armv7_get_dfsr();
+    unsigned int	dfar	= armv7_get_dfar();
+    unsigned int	flags	= armv7_fault_flags(dfsr, regs);
+    int			ret	= EINVAL;
+    
+    if (armv7_is_mm_fault(dfsr)) {
+	if (dfsr & ARMV7_FSR_WNR) {
+	    flags |= MM_FAULT_WRITE;
+	}
 	
-	while(1);
+	ret = mm_handle_fault(dfar, flags);
+    }
+    
+    if (ret != ESUCC) {
+	armv7_abt_die("Data Abort", dfsr, dfar, ret, regs);
+    }
 }
 
-void dump_pref_abt(unsigned int addr) {
-	unsigned int type = 0;
-	
-	asm volatile("mrc p15, 0, %0, c5, c0, 1" : "=r" (type));
-	
-	mach_early_kprintf("[ERROR] Prefetch Abort at 0x%x, FSR[10]: 0x%x, FSR[3:0]: 0x%x\n", addr, ((type >> 10) & 0x1), type & 0xF);
-	mach_early_kprintf("register: 0x%x\n", type);
-	
+/**
+ * armv7_pref_abt
+ * 
+ * prefetch abort handler; translation & permission faults are passed
+ * to mm_handle_fault.  unresolved faults are fatal.
+ * 
+ * @regs	register state of the aborted mode
+ **/
+void armv7_pref_abt(struct armv7_regs *regs) {
+    unsigned int	ifsr	= armv7_get_ifsr();
+    unsigned int	ifar	= armv7_get_ifar();
+    unsigned int	flags	= armv7_fault_flags(ifsr, regs) | MM_FAULT_EXEC;
+    int			ret	= EINVAL;
+    
+    if (armv7_is_mm_fault(ifsr)) {
+	ret = mm_handle_fault(ifar, flags);
+    }
+    
+    if (ret != ESUCC) {
+	armv7_abt_die("Prefetch Abort", ifsr, ifar, ret, regs);
+    }
+}
+
+/**
+ * armv7_is_mm_fault
+ * 
+ * determines if a fault status may be resolved by the mm
+ * 
+ * @fsr		DFSR or IFSR
+ * @return true if translation or permission fault
+ **/
+static bool armv7_is_mm_fault(unsigned int fsr) {
+    bool ret = false;
+    
+    switch (armv7_get_fsr_status(fsr)) {
+	case ARMV7_FSR_TRANS_SECT:
+	case ARMV7_FSR_TRANS_PG:
+	case ARMV7_FSR_PERM_SECT:
+	case ARMV7_FSR_PERM_PG:
+	    ret = true;
+	    break;
+	default:
+	    break;
+    }
+    
+    return ret;
+}
+
+/**
+ * armv7_fault_flags
+ * 
+ * returns the MM_FAULT_* flags common to data & prefetch aborts
+ * 
+ * @fsr		DFSR or IFSR
+ * @regs	register state of the aborted mode
+ * @return MM_FAULT_* flags
+ **/
+static unsigned int armv7_fault_flags(unsigned int fsr, struct armv7_regs *regs) {
+    unsigned int	status	= armv7_get_fsr_status(fsr);
+    unsigned int	ret	= 0;
+    
+    if ((regs->cpsr & ARMV7_CPSR_MODE_MASK) == ARMV7_CPSR_MODE_USR) {
+	ret |= MM_FAULT_USER;
+    }
+    
+    if (status == ARMV7_FSR_PERM_SECT || status == ARMV7_FSR_PERM_PG) {
+	ret |= MM_FAULT_PROT;
+    }
+    
+    return ret;
+}
+
+/**
+ * armv7_abt_die
+ * 
+ * reports an unresolved abort & halts
+ * 
+ * @desc	abort description
+ * @fsr		DFSR or IFSR
+ * @far		DFAR or IFAR
+ * @err		errno returned by mm_handle_fault
+ * @regs	register state of the aborted mode
+ **/
+static void armv7_abt_die(const char *desc, unsigned int fsr, unsigned int far, int err, struct armv7_regs *regs) {
+    mach_early_kprintf("[ERROR] %s at 0x%x, address: 0x%x, status: 0x%x, fsr: 0x%x (%i)\n", 
+	desc, regs->pc, far, armv7_get_fsr_status(fsr), fsr, err);
+    
+    for (int i = 0; i < 13; i++) {
+	mach_early_kprintf("r%i: 0x%x\n", i, regs->r[i]);
+    }
+    
+    mach_early_kprintf("sp: 0x%x lr: 0x%x cpsr: 0x%x\n", regs->sp, regs->lr, regs->cpsr);
+    
+    while(1);
 }
 
 void c_irq_hand(void) {
-    /*
-	unsigned int base = armv7_get_config_base() + ARM_GICC_OFFSET;
-	unsigned int irq_ack = memr(base + 0xC) & 0x1FFF;
-	
-	mach_init_printf("Interrupt!  ID: 0x%x\n", (irq_ack & 0x3FF));
+    unsigned int iar	= gic_ack();
+    unsigned int id	= iar & GICC_IAR_ID_MASK;
+    
+    if (id != GICC_IAR_SPURIOUS) {
+	switch (id) {
+	    case IPI_TLB_SHOOTDOWN:
+		tlb_shootdown_hand();
+		break;
+	    case IPI_CALL_FUNC:
+		smp_call_hand();
+		break;
+	    default:
+		break;
+	}
 	
-	// write and mark it finished 
-	memw(base + 0x10, irq_ack);
-	*/
+	gic_eoi(iar);
+    }
 }
 
 /*
@@ -18,35 +18,33 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
-.extern kern_stack		/* kernel.ld */
+/*
+ * the handlers run on the banked sp of their mode, set per cpu
+ * by install_ivt (armv7_ivt.c).
+ */
 
 /* armv7_ivt.c */
 .extern armv7_irq_hand
+.extern armv7_dat_abt
+.extern armv7_pref_abt
 /* temp */
 .extern dump_undef_except
-.extern dump_data_abt
-.extern dump_pref_abt
 
 .global armv7_irq_hand
 armv7_irq_hand:
-	ldr sp, =k_stack
-	add sp, sp, #0x2000
-	
-	push {r0-r3}
+	/* lr is clobbered by the call below */
+	push {r0-r3, r12, lr}
 	
 	/* branch into C handler */
 	bl c_irq_hand
 	
-	pop {r0-r3}
+	pop {r0-r3, r12, lr}
 	
 	/* return to before interrupt */
 	subs pc, lr, #4
 
 .global armv7_undef_hand
 armv7_undef_hand:
-	ldr sp, =k_stack
-	add sp, sp, #0x3000
-	
 	push {r0-r3}
 	
 	mov r0, lr
@@ -63,34 +61,55 @@ armv7_undef_hand:
 
 .global armv7_dat_abt_hand
 armv7_dat_abt_hand:
-	ldr sp, =k_stack
-	add sp, sp, #0x3000
-	
-	push {r0-r3}
-	
-	mov r0, lr
-	sub r0, r0, #8
-	
-	bl dump_data_abt
-	
-	pop {r0-r3}
-	
-	/* returns after */
-	subs pc, lr, #4
+	/* lr - 8 holds the aborted instruction, which is retried */
+	sub lr, lr, #8
+	
+	/*
+	 * struct armv7_regs; pc & cpsr, user sp & lr, then r0-r12, below
+	 * which a word keeps sp 8 byte aligned for the call (72 bytes)
+	 */
+	srsdb sp!, #0x17
+	sub sp, sp, #8
+	push {r0-r12}
+	add r0, sp, #52
+	stmia r0, {sp, lr}^
+	sub sp, sp, #4
+	
+	add r0, sp, #4
+	bl armv7_dat_abt
+	
+	/* the handler may have altered the saved state */
+	add sp, sp, #4
+	add r0, sp, #52
+	ldmia r0, {sp, lr}^
+	nop
+	pop {r0-r12}
+	add sp, sp, #8
+	rfeia sp!
 
 .global armv7_pref_abt_hand
 armv7_pref_abt_hand:
-	ldr sp, =k_stack
-	add sp, sp, #0x3000
-	
-	push {r0-r3}
-	
-	mov r0, lr
-	sub r0, r0, #4
-	
-	bl dump_pref_abt
-	
-	pop {r0-r3}
-	
-	/* returns after */
-	movs pc, lr
+	/* lr - 4 holds the aborted instruction, which is retried */
+	sub lr, lr, #4
+	
+	/*
+	 * struct armv7_regs; pc & cpsr, user sp & lr, then r0-r12, below
+	 * which a word keeps sp 8 byte aligned for the call (72 bytes)
+	 */
+	srsdb sp!, #0x17
+	sub sp, sp, #8
+	push {r0-r12}
+	add r0, sp, #52
+	stmia r0, {sp, lr}^
+	sub sp, sp, #4
+	
+	add r0, sp, #4
+	bl armv7_pref_abt
+	
+	add sp, sp, #4
+	add r0, sp, #52
+	ldmia r0, {sp, lr}^
+	nop
+	pop {r0-r12}
+	add sp, sp, #8
+	rfeia sp!
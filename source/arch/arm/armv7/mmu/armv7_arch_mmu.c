@@ -22,6 +22,7 @@
  */
 #include <arch/arm/armv7/armv7_syscntl.h>
 #include <arch/arm/armv7/armv7_mmu.h>
+#include <arch/arm/armv7/armv7_mmu_dump.h>
 #include <arch/arch_mmu.h>
 #include <mm/mmu.h>
 #include <stdbool.h>
@@ -33,6 +34,7 @@ static armv7_mmu_acc_perm arch_mmu_acc_to_armv7(mmu_acc_flags_t flags);
 static armv7_mmu_pgd_type arch_mmu_pgd_type_to_armv7(mmu_entry_type_t type);
 static armv7_mmu_pgtb_type arch_mmu_pgtb_type_to_armv7(mmu_entry_type_t type);
 static unsigned char arch_mmu_acc_to_domain(mmu_acc_flags_t flags);
+static unsigned int arch_mmu_acc_to_pgtb_attr(mmu_acc_flags_t flags);
 
 bool arch_mmu_is_enabled(void) {
     return armv7_mmu_is_enabled();
@@ -43,7 +45,7 @@ addr_t virt_to_phy(addr_t virt_addr) {
 }
 
 int arch_mmu_set_user_pg_dir(addr_t page_dir) {
-    return armv7_mmu_set_user_pgd(page_dir, 0x0);
+    return armv7_mmu_set_user_pgd(page_dir, ARMV7_MMU_TTBR_FLAGS);
 }
 
 int arch_mmu_create_entry(struct mmu_entry *entry) {
@@ -69,7 +71,7 @@ int arch_mmu_create_entry(struct mmu_entry *entry) {
 	    armv7_pgtb_entry.virt_addr	= entry->virt_addr;
 	    armv7_pgtb_entry.acc_perm	= arch_mmu_acc_to_armv7(entry->acc_flags);
 	    armv7_pgtb_entry.type	= arch_mmu_pgtb_type_to_armv7(entry->type);
-	    armv7_pgtb_entry.flags	= 0x0;	/* TODO */
+	    armv7_pgtb_entry.flags	= arch_mmu_acc_to_pgtb_attr(entry->acc_flags);
 	    
 	    ret = armv7_mmu_map_pgtb(&armv7_pgtb_entry);
 	    break;
@@ -103,7 +105,7 @@ int arch_mmu_create_new_entry(addr_t pg_base, struct mmu_entry *entry) {
 	    armv7_pgtb_entry.virt_addr	= entry->virt_addr;
 	    armv7_pgtb_entry.acc_perm	= arch_mmu_acc_to_armv7(entry->acc_flags);
 	    armv7_pgtb_entry.type	= arch_mmu_pgtb_type_to_armv7(entry->type);
-	    armv7_pgtb_entry.flags	= 0x0;	/* TODO */
+	    armv7_pgtb_entry.flags	= arch_mmu_acc_to_pgtb_attr(entry->acc_flags);
 	    
 	    /* grab kvaddr */
 	    kvaddr = arch_mmu_get_kern_vaddr();
@@ -123,55 +125,28 @@ int arch_mmu_create_new_entry(addr_t pg_base, struct mmu_entry *entry) {
 }
 
 size_t arch_mmu_get_kern_pgtb_reg_sz(void) {
-    int		pg_div 	= armv7_mmu_get_pg_div();
-    size_t	ret	= 0;
+    size_t ret = PGD_ENTRY_CNT * PGTB_SZ;
     
-    if (pg_div > 0) {
-	ret = (PGD_ENTRY_CNT - (1 << (32 - (pg_div + PGD_IDX_SHIFT)))) * PGTB_SZ;
-    } else {
-	ret = PGD_ENTRY_CNT * PGTB_SZ;
+    /* without a split ttbr0 & ttbr1 each span everything */
+    if (armv7_mmu_get_pg_div() > 0) {
+	ret = (PGD_ENTRY_CNT - armv7_mmu_get_user_pgd_entry_cnt()) * PGTB_SZ;
     }
     
     return ret;
 }
 
 size_t arch_mmu_get_user_pgtb_reg_sz(void) {
-    int		pg_div	= armv7_mmu_get_pg_div();
-    size_t	ret	= 0;	
-    
-    if (pg_div > 0) {
-	ret = (1 << (32 - (pg_div + PGD_IDX_SHIFT))) * PGTB_SZ;
-    } else {
-	ret = PGD_ENTRY_CNT * PGTB_SZ;
-    }
-    
-    return ret;
+    return armv7_mmu_get_user_pgd_entry_cnt() * PGTB_SZ;
 }
 
+#ifdef CONFIG_VM_SPLIT_GENERIC
 addr_t arch_mmu_get_kern_vaddr(void) {
-    int		pg_div	= armv7_mmu_get_pg_div();
-    addr_t 	ret 	= 0x0;
-    
-    if (pg_div > 0) {
-	ret = (1 << (32 - pg_div));
-    } else {
-	ret = 0x0;
-    }
-    
-    return ret;
+    return armv7_mmu_get_kern_vaddr();
 }
+#endif
 
 size_t arch_mmu_get_user_pgd_sz(void) {
-    int		pg_div	= armv7_mmu_get_pg_div();
-    size_t	ret	= 0;
-    
-    if (pg_div > 0) {
-	ret = (1 << (32 - (pg_div + PGD_IDX_SHIFT))) * PGD_ENTRY_SZ;
-    } else {
-	ret = PGD_ENTRY_CNT * PGD_ENTRY_SZ;
-    }
-    
-    return ret;
+    return armv7_mmu_get_user_pgd_entry_cnt() * PGD_ENTRY_SZ;
 }
 
 bool arch_mmu_user_pgd_requires_alignment(void) {
@@ -179,17 +154,71 @@ bool arch_mmu_user_pgd_requires_alignment(void) {
 }
 
 unsigned int arch_mmu_get_user_pgd_alignment(void) {
-    return (1 << (TTBR_ALIGN - armv7_mmu_get_pg_div()));
+    return armv7_mmu_get_user_pgd_align();
+}
+
+#ifdef CONFIG_MMU_DUMP
+void arch_mmu_dump(void) {
+    armv7_mmu_dump();
 }
+#endif
 
 void arch_mmu_invalidate(void) {
     armv7_invalidate_unified_tlb();
 }
 
+void arch_mmu_invalidate_page(addr_t virt_addr) {
+    armv7_invalidate_unified_tlb_mva(virt_addr);
+}
+
+void arch_mmu_invalidate_bcast(void) {
+#ifdef CONFIG_SMP
+    armv7_invalidate_unified_tlb_is();
+#else
+    armv7_invalidate_unified_tlb();
+#endif
+}
+
+void arch_mmu_invalidate_page_bcast(addr_t virt_addr) {
+#ifdef CONFIG_SMP
+    armv7_invalidate_unified_tlb_mva_is(virt_addr);
+#else
+    armv7_invalidate_unified_tlb_mva(virt_addr);
+#endif
+}
+
 unsigned int arch_mmu_get_pgtb_alignment() {
     return MMU_PG_SZ;
 }
 
+size_t arch_mmu_get_pgtb_sz(void) {
+    return PGTB_SZ;
+}
+
+size_t arch_mmu_get_pgtb_entry_cnt(void) {
+    return (PGTB_SZ / PGD_ENTRY_SZ);
+}
+
+addr_t arch_mmu_pgtb_get_phy(addr_t pgtb_addr, unsigned int idx) {
+    return armv7_mmu_pgtb_get_phy(pgtb_addr, idx);
+}
+
+void arch_mmu_pgtb_wrprotect(addr_t pgtb_addr) {
+    armv7_mmu_pgtb_wrprotect(pgtb_addr);
+}
+
+addr_t arch_mmu_get_pgtb(addr_t virt_addr) {
+    return armv7_mmu_get_pgtb(virt_addr);
+}
+
+addr_t arch_mmu_pgd_get_pgtb(addr_t pgd_addr, addr_t virt_addr) {
+    return armv7_mmu_pgd_get_pgtb(pgd_addr, virt_addr);
+}
+
+bool arch_mmu_pgtb_is_empty(addr_t pgtb_addr) {
+    return armv7_mmu_pgtb_is_empty(pgtb_addr);
+}
+
 /**
  * arch_mmu_acc_to_domain
  * 
@@ -215,6 +244,31 @@ static unsigned char arch_mmu_acc_to_domain(mmu_acc_flags_t flags) {
     return ret;
 }
 
+/**
+ * arch_mmu_acc_to_pgtb_attr
+ * 
+ * translates mmu access flags to page table memory attributes
+ * @flags	mmu access flags
+ * @return armv7 page table memory attributes
+ **/
+static unsigned int arch_mmu_acc_to_pgtb_attr(mmu_acc_flags_t flags) {
+    unsigned int ret = 0;
+    
+    switch (flags) {
+	case USER:
+	case KERN_USER:
+	case KERNEL:
+	case KERNEL_RO:
+	    ret = ARMV7_MMU_PGTB_NORMAL;
+	    break;
+	case DEVICE:
+	    ret = ARMV7_MMU_PGTB_DEVICE;
+	    break;
+    }
+    
+    return ret;
+}
+
 /**
  * arch_mmu_acc_to_armv7
  * 
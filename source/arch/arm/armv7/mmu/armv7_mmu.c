@@ -22,13 +22,15 @@
 #include <arch/arm/armv7/armv7_mmu.h>
 #include <arch/arm/armv7/armv7_syscntl.h>
 #include <util/bits.h>
+#include <memlayout.h>
 #include <types.h>
 #include <errno.h>
 #include <stdbool.h>
 
 /* helper functions */
 static void armv7_mmu_update(bool dsb);
-static bool is_higher_half(addr_t virt_addr, int n);
+static addr_t translate(addr_t virt_addr, bool user);
+static addr_t table_to_virt(addr_t phy_addr);
 static int get_pgd_entry(addr_t pgd_addr, addr_t virt_addr, struct armv7_mmu_pgd_entry *out);
 static int create_pgtb_entry(addr_t pgtb_addr, struct armv7_mmu_pgtb_entry *entry);
 static int create_pgd_entry(addr_t pgd_addr, struct armv7_mmu_pgd_entry *entry);
@@ -37,52 +39,249 @@ static int create_pgd_entry(addr_t pgd_addr, struct armv7_mmu_pgd_entry *entry);
  * armv7_mmu_virt_to_phy
  * 
  * returns the physical address associated with a virtual address.
+ * translation is performed by the mmu (ATS1CPR); if the mmu is disabled
+ * the virtual address is returned.
  * if the virtual address isn't mapped to a physical address, returns 0.
  * 
  * @virt_addr	virtual address
  * @return physical address
  **/
 addr_t armv7_mmu_virt_to_phy(addr_t virt_addr) {
-    unsigned int	index	= 0;
-    unsigned char	type	= 0;
-    addr_t 		ret 	= 0x0;
-    addr_t 		*pg_dir	= NULL;
+    addr_t ret = 0x0;
     
     if (armv7_mmu_is_enabled()) {
-	index = virt_addr >> PGD_IDX_SHIFT;
-	
-	if (is_higher_half(virt_addr, armv7_mmu_get_pg_div())) {
-	    pg_dir = (addr_t *)armv7_mmu_get_kern_pgd();
+	ret = translate(virt_addr, false);
+    } else {
+	ret = virt_addr;
+    }
+    
+    return ret;
+}
+
+/**
+ * armv7_mmu_virt_to_phy_user
+ * 
+ * returns the physical address associated with a virtual address,
+ * only if the address is readable from user mode (ATS1CUR).
+ * if the virtual address isn't mapped or isn't accessible to user mode,
+ * returns 0.
+ * 
+ * @virt_addr	virtual address
+ * @return physical address
+ **/
+addr_t armv7_mmu_virt_to_phy_user(addr_t virt_addr) {
+    addr_t ret = 0x0;
+    
+    if (armv7_mmu_is_enabled()) {
+	ret = translate(virt_addr, true);
+    }
+    
+    return ret;
+}
+
+/**
+ * armv7_mmu_virt_to_phy_sw
+ * 
+ * returns the physical address associated with a virtual address
+ * by walking the active page directories in software.
+ * if the mmu is disabled, the virtual address is returned.
+ * if the virtual address isn't mapped to a physical address, returns 0.
+ * 
+ * @virt_addr	virtual address
+ * @return physical address
+ **/
+addr_t armv7_mmu_virt_to_phy_sw(addr_t virt_addr) {
+    addr_t ret = 0x0;
+    
+    if (armv7_mmu_is_enabled()) {
+	if (armv7_mmu_is_higher_half(virt_addr)) {
+	    ret = armv7_mmu_walk(armv7_mmu_get_kern_pgd(), virt_addr);
 	} else {
-	    pg_dir = (addr_t *)armv7_mmu_get_user_pgd();
+	    ret = armv7_mmu_walk(armv7_mmu_get_user_pgd(), virt_addr);
 	}
-	
-	/* grab entry type */
-	type = (pg_dir[index] & PGD_TYPE_MASK);
+    } else {
+	ret = virt_addr;
+    }
+    
+    return ret;
+}
+
+/**
+ * armv7_mmu_walk
+ * 
+ * walks a page directory (which needn't be active) in software and
+ * returns the physical address associated with a virtual address.
+ * page directories & tables are physical; while the mmu is enabled they
+ * are accessed through the kernel linear map.
+ * if the virtual address isn't mapped to a physical address, returns 0.
+ * 
+ * @pgd_addr	physical address of page directory
+ * @virt_addr	virtual address
+ * @return physical address
+ **/
+addr_t armv7_mmu_walk(addr_t pgd_addr, addr_t virt_addr) {
+    uint32_t		*pg_dir	= NULL;
+    uint32_t		*pg_tb	= NULL;
+    addr_t		entry	= 0x0;
+    unsigned int	index	= 0;
+    addr_t		ret	= 0x0;
+    
+    if (pgd_addr != 0x0) {
+	pg_dir	= (uint32_t *)table_to_virt(pgd_addr);
+	entry	= pg_dir[virt_addr >> PGD_IDX_SHIFT];
 	
 	/* determine entry type; get phy addr based on that */
-	if (type == ARMV7_MMU_PGD_SECTION) {
-	    ret = ((pg_dir[index] & PGD_SECT_MASK) | (virt_addr & ~PGD_SECT_MASK));
-	} else if (type == ARMV7_MMU_PGD_TABLE) {
-	    addr_t *pg_tb = (addr_t *)(pg_dir[index] & PGD_TABLE_MASK);
-	    
-	    /* table index */
-	    index 	= (virt_addr >> PGTB_IDX_SHIFT) & PGTB_IDX_MASK;
-	    type	= pg_tb[index] & PGTB_TYPE_MASK;
-	    
-	    if (type == ARMV7_MMU_PGTB_LARGE_PG) {
-		ret = ((pg_tb[index] & PGTB_LG_PG_MASK) | (virt_addr & ~PGTB_LG_PG_MASK));
-	    } else if (type == ARMV7_MMU_PGTB_SMALL_PG) {
-		ret = ((pg_tb[index] & PGTB_SM_PG_MASK) | (virt_addr & ~PGTB_SM_PG_MASK));
+	switch (entry & PGD_TYPE_MASK) {
+	    case ARMV7_MMU_PGD_SECTION:
+		if (entry & PGD_SECT_SUPER) {
+		    ret = ((entry & PGD_SUPER_SECT_MASK) | (virt_addr & ~PGD_SUPER_SECT_MASK));
+		} else {
+		    ret = ((entry & PGD_SECT_MASK) | (virt_addr & ~PGD_SECT_MASK));
+		}
+		break;
+	    case ARMV7_MMU_PGD_TABLE:
+		pg_tb	= (uint32_t *)table_to_virt(entry & PGD_TABLE_MASK);
+		index	= (virt_addr >> PGTB_IDX_SHIFT) & PGTB_IDX_MASK;
+		entry	= pg_tb[index];
+		
+		/* bit 1 set denotes a small page (bit 0 being XN) */
+		if (entry & ARMV7_MMU_PGTB_SMALL_PG) {
+		    ret = ((entry & PGTB_SM_PG_MASK) | (virt_addr & ~PGTB_SM_PG_MASK));
+		} else if ((entry & PGTB_TYPE_MASK) == ARMV7_MMU_PGTB_LARGE_PG) {
+		    ret = ((entry & PGTB_LG_PG_MASK) | (virt_addr & ~PGTB_LG_PG_MASK));
+		}
+		break;
+	    default:
+		break;
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * armv7_mmu_get_pgtb
+ * 
+ * returns the page table mapping a virtual address within the active
+ * page directories.
+ * 
+ * @virt_addr	virtual address
+ * @return physical address of page table or 0x0 if the page directory
+ * entry isn't a page table
+ **/
+addr_t armv7_mmu_get_pgtb(addr_t virt_addr) {
+    struct armv7_mmu_pgd_entry	pgd_ent;
+    addr_t			pgd_addr	= 0x0;
+    addr_t			ret		= 0x0;
+    
+    if (armv7_mmu_is_enabled()) {
+	if (armv7_mmu_is_higher_half(virt_addr)) {
+	    pgd_addr = armv7_mmu_get_kern_pgd();
+	} else {
+	    pgd_addr = armv7_mmu_get_user_pgd();
+	}
+	
+	if (get_pgd_entry(pgd_addr, virt_addr, &pgd_ent) == ESUCC) {
+	    if (pgd_ent.type == ARMV7_MMU_PGD_TABLE) {
+		ret = pgd_ent.phy_addr;
 	    }
 	}
-    } else {
-	ret = virt_addr;
     }
     
     return ret;
 }
 
+/**
+ * armv7_mmu_pgd_get_pgtb
+ * 
+ * returns the page table mapping a virtual address within
+ * a (not necessarily active) page directory.
+ * 
+ * @pgd_addr	physical address of page directory
+ * @virt_addr	virtual address
+ * @return physical address of page table or 0x0 if the page directory
+ * entry isn't a page table
+ **/
+addr_t armv7_mmu_pgd_get_pgtb(addr_t pgd_addr, addr_t virt_addr) {
+    struct armv7_mmu_pgd_entry	pgd_ent;
+    addr_t			ret	= 0x0;
+    
+    if (get_pgd_entry(pgd_addr, virt_addr, &pgd_ent) == ESUCC) {
+	if (pgd_ent.type == ARMV7_MMU_PGD_TABLE) {
+	    ret = pgd_ent.phy_addr;
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * armv7_mmu_pgtb_is_empty
+ * 
+ * determines if a page table contains no valid entries
+ * 
+ * @pgtb_addr	physical address of page table
+ * @return true if empty
+ **/
+bool armv7_mmu_pgtb_is_empty(addr_t pgtb_addr) {
+    uint32_t	*pg_tb	= (uint32_t *)table_to_virt(pgtb_addr);
+    bool	ret	= true;
+    
+    for (unsigned int i = 0; i < (PGTB_SZ / PGD_ENTRY_SZ) && ret; i++) {
+	if (pg_tb[i] & PGTB_TYPE_MASK) {
+	    ret = false;
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * armv7_mmu_pgtb_get_phy
+ * 
+ * returns the physical page mapped by an entry of a page table
+ * 
+ * @pgtb_addr	physical address of page table
+ * @idx		entry index
+ * @return physical address or 0x0 if the entry is invalid
+ **/
+addr_t armv7_mmu_pgtb_get_phy(addr_t pgtb_addr, unsigned int idx) {
+    uint32_t	*pg_tb	= (uint32_t *)table_to_virt(pgtb_addr);
+    addr_t	ret	= 0x0;
+    
+    if (idx < (PGTB_SZ / PGD_ENTRY_SZ)) {
+	/* bit 0 is XN for small pages */
+	if (pg_tb[idx] & ARMV7_MMU_PGTB_SMALL_PG) {
+	    ret = pg_tb[idx] & PGTB_SM_PG_MASK;
+	} else if ((pg_tb[idx] & PGTB_TYPE_MASK) == ARMV7_MMU_PGTB_LARGE_PG) {
+	    ret = (pg_tb[idx] & PGTB_LG_PG_MASK) | ((idx << PGTB_IDX_SHIFT) & ~PGTB_LG_PG_MASK);
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * armv7_mmu_pgtb_wrprotect
+ * 
+ * makes every user writable entry of a page table read only
+ * (ARMV7_MMU_ACC_KRW_URW -> ARMV7_MMU_ACC_KRO_URO).
+ * the caller must invalidate the tlb of every cpu using the table.
+ * 
+ * @pgtb_addr	physical address of page table
+ **/
+void armv7_mmu_pgtb_wrprotect(addr_t pgtb_addr) {
+    uint32_t		*pg_tb	= (uint32_t *)table_to_virt(pgtb_addr);
+    unsigned int	urw	= (ARMV7_MMU_ACC_KRW_URW & ARMV7_MMU_ACC_AP_MASK) << PGTB_AP_SHIFT;
+    
+    for (unsigned int i = 0; i < (PGTB_SZ / PGD_ENTRY_SZ); i++) {
+	if ((pg_tb[i] & PGTB_TYPE_MASK) && !(pg_tb[i] & PGTB_APX) && 
+	    ((pg_tb[i] & (ARMV7_MMU_ACC_AP_MASK << PGTB_AP_SHIFT)) == urw)) {
+	    pg_tb[i] |= PGTB_APX;
+	}
+    }
+}
+
 /**
  * armv7_mmu_get_kern_pgd
  * 
@@ -106,16 +305,10 @@ addr_t armv7_mmu_get_kern_pgd(void) {
  * @return user pgd
  **/
 addr_t armv7_mmu_get_user_pgd(void) {
-    addr_t 		ret 	= 0x0;
-    int			pg_div	= 0;
-    unsigned int	mask	= 0;
+    addr_t ret = 0x0;
     
     if (armv7_mmu_is_enabled()) {
-	pg_div 	= armv7_mmu_get_pg_div();
-	mask 	= ~((1 << (TTBR_ALIGN - pg_div)) - 1);
-	
-	ret = armv7_get_ttbr0() & mask;
-	
+	ret = armv7_get_ttbr0() & ~(armv7_mmu_get_user_pgd_align() - 1);
     }
     
     return ret;
@@ -159,7 +352,7 @@ int armv7_mmu_set_kern_pgd(addr_t pgd_addr, unsigned char flags) {
  * @return errno
  **/
 int armv7_mmu_set_user_pgd(addr_t pgd_addr, unsigned char flags) {
-    unsigned int	align	= 1 << (TTBR_ALIGN - armv7_mmu_get_pg_div());
+    unsigned int	align	= armv7_mmu_get_user_pgd_align();
     int			ret	= ESUCC;
     
     if (is_aligned_n(pgd_addr, align)) {
@@ -190,15 +383,12 @@ int armv7_mmu_set_user_pgd(addr_t pgd_addr, unsigned char flags) {
  **/
 int armv7_mmu_map_pgd(struct armv7_mmu_pgd_entry *pgd_ent) {
     addr_t	pgd_addr	= 0x0;
-    int		pg_div		= 0;
     int 	ret 		= ESUCC;
     
     if (pgd_ent != NULL) {
 	if (armv7_is_supported_pgd_type(pgd_ent->type)) {
 	    if (armv7_mmu_is_enabled()) {
-		pg_div = armv7_mmu_get_pg_div();
-		
-		if (is_higher_half(pgd_ent->virt_addr, pg_div)) {
+		if (armv7_mmu_is_higher_half(pgd_ent->virt_addr)) {
 		    pgd_addr = armv7_mmu_get_kern_pgd();
 		} else {
 		    pgd_addr = armv7_mmu_get_user_pgd();
@@ -261,18 +451,15 @@ int armv7_mmu_map_new_pgd(addr_t pgd_addr, struct armv7_mmu_pgd_entry *pgd_ent)
  **/
 int armv7_mmu_map_pgtb(struct armv7_mmu_pgtb_entry *pgtb_ent) {
     addr_t 	pgd_addr	= 0x0;
-    int		pg_div		= 0;
     int		ret		= ESUCC;
     
     if (pgtb_ent != NULL) {
 	if (armv7_mmu_is_enabled()) {
-	    pg_div = armv7_mmu_get_pg_div();
-	    
 	    if (armv7_is_supported_pgtb_type(pgtb_ent->type)) {
 		struct armv7_mmu_pgd_entry pgd_ent;
 		
 		/* determine which page directory to use */
-		if (is_higher_half(pgtb_ent->virt_addr, pg_div)) {
+		if (armv7_mmu_is_higher_half(pgtb_ent->virt_addr)) {
 		    pgd_addr = armv7_mmu_get_kern_pgd();
 		} else {
 		    pgd_addr = armv7_mmu_get_user_pgd();
@@ -326,30 +513,63 @@ int armv7_mmu_map_new_pgtb(addr_t pgtb_addr, struct armv7_mmu_pgtb_entry *pgtb_e
 }
 
 /**
- * is_higher_half
+ * translate
  * 
- * determines whether an address is higher half (i.e., uses ttbr1)
- * based on the address and the split N
+ * translates a virtual address using the mmu's address translation
+ * operations; irqs are masked so the Physical Address Register isn't
+ * overwritten before it's read.
  * 
- * @virt_addr	address to check
- * @pg_div_n	mmu split
- * @return true if higher
+ * @virt_addr	virtual address
+ * @user	true to apply unprivileged permission checks
+ * @return physical address, 0 if translation faulted
  **/
-static bool is_higher_half(addr_t virt_addr, int pg_div_n) {
-    addr_t	div		= 0;
-    bool 	ret 		= false;
+static addr_t translate(addr_t virt_addr, bool user) {
+    unsigned int	flags	= armv7_irq_save();
+    unsigned int	par	= 0;
+    addr_t		ret	= 0x0;
     
-    if (pg_div_n > 0) {
-	div = (1 << (32 - pg_div_n));
-	
-	if (virt_addr >= div) {
-	    ret = true;
+    if (user) {
+	armv7_ats1cur(virt_addr);
+    } else {
+	armv7_ats1cpr(virt_addr);
+    }
+    
+    isb();
+    par = armv7_get_par();
+    
+    armv7_irq_restore(flags);
+    
+    if (!(par & ARMV7_PAR_FAULT)) {
+	if (par & ARMV7_PAR_SUPER_SECT) {
+	    ret = (par & ARMV7_PAR_SS_PA_MASK) | (virt_addr & ~ARMV7_PAR_SS_PA_MASK);
+	} else {
+	    ret = (par & ARMV7_PAR_PA_MASK) | (virt_addr & ~ARMV7_PAR_PA_MASK);
 	}
     }
     
     return ret;
 }
 
+/**
+ * table_to_virt
+ * 
+ * returns an address through which a page directory/table
+ * located at phy_addr can be accessed; the kernel linear map
+ * while the mmu is enabled.
+ * 
+ * @phy_addr	physical address of table
+ * @return accessible address of table
+ **/
+static addr_t table_to_virt(addr_t phy_addr) {
+    addr_t ret = phy_addr;
+    
+    if (armv7_mmu_is_enabled()) {
+	ret = __va(phy_addr);
+    }
+    
+    return ret;
+}
+
 /**
  * armv7_mmu_update
  * 
@@ -372,12 +592,12 @@ static void armv7_mmu_update(bool dsb) {
  * creates a page table entry from the specified page directory.
  * note: this does not create the mapped pgd entry
  * 
- * @pgd_addr	address of the page table
+ * @pgtb_addr	physical address of the page table
  * @entry	entry to add
  * @return errno
  **/
 static int create_pgtb_entry(addr_t pgtb_addr, struct armv7_mmu_pgtb_entry *entry) {
-    addr_t		*pg_tb	= (addr_t *)pgtb_addr;
+    uint32_t		*pg_tb	= (uint32_t *)table_to_virt(pgtb_addr);
     unsigned int 	index	= 0;
     unsigned int	wr_ent	= 0;
     int			ret	= ESUCC;
@@ -392,7 +612,13 @@ static int create_pgtb_entry(addr_t pgtb_addr, struct armv7_mmu_pgtb_entry *entr
 	    wr_ent &= PGTB_SM_PG_MASK;
 	}
 	
-	pg_tb[index] = wr_ent | (entry->acc_perm << PGTB_AP_SHIFT) | entry->flags | entry->type;
+	wr_ent	|= ((entry->acc_perm & ARMV7_MMU_ACC_AP_MASK) << PGTB_AP_SHIFT);
+	
+	if (entry->acc_perm & ARMV7_MMU_ACC_APX) {
+	    wr_ent |= PGTB_APX;
+	}
+	
+	pg_tb[index] = wr_ent | entry->flags | entry->type;
     } else {
 	ret = EINVAL;
     }
@@ -405,12 +631,12 @@ static int create_pgtb_entry(addr_t pgtb_addr, struct armv7_mmu_pgtb_entry *entr
  * 
  * creates a page directory entry in specified page directory
  * 
- * @pgd_addr	address to page directory
+ * @pgd_addr	physical address of page directory
  * @entry	entry to add
  * @return errno
  **/
 static int create_pgd_entry(addr_t pgd_addr, struct armv7_mmu_pgd_entry *entry) {
-    addr_t 		*pg_dir = (addr_t *)pgd_addr;
+    uint32_t 		*pg_dir = (uint32_t *)table_to_virt(pgd_addr);
     unsigned int	index	= 0;
     unsigned int	wr_ent	= 0;
     int			ret	= ESUCC;
@@ -422,7 +648,11 @@ static int create_pgd_entry(addr_t pgd_addr, struct armv7_mmu_pgd_entry *entry)
 	switch (entry->type) {
 	    case ARMV7_MMU_PGD_SECTION:
 		wr_ent	= (entry->phy_addr & PGD_SECT_MASK);
-		wr_ent	|= (entry->acc_perm << PGD_SECT_AP_SHIFT);
+		wr_ent	|= ((entry->acc_perm & ARMV7_MMU_ACC_AP_MASK) << PGD_SECT_AP_SHIFT);
+		
+		if (entry->acc_perm & ARMV7_MMU_ACC_APX) {
+		    wr_ent |= PGD_SECT_APX;
+		}
 		break;
 	    case ARMV7_MMU_PGD_TABLE:
 		wr_ent	= (entry->phy_addr & PGD_TABLE_MASK);
@@ -446,13 +676,13 @@ static int create_pgd_entry(addr_t pgd_addr, struct armv7_mmu_pgd_entry *entry)
  * 
  * returns the page directory entry for specified virtual address
  * 
- * @pgd_addr	page directory base address
+ * @pgd_addr	physical page directory base address
  * @virt_addr	virtual address
  * @out		structure to output entry
  * @return errno
  **/
 static int get_pgd_entry(addr_t pgd_addr, addr_t virt_addr, struct armv7_mmu_pgd_entry *out) {
-    addr_t 		*pg_dir	= (addr_t *)pgd_addr;
+    uint32_t 		*pg_dir	= (uint32_t *)table_to_virt(pgd_addr);
     unsigned int	index	= 0;
     int			ret	= 0;
     unsigned char	type	= 0;
@@ -463,11 +693,16 @@ static int get_pgd_entry(addr_t pgd_addr, addr_t virt_addr, struct armv7_mmu_pgd
 	type	= pg_dir[index] & PGD_TYPE_MASK;
 	
 	if (type == ARMV7_MMU_PGD_SECTION) {
-	    flg_msk		= ~(PGD_SECT_MASK | PGD_DOMAIN_MASK | PGD_AP_MASK | PGD_TYPE_MASK);
+	    flg_msk		= ~(PGD_SECT_MASK | PGD_DOMAIN_MASK | PGD_AP_MASK | PGD_SECT_APX | PGD_TYPE_MASK);
 	    
 	    out->phy_addr 	= (pg_dir[index] & PGD_SECT_MASK);
 	    out->domain		= (pg_dir[index] & PGD_DOMAIN_MASK) >> PGD_DOMAIN_SHIFT;
 	    out->acc_perm	= (pg_dir[index] & PGD_AP_MASK) >> PGD_SECT_AP_SHIFT;
+	    
+	    if (pg_dir[index] & PGD_SECT_APX) {
+		out->acc_perm |= ARMV7_MMU_ACC_APX;
+	    }
+	    
 	    out->type		= (pg_dir[index] & PGD_TYPE_MASK);
 	    out->flags		= (pg_dir[index] & flg_msk);
 	    out->virt_addr	= virt_addr;
@@ -0,0 +1,440 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifdef CONFIG_MMU_DUMP
+#include <arch/arm/armv7/armv7_mmu_dump.h>
+#include <arch/arm/armv7/armv7_mmu.h>
+#include <mach/mach.h>
+#include <memlayout.h>
+#include <types.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define DUMP_SUPER_SECT_SZ	0x1000000
+#define DUMP_SECT_SZ		0x100000
+#define DUMP_LARGE_PG_SZ	0x10000
+#define DUMP_SMALL_PG_SZ	0x1000
+/* supersections & large pages are repeated across 16 consecutive entries */
+#define DUMP_REPEAT_MASK	0xF
+#define DUMP_PGTB_ENTRY_CNT	(PGTB_SZ / PGD_ENTRY_SZ)
+/* descriptor bits not named by armv7_mmu.h */
+#define DUMP_PGD_SECT_XN	0x10
+#define DUMP_PGD_SECT_NG	0x20000
+#define DUMP_PGTB_LG_XN		0x8000
+#define DUMP_PGTB_LG_TEX_SHIFT	12
+#define DUMP_PGTB_SM_XN		0x1
+#define DUMP_PGTB_NG		0x800
+#define DUMP_TEX_MASK		0x7
+
+/**
+ * armv7_mmu_walk
+ * 
+ * state of a walk
+ * 
+ * @cur		range being accumulated
+ * @valid	true if cur holds a range
+ * @emit	receives each merged range
+ * @arg		argument of emit
+ * @stats	totals of the walk
+ **/
+struct armv7_mmu_walk {
+    struct armv7_mmu_range	cur;
+    bool			valid;
+    void			(*emit)(struct armv7_mmu_range *range, void *arg);
+    void			*arg;
+    struct armv7_mmu_dump_stats	*stats;
+};
+
+static void dump_pgd(struct armv7_mmu_walk *walk, uint8_t ttbr, addr_t pgd_addr, unsigned int first, unsigned int last);
+static void dump_pgtb(struct armv7_mmu_walk *walk, uint8_t ttbr, addr_t virt_addr, addr_t pgd_ent);
+static void dump_add(struct armv7_mmu_walk *walk, struct armv7_mmu_range *range);
+static void dump_flush(struct armv7_mmu_walk *walk);
+static uint8_t dump_mem_type(unsigned int tex, bool cacheable, bool bufferable);
+static void dump_print_range(struct armv7_mmu_range *range, void *arg);
+static void dump_emit_range(struct armv7_mmu_range *range, void *arg);
+static void dump_emit_hex(const uint8_t *buf, size_t len, uint32_t *sum);
+static void dump_put_le32(uint8_t *buf, uint32_t val);
+
+static const char *dump_desc_names[ARMV7_MMU_DESC_CNT] = {
+    "supersection", "section", "large", "small"
+};
+
+/* indexed by AP[2:0] */
+static const char *dump_ap_names[8] = {
+    "none", "krw", "krw/uro", "krw/urw", "resv", "kro", "kro/uro", "kro/uro"
+};
+
+/* normal memory policies of TEX[1:0] / C,B when TEX[2] is set */
+static const uint8_t dump_cache_policies[4] = {
+    ARMV7_MMU_MEM_NORMAL_NC, ARMV7_MMU_MEM_NORMAL_WBWA, ARMV7_MMU_MEM_NORMAL_WT, ARMV7_MMU_MEM_NORMAL_WB
+};
+
+static const char *dump_mem_names[] = {
+    "strongly-ordered", "device", "normal-nc", "normal-wt", "normal-wb", "normal-wbwa", "normal-other"
+};
+
+/**
+ * armv7_mmu_dump_walk
+ * 
+ * walks the active ttbr0 & ttbr1 translation tables in address order,
+ * merging descriptors into ranges (see armv7_mmu_range).
+ * the mmu must be enabled; the tables are read through the linear map.
+ * 
+ * @emit	receives each merged range
+ * @arg		argument of emit
+ * @stats	totals of the walk
+ **/
+void armv7_mmu_dump_walk(void (*emit)(struct armv7_mmu_range *range, void *arg), void *arg,
+    struct armv7_mmu_dump_stats *stats) {
+    struct armv7_mmu_walk walk = {
+	.valid	= false,
+	.emit	= emit,
+	.arg	= arg,
+	.stats	= stats
+    };
+    
+    for (int i = 0; i < ARMV7_MMU_DESC_CNT; i++) {
+	stats->desc_cnt[i] = 0;
+    }
+    
+    stats->pgtb_cnt	= 0;
+    stats->range_cnt	= 0;
+    
+    if (armv7_mmu_is_enabled()) {
+	dump_pgd(&walk, 0, armv7_mmu_get_user_pgd(), 0, armv7_mmu_get_user_pgd_entry_cnt());
+	
+	/* without a split ttbr1 is never used */
+	if (armv7_mmu_get_pg_div() > 0) {
+	    dump_pgd(&walk, 1, armv7_mmu_get_kern_pgd(), armv7_mmu_get_user_pgd_entry_cnt(), PGD_ENTRY_CNT);
+	}
+	
+	dump_flush(&walk);
+    }
+}
+
+/**
+ * armv7_mmu_dump
+ * 
+ * prints the active translation tables as merged ranges, followed by the
+ * same ranges as a binary export for host analysis.  each line of the
+ * export is prefixed by "ptdump: " & carries hex encoded, little endian
+ * records:
+ *   begin <version>
+ *   r <va:4 pa:4 size:4 ttbr:1 type:1 ap:1 domain:1 mem:1 flags:1 pad:2>
+ *   c <supersections:4 sections:4 large pages:4 small pages:4 page tables:4>
+ *   end <sum of every record byte:4>
+ **/
+void armv7_mmu_dump(void) {
+    struct armv7_mmu_dump_stats	stats;
+    uint8_t			rec[ARMV7_MMU_DESC_CNT * 4 + 4];
+    uint32_t			sum	= 0;
+    
+    mach_early_kprintf("mmu: translation tables (ttbcr.n %i)\n", armv7_mmu_get_pg_div());
+    armv7_mmu_dump_walk(dump_print_range, NULL, &stats);
+    
+    mach_early_kprintf("mmu: %i ranges, %i page tables; supersections %i, sections %i, large %i, small %i\n",
+	stats.range_cnt, stats.pgtb_cnt, stats.desc_cnt[ARMV7_MMU_DESC_SUPER_SECT],
+	stats.desc_cnt[ARMV7_MMU_DESC_SECT], stats.desc_cnt[ARMV7_MMU_DESC_LARGE_PG],
+	stats.desc_cnt[ARMV7_MMU_DESC_SMALL_PG]);
+    
+    mach_early_kprintf("ptdump: begin 1\n");
+    armv7_mmu_dump_walk(dump_emit_range, &sum, &stats);
+    
+    for (int i = 0; i < ARMV7_MMU_DESC_CNT; i++) {
+	dump_put_le32(&rec[i * 4], stats.desc_cnt[i]);
+    }
+    
+    dump_put_le32(&rec[ARMV7_MMU_DESC_CNT * 4], stats.pgtb_cnt);
+    
+    mach_early_kprintf("ptdump: c ");
+    dump_emit_hex(rec, sizeof(rec), &sum);
+    mach_early_kprintf("\n");
+    
+    dump_put_le32(rec, sum);
+    mach_early_kprintf("ptdump: end ");
+    dump_emit_hex(rec, 4, NULL);
+    mach_early_kprintf("\n");
+}
+
+/**
+ * dump_pgd
+ * 
+ * walks a range of page directory entries
+ * 
+ * @walk	walk
+ * @ttbr	translation table of pgd_addr
+ * @pgd_addr	physical address of page directory
+ * @first	first entry
+ * @last	entry past the last
+ **/
+static void dump_pgd(struct armv7_mmu_walk *walk, uint8_t ttbr, addr_t pgd_addr, unsigned int first, unsigned int last) {
+    uint32_t			*pg_dir	= (uint32_t *)__va(pgd_addr);
+    addr_t			ent	= 0;
+    struct armv7_mmu_range	range;
+    
+    for (unsigned int i = first; i < last; i++) {
+	ent = pg_dir[i];
+	
+	if ((ent & PGD_TYPE_MASK) == ARMV7_MMU_PGD_TABLE) {
+	    walk->stats->pgtb_cnt++;
+	    dump_pgtb(walk, ttbr, (i << PGD_IDX_SHIFT), ent);
+	} else if ((ent & ARMV7_MMU_PGD_SECTION) && (!(ent & PGD_SECT_SUPER) || !(i & DUMP_REPEAT_MASK))) {
+	    range.virt_addr	= (i << PGD_IDX_SHIFT);
+	    range.ttbr		= ttbr;
+	    range.ap		= ((ent & PGD_AP_MASK) >> PGD_SECT_AP_SHIFT) | ((ent & PGD_SECT_APX) ? ARMV7_MMU_ACC_APX : 0);
+	    range.mem		= dump_mem_type(((ent >> PGD_SECT_TEX_SHIFT) & DUMP_TEX_MASK), (ent & PGD_SECT_C), (ent & PGD_SECT_B));
+	    range.flags		= ((ent & DUMP_PGD_SECT_XN) ? ARMV7_MMU_RANGE_XN : 0) | 
+				  ((ent & PGD_SECT_S) ? ARMV7_MMU_RANGE_SHARED : 0) | 
+				  ((ent & DUMP_PGD_SECT_NG) ? ARMV7_MMU_RANGE_NG : 0);
+	    
+	    if (ent & PGD_SECT_SUPER) {
+		/* supersections are always domain 0 */
+		range.phy_addr	= ent & PGD_SUPER_SECT_MASK;
+		range.size	= DUMP_SUPER_SECT_SZ;
+		range.type	= ARMV7_MMU_DESC_SUPER_SECT;
+		range.domain	= 0;
+	    } else {
+		range.phy_addr	= ent & PGD_SECT_MASK;
+		range.size	= DUMP_SECT_SZ;
+		range.type	= ARMV7_MMU_DESC_SECT;
+		range.domain	= (ent & PGD_DOMAIN_MASK) >> PGD_DOMAIN_SHIFT;
+	    }
+	    
+	    dump_add(walk, &range);
+	}
+    }
+}
+
+/**
+ * dump_pgtb
+ * 
+ * walks the entries of a page table
+ * 
+ * @walk	walk
+ * @ttbr	translation table the page table belongs to
+ * @virt_addr	virtual address translated by the page table
+ * @pgd_ent	page directory entry of the page table
+ **/
+static void dump_pgtb(struct armv7_mmu_walk *walk, uint8_t ttbr, addr_t virt_addr, addr_t pgd_ent) {
+    uint32_t			*pg_tb	= (uint32_t *)__va(pgd_ent & PGD_TABLE_MASK);
+    addr_t			ent	= 0;
+    struct armv7_mmu_range	range;
+    
+    range.ttbr		= ttbr;
+    range.domain	= (pgd_ent & PGD_DOMAIN_MASK) >> PGD_DOMAIN_SHIFT;
+    
+    for (unsigned int i = 0; i < DUMP_PGTB_ENTRY_CNT; i++) {
+	ent = pg_tb[i];
+	
+	/* bit 0 is XN for small pages */
+	if (ent & ARMV7_MMU_PGTB_SMALL_PG) {
+	    range.phy_addr	= ent & PGTB_SM_PG_MASK;
+	    range.size		= DUMP_SMALL_PG_SZ;
+	    range.type		= ARMV7_MMU_DESC_SMALL_PG;
+	    range.mem		= dump_mem_type(((ent >> PGTB_TEX_SHIFT) & DUMP_TEX_MASK), (ent & PGTB_C), (ent & PGTB_B));
+	    range.flags		= (ent & DUMP_PGTB_SM_XN) ? ARMV7_MMU_RANGE_XN : 0;
+	} else if ((ent & PGTB_TYPE_MASK) == ARMV7_MMU_PGTB_LARGE_PG && !(i & DUMP_REPEAT_MASK)) {
+	    range.phy_addr	= ent & PGTB_LG_PG_MASK;
+	    range.size		= DUMP_LARGE_PG_SZ;
+	    range.type		= ARMV7_MMU_DESC_LARGE_PG;
+	    range.mem		= dump_mem_type(((ent >> DUMP_PGTB_LG_TEX_SHIFT) & DUMP_TEX_MASK), (ent & PGTB_C), (ent & PGTB_B));
+	    range.flags		= (ent & DUMP_PGTB_LG_XN) ? ARMV7_MMU_RANGE_XN : 0;
+	} else {
+	    continue;
+	}
+	
+	range.virt_addr	= virt_addr + (i << PGTB_IDX_SHIFT);
+	range.ap	= ((ent >> PGTB_AP_SHIFT) & ARMV7_MMU_ACC_AP_MASK) | ((ent & PGTB_APX) ? ARMV7_MMU_ACC_APX : 0);
+	range.flags	|= ((ent & PGTB_S) ? ARMV7_MMU_RANGE_SHARED : 0) | ((ent & DUMP_PGTB_NG) ? ARMV7_MMU_RANGE_NG : 0);
+	
+	dump_add(walk, &range);
+    }
+}
+
+/**
+ * dump_add
+ * 
+ * adds a descriptor to the walk; it extends the current range when it
+ * directly follows it (virtually & physically) with the same attributes.
+ * 
+ * @walk	walk
+ * @range	range of a single descriptor
+ **/
+static void dump_add(struct armv7_mmu_walk *walk, struct armv7_mmu_range *range) {
+    struct armv7_mmu_range *cur = &walk->cur;
+    
+    walk->stats->desc_cnt[range->type]++;
+    
+    if (walk->valid && cur->ttbr == range->ttbr && cur->type == range->type && 
+	cur->ap == range->ap && cur->domain == range->domain && cur->mem == range->mem && 
+	cur->flags == range->flags && (cur->virt_addr + cur->size) == range->virt_addr &&
+	(cur->phy_addr + cur->size) == range->phy_addr) {
+	cur->size += range->size;
+    } else {
+	dump_flush(walk);
+	
+	walk->cur	= *range;
+	walk->valid	= true;
+    }
+}
+
+/**
+ * dump_flush
+ * 
+ * emits the current range of the walk, if any
+ * 
+ * @walk	walk
+ **/
+static void dump_flush(struct armv7_mmu_walk *walk) {
+    if (walk->valid) {
+	walk->stats->range_cnt++;
+	walk->emit(&walk->cur, walk->arg);
+	walk->valid = false;
+    }
+}
+
+/**
+ * dump_mem_type
+ * 
+ * decodes the memory type of a descriptor (TEX remap disabled)
+ * 
+ * @tex		TEX[2:0]
+ * @cacheable	C bit
+ * @bufferable	B bit
+ * @return ARMV7_MMU_MEM_*
+ **/
+static uint8_t dump_mem_type(unsigned int tex, bool cacheable, bool bufferable) {
+    unsigned int	attr	= (tex << 2) | (cacheable << 1) | bufferable;
+    uint8_t		ret	= ARMV7_MMU_MEM_OTHER;
+    
+    switch (attr) {
+	case 0x0:
+	    ret = ARMV7_MMU_MEM_STRONG;
+	    break;
+	case 0x1:
+	case 0x8:
+	    ret = ARMV7_MMU_MEM_DEVICE;
+	    break;
+	case 0x2:
+	    ret = ARMV7_MMU_MEM_NORMAL_WT;
+	    break;
+	case 0x3:
+	    ret = ARMV7_MMU_MEM_NORMAL_WB;
+	    break;
+	case 0x4:
+	    ret = ARMV7_MMU_MEM_NORMAL_NC;
+	    break;
+	case 0x7:
+	    ret = ARMV7_MMU_MEM_NORMAL_WBWA;
+	    break;
+	default:
+	    /* TEX[2] set: outer (TEX[1:0]) & inner (C,B) policies given separately */
+	    if ((tex & 0x4) && (tex & 0x3) == (attr & 0x3)) {
+		ret = dump_cache_policies[attr & 0x3];
+	    }
+	    break;
+    }
+    
+    return ret;
+}
+
+/**
+ * dump_print_range
+ * 
+ * prints a range (see armv7_mmu_dump_walk)
+ * 
+ * @range	range
+ * @arg		unused
+ **/
+static void dump_print_range(struct armv7_mmu_range *range, void *arg) {
+    (void)arg;
+    
+    mach_early_kprintf("mmu: ttbr%i 0x%x-0x%x -> 0x%x %iK %s %s d%i %s%s%s%s\n",
+	range->ttbr, range->virt_addr, (range->virt_addr + (range->size - 1)), range->phy_addr,
+	(range->size >> 10), dump_desc_names[range->type], dump_ap_names[range->ap], range->domain,
+	dump_mem_names[range->mem], (range->flags & ARMV7_MMU_RANGE_SHARED) ? " s" : "",
+	(range->flags & ARMV7_MMU_RANGE_XN) ? " xn" : "", (range->flags & ARMV7_MMU_RANGE_NG) ? " ng" : "");
+}
+
+/**
+ * dump_emit_range
+ * 
+ * emits a range as a record of the binary export (see armv7_mmu_dump_walk)
+ * 
+ * @range	range
+ * @arg		running sum of the export
+ **/
+static void dump_emit_range(struct armv7_mmu_range *range, void *arg) {
+    uint8_t rec[ARMV7_MMU_DUMP_REC_SZ];
+    
+    dump_put_le32(&rec[0], range->virt_addr);
+    dump_put_le32(&rec[4], range->phy_addr);
+    dump_put_le32(&rec[8], range->size);
+    rec[12] = range->ttbr;
+    rec[13] = range->type;
+    rec[14] = range->ap;
+    rec[15] = range->domain;
+    rec[16] = range->mem;
+    rec[17] = range->flags;
+    rec[18] = 0;
+    rec[19] = 0;
+    
+    mach_early_kprintf("ptdump: r ");
+    dump_emit_hex(rec, sizeof(rec), (uint32_t *)arg);
+    mach_early_kprintf("\n");
+}
+
+/**
+ * dump_emit_hex
+ * 
+ * prints bytes as hex
+ * 
+ * @buf		bytes
+ * @len		number of bytes
+ * @sum		running sum the bytes are added to (or NULL)
+ **/
+static void dump_emit_hex(const uint8_t *buf, size_t len, uint32_t *sum) {
+    static const char hex[] = "0123456789abcdef";
+    
+    for (size_t i = 0; i < len; i++) {
+	mach_early_kprintf("%c%c", hex[buf[i] >> 4], hex[buf[i] & 0xF]);
+	
+	if (sum != NULL) {
+	    *sum += buf[i];
+	}
+    }
+}
+
+/**
+ * dump_put_le32
+ * 
+ * stores a 32 bit value little endian
+ * 
+ * @buf		destination
+ * @val		value
+ **/
+static void dump_put_le32(uint8_t *buf, uint32_t val) {
+    for (int i = 0; i < 4; i++) {
+	buf[i] = (val >> (i * 8)) & 0xFF;
+    }
+}
+
+#endif
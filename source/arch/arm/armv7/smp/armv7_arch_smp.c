@@ -0,0 +1,49 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * armv7_arch_smp.c provides the arch_smp interface.
+ */
+#include <arch/arm/armv7/armv7.h>
+#include <arch/arm/armv7/armv7_syscntl.h>
+#include <arch/arm/gic.h>
+#include <arch/arch_smp.h>
+
+unsigned int arch_smp_get_cpu_id(void) {
+#ifdef CONFIG_SMP
+    return (armv7_get_mpidr() & ARMV7_MPIDR_CPU_MASK);
+#else
+    return 0;
+#endif
+}
+
+void arch_smp_send_ipi(unsigned int cpu_mask, ipi_t ipi) {
+    /* the gic's cpu interfaces are numbered as the cpus */
+    gic_send_sgi(cpu_mask, (unsigned int)ipi);
+}
+
+void arch_smp_idle(void) {
+    /* a pending irq ends wfi even while masked */
+    dsb();
+    asm volatile("wfi" : : : "memory");
+    
+    asm volatile("cpsie i\n\t"
+		 "isb\n\t"
+		 "cpsid i" : : : "memory");
+}
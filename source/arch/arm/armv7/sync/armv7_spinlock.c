@@ -0,0 +1,97 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * armv7_spinlock.c provides the arch_sync spinlock & irq interface.
+ */
+#include <arch/arm/armv7/armv7.h>
+#include <arch/arch_sync.h>
+#include <sync/spinlock.h>
+#include <types.h>
+#include <stdbool.h>
+
+void arch_spin_lock(struct spinlock *lock) {
+    uint32_t	tickets	= 0;
+    uint32_t	next	= 0;
+    uint32_t	fail	= 0;
+    uint16_t	ticket	= 0;
+    
+    /* take the next ticket */
+    asm volatile("1:\n\t"
+		 "ldrex %0, [%3]\n\t"
+		 "add %1, %0, %4\n\t"
+		 "strex %2, %1, [%3]\n\t"
+		 "teq %2, #0\n\t"
+		 "bne 1b"
+		 : "=&r" (tickets), "=&r" (next), "=&r" (fail)
+		 : "r" (&lock->tickets), "r" (1 << SPIN_TICKET_SHIFT)
+		 : "cc", "memory");
+    
+    ticket = (uint16_t)(tickets >> SPIN_TICKET_SHIFT);
+    
+    /* an unlock between the check & wfe leaves the event set */
+    while (ticket != (uint16_t)(tickets & SPIN_TICKET_MASK)) {
+	wfe();
+	tickets = lock->owner;
+    }
+    
+    dmb();
+}
+
+bool arch_spin_trylock(struct spinlock *lock) {
+    uint32_t	tickets	= 0;
+    uint32_t	busy	= 0;
+    uint32_t	fail	= 0;
+    
+    /* a ticket is only taken if it would be served immediately */
+    do {
+	asm volatile("ldrex %0, [%3]\n\t"
+		     "mov %2, #0\n\t"
+		     "subs %1, %0, %0, ror #16\n\t"
+		     "addeq %0, %0, %4\n\t"
+		     "strexeq %2, %0, [%3]"
+		     : "=&r" (tickets), "=&r" (busy), "=&r" (fail)
+		     : "r" (&lock->tickets), "r" (1 << SPIN_TICKET_SHIFT)
+		     : "cc", "memory");
+    } while (fail != 0);
+    
+    if (busy == 0) {
+	dmb();
+    }
+    
+    return (busy == 0);
+}
+
+void arch_spin_unlock(struct spinlock *lock) {
+    dmb();
+    
+    /* only the holder writes owner */
+    lock->owner = (uint16_t)(lock->owner + 1);
+    
+    dsb();
+    sev();
+}
+
+unsigned int arch_irq_save(void) {
+    return armv7_irq_save();
+}
+
+void arch_irq_restore(unsigned int flags) {
+    armv7_irq_restore(flags);
+}
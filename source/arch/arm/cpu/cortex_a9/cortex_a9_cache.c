@@ -0,0 +1,88 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <arch/arm/armv7/armv7.h>
+#include <arch/arm/armv7/armv7_cache.h>
+#include <arch/arm/armv7/armv7_syscntl.h>
+#include <arch/arm/cpu/cortex_a9.h>
+#include <mm/mem.h>
+#include <types.h>
+
+/**
+ * cortex_a9_scu_enable
+ * 
+ * invalidates the snoop control unit tag rams and enables the
+ * snoop control unit.
+ * this only needs to be performed once (by the boot cpu); if the
+ * scu is already enabled, this does nothing.
+ **/
+void cortex_a9_scu_enable(void) {
+    addr_t base = cortex_a9_get_scu_base();
+    
+    if (!cortex_a9_scu_is_enabled()) {
+	/* invalidate all ways, for all cpus */
+	memw(base + CORTEX_A9_SCU_INVAL_ALL, CORTEX_A9_SCU_INVAL_ALL_WAYS);
+	memw(base + CORTEX_A9_SCU_CNTL, 
+	    memr(base + CORTEX_A9_SCU_CNTL) | CORTEX_A9_SCU_CNTL_ENB);
+	
+	dsb();
+    }
+}
+
+/**
+ * cortex_a9_cache_init
+ * 
+ * brings up the level 1 caches of the calling cpu.
+ * the sequence is:
+ * invalidate the data cache by set/way, invalidate the instruction cache
+ * and branch predictor, enable the scu, set ACTLR.SMP/FW (joining coherency
+ * and broadcasting maintenance) and lastly enable the caches & branch
+ * prediction selected by flags.
+ * 
+ * @flags	CORTEX_A9_CACHE_xxx flags
+ **/
+void cortex_a9_cache_init(unsigned int flags) {
+    unsigned int sctlr_bits = 0;
+    
+    /* the caches must be in a known state prior to being enabled */
+    armv7_dcache_inval_all();
+    armv7_icache_inval_all();
+    
+    if (flags & CORTEX_A9_CACHE_SCU) {
+	cortex_a9_scu_enable();
+	
+	armv7_set_aux_cntl(armv7_get_aux_cntl() | CORTEX_A9_ACTLR_SMP | CORTEX_A9_ACTLR_FW);
+	isb();
+    }
+    
+    if (flags & CORTEX_A9_CACHE_DCACHE) {
+	sctlr_bits |= ARMV7_SCTLR_DCACHE_ENB;
+    }
+    
+    if (flags & CORTEX_A9_CACHE_ICACHE) {
+	sctlr_bits |= ARMV7_SCTLR_ICACHE_ENB;
+    }
+    
+    if (flags & CORTEX_A9_CACHE_BPRED) {
+	sctlr_bits |= ARMV7_SCTLR_BPRED_ENB;
+    }
+    
+    armv7_cache_enable(sctlr_bits);
+}
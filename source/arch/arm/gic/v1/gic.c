@@ -0,0 +1,123 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <arch/arm/gic.h>
+#include <sync/barriers.h>
+#include <util/fdt.h>
+#include <mm/mem.h>
+#include <mm/vmalloc.h>
+#include <types.h>
+#include <errno.h>
+
+/* the sgi enables are banked per cpu */
+#define GICD_SGI_ENB_MASK	0xFFFF
+
+/* virtual addresses of the distributor & cpu interface (see ioremap) */
+static addr_t gicd_base = 0x0;
+static addr_t gicc_base = 0x0;
+
+/**
+ * gic_init
+ * 
+ * discovers the GIC from the fdt ("arm,cortex-a9-gic"), enables
+ * the distributor & the calling cpu's interface.
+ * the first "reg" entry is the distributor, the second the cpu interface;
+ * both are mapped through ioremap, so vmalloc_init must have completed.
+ * 
+ * @fdt_base	base address of fdt
+ * @return errno
+ **/
+int gic_init(addr_t fdt_base) {
+    struct fdt_node	*node	= NULL;
+    struct fdt_property	*prop	= NULL;
+    fdt32_t		*reg	= NULL;
+    int			ret	= ESUCC;
+    
+    if ((node = fdt_get_compatible_node(GIC_COMPATIBLE, fdt_base)) == NULL) {
+	ret = ENOTFND;
+    } else if ((prop = fdt_get_property(fdt_base, node, "reg")) == NULL) {
+	ret = ENOTFND;
+    } else if (be32_to_cpu(prop->length) < (sizeof(fdt32_t) * 4)) {
+	ret = EINVAL;
+    } else {
+	reg = (fdt32_t *)prop->data;
+	
+	gicd_base = (addr_t)ioremap(be32_to_cpu(reg[0]), be32_to_cpu(reg[1]));
+	gicc_base = (addr_t)ioremap(be32_to_cpu(reg[2]), be32_to_cpu(reg[3]));
+	
+	if (gicd_base == 0x0 || gicc_base == 0x0) {
+	    ret = ENOMEM;
+	} else {
+	    memw(gicd_base + GICD_CTLR, GICD_CTLR_ENB);
+	    gic_cpu_init();
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * gic_cpu_init
+ * 
+ * enables the calling cpu's interface & its sgis.
+ * secondary cpus must call this once gic_init has completed.
+ **/
+void gic_cpu_init(void) {
+    memw(gicd_base + GICD_ISENABLER, GICD_SGI_ENB_MASK);
+    memw(gicc_base + GICC_PMR, GICC_PMR_ALL);
+    memw(gicc_base + GICC_CTLR, GICC_CTLR_ENB);
+}
+
+/**
+ * gic_send_sgi
+ * 
+ * raises a software generated interrupt on the cpus in cpu_mask.
+ * prior memory accesses are made visible before the sgi is raised.
+ * 
+ * @cpu_mask	bitmask of target cpu interfaces
+ * @sgi_id	sgi to raise (< GIC_SGI_CNT)
+ **/
+void gic_send_sgi(unsigned int cpu_mask, unsigned int sgi_id) {
+    arch_dsb();
+    memw(gicd_base + GICD_SGIR, ((cpu_mask & GICD_SGIR_TARGET_MASK) << GICD_SGIR_TARGET_SHIFT) |
+	(sgi_id & GICD_SGIR_ID_MASK));
+}
+
+/**
+ * gic_ack
+ * 
+ * acknowledges the highest priority pending interrupt.
+ * 
+ * @return value of GICC_IAR; the id is (iar & GICC_IAR_ID_MASK)
+ **/
+unsigned int gic_ack(void) {
+    return memr(gicc_base + GICC_IAR);
+}
+
+/**
+ * gic_eoi
+ * 
+ * signals completion of an interrupt returned by gic_ack.
+ * 
+ * @iar		value returned by gic_ack
+ **/
+void gic_eoi(unsigned int iar) {
+    memw(gicc_base + GICC_EOIR, iar);
+}
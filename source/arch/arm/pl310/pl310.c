@@ -0,0 +1,334 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <arch/arm/pl310.h>
+#include <sync/barriers.h>
+#include <sync/spinlock.h>
+#include <util/bits.h>
+#include <util/fdt.h>
+#include <mm/cache.h>
+#include <mm/mem.h>
+#include <mm/vmalloc.h>
+#include <types.h>
+#include <errno.h>
+#include <stdbool.h>
+
+#define WAY_SZ_BASE	0x2000
+
+/* helper functions */
+static void pl310_clean_range(addr_t phy_start, size_t size);
+static void pl310_inval_range(addr_t phy_start, size_t size);
+static void pl310_clean_inval_range(addr_t phy_start, size_t size);
+static void pl310_clean_inval_all(void);
+static void pl310_sync(void);
+static void pl310_disable(void);
+static void pl310_cache_sync(void);
+static void pl310_op_way(unsigned int reg);
+static void pl310_op_pa(unsigned int reg, addr_t start, addr_t end);
+static unsigned int pl310_fdt_aux(addr_t fdt_base, struct fdt_node *node, unsigned int aux);
+
+/*
+ * held over every maintenance operation; the controller mustn't be sent
+ * an operation while a background (way) operation is in progress, and
+ * the cpus may otherwise interleave them.
+ */
+static spinlock_t	pl310_lock	= SPINLOCK_INIT;
+/* virtual address of the controller (see ioremap) */
+static addr_t		pl310_base	= 0x0;
+static unsigned int	pl310_way_mask	= 0;
+static size_t		pl310_size	= 0;
+
+static const struct outer_cache_ops pl310_ops = {
+    .clean_range	= pl310_clean_range,
+    .inval_range	= pl310_inval_range,
+    .clean_inval_range	= pl310_clean_inval_range,
+    .clean_inval_all	= pl310_clean_inval_all,
+    .sync		= pl310_sync,
+    .disable		= pl310_disable
+};
+
+/**
+ * pl310_init
+ * 
+ * discovers the PL310 from the fdt ("arm,pl310-cache"), configures
+ * the auxiliary control register, enables the cache and registers it
+ * as the outer cache.
+ * the auxiliary control register is computed as ((aux & aux_mask) | aux_val),
+ * after which the fdt properties "arm,prefetch-data", "arm,prefetch-instr" and
+ * "arm,early-bresp-disable" are applied.
+ * if the controller was already enabled (i.e., by firmware) its configuration
+ * is left untouched.
+ * the controller is mapped through ioremap, so vmalloc_init must have completed.
+ * 
+ * @fdt_base	base address of fdt
+ * @aux_val	auxiliary control bits to set
+ * @aux_mask	auxiliary control bits to keep
+ * @return errno
+ **/
+int pl310_init(addr_t fdt_base, unsigned int aux_val, unsigned int aux_mask) {
+    struct fdt_node	*node	= NULL;
+    struct fdt_property	*prop	= NULL;
+    unsigned int	aux	= 0;
+    unsigned int	way_sz	= 0;
+    int			ret	= ESUCC;
+    
+    if ((node = fdt_get_compatible_node(PL310_COMPATIBLE, fdt_base)) == NULL) {
+	ret = ENOTFND;
+    } else if ((prop = fdt_get_property(fdt_base, node, "reg")) == NULL) {
+	ret = ENOTFND;
+    } else if (be32_to_cpu(prop->length) < (sizeof(fdt32_t) * 2)) {
+	ret = EINVAL;
+    } else if ((pl310_base = (addr_t)ioremap(be32_to_cpu(((fdt32_t *)prop->data)[0]),
+					      be32_to_cpu(((fdt32_t *)prop->data)[1]))) == 0x0) {
+	ret = ENOMEM;
+    } else {
+	if (!(memr(pl310_base + PL310_CNTL) & PL310_CNTL_ENB)) {
+	    aux = memr(pl310_base + PL310_AUX_CNTL);
+	    aux = (aux & aux_mask) | aux_val;
+	    aux = pl310_fdt_aux(fdt_base, node, aux);
+	    
+	    /* aux may only be written while disabled */
+	    memw(pl310_base + PL310_AUX_CNTL, aux);
+	}
+	
+	/* geometry */
+	aux		= memr(pl310_base + PL310_AUX_CNTL);
+	way_sz		= (aux & PL310_AUX_WAY_SZ_MASK) >> PL310_AUX_WAY_SZ_SHIFT;
+	
+	if (aux & PL310_AUX_ASSOC_16) {
+	    pl310_way_mask	= PL310_WAY_MASK_16;
+	    pl310_size		= (WAY_SZ_BASE << way_sz) * 16;
+	} else {
+	    pl310_way_mask	= PL310_WAY_MASK_8;
+	    pl310_size		= (WAY_SZ_BASE << way_sz) * 8;
+	}
+	
+	if (!(memr(pl310_base + PL310_CNTL) & PL310_CNTL_ENB)) {
+	    /* contents are unknown out of reset */
+	    pl310_op_way(PL310_INVAL_WAY);
+	    
+	    memw(pl310_base + PL310_CNTL, PL310_CNTL_ENB);
+	    arch_dsb();
+	}
+	
+	ret = outer_cache_register(&pl310_ops);
+    }
+    
+    return ret;
+}
+
+/**
+ * pl310_fdt_aux
+ * 
+ * applies the fdt prefetch & early bresp properties to aux.
+ * 
+ * @fdt_base	base address of fdt
+ * @node	pl310 node
+ * @aux		auxiliary control value
+ * @return updated auxiliary control value
+ **/
+static unsigned int pl310_fdt_aux(addr_t fdt_base, struct fdt_node *node, unsigned int aux) {
+    struct fdt_property *prop = NULL;
+    
+    if ((prop = fdt_get_property(fdt_base, node, "arm,prefetch-data")) != NULL) {
+	if (be32_to_cpu(*(fdt32_t *)prop->data)) {
+	    aux |= PL310_AUX_DATA_PREFETCH;
+	} else {
+	    aux &= ~PL310_AUX_DATA_PREFETCH;
+	}
+    }
+    
+    if ((prop = fdt_get_property(fdt_base, node, "arm,prefetch-instr")) != NULL) {
+	if (be32_to_cpu(*(fdt32_t *)prop->data)) {
+	    aux |= PL310_AUX_INST_PREFETCH;
+	} else {
+	    aux &= ~PL310_AUX_INST_PREFETCH;
+	}
+    }
+    
+    if (fdt_get_property(fdt_base, node, "arm,early-bresp-disable") != NULL) {
+	aux &= ~PL310_AUX_EARLY_BRESP;
+    }
+    
+    return aux;
+}
+
+/**
+ * pl310_clean_range
+ * 
+ * writes back dirty lines in a physical range
+ * 
+ * @phy_start	physical start address
+ * @size	size (in bytes) of range
+ **/
+static void pl310_clean_range(addr_t phy_start, size_t size) {
+    unsigned int flags = spin_lock_irqsave(&pl310_lock);
+    
+    if (size >= pl310_size) {
+	pl310_op_way(PL310_CLEAN_WAY);
+    } else {
+	pl310_op_pa(PL310_CLEAN_PA, phy_start, phy_start + size);
+	pl310_cache_sync();
+    }
+    
+    spin_unlock_irqrestore(&pl310_lock, flags);
+}
+
+/**
+ * pl310_inval_range
+ * 
+ * discards lines in a physical range; partial lines at either end
+ * are cleaned first so neighbouring data isn't lost.
+ * 
+ * @phy_start	physical start address
+ * @size	size (in bytes) of range
+ **/
+static void pl310_inval_range(addr_t phy_start, size_t size) {
+    addr_t start	= phy_start;
+    addr_t end		= phy_start + size;
+    unsigned int flags	= spin_lock_irqsave(&pl310_lock);
+    
+    if (start & (PL310_LINE_SZ - 1)) {
+	start &= ~(PL310_LINE_SZ - 1);
+	memw(pl310_base + PL310_CLEAN_INVAL_PA, start);
+	start += PL310_LINE_SZ;
+    }
+    
+    if ((end & (PL310_LINE_SZ - 1)) && (end > start)) {
+	end &= ~(PL310_LINE_SZ - 1);
+	memw(pl310_base + PL310_CLEAN_INVAL_PA, end);
+    }
+    
+    pl310_op_pa(PL310_INVAL_PA, start, end);
+    pl310_cache_sync();
+    
+    spin_unlock_irqrestore(&pl310_lock, flags);
+}
+
+/**
+ * pl310_clean_inval_range
+ * 
+ * writes back & discards lines in a physical range
+ * 
+ * @phy_start	physical start address
+ * @size	size (in bytes) of range
+ **/
+static void pl310_clean_inval_range(addr_t phy_start, size_t size) {
+    unsigned int flags = spin_lock_irqsave(&pl310_lock);
+    
+    if (size >= pl310_size) {
+	pl310_op_way(PL310_CLEAN_INVAL_WAY);
+    } else {
+	pl310_op_pa(PL310_CLEAN_INVAL_PA, phy_start, phy_start + size);
+	pl310_cache_sync();
+    }
+    
+    spin_unlock_irqrestore(&pl310_lock, flags);
+}
+
+/**
+ * pl310_clean_inval_all
+ * 
+ * writes back & discards every line
+ **/
+static void pl310_clean_inval_all(void) {
+    unsigned int flags = spin_lock_irqsave(&pl310_lock);
+    
+    pl310_op_way(PL310_CLEAN_INVAL_WAY);
+    
+    spin_unlock_irqrestore(&pl310_lock, flags);
+}
+
+/**
+ * pl310_sync
+ * 
+ * drains the controller's store & eviction buffers
+ **/
+static void pl310_sync(void) {
+    unsigned int flags = spin_lock_irqsave(&pl310_lock);
+    
+    pl310_cache_sync();
+    
+    spin_unlock_irqrestore(&pl310_lock, flags);
+}
+
+/**
+ * pl310_disable
+ * 
+ * cleans, invalidates & disables the controller
+ **/
+static void pl310_disable(void) {
+    unsigned int flags = spin_lock_irqsave(&pl310_lock);
+    
+    pl310_op_way(PL310_CLEAN_INVAL_WAY);
+    
+    memw(pl310_base + PL310_CNTL, 0);
+    arch_dsb();
+    
+    spin_unlock_irqrestore(&pl310_lock, flags);
+}
+
+/**
+ * pl310_cache_sync
+ * 
+ * drains the controller's store & eviction buffers; pl310_lock must
+ * be held (or the controller be unregistered).
+ **/
+static void pl310_cache_sync(void) {
+    memw(pl310_base + PL310_CACHE_SYNC, 0);
+    
+    while (memr(pl310_base + PL310_CACHE_SYNC) & 0x1);
+}
+
+/**
+ * pl310_op_way
+ * 
+ * performs a background maintenance operation on every way
+ * and waits for it to complete; pl310_lock must be held (or the
+ * controller be unregistered).
+ * 
+ * @reg	way operation register
+ **/
+static void pl310_op_way(unsigned int reg) {
+    memw(pl310_base + reg, pl310_way_mask);
+    
+    while (memr(pl310_base + reg) & pl310_way_mask);
+    
+    pl310_cache_sync();
+}
+
+/**
+ * pl310_op_pa
+ * 
+ * performs a maintenance operation on every line within
+ * [start, end); pl310_lock must be held.
+ * 
+ * @reg		physical address operation register
+ * @start	physical start address
+ * @end		physical end address
+ **/
+static void pl310_op_pa(unsigned int reg, addr_t start, addr_t end) {
+    start &= ~(PL310_LINE_SZ - 1);
+    
+    while (start < end) {
+	memw(pl310_base + reg, start);
+	start += PL310_LINE_SZ;
+    }
+}
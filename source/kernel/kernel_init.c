@@ -20,17 +20,29 @@
  */
 #include <mach/mach.h> /* TODO: tmp */
 #include <init/kinit.h>
+#include <arch/arch_mmu.h>
 #include <mm/mem.h>
+#include <mm/pmm.h>
+#include <mm/tlb.h>
+#include <mm/vmalloc.h>
 #include <types.h>
 #include <util/fdt.h>
 #include <memlayout.h>
+#include <percpu.h>
+#include <smp.h>
+#include <smp_call_bench.h>
+#include <sync/lock_bench.h>
+#include <sync/lockstat.h>
+#include <sync/rcu.h>
 #include <errno.h>
 
 
 extern void install_ivt();
+static int kernel_init_pmm(addr_t atag_fdt_base);
+
 /**
  * expectation when entering kernel_init is that a 1:1 mapping has been
- * utilized.
+ * utilized & ram has been mapped linearly at kv_start (see memlayout.h).
  */
 void kernel_init(unsigned int mach, addr_t atag_fdt_base, 
     struct mm_vreg *mmu_pgtb_reg, struct mm_vreg *reserved_regs, 
@@ -38,16 +50,69 @@ void kernel_init(unsigned int mach, addr_t atag_fdt_base,
     struct mm_reg mem_reg;
     size_t hmi_bss_sz	= (size_t)&hmi_bss_start - (size_t)&hmi_bss_end;
     size_t k_bss_sz	= (size_t)&k_bss_end - (size_t)&k_bss_start;
+    int err		= ESUCC;
     
     /* clear hmi & kernel bss */
     memset(&hmi_bss_start, 0, hmi_bss_sz);
     memset(&k_bss_start, 0, k_bss_sz);
     
     mach_early_kprintf("inside kernel_init\n");
+    
+    if ((err = percpu_init()) != ESUCC) {
+	mach_early_kprintf("percpu_init() failed with %i\n", err);
+    }
+    
+    rcu_init();
+    
+#ifdef CONFIG_LOCKSTAT
+    lockstat_cpu_init();
+#endif
+    
     install_ivt();
     
+    /* the boot cpu translates through the kernel space from here on */
+    vm_space_enter(&kern_vm_space);
+    
     dump_fdt(atag_fdt_base);
     
+    if ((err = kernel_init_pmm(atag_fdt_base)) != ESUCC) {
+	mach_early_kprintf("kernel_init_pmm() failed with %i\n", err);
+    }
+    
+    vmalloc_init();
+    
+    /* device registers are mapped through ioremap from here on */
+#ifdef CONFIG_OUTER_CACHE
+    if (mach_init_outer_cache(atag_fdt_base) != ESUCC) {
+	mach_early_kprintf("outer cache unavailable\n");
+    }
+#endif
+    
+#ifdef CONFIG_SMP
+    if (mach_init_irq_cntl(atag_fdt_base) != ESUCC) {
+	mach_early_kprintf("interrupt controller unavailable\n");
+    }
+#endif
+    
+#ifdef CONFIG_MMU_DUMP
+    arch_mmu_dump();
+#endif
+    
+    /* secondary cpus share the kernel space & tables set up above */
+    smp_init();
+    
+#if defined(CONFIG_LOCK_BENCH) && defined(CONFIG_EARLY_KPRINTF)
+    lock_bench();
+#endif
+    
+#if defined(CONFIG_SMP_CALL_BENCH) && defined(CONFIG_EARLY_KPRINTF)
+    smp_call_bench();
+#endif
+    
+#if defined(CONFIG_LOCKSTAT) && defined(CONFIG_EARLY_KPRINTF)
+    lockstat_dump(LOCKSTAT_DUMP_CNT);
+#endif
+    
     if (mach) {
 	if (atag_fdt_base) {
 	    if (mmu_pgtb_reg) {
@@ -60,7 +125,7 @@ void kernel_init(unsigned int mach, addr_t atag_fdt_base,
 	}
     }
     
-    int err = mlay_get_phy_mem_reg(atag_fdt_base, &mem_reg);
+    err = mlay_get_phy_mem_reg(atag_fdt_base, &mem_reg);
     if (err != ESUCC) {
 	mach_early_kprintf("error: %i\n", err);
     } else {
@@ -77,6 +142,8 @@ void kernel_init(unsigned int mach, addr_t atag_fdt_base,
 	    (mem_reg.size));
     }
     
+    /* nothing further runs on the boot cpu; it idles as the others do */
+    smp_idle();
     
     
     /* will need to map kernel hmi_init & hmi regions
@@ -108,4 +175,41 @@ void kernel_init(unsigned int mach, addr_t atag_fdt_base,
 	*/
 }
 
-
+/**
+ * kernel_init_pmm
+ * 
+ * hands the ram covered by the kernel linear map to the pmm,
+ * reserving the kernel, fdt & initrd.
+ * 
+ * @atag_fdt_base	base address of fdt
+ * @return errno
+ **/
+static int kernel_init_pmm(addr_t atag_fdt_base) {
+    struct fdt_header	*hdr		= (struct fdt_header *)atag_fdt_base;
+    struct mm_reg	mem_reg		= {0, 0};
+    struct mm_reg	resv_reg	= {0, 0};
+    int			ret		= ESUCC;
+    
+    if ((ret = mlay_get_phy_mem_reg(atag_fdt_base, &mem_reg)) == ESUCC) {
+	mlay_clip_linear_reg(&mem_reg);
+	
+	if ((ret = pmm_init(&mem_reg)) == ESUCC) {
+	    /* kernel */
+	    resv_reg.base = mlay_get_kern_phy_start();
+	    resv_reg.size = __pa(&k_end) - resv_reg.base;
+	    pmm_reserve_region(&resv_reg);
+	    
+	    /* fdt */
+	    resv_reg.base = atag_fdt_base;
+	    resv_reg.size = be32_to_cpu(hdr->total_sz);
+	    pmm_reserve_region(&resv_reg);
+	    
+	    /* initrd */
+	    if (mlay_get_initrd_reg(atag_fdt_base, &resv_reg) == ESUCC) {
+		pmm_reserve_region(&resv_reg);
+	    }
+	}
+    }
+    
+    return ret;
+}
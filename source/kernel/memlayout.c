@@ -21,10 +21,38 @@
 #include <util/bits.h>
 #include <util/fdt.h>
 #include <util/str.h>
+#include <sync/seqlock.h>
 #include <memlayout.h>
 #include <errno.h>
+#include <stdbool.h>
 #include <mach/mach.h> /* TODO: tmp */
 
+/**
+ * mlay_reg_cache
+ * 
+ * a region found within the fdt; each is parsed once & then read
+ * without a lock by any cpu (see mlay_lock).
+ * 
+ * @fdt_base	base address of the fdt the region was found within
+ * @reg		region
+ * @valid	set once reg has been found
+ **/
+struct mlay_reg_cache {
+    addr_t		fdt_base;
+    struct mm_reg	reg;
+    bool		valid;
+};
+
+static int mlay_find_phy_mem_reg(addr_t fdt_base, struct mm_reg *mem_reg);
+static int mlay_find_initrd_reg(addr_t fdt_base, struct mm_reg *initrd_reg);
+static bool mlay_cache_get(struct mlay_reg_cache *cache, addr_t fdt_base, struct mm_reg *reg);
+static void mlay_cache_set(struct mlay_reg_cache *cache, addr_t fdt_base, struct mm_reg *reg);
+
+/* guards the region caches; lookups are read mostly */
+static seqlock_t		mlay_lock	= SEQLOCK_INIT;
+static struct mlay_reg_cache	mlay_mem_cache;
+static struct mlay_reg_cache	mlay_initrd_cache;
+
 /* functionality for grabbing memory size, memory start */
 /* functionality for grabbing initrd */
 /* functionality for grabbing kernel pgtb region & size
@@ -43,6 +71,49 @@
  * @return errno
  **/
 int mlay_get_phy_mem_reg(addr_t fdt_base, struct mm_reg *mem_reg) {
+    int ret = ESUCC;
+    
+    if (!mlay_cache_get(&mlay_mem_cache, fdt_base, mem_reg)) {
+	if ((ret = mlay_find_phy_mem_reg(fdt_base, mem_reg)) == ESUCC) {
+	    mlay_cache_set(&mlay_mem_cache, fdt_base, mem_reg);
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * mlay_get_initrd_reg
+ * Memory Layout Get Initial Ramdisk Region
+ * 
+ * returns the initrd region (from the fdt's chosen node)
+ * 
+ * @fdt_base	base address of fdt
+ * @initrd_reg	returned initrd region
+ * @return errno
+ **/
+int mlay_get_initrd_reg(addr_t fdt_base, struct mm_reg *initrd_reg) {
+    int ret = ESUCC;
+    
+    if (!mlay_cache_get(&mlay_initrd_cache, fdt_base, initrd_reg)) {
+	if ((ret = mlay_find_initrd_reg(fdt_base, initrd_reg)) == ESUCC) {
+	    mlay_cache_set(&mlay_initrd_cache, fdt_base, initrd_reg);
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * mlay_find_phy_mem_reg
+ * 
+ * parses the fdt for mlay_get_phy_mem_reg
+ * 
+ * @fdt_base	base address of fdt
+ * @mem_reg	returned memory region
+ * @return errno
+ **/
+static int mlay_find_phy_mem_reg(addr_t fdt_base, struct mm_reg *mem_reg) {
     struct fdt_node 	*node	= NULL;
     struct fdt_property *prop	= NULL;
     fdt32_t		*ptr	= NULL;
@@ -78,7 +149,16 @@ int mlay_get_phy_mem_reg(addr_t fdt_base, struct mm_reg *mem_reg) {
     return ret;
 }
 
-int mlay_get_initrd_reg(addr_t fdt_base, struct mm_reg *initrd_reg) {
+/**
+ * mlay_find_initrd_reg
+ * 
+ * parses the fdt for mlay_get_initrd_reg
+ * 
+ * @fdt_base	base address of fdt
+ * @initrd_reg	returned initrd region
+ * @return errno
+ **/
+static int mlay_find_initrd_reg(addr_t fdt_base, struct mm_reg *initrd_reg) {
     struct fdt_node	*node	= NULL;
     struct fdt_property	*s_prop	= NULL;
     struct fdt_property	*e_prop	= NULL;
@@ -106,6 +186,51 @@ int mlay_get_initrd_reg(addr_t fdt_base, struct mm_reg *initrd_reg) {
     
     return ret;
 }
+/**
+ * mlay_cache_get
+ * 
+ * reads a cached region without taking mlay_lock, retrying if
+ * it was written meanwhile.
+ * 
+ * @cache	region cache
+ * @fdt_base	base address of fdt
+ * @reg		returned region
+ * @return true if the region was cached for fdt_base
+ **/
+static bool mlay_cache_get(struct mlay_reg_cache *cache, addr_t fdt_base, struct mm_reg *reg) {
+    unsigned int	seq	= 0;
+    bool		ret	= false;
+    
+    do {
+	seq = read_seqbegin(&mlay_lock);
+	
+	if ((ret = (cache->valid && cache->fdt_base == fdt_base))) {
+	    *reg = cache->reg;
+	}
+    } while (read_seqretry(&mlay_lock, seq));
+    
+    return ret;
+}
+
+/**
+ * mlay_cache_set
+ * 
+ * caches a region found within the fdt.
+ * 
+ * @cache	region cache
+ * @fdt_base	base address of fdt
+ * @reg		region
+ **/
+static void mlay_cache_set(struct mlay_reg_cache *cache, addr_t fdt_base, struct mm_reg *reg) {
+    write_seqlock(&mlay_lock);
+    
+    cache->fdt_base	= fdt_base;
+    cache->reg		= *reg;
+    cache->valid	= true;
+    
+    write_sequnlock(&mlay_lock);
+}
+
 /*
 int mlay_get_initrd
 * linux,initrd-end
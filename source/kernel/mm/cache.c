@@ -0,0 +1,249 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <arch/arch_cache.h>
+#include <arch/arch_mmu.h>
+#include <mm/cache.h>
+#include <types.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* helper functions */
+static void outer_virt_range(addr_t start, size_t size, void (*op)(addr_t, size_t));
+
+/* registered outer cache controller (if any) */
+static const struct outer_cache_ops *outer_ops = NULL;
+
+/**
+ * dcache_clean_range
+ * 
+ * writes back dirty lines within a virtual range, through every
+ * cache level, so the range is visible to other bus masters (i.e., DMA).
+ * 
+ * @start	virtual start address
+ * @size	size (in bytes) of range
+ **/
+void dcache_clean_range(addr_t start, size_t size) {
+    arch_dcache_clean_range(start, size);
+    
+    if (outer_cache_is_enabled()) {
+	outer_virt_range(start, size, outer_clean_range);
+    }
+}
+
+/**
+ * dcache_inval_range
+ * 
+ * discards lines within a virtual range, through every cache level,
+ * so data written by other bus masters is observed.
+ * lines only partially covered by the range are written back.
+ * 
+ * @start	virtual start address
+ * @size	size (in bytes) of range
+ **/
+void dcache_inval_range(addr_t start, size_t size) {
+    /* outer first; inner lines can't be refilled with stale outer data */
+    if (outer_cache_is_enabled()) {
+	outer_virt_range(start, size, outer_inval_range);
+    }
+    
+    arch_dcache_inval_range(start, size);
+}
+
+/**
+ * dcache_clean_inval_range
+ * 
+ * writes back & discards lines within a virtual range, through
+ * every cache level.
+ * 
+ * @start	virtual start address
+ * @size	size (in bytes) of range
+ **/
+void dcache_clean_inval_range(addr_t start, size_t size) {
+    arch_dcache_clean_inval_range(start, size);
+    
+    if (outer_cache_is_enabled()) {
+	outer_virt_range(start, size, outer_clean_inval_range);
+    }
+}
+
+/**
+ * icache_sync_range
+ * 
+ * makes instructions written within a virtual range visible to
+ * instruction fetch, i.e., after loading or patching code.
+ * 
+ * @start	virtual start address
+ * @size	size (in bytes) of range
+ **/
+void icache_sync_range(addr_t start, size_t size) {
+    arch_icache_sync_range(start, size);
+}
+
+/**
+ * dcache_flush_all
+ * 
+ * writes back & discards every data cache line, through every
+ * cache level.
+ **/
+void dcache_flush_all(void) {
+    arch_dcache_flush_all();
+    outer_clean_inval_all();
+}
+
+/**
+ * outer_cache_register
+ * 
+ * registers the outer cache controller; only a single controller
+ * may be registered.
+ * 
+ * @ops	controller operations
+ * @return errno
+ **/
+int outer_cache_register(const struct outer_cache_ops *ops) {
+    int ret = ESUCC;
+    
+    if (ops == NULL) {
+	ret = EINVAL;
+    } else if (outer_ops != NULL) {
+	ret = ENOTSUPP;
+    } else {
+	outer_ops = ops;
+    }
+    
+    return ret;
+}
+
+/**
+ * outer_cache_is_enabled
+ * 
+ * determines if an outer cache controller is registered
+ * 
+ * @return true if registered
+ **/
+bool outer_cache_is_enabled(void) {
+    return (outer_ops != NULL);
+}
+
+/**
+ * outer_clean_range
+ * 
+ * writes back dirty outer cache lines in a physical range
+ * 
+ * @phy_start	physical start address
+ * @size	size (in bytes) of range
+ **/
+void outer_clean_range(addr_t phy_start, size_t size) {
+    if (outer_ops != NULL && outer_ops->clean_range != NULL) {
+	outer_ops->clean_range(phy_start, size);
+    }
+}
+
+/**
+ * outer_inval_range
+ * 
+ * discards outer cache lines in a physical range
+ * 
+ * @phy_start	physical start address
+ * @size	size (in bytes) of range
+ **/
+void outer_inval_range(addr_t phy_start, size_t size) {
+    if (outer_ops != NULL && outer_ops->inval_range != NULL) {
+	outer_ops->inval_range(phy_start, size);
+    }
+}
+
+/**
+ * outer_clean_inval_range
+ * 
+ * writes back & discards outer cache lines in a physical range
+ * 
+ * @phy_start	physical start address
+ * @size	size (in bytes) of range
+ **/
+void outer_clean_inval_range(addr_t phy_start, size_t size) {
+    if (outer_ops != NULL && outer_ops->clean_inval_range != NULL) {
+	outer_ops->clean_inval_range(phy_start, size);
+    }
+}
+
+/**
+ * outer_clean_inval_all
+ * 
+ * writes back & discards the whole outer cache
+ **/
+void outer_clean_inval_all(void) {
+    if (outer_ops != NULL && outer_ops->clean_inval_all != NULL) {
+	outer_ops->clean_inval_all();
+    }
+}
+
+/**
+ * outer_sync
+ * 
+ * drains the outer cache controller's buffers
+ **/
+void outer_sync(void) {
+    if (outer_ops != NULL && outer_ops->sync != NULL) {
+	outer_ops->sync();
+    }
+}
+
+/**
+ * outer_disable
+ * 
+ * cleans, invalidates & disables the outer cache
+ **/
+void outer_disable(void) {
+    if (outer_ops != NULL && outer_ops->disable != NULL) {
+	outer_ops->disable();
+    }
+}
+
+/**
+ * outer_virt_range
+ * 
+ * performs an outer cache operation on the physical pages backing
+ * a virtual range; unmapped pages are skipped.
+ * 
+ * @start	virtual start address
+ * @size	size (in bytes) of range
+ * @op		outer range operation
+ **/
+static void outer_virt_range(addr_t start, size_t size, void (*op)(addr_t, size_t)) {
+    addr_t	end	= start + size;
+    addr_t	phy	= 0x0;
+    size_t	len	= 0;
+    
+    while (start < end) {
+	len = PG_SZ - (start & (PG_SZ - 1));
+	
+	if (len > (end - start)) {
+	    len = end - start;
+	}
+	
+	if ((phy = virt_to_phy(start)) != 0x0) {
+	    op(phy, len);
+	}
+	
+	start += len;
+    }
+}
@@ -0,0 +1,200 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <arch/arch_mmu.h>
+#include <mm/fault.h>
+#include <mm/cache.h>
+#include <mm/mmu.h>
+#include <mm/pmm.h>
+#include <mm/tlb.h>
+#include <mm/vma.h>
+#include <mm/mem.h>
+#include <memlayout.h>
+#include <types.h>
+#include <errno.h>
+
+static int mm_fault_anon(struct vma *vma, addr_t fault_addr);
+static int mm_fault_cow(struct vma *vma, addr_t fault_addr);
+static int mm_fault_phys(struct vma *vma, addr_t fault_addr);
+
+/**
+ * mm_handle_fault
+ * 
+ * resolves a fault within the calling cpu's user space.
+ * the vma containing fault_addr must permit the access; anonymous
+ * pages are backed by a zeroed page upon first access, resident pages
+ * are mapped together with their unmapped neighbours (fault-around) &
+ * pages shared by mmu_fork_user are copied upon the first write.
+ * 
+ * @fault_addr	faulting virtual address
+ * @flags	MM_FAULT_* flags
+ * @return errno; ESUCC if the access may be retried
+ **/
+int mm_handle_fault(addr_t fault_addr, unsigned int flags) {
+    struct vm_space	*space	= vm_space_get_current();
+    struct vma		*vma	= NULL;
+    unsigned int	acc	= VMA_READ;
+    int			ret	= ESUCC;
+    
+    if (flags & MM_FAULT_WRITE) {
+	acc = VMA_WRITE;
+    } else if (flags & MM_FAULT_EXEC) {
+	acc = VMA_EXEC;
+    }
+    
+    if (fault_addr >= arch_mmu_get_kern_vaddr() || space == NULL) {
+	/* the kernel space is never demand paged */
+	ret = EINVAL;
+    } else if ((vma = vma_find(space, fault_addr)) == NULL) {
+	ret = ENOTFND;
+    } else if (!vma_allows(vma, acc)) {
+	ret = EINVAL;
+    } else if (flags & MM_FAULT_PROT) {
+	/* permitted by the vma, yet mapped without it; only writes are shared */
+	if (flags & MM_FAULT_WRITE) {
+	    ret = mm_fault_cow(vma, fault_addr);
+	} else {
+	    ret = ENOTSUPP;
+	}
+    } else if (vma->flags & VMA_ANON) {
+	ret = mm_fault_anon(vma, fault_addr);
+    } else if (vma->flags & VMA_PHYS) {
+	ret = mm_fault_phys(vma, fault_addr);
+    } else {
+	ret = ENOTSUPP;
+    }
+    
+    return ret;
+}
+
+/**
+ * mm_fault_anon
+ * 
+ * backs the page containing fault_addr with a zeroed page
+ * 
+ * @vma		anonymous vma containing fault_addr
+ * @fault_addr	faulting virtual address
+ * @return errno
+ **/
+static int mm_fault_anon(struct vma *vma, addr_t fault_addr) {
+    addr_t		page	= pmm_alloc_page();
+    mmu_acc_flags_t	acc	= KERN_USER;
+    int			ret	= ESUCC;
+    
+    if (vma->flags & VMA_WRITE) {
+	acc = USER;
+    }
+    
+    if (page == 0x0) {
+	ret = ENOMEM;
+    } else {
+	/* zeroed through the linear map; the attributes match the user mapping */
+	memset((void *)__va(page), 0, PG_SZ);
+	
+	if (vma->flags & VMA_EXEC) {
+	    icache_sync_range(__va(page), PG_SZ);
+	}
+	
+	if ((ret = mmu_map_page(fault_addr & PG_MASK, page, acc)) != ESUCC) {
+	    pmm_free_page(page);
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * mm_fault_cow
+ * 
+ * breaks the sharing of the page containing fault_addr; the page is
+ * copied unless this was its last reference, in which case it is
+ * simply made writable again.
+ * 
+ * @vma		writable vma containing fault_addr
+ * @fault_addr	faulting virtual address
+ * @return errno
+ **/
+static int mm_fault_cow(struct vma *vma, addr_t fault_addr) {
+    addr_t	virt	= fault_addr & PG_MASK;
+    addr_t	phy	= 0x0;
+    addr_t	page	= 0x0;
+    int		ret	= ESUCC;
+    
+    /* the table is private once a page within it is written */
+    if ((ret = mmu_unshare_pgtb(virt)) == ESUCC) {
+	if ((phy = (virt_to_phy(virt) & PG_MASK)) == 0x0) {
+	    ret = ENOTFND;
+	} else if (pmm_get_page_refcnt(phy) == 1) {
+	    ret = mmu_remap_page(virt, phy, USER);
+	} else if ((page = pmm_alloc_page()) == 0x0) {
+	    ret = ENOMEM;
+	} else {
+	    memcpy((void *)__va(page), (void *)__va(phy), PG_SZ);
+	    
+	    if (vma->flags & VMA_EXEC) {
+		icache_sync_range(__va(page), PG_SZ);
+	    }
+	    
+	    if ((ret = mmu_remap_page(virt, page, USER)) == ESUCC) {
+		pmm_page_put(phy);
+	    } else {
+		pmm_free_page(page);
+	    }
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * mm_fault_phys
+ * 
+ * maps the resident page containing fault_addr along with every unmapped
+ * page of the vma within the surrounding MM_FAULT_AROUND_PAGES window,
+ * so that sequential access faults once per window.  the window is
+ * aligned to its size & never crosses a page table, so the update is
+ * a single batch of entries within one table.
+ * pages are mapped read only; writes are copied (see mm_fault_cow).
+ * 
+ * @vma		resident vma containing fault_addr
+ * @fault_addr	faulting virtual address
+ * @return errno
+ **/
+static int mm_fault_phys(struct vma *vma, addr_t fault_addr) {
+    addr_t	pages[MM_FAULT_AROUND_PAGES];
+    addr_t	base	= fault_addr & ~((MM_FAULT_AROUND_PAGES * PG_SZ) - 1);
+    addr_t	virt	= base;
+    
+    for (int i = 0; i < MM_FAULT_AROUND_PAGES; i++, virt += PG_SZ) {
+	pages[i] = 0x0;
+	
+	if (virt >= vma->start && virt < vma->end) {
+	    if (virt == (fault_addr & PG_MASK) || !mmu_is_mapped(virt)) {
+		pages[i] = vma->phy_base + (virt - vma->start);
+		
+		if (vma->flags & VMA_EXEC) {
+		    icache_sync_range(__va(pages[i]), PG_SZ);
+		}
+	    }
+	}
+    }
+    
+    return mmu_map_region(base, pages, MM_FAULT_AROUND_PAGES, KERN_USER);
+}
@@ -19,9 +19,14 @@
  * THE SOFTWARE.
  */
 #include <sync/barriers.h>
+#include <sync/spinlock.h>
 #include <arch/arch_mmu.h>
 #include <util/bits.h>
 #include <mm/mmu.h>
+#include <mm/pgtb.h>
+#include <mm/tlb.h>
+#include <mm/pmm.h>
+#include <memlayout.h>
 #include <mm/mem.h>
 #include <mm/mm.h>
 #include <types.h>
@@ -38,7 +43,18 @@
 /* keep track of kernel page tables */
 static struct mm_resv_reg mmu_pg_tbs;
 
+/*
+ * held while the kernel page directory's entries are linked & unlinked
+ * (& the page tables they link are written); the kernel page directory
+ * is shared by every cpu, whereas a user one is only altered by its owner.
+ */
+static spinlock_t mmu_kern_pgd_lock = SPINLOCK_INIT;
+
+static int mmu_map_entry(addr_t virt_addr, addr_t phy_addr, mmu_acc_flags_t acc_flags);
 static int mmu_create_pgtb_entry(addr_t, addr_t, mmu_acc_flags_t, mmu_entry_type_t, bool);
+static int mmu_create_pgd_entry(addr_t, addr_t, mmu_acc_flags_t, mmu_entry_type_t);
+static void mmu_release_pgtb(struct tlb_batch *batch, addr_t virt_addr, mmu_acc_flags_t acc_flags);
+static struct vm_space *mmu_get_vm_space(addr_t virt_addr);
 
 /* require a lock on any access to the kernel regions */
 
@@ -73,16 +89,279 @@ int mmu_set_user_page_dir(addr_t page_dir) {
     return arch_mmu_set_user_pg_dir(page_dir);
 }
 
+/**
+ * mmu_switch_vm_space
+ * 
+ * switches the calling cpu's user address space from prev to next,
+ * so that shootdowns within next (and no longer prev) reach this cpu.
+ * 
+ * @prev	current user space or NULL if none
+ * @next	new user space
+ * @return errno
+ **/
+int mmu_switch_vm_space(struct vm_space *prev, struct vm_space *next) {
+    int ret = ESUCC;
+    
+    if (next == NULL) {
+	ret = EINVAL;
+    } else {
+	/* prev's entries are discarded by the page directory switch */
+	if (prev != NULL) {
+	    vm_space_leave(prev);
+	}
+	
+	vm_space_enter(next);
+	ret = arch_mmu_set_user_pg_dir(next->pg_dir);
+    }
+    
+    return ret;
+}
+
+/**
+ * mmu_map_page
+ * 
+ * maps a page virtual->physical in the active page directories.
+ * if no page table covers virt_addr yet, one is allocated from the
+ * page table pool and linked into the page directory; a table shared
+ * with another user page directory is copied first.
+ * virt_addr must not currently be mapped.
+ * 
+ * @virt_addr	virtual address
+ * @phy_addr	physical address
+ * @acc_flags	access flags
+ * @return errno
+ **/
+int mmu_map_page(addr_t virt_addr, addr_t phy_addr, mmu_acc_flags_t acc_flags) {
+    int ret = ESUCC;
+    
+    /* a shared table must not change beneath the other page directory */
+    if (virt_addr < arch_mmu_get_kern_vaddr()) {
+	ret = mmu_unshare_pgtb(virt_addr);
+    }
+    
+    if (ret == ESUCC) {
+	ret = mmu_map_entry(virt_addr, phy_addr, acc_flags);
+    }
+    
+    /* invalid entries aren't cached by the tlb; only ordering is required */
+    if (ret == ESUCC) {
+	arch_dsb();
+    }
+    
+    return ret;
+}
+
+/**
+ * mmu_map_region
+ * 
+ * maps a run of pages virtual->physical in the active page directories
+ * as a single update; pages whose physical address is 0x0 are skipped.
+ * the mapped pages must not currently be mapped.
+ * 
+ * @virt_addr	virtual address of first page
+ * @phy_pages	physical address of each page
+ * @pg_cnt	number of pages
+ * @acc_flags	access flags
+ * @return errno
+ **/
+int mmu_map_region(addr_t virt_addr, addr_t *phy_pages, int pg_cnt, mmu_acc_flags_t acc_flags) {
+    int ret = ESUCC;
+    
+    if (phy_pages == NULL || pg_cnt <= 0) {
+	ret = EINVAL;
+    } else {
+	for (int i = 0; i < pg_cnt && ret == ESUCC; i++, virt_addr += PG_SZ) {
+	    /* a shared table must not change beneath the other page directory */
+	    if (virt_addr < arch_mmu_get_kern_vaddr() && (i == 0 || !(virt_addr & ((1 << MMU_PGD_SHIFT) - 1)))) {
+		ret = mmu_unshare_pgtb(virt_addr);
+	    }
+	    
+	    if (ret == ESUCC && phy_pages[i] != 0x0) {
+		ret = mmu_map_entry(virt_addr, phy_pages[i], acc_flags);
+	    }
+	}
+	
+	/* invalid entries aren't cached by the tlb; only ordering is required */
+	arch_dsb();
+    }
+    
+    return ret;
+}
+
+/**
+ * mmu_is_mapped
+ * 
+ * determines if a page is mapped by the active page directories'
+ * page tables, without translating through the mmu.
+ * 
+ * @virt_addr	virtual address
+ * @return true if mapped by a page table
+ **/
+bool mmu_is_mapped(addr_t virt_addr) {
+    addr_t	pg_tb	= arch_mmu_get_pgtb(virt_addr);
+    bool	ret	= false;
+    
+    if (pg_tb != 0x0) {
+	ret = (arch_mmu_pgtb_get_phy(pg_tb, (virt_addr >> MMU_PG_SHIFT) & 
+	    (arch_mmu_get_pgtb_entry_cnt() - 1)) != 0x0);
+    }
+    
+    return ret;
+}
+
+/**
+ * mmu_remap_page
+ * 
+ * replaces the mapping of a currently mapped page, i.e., to change its
+ * access flags or the page backing it.
+ * 
+ * @virt_addr	virtual address
+ * @phy_addr	physical address
+ * @acc_flags	access flags
+ * @return errno
+ **/
+int mmu_remap_page(addr_t virt_addr, addr_t phy_addr, mmu_acc_flags_t acc_flags) {
+    struct tlb_batch	batch;
+    int			ret	= ESUCC;
+    
+    tlb_batch_init(&batch, mmu_get_vm_space(virt_addr));
+    
+    if (virt_addr < arch_mmu_get_kern_vaddr()) {
+	ret = mmu_unshare_pgtb(virt_addr);
+    }
+    
+    if (ret == ESUCC && (ret = mmu_create_pgtb_entry(virt_addr, phy_addr, acc_flags, PG_TAB, false)) == ESUCC) {
+	tlb_batch_add_page(&batch, virt_addr);
+	tlb_batch_flush(&batch);
+    }
+    
+    return ret;
+}
+
+/**
+ * mmu_unshare_pgtb
+ * 
+ * gives the active user page directory a private copy of the page table
+ * covering virt_addr if it is shared with another (see mmu_fork_user).
+ * the pages mapped by the copy keep the references taken for this page
+ * directory at fork, so sharers copying at once (or the last holder
+ * keeping the table) leave every page with one reference per mapping.
+ * 
+ * @virt_addr	user virtual address
+ * @return errno
+ **/
+int mmu_unshare_pgtb(addr_t virt_addr) {
+    addr_t		pg_tb	= arch_mmu_get_pgtb(virt_addr);
+    addr_t		new_tb	= 0x0;
+    struct tlb_batch	batch;
+    int			ret	= ESUCC;
+    
+    if (pg_tb != 0x0 && pgtb_get_refcnt(pg_tb) > 1) {
+	if ((new_tb = pgtb_alloc()) == 0x0) {
+	    ret = ENOMEM;
+	} else {
+	    memcpy((void *)__va(new_tb), (void *)__va(pg_tb), arch_mmu_get_pgtb_sz());
+	    
+	    /* the copy must be visible before it is linked in */
+	    arch_dsb();
+	    
+	    if ((ret = mmu_create_pgd_entry(virt_addr, new_tb, USER, PG_DIR)) != ESUCC) {
+		pgtb_free(new_tb);
+	    } else {
+		/* the shared table is released once no longer walked */
+		tlb_batch_init(&batch, mmu_get_vm_space(virt_addr));
+		tlb_batch_add_pgtb(&batch, virt_addr, pg_tb);
+		tlb_batch_flush(&batch);
+	    }
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * mmu_fork_user
+ * 
+ * shares every page table of the active user page directory with a
+ * new (unmapped) page directory.  the tables are write protected so
+ * that writes by either side fault & may be copied on write; they are
+ * only duplicated once altered (see mmu_unshare_pgtb).
+ * every page mapped by a shared table gains a reference for the new
+ * page directory, which holds it until the page is unmapped or the
+ * space destroyed, whether or not the table is ever copied.
+ * 
+ * @pgd_addr	physical address of new user page directory
+ * @return errno
+ **/
+int mmu_fork_user(addr_t pgd_addr) {
+    addr_t		kvaddr	= arch_mmu_get_kern_vaddr();
+    addr_t		pg_tb	= 0x0;
+    addr_t		phy	= 0x0;
+    struct tlb_batch	batch;
+    struct mmu_entry	entry	= {
+	.phy_addr	= 0x0,
+	.virt_addr	= 0x0,
+	.type		= PG_DIR,
+	.acc_flags	= USER
+    };
+    int			ret	= ESUCC;
+    
+    tlb_batch_init(&batch, vm_space_get_current());
+    
+    for (addr_t addr = 0x0; addr < kvaddr && ret == ESUCC; addr += (1 << MMU_PGD_SHIFT)) {
+	if ((pg_tb = arch_mmu_get_pgtb(addr)) != 0x0) {
+	    arch_mmu_pgtb_wrprotect(pg_tb);
+	    
+	    entry.phy_addr	= pg_tb;
+	    entry.virt_addr	= addr;
+	    
+	    if ((ret = arch_mmu_create_new_entry(pgd_addr, &entry)) == ESUCC) {
+		pgtb_get(pg_tb);
+		
+		for (unsigned int i = 0; i < arch_mmu_get_pgtb_entry_cnt(); i++) {
+		    if ((phy = arch_mmu_pgtb_get_phy(pg_tb, i)) != 0x0) {
+			pmm_page_get(phy);
+		    }
+		}
+	    }
+	    
+	    tlb_batch_add_all(&batch);
+	}
+    }
+    
+    /* the parent loses write access to everything shared */
+    tlb_batch_flush(&batch);
+    
+    return ret;
+}
+
+/**
+ * mmu_unmap_page
+ * 
+ * removes a virtual->physical mapping; the page table is returned to
+ * the page table pool once it no longer maps anything.
+ * 
+ * @virt_addr	virtual address
+ * @return errno
+ **/
+int mmu_unmap_page(addr_t virt_addr) {
+    return mmu_invalidate_page(virt_addr);
+}
+
 /**
  * mmu_invalidate_page
  * 
  * invalidates a page by removing the virtual->physical mapping.
+ * the page table is returned to the page table pool once it no longer
+ * maps anything.
  * @virt_addr	virtual address to invalidate
  * @return errno
  **/
 int mmu_invalidate_page(addr_t virt_addr) {
     addr_t 		kvaddr 	= arch_mmu_get_kern_vaddr();
     mmu_acc_flags_t	acc;
+    struct tlb_batch	batch;
+    int			ret	= ESUCC;
     
     if (virt_addr >= kvaddr) {
 	acc = KERNEL;
@@ -90,7 +369,21 @@ int mmu_invalidate_page(addr_t virt_addr) {
 	acc = USER;
     }
     
-    return mmu_create_pgtb_entry(virt_addr, 0x0, acc, PG_TAB_INVAL, true);
+    tlb_batch_init(&batch, mmu_get_vm_space(virt_addr));
+    
+    /* a shared table must not change beneath the other page directory */
+    if (acc == USER) {
+	ret = mmu_unshare_pgtb(virt_addr);
+    }
+    
+    if (ret == ESUCC && (ret = mmu_create_pgtb_entry(virt_addr, 0x0, acc, PG_TAB_INVAL, false)) == ESUCC) {
+	tlb_batch_add_page(&batch, virt_addr);
+	mmu_release_pgtb(&batch, virt_addr, acc);
+	
+	tlb_batch_flush(&batch);
+    }
+    
+    return ret;
 }
 
 /**
@@ -106,8 +399,11 @@ int mmu_invalidate_region(addr_t virt_addr, int pg_cnt) {
     int			i	= 0;
     addr_t		kvaddr	= arch_mmu_get_kern_vaddr();
     mmu_acc_flags_t	acc;
+    struct tlb_batch	batch;
     
     if (pg_cnt > 0) {
+	tlb_batch_init(&batch, mmu_get_vm_space(virt_addr));
+	
 	while ((ret == ESUCC) && (i < pg_cnt)) {
 	    if (virt_addr >= kvaddr) {
 		acc = KERNEL;
@@ -115,21 +411,26 @@ int mmu_invalidate_region(addr_t virt_addr, int pg_cnt) {
 		acc = USER;
 	    }
 	    
-	    ret = mmu_create_pgtb_entry(virt_addr, 0x0, acc, PG_TAB_INVAL, false);
-	    virt_addr += PG_SZ;
+	    /* a shared table must not change beneath the other page directory */
+	    if (acc == USER && (i == 0 || !(virt_addr & ((1 << MMU_PGD_SHIFT) - 1)))) {
+		ret = mmu_unshare_pgtb(virt_addr);
+	    }
+	    
+	    if (ret == ESUCC && (ret = mmu_create_pgtb_entry(virt_addr, 0x0, acc, PG_TAB_INVAL, false)) == ESUCC) {
+		tlb_batch_add_page(&batch, virt_addr);
+		virt_addr += PG_SZ;
+		i++;
+	    }
 	}
 	
-	/* if successful, invalidate */
-	if (ret == ESUCC) {
-	    /*
-	     * ensure all data is written
-	     * prior to invalidating the tlb
-	     */
-	    arch_dsb();
-	    
-	    /* invalidate */
-	    arch_mmu_invalidate();
+	/* release page tables left empty; one per page directory entry */
+	for (addr_t addr = virt_addr - (i * PG_SZ); addr < virt_addr;
+	    addr = (addr & ~((1 << MMU_PGD_SHIFT) - 1)) + (1 << MMU_PGD_SHIFT)) {
+	    mmu_release_pgtb(&batch, addr, acc);
 	}
+	
+	/* entries removed before any failure must still be invalidated */
+	tlb_batch_flush(&batch);
     } else {
 	ret = EINVAL;
     }
@@ -137,6 +438,50 @@ int mmu_invalidate_region(addr_t virt_addr, int pg_cnt) {
     return ret;
 }
 
+/**
+ * mmu_map_entry
+ * 
+ * writes a page table entry, allocating the page table from the
+ * page table pool if none covers virt_addr yet.
+ * within the kernel half, mmu_kern_pgd_lock is held throughout, so a
+ * page table linked by another cpu meanwhile is found (and used) rather
+ * than replaced, & one being released isn't written.
+ * it is the responsibility of caller to use any necessary memory barriers.
+ * 
+ * @virt_addr	virtual address
+ * @phy_addr	physical address
+ * @acc_flags	access flags
+ * @return errno
+ **/
+static int mmu_map_entry(addr_t virt_addr, addr_t phy_addr, mmu_acc_flags_t acc_flags) {
+    bool	kern	= (virt_addr >= arch_mmu_get_kern_vaddr());
+    addr_t	pg_tb	= 0x0;
+    int		ret	= ESUCC;
+    
+    if (kern) {
+	spin_lock(&mmu_kern_pgd_lock);
+    }
+    
+    ret = mmu_create_pgtb_entry(virt_addr, phy_addr, acc_flags, PG_TAB, false);
+    
+    /* first use of this page directory entry */
+    if (ret == ENOTFND) {
+	if ((pg_tb = pgtb_alloc()) == 0x0) {
+	    ret = ENOMEM;
+	} else if ((ret = mmu_create_pgd_entry(virt_addr, pg_tb, acc_flags, PG_DIR)) != ESUCC) {
+	    pgtb_free(pg_tb);
+	} else {
+	    ret = mmu_create_pgtb_entry(virt_addr, phy_addr, acc_flags, PG_TAB, false);
+	}
+    }
+    
+    if (kern) {
+	spin_unlock(&mmu_kern_pgd_lock);
+    }
+    
+    return ret;
+}
+
 /**
  * mmu_create_pgtb_entry
  * 
@@ -167,6 +512,85 @@ static int mmu_create_pgtb_entry(addr_t virt_addr, addr_t phy_addr, mmu_acc_flag
     return ret;
 }
 
+/**
+ * mmu_create_pgd_entry
+ * 
+ * creates a page directory entry based on the specified parameters.
+ * 
+ * @virt_addr	virtual address
+ * @pgtb_addr	physical address of page table
+ * @acc_flags	access flags
+ * @type	entry type
+ * @return errno
+ **/
+static int mmu_create_pgd_entry(addr_t virt_addr, addr_t pgtb_addr, mmu_acc_flags_t acc_flags, mmu_entry_type_t type) {
+    struct mmu_entry	entry	= {
+	.phy_addr	= pgtb_addr,
+	.virt_addr	= virt_addr,
+	.type		= type,
+	.acc_flags	= acc_flags
+    };
+    
+    return arch_mmu_create_entry(&entry);
+}
+
+/**
+ * mmu_release_pgtb
+ * 
+ * unlinks the page table covering virt_addr if it no longer maps
+ * anything; it is returned to the pool once batch is flushed.
+ * within the kernel half, the check & unlink are made under
+ * mmu_kern_pgd_lock, so no other cpu maps into the table meanwhile.
+ * 
+ * @batch	batch of the current operation
+ * @virt_addr	virtual address covered by the page table
+ * @acc_flags	access flags of the page directory entry
+ **/
+static void mmu_release_pgtb(struct tlb_batch *batch, addr_t virt_addr, mmu_acc_flags_t acc_flags) {
+    bool	kern	= (virt_addr >= arch_mmu_get_kern_vaddr());
+    addr_t	pg_tb	= 0x0;
+    bool	release	= false;
+    
+    if (kern) {
+	spin_lock(&mmu_kern_pgd_lock);
+    }
+    
+    pg_tb = arch_mmu_get_pgtb(virt_addr);
+    
+    if (pg_tb != 0x0 && arch_mmu_pgtb_is_empty(pg_tb)) {
+	release = (mmu_create_pgd_entry(virt_addr, 0x0, acc_flags, PG_DIR_INVAL) == ESUCC);
+    }
+    
+    if (kern) {
+	spin_unlock(&mmu_kern_pgd_lock);
+    }
+    
+    /* the batch may be flushed early, which waits upon the other cpus */
+    if (release) {
+	tlb_batch_add_pgtb(batch, virt_addr, pg_tb);
+    }
+}
+
+/**
+ * mmu_get_vm_space
+ * 
+ * returns the address space virt_addr belongs to on the calling cpu
+ * 
+ * @virt_addr	virtual address
+ * @return address space or NULL if no user space is active
+ **/
+static struct vm_space *mmu_get_vm_space(addr_t virt_addr) {
+    struct vm_space *ret = NULL;
+    
+    if (virt_addr >= arch_mmu_get_kern_vaddr()) {
+	ret = &kern_vm_space;
+    } else {
+	ret = vm_space_get_current();
+    }
+    
+    return ret;
+}
+
 /**
  * arch_mmu_create_new_entry
  * 
@@ -196,8 +620,6 @@ extern bool arch_mmu_user_pgd_requires_alignment(void);
 extern unsigned int arch_mmu_get_user_pgd_alignment(void);
 extern addr_t arch_mmu_get_kern_vaddr(void);
 
-/* int mmu_map_page(addr_t virt_addr, addr_t phy_addr, mmu_acc_flags_t acc_flags) */
-/* int mmu_map_region(addr_t virt_addr, addr_t *phy_pages, int pg_cnt, mmu_acc_flags_t acc_flags); */
 /* int mmu_map_new_page(addr_t pgtb_base, addr_t virt_addr, addr_t phy_addr, mmc_acc_flags_t acc_flags) */
 /* int mmu_map_new_region(addr_t pgtb_base, addr_t virt_addr, addr_t *phy_pages, int pg_cnt, mmu_acc_flags_t acc_flags) */
 /* int mmu_create_new_user_pgd_pgtb(addr_t pg_dir, addr_t pg_tbs_base); */
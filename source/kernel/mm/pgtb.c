@@ -0,0 +1,419 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <arch/arch_mmu.h>
+#include <percpu.h>
+#include <sync/barriers.h>
+#include <sync/spinlock.h>
+#include <util/bits.h>
+#include <mm/pgtb.h>
+#include <mm/pmm.h>
+#include <mm/mem.h>
+#include <memlayout.h>
+#include <types.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* tables per frame are tracked by free_mask */
+#define PGTB_FRAME_MAX_TABLES	32
+
+/**
+ * pgtb_frame
+ * 
+ * a physical page split into page tables
+ * 
+ * @phy_addr	physical address of frame
+ * @free_mask	bit n set if the n-th table in the frame is free
+ * @refcnt	page directory references of the n-th table
+ **/
+struct pgtb_frame {
+    addr_t		phy_addr;
+    unsigned int	free_mask;
+    uint16_t		refcnt[PGTB_FRAME_MAX_TABLES];
+};
+
+/**
+ * pgtb_quicklist
+ * 
+ * per cpu cache of freed page tables (or page directories); tables on
+ * a quicklist remain allocated within their frame so that allocation &
+ * release don't need to search the frames.
+ * 
+ * @tbls	physical address of each cached table
+ * @cnt		number of cached tables
+ **/
+struct pgtb_quicklist {
+    addr_t		tbls[PGTB_QUICKLIST_MAX];
+    unsigned int	cnt;
+};
+
+/* helper functions */
+static struct pgtb_frame *pgtb_get_frame(addr_t phy_addr);
+static unsigned int pgtb_get_idx(addr_t pgtb_addr);
+static struct pgtb_frame *pgtb_new_frame(void);
+static void pgtb_release(addr_t pgtb_addr);
+static void pgtb_quicklist_drain(struct pgtb_quicklist *ql, unsigned int cnt);
+static unsigned int pgd_get_pg_cnt(void);
+
+/*
+ * held over any access to the frames (their free masks & refcounts);
+ * the quicklists are taken from & filled outside of it.
+ */
+static spinlock_t		pgtb_lock	= SPINLOCK_INIT;
+static struct pgtb_frame	pgtb_frames[PGTB_POOL_MAX_FRAMES];
+static unsigned int		pgtb_frame_cnt	= 0;
+
+/* only ever accessed by the cpu each belongs to */
+static DEFINE_PER_CPU(struct pgtb_quicklist, pgtb_quick);
+static DEFINE_PER_CPU(struct pgtb_quicklist, pgd_quick);
+
+/**
+ * pgtb_alloc
+ * 
+ * allocates a zeroed page table from the page table pool; the calling
+ * cpu's quicklist is used first, otherwise frames are taken from the
+ * pmm as needed and split into (PG_SZ / arch_mmu_get_pgtb_sz()) tables.
+ * the table starts out with a single reference (see pgtb_get).
+ * 
+ * @return physical address of page table or 0x0 if out of memory
+ **/
+addr_t pgtb_alloc(void) {
+    struct pgtb_quicklist	*ql	= this_cpu_ptr(pgtb_quick);
+    struct pgtb_frame		*frame	= NULL;
+    size_t			tb_sz	= arch_mmu_get_pgtb_sz();
+    unsigned int		idx	= 0;
+    addr_t			ret	= 0x0;
+    
+    spin_lock(&pgtb_lock);
+    
+    if (ql->cnt > 0) {
+	ret	= ql->tbls[--ql->cnt];
+	frame	= pgtb_get_frame(ret & ~(PG_SZ - 1));
+	idx	= pgtb_get_idx(ret);
+    } else {
+	/* partially used frames first */
+	for (unsigned int i = 0; i < pgtb_frame_cnt && frame == NULL; i++) {
+	    if (pgtb_frames[i].free_mask != 0) {
+		frame = &pgtb_frames[i];
+	    }
+	}
+	
+	if (frame == NULL) {
+	    frame = pgtb_new_frame();
+	}
+	
+	if (frame != NULL) {
+	    idx = idx_lsb(frame->free_mask) - 1;
+	    frame->free_mask &= ~(1 << idx);
+	    ret = frame->phy_addr + (idx * tb_sz);
+	}
+    }
+    
+    if (frame != NULL) {
+	frame->refcnt[idx] = 1;
+    }
+    
+    spin_unlock(&pgtb_lock);
+    
+    if (frame != NULL) {
+	memset((void *)__va(ret), 0, tb_sz);
+	
+	/* table must be visible before it is linked in */
+	arch_dsb();
+    }
+    
+    return ret;
+}
+
+/**
+ * pgtb_free
+ * 
+ * drops a reference to a page table (see pgtb_free_bulk)
+ * 
+ * @pgtb_addr	physical address of page table
+ **/
+void pgtb_free(addr_t pgtb_addr) {
+    pgtb_free_bulk(&pgtb_addr, 1);
+}
+
+/**
+ * pgtb_free_bulk
+ * 
+ * drops a reference to each of a set of page tables; tables losing
+ * their last reference are cached on the calling cpu's quicklist.
+ * a full quicklist returns half of its tables to their frames in one
+ * pass, releasing frames left entirely free to the pmm.
+ * the tables must no longer be referenced by the page directory
+ * (or tlb) the references belonged to.
+ * 
+ * @pgtbs	physical address of each page table
+ * @cnt		number of page tables
+ **/
+void pgtb_free_bulk(addr_t *pgtbs, unsigned int cnt) {
+    struct pgtb_quicklist	*ql	= this_cpu_ptr(pgtb_quick);
+    struct pgtb_frame		*frame	= NULL;
+    unsigned int		idx	= 0;
+    
+    spin_lock(&pgtb_lock);
+    
+    for (unsigned int i = 0; i < cnt; i++) {
+	frame	= pgtb_get_frame(pgtbs[i] & ~(PG_SZ - 1));
+	idx	= pgtb_get_idx(pgtbs[i]);
+	
+	if (frame != NULL && frame->refcnt[idx] > 0 && --frame->refcnt[idx] == 0) {
+	    if (ql->cnt == PGTB_QUICKLIST_MAX) {
+		pgtb_quicklist_drain(ql, (PGTB_QUICKLIST_MAX / 2));
+	    }
+	    
+	    ql->tbls[ql->cnt++] = pgtbs[i];
+	}
+    }
+    
+    spin_unlock(&pgtb_lock);
+}
+
+/**
+ * pgtb_get
+ * 
+ * takes an additional reference to a page table, i.e., when it is
+ * shared by another page directory.
+ * 
+ * @pgtb_addr	physical address of page table
+ **/
+void pgtb_get(addr_t pgtb_addr) {
+    struct pgtb_frame *frame = NULL;
+    
+    spin_lock(&pgtb_lock);
+    
+    if ((frame = pgtb_get_frame(pgtb_addr & ~(PG_SZ - 1))) != NULL) {
+	frame->refcnt[pgtb_get_idx(pgtb_addr)]++;
+    }
+    
+    spin_unlock(&pgtb_lock);
+}
+
+/**
+ * pgtb_get_refcnt
+ * 
+ * returns the number of references to a page table
+ * 
+ * @pgtb_addr	physical address of page table
+ * @return reference count or 0 if not held by the pool
+ **/
+unsigned int pgtb_get_refcnt(addr_t pgtb_addr) {
+    struct pgtb_frame	*frame	= NULL;
+    unsigned int	ret	= 0;
+    
+    spin_lock(&pgtb_lock);
+    
+    if ((frame = pgtb_get_frame(pgtb_addr & ~(PG_SZ - 1))) != NULL) {
+	ret = frame->refcnt[pgtb_get_idx(pgtb_addr)];
+    }
+    
+    spin_unlock(&pgtb_lock);
+    
+    return ret;
+}
+
+/**
+ * pgtb_get_frame_cnt
+ * 
+ * returns the number of frames currently held by the page table pool
+ * 
+ * @return frame count
+ **/
+size_t pgtb_get_frame_cnt(void) {
+    return pgtb_frame_cnt;
+}
+
+/**
+ * pgtb_trim
+ * 
+ * returns every table & page directory cached by the calling cpu
+ * to the pool & pmm respectively, i.e., when memory is low.
+ **/
+void pgtb_trim(void) {
+    struct pgtb_quicklist *ql = this_cpu_ptr(pgd_quick);
+    
+    spin_lock(&pgtb_lock);
+    pgtb_quicklist_drain(this_cpu_ptr(pgtb_quick), PGTB_QUICKLIST_MAX);
+    spin_unlock(&pgtb_lock);
+    
+    while (ql->cnt > 0) {
+	pmm_free_pages(ql->tbls[--ql->cnt], pgd_get_pg_cnt());
+    }
+}
+
+/**
+ * pgd_alloc
+ * 
+ * allocates a zeroed user page directory, aligned as required by the
+ * arch (see arch_mmu_get_user_pgd_alignment); the calling cpu's
+ * quicklist is used first.
+ * 
+ * @return physical address of page directory or 0x0 if out of memory
+ **/
+addr_t pgd_alloc(void) {
+    struct pgtb_quicklist	*ql	= this_cpu_ptr(pgd_quick);
+    size_t			align	= PG_SZ;
+    addr_t			ret	= 0x0;
+    
+    if (arch_mmu_user_pgd_requires_alignment() && arch_mmu_get_user_pgd_alignment() > align) {
+	align = arch_mmu_get_user_pgd_alignment();
+    }
+    
+    if (ql->cnt > 0) {
+	ret = ql->tbls[--ql->cnt];
+    } else {
+	ret = pmm_alloc_pages(pgd_get_pg_cnt(), align);
+    }
+    
+    if (ret != 0x0) {
+	memset((void *)__va(ret), 0, arch_mmu_get_user_pgd_sz());
+	
+	/* page directory must be visible before it is loaded */
+	arch_dsb();
+    }
+    
+    return ret;
+}
+
+/**
+ * pgd_free
+ * 
+ * releases a user page directory allocated by pgd_alloc; it must no
+ * longer be loaded by any cpu.
+ * 
+ * @pgd_addr	physical address of page directory
+ **/
+void pgd_free(addr_t pgd_addr) {
+    struct pgtb_quicklist *ql = this_cpu_ptr(pgd_quick);
+    
+    if (ql->cnt < PGD_QUICKLIST_MAX) {
+	ql->tbls[ql->cnt++] = pgd_addr;
+    } else {
+	pmm_free_pages(pgd_addr, pgd_get_pg_cnt());
+    }
+}
+
+/**
+ * pgtb_get_frame
+ * 
+ * returns the frame descriptor of a physical frame; pgtb_lock must be held.
+ * 
+ * @phy_addr	physical address of frame
+ * @return frame descriptor or NULL if not held by the pool
+ **/
+static struct pgtb_frame *pgtb_get_frame(addr_t phy_addr) {
+    struct pgtb_frame *ret = NULL;
+    
+    for (unsigned int i = 0; i < pgtb_frame_cnt && ret == NULL; i++) {
+	if (pgtb_frames[i].phy_addr == phy_addr) {
+	    ret = &pgtb_frames[i];
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * pgtb_get_idx
+ * 
+ * returns the index of a page table within its frame
+ * 
+ * @pgtb_addr	physical address of page table
+ * @return index
+ **/
+static unsigned int pgtb_get_idx(addr_t pgtb_addr) {
+    return ((pgtb_addr & (PG_SZ - 1)) / arch_mmu_get_pgtb_sz());
+}
+
+/**
+ * pgtb_new_frame
+ * 
+ * takes a new frame from the pmm; pgtb_lock must be held.
+ * 
+ * @return frame descriptor or NULL if out of memory
+ **/
+static struct pgtb_frame *pgtb_new_frame(void) {
+    struct pgtb_frame	*ret	= NULL;
+    addr_t		phy	= 0x0;
+    
+    if (pgtb_frame_cnt < PGTB_POOL_MAX_FRAMES) {
+	if ((phy = pmm_alloc_page()) != 0x0) {
+	    ret			= &pgtb_frames[pgtb_frame_cnt++];
+	    ret->phy_addr	= phy;
+	    ret->free_mask	= (1 << (PG_SZ / arch_mmu_get_pgtb_sz())) - 1;
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * pgtb_release
+ * 
+ * returns an unreferenced table to its frame; the frame is released
+ * to the pmm once every table within it is free; pgtb_lock must be held.
+ * 
+ * @pgtb_addr	physical address of page table
+ **/
+static void pgtb_release(addr_t pgtb_addr) {
+    struct pgtb_frame	*frame	= pgtb_get_frame(pgtb_addr & ~(PG_SZ - 1));
+    unsigned int	all	= (1 << (PG_SZ / arch_mmu_get_pgtb_sz())) - 1;
+    
+    if (frame != NULL) {
+	frame->free_mask |= (1 << pgtb_get_idx(pgtb_addr));
+	
+	if (frame->free_mask == all) {
+	    pmm_free_page(frame->phy_addr);
+	    
+	    /* keep the frame list dense */
+	    pgtb_frame_cnt--;
+	    memcpy(frame, &pgtb_frames[pgtb_frame_cnt], sizeof(struct pgtb_frame));
+	}
+    }
+}
+
+/**
+ * pgtb_quicklist_drain
+ * 
+ * returns the most recently cached tables of a quicklist to their frames;
+ * pgtb_lock must be held.
+ * 
+ * @ql		quicklist
+ * @cnt		largest number of tables to return
+ **/
+static void pgtb_quicklist_drain(struct pgtb_quicklist *ql, unsigned int cnt) {
+    for (unsigned int i = 0; i < cnt && ql->cnt > 0; i++) {
+	pgtb_release(ql->tbls[--ql->cnt]);
+    }
+}
+
+/**
+ * pgd_get_pg_cnt
+ * 
+ * returns the number of pages spanned by a user page directory
+ * 
+ * @return page count
+ **/
+static unsigned int pgd_get_pg_cnt(void) {
+    return ((arch_mmu_get_user_pgd_sz() + (PG_SZ - 1)) / PG_SZ);
+}
@@ -21,4 +21,390 @@
 #include <stddef.h>
 #include <mm/mem.h>
 #include <mm/pmm.h>
+#include <mm/mm.h>
+#include <sync/spinlock.h>
 #include <util/bits.h>
+#include <types.h>
+#include <errno.h>
+#include <stdbool.h>
+
+#define BM_WORD_BITS	32
+#define BM_WORD_SHIFT	5
+#define BM_WORD_CNT	((PMM_MAX_MEM >> DIV_PG) >> BM_WORD_SHIFT)
+#define BM_WORD_FULL	0xFFFFFFFF
+
+/* helper functions */
+static bool pmm_get_pg_idx(addr_t pg_addr, unsigned int *idx);
+static void pmm_set_used(unsigned int idx);
+static void pmm_set_unused(unsigned int idx);
+static bool pmm_is_used(unsigned int idx);
+static void pmm_free_idx(addr_t pg_addr);
+
+/* one bit per page; set == used */
+static uint32_t		pmm_bitmap[BM_WORD_CNT];
+/* references to each allocated page (i.e., mappings sharing it) */
+static uint16_t		pmm_refcnt[PMM_MAX_MEM >> DIV_PG];
+static addr_t		pmm_base	= 0x0;
+static unsigned int	pmm_pg_cnt	= 0;
+static unsigned int	pmm_free_cnt	= 0;
+static unsigned int	pmm_hint	= 0;
+/* held over any change to the bitmap, counts & references */
+static spinlock_t	pmm_lock	= SPINLOCK_INIT;
+
+/**
+ * pmm_init
+ * 
+ * initializes the physical memory manager over a region of memory;
+ * every page in the region starts out free.
+ * regions larger than PMM_MAX_MEM are truncated.
+ * 
+ * @mem_reg	physical memory region
+ * @return errno
+ **/
+int pmm_init(struct mm_reg *mem_reg) {
+    size_t	size	= 0;
+    int		ret	= ESUCC;
+    
+    if (mem_reg == NULL || !is_aligned_n(mem_reg->base, PG_SZ)) {
+	ret = EINVAL;
+    } else {
+	size = mem_reg->size;
+	
+	if (size > PMM_MAX_MEM) {
+	    size = PMM_MAX_MEM;
+	}
+	
+	pmm_base	= mem_reg->base;
+	pmm_pg_cnt	= size >> DIV_PG;
+	pmm_free_cnt	= pmm_pg_cnt;
+	pmm_hint	= 0;
+	
+	/* pages past the end of the region are never handed out */
+	memset(pmm_bitmap, 0xFF, sizeof(pmm_bitmap));
+	memset(pmm_bitmap, 0x00, (pmm_pg_cnt >> BM_WORD_SHIFT) * sizeof(uint32_t));
+	
+	if (pmm_pg_cnt & (BM_WORD_BITS - 1)) {
+	    pmm_bitmap[pmm_pg_cnt >> BM_WORD_SHIFT] = BM_WORD_FULL << (pmm_pg_cnt & (BM_WORD_BITS - 1));
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * pmm_reserve_region
+ * 
+ * marks every page overlapping a region as used; pages outside
+ * of the managed region are ignored.
+ * 
+ * @reg	physical region to reserve
+ * @return errno
+ **/
+int pmm_reserve_region(struct mm_reg *reg) {
+    addr_t		pg	= 0x0;
+    addr_t		end	= 0x0;
+    unsigned int	idx	= 0;
+    unsigned int	flags	= 0;
+    int			ret	= ESUCC;
+    
+    if (reg == NULL) {
+	ret = EINVAL;
+    } else if (pmm_pg_cnt == 0) {
+	ret = ENOTINIT;
+    } else {
+	end	= reg->base + reg->size;
+	flags	= spin_lock_irqsave(&pmm_lock);
+	
+	for (pg = (reg->base & PG_MASK); pg < end; pg += PG_SZ) {
+	    if (pmm_get_pg_idx(pg, &idx)) {
+		pmm_set_used(idx);
+	    }
+	}
+	
+	spin_unlock_irqrestore(&pmm_lock, flags);
+    }
+    
+    return ret;
+}
+
+/**
+ * pmm_alloc_page
+ * 
+ * allocates a single physical page; the page starts out with a
+ * single reference (see pmm_page_get).
+ * 
+ * @return physical address of page or 0x0 if out of memory
+ **/
+addr_t pmm_alloc_page(void) {
+    unsigned int	word_cnt	= (pmm_pg_cnt + (BM_WORD_BITS - 1)) >> BM_WORD_SHIFT;
+    unsigned int	word		= 0;
+    unsigned int	idx		= 0;
+    unsigned int	flags		= spin_lock_irqsave(&pmm_lock);
+    addr_t		ret		= 0x0;
+    
+    if (pmm_free_cnt > 0) {
+	/* next fit, starting at the last word allocated from */
+	for (unsigned int i = 0; i < word_cnt && ret == 0x0; i++) {
+	    word = pmm_hint + i;
+	    
+	    if (word >= word_cnt) {
+		word -= word_cnt;
+	    }
+	    
+	    if (pmm_bitmap[word] != BM_WORD_FULL) {
+		idx = (word << BM_WORD_SHIFT) + (idx_lsb(~pmm_bitmap[word]) - 1);
+		
+		pmm_set_used(idx);
+		pmm_refcnt[idx]	= 1;
+		pmm_hint	= word;
+		ret		= pmm_base + (idx << DIV_PG);
+	    }
+	}
+    }
+    
+    spin_unlock_irqrestore(&pmm_lock, flags);
+    
+    return ret;
+}
+
+/**
+ * pmm_alloc_pages
+ * 
+ * allocates physically contiguous pages, each with a single reference.
+ * 
+ * @pg_cnt	number of pages
+ * @align	alignment (in bytes) of the first page; a power of two >= PG_SZ
+ * @return physical address of first page or 0x0 if unavailable
+ **/
+addr_t pmm_alloc_pages(unsigned int pg_cnt, size_t align) {
+    unsigned int	idx	= 0;
+    unsigned int	run	= 0;
+    unsigned int	flags	= spin_lock_irqsave(&pmm_lock);
+    addr_t		ret	= 0x0;
+    
+    if (pg_cnt > 0 && pg_cnt <= pmm_free_cnt && is_power_of_two(align) && align >= PG_SZ) {
+	/* first index whose address is aligned */
+	idx = (((pmm_base + align - 1) & ~(align - 1)) - pmm_base) >> DIV_PG;
+	
+	while (ret == 0x0 && (idx + pg_cnt) <= pmm_pg_cnt) {
+	    for (run = 0; run < pg_cnt && !pmm_is_used(idx + run); run++);
+	    
+	    if (run == pg_cnt) {
+		for (run = 0; run < pg_cnt; run++) {
+		    pmm_set_used(idx + run);
+		    pmm_refcnt[idx + run] = 1;
+		}
+		
+		ret = pmm_base + (idx << DIV_PG);
+	    } else {
+		idx += (align >> DIV_PG);
+	    }
+	}
+    }
+    
+    spin_unlock_irqrestore(&pmm_lock, flags);
+    
+    return ret;
+}
+
+/**
+ * pmm_free_page
+ * 
+ * releases a page allocated by pmm_alloc_page regardless of
+ * its references
+ * 
+ * @pg_addr	physical address of page
+ **/
+void pmm_free_page(addr_t pg_addr) {
+    unsigned int flags = spin_lock_irqsave(&pmm_lock);
+    
+    pmm_free_idx(pg_addr);
+    spin_unlock_irqrestore(&pmm_lock, flags);
+}
+
+/**
+ * pmm_free_pages
+ * 
+ * releases pages allocated by pmm_alloc_pages
+ * 
+ * @pg_addr	physical address of first page
+ * @pg_cnt	number of pages
+ **/
+void pmm_free_pages(addr_t pg_addr, unsigned int pg_cnt) {
+    unsigned int flags = spin_lock_irqsave(&pmm_lock);
+    
+    for (unsigned int i = 0; i < pg_cnt; i++) {
+	pmm_free_idx(pg_addr + (i << DIV_PG));
+    }
+    
+    spin_unlock_irqrestore(&pmm_lock, flags);
+}
+
+/**
+ * pmm_page_get
+ * 
+ * takes an additional reference to an allocated page
+ * 
+ * @pg_addr	physical address of page
+ **/
+void pmm_page_get(addr_t pg_addr) {
+    unsigned int	idx	= 0;
+    unsigned int	flags	= spin_lock_irqsave(&pmm_lock);
+    
+    if (pmm_get_pg_idx(pg_addr, &idx) && pmm_refcnt[idx] > 0) {
+	pmm_refcnt[idx]++;
+    }
+    
+    spin_unlock_irqrestore(&pmm_lock, flags);
+}
+
+/**
+ * pmm_page_put
+ * 
+ * drops a reference to an allocated page; the page is freed
+ * once the last reference is dropped.
+ * 
+ * @pg_addr	physical address of page
+ **/
+void pmm_page_put(addr_t pg_addr) {
+    unsigned int	idx	= 0;
+    unsigned int	flags	= spin_lock_irqsave(&pmm_lock);
+    
+    if (pmm_get_pg_idx(pg_addr, &idx) && pmm_refcnt[idx] > 0) {
+	if (--pmm_refcnt[idx] == 0) {
+	    pmm_set_unused(idx);
+	}
+    }
+    
+    spin_unlock_irqrestore(&pmm_lock, flags);
+}
+
+/**
+ * pmm_get_page_refcnt
+ * 
+ * returns the number of references to a page
+ * 
+ * @pg_addr	physical address of page
+ * @return reference count; 0 if free, reserved or not managed
+ **/
+unsigned int pmm_get_page_refcnt(addr_t pg_addr) {
+    unsigned int	idx	= 0;
+    unsigned int	ret	= 0;
+    
+    if (pmm_get_pg_idx(pg_addr, &idx)) {
+	ret = pmm_refcnt[idx];
+    }
+    
+    return ret;
+}
+
+/**
+ * pmm_get_free_pg_cnt
+ * 
+ * returns the number of free pages
+ * 
+ * @return free page count
+ **/
+size_t pmm_get_free_pg_cnt(void) {
+    return pmm_free_cnt;
+}
+
+/**
+ * is_page_allocated
+ * 
+ * determines if a page is in use; pages outside of the managed
+ * region are always considered in use.
+ * 
+ * @pg_addr	physical address of page
+ * @return true if allocated
+ **/
+bool is_page_allocated(addr_t pg_addr) {
+    unsigned int	idx	= 0;
+    bool		ret	= true;
+    
+    if (pmm_get_pg_idx(pg_addr, &idx)) {
+	ret = pmm_is_used(idx);
+    }
+    
+    return ret;
+}
+
+/**
+ * pmm_free_idx
+ * 
+ * releases a page regardless of its references; pmm_lock must be held.
+ * 
+ * @pg_addr	physical address of page
+ **/
+static void pmm_free_idx(addr_t pg_addr) {
+    unsigned int idx = 0;
+    
+    if (pmm_get_pg_idx(pg_addr, &idx)) {
+	pmm_refcnt[idx] = 0;
+	pmm_set_unused(idx);
+    }
+}
+
+/**
+ * pmm_get_pg_idx
+ * 
+ * returns the bitmap index of a page
+ * 
+ * @pg_addr	physical address of page
+ * @idx		returned index
+ * @return true if the page is managed
+ **/
+static bool pmm_get_pg_idx(addr_t pg_addr, unsigned int *idx) {
+    bool ret = false;
+    
+    if (pg_addr >= pmm_base) {
+	*idx = (pg_addr - pmm_base) >> DIV_PG;
+	ret = (*idx < pmm_pg_cnt);
+    }
+    
+    return ret;
+}
+
+/**
+ * pmm_set_used
+ * 
+ * marks a page as used
+ * 
+ * @idx	bitmap index
+ **/
+static void pmm_set_used(unsigned int idx) {
+    uint32_t bit = ((uint32_t)1 << (idx & (BM_WORD_BITS - 1)));
+    
+    if (!(pmm_bitmap[idx >> BM_WORD_SHIFT] & bit)) {
+	pmm_bitmap[idx >> BM_WORD_SHIFT] |= bit;
+	pmm_free_cnt--;
+    }
+}
+
+/**
+ * pmm_set_unused
+ * 
+ * marks a page as free
+ * 
+ * @idx	bitmap index
+ **/
+static void pmm_set_unused(unsigned int idx) {
+    uint32_t bit = ((uint32_t)1 << (idx & (BM_WORD_BITS - 1)));
+    
+    if (pmm_bitmap[idx >> BM_WORD_SHIFT] & bit) {
+	pmm_bitmap[idx >> BM_WORD_SHIFT] &= ~bit;
+	pmm_free_cnt++;
+    }
+}
+
+/**
+ * pmm_is_used
+ * 
+ * determines if a page is marked as used
+ * 
+ * @idx	bitmap index
+ * @return true if used
+ **/
+static bool pmm_is_used(unsigned int idx) {
+    return (pmm_bitmap[idx >> BM_WORD_SHIFT] & ((uint32_t)1 << (idx & (BM_WORD_BITS - 1))));
+}
@@ -0,0 +1,293 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <sync/barriers.h>
+#include <arch/arch_mmu.h>
+#include <arch/arch_smp.h>
+#include <mm/tlb.h>
+#include <mm/pgtb.h>
+#include <smp.h>
+#include <types.h>
+#include <stdbool.h>
+
+static unsigned int tlb_get_cpu_mask(struct vm_space *space);
+static void tlb_invalidate_local(struct tlb_batch *batch);
+static void tlb_shootdown(struct tlb_batch *batch, unsigned int cpu, unsigned int cpu_mask);
+
+struct vm_space kern_vm_space;
+
+/* user space each cpu currently translates through */
+static struct vm_space *cur_user_space[NR_CPUS];
+
+/*
+ * outstanding shootdown of each sender & whether each target has yet to
+ * complete it ([sender][target]).
+ * a sender has at most one shootdown outstanding; it sets the flags and the
+ * target clears them, so no atomic access is required.
+ */
+static struct tlb_batch *volatile	shootdown_req[NR_CPUS];
+static volatile bool			shootdown_pending[NR_CPUS][NR_CPUS];
+
+/**
+ * vm_space_enter
+ * 
+ * marks the calling cpu as translating through space.
+ * this must precede loading the page directory of space.
+ * 
+ * @space	address space
+ **/
+void vm_space_enter(struct vm_space *space) {
+    unsigned int cpu = arch_smp_get_cpu_id();
+    
+    if (space != &kern_vm_space) {
+	cur_user_space[cpu] = space;
+    }
+    
+    space->cpu_active[cpu] = true;
+    
+    /* visible before any walk through space */
+    arch_dsb();
+}
+
+/**
+ * vm_space_leave
+ * 
+ * marks the calling cpu as no longer translating through space.
+ * the caller must invalidate its tlb before translating through space
+ * again (see arch_mmu_set_user_pg_dir).
+ * 
+ * @space	address space
+ **/
+void vm_space_leave(struct vm_space *space) {
+    unsigned int cpu = arch_smp_get_cpu_id();
+    
+    space->cpu_active[cpu] = false;
+    
+    if (cur_user_space[cpu] == space) {
+	cur_user_space[cpu] = NULL;
+    }
+}
+
+/**
+ * vm_space_get_current
+ * 
+ * returns the user space the calling cpu translates through
+ * 
+ * @return current user space or NULL if none
+ **/
+struct vm_space *vm_space_get_current(void) {
+    return cur_user_space[arch_smp_get_cpu_id()];
+}
+
+/**
+ * tlb_batch_init
+ * 
+ * initializes an empty batch for invalidations within space.
+ * 
+ * @batch	batch to initialize
+ * @space	address space, or NULL if only the calling cpu must be invalidated
+ **/
+void tlb_batch_init(struct tlb_batch *batch, struct vm_space *space) {
+    batch->space	= space;
+    batch->pg_cnt	= 0;
+    batch->pgtb_cnt	= 0;
+    batch->flush_all	= false;
+}
+
+/**
+ * tlb_batch_add_page
+ * 
+ * adds a page whose mapping was altered to the batch.
+ * 
+ * @batch	batch
+ * @virt_addr	virtual address within the page
+ **/
+void tlb_batch_add_page(struct tlb_batch *batch, addr_t virt_addr) {
+    if (batch->pg_cnt < TLB_BATCH_MAX_PAGES) {
+	batch->pages[batch->pg_cnt++] = virt_addr;
+    } else {
+	batch->flush_all = true;
+    }
+}
+
+/**
+ * tlb_batch_add_all
+ * 
+ * marks the batch as invalidating the entire tlb, i.e., when every
+ * mapping of the address space may have been altered.
+ * 
+ * @batch	batch
+ **/
+void tlb_batch_add_all(struct tlb_batch *batch) {
+    batch->flush_all = true;
+}
+
+/**
+ * tlb_batch_add_pgtb
+ * 
+ * adds a page table that was unlinked from the page directory; it is
+ * returned to the page table pool once no cpu may walk it.
+ * the batch is flushed early if it cannot hold another page table.
+ * 
+ * @batch	batch
+ * @virt_addr	virtual address formerly covered by the page table
+ * @pgtb_addr	physical address of the page table
+ **/
+void tlb_batch_add_pgtb(struct tlb_batch *batch, addr_t virt_addr, addr_t pgtb_addr) {
+    if (batch->pgtb_cnt >= TLB_BATCH_MAX_PGTBS) {
+	tlb_batch_flush(batch);
+    }
+    
+    /* invalidating any address it covered discards cached walks of it */
+    tlb_batch_add_page(batch, virt_addr);
+    batch->pgtbs[batch->pgtb_cnt++] = pgtb_addr;
+}
+
+/**
+ * tlb_batch_flush
+ * 
+ * performs the invalidations gathered by the batch on every cpu
+ * translating through its address space, releases its page tables
+ * and empties it.
+ * small batches are broadcast by the hardware; larger ones are performed
+ * locally and sent to the remaining cpus with a single ipi, after which
+ * the calling cpu waits for them to complete.
+ * 
+ * @batch	batch to flush
+ **/
+void tlb_batch_flush(struct tlb_batch *batch) {
+    unsigned int	cpu	= arch_smp_get_cpu_id();
+    unsigned int	mask	= tlb_get_cpu_mask(batch->space) & ~(1 << cpu);
+    
+    if (batch->pg_cnt > 0 || batch->flush_all) {
+	/* page table writes must reach the walkers first */
+	arch_dsb();
+	
+	if (mask == 0) {
+	    tlb_invalidate_local(batch);
+	} else if (!batch->flush_all && batch->pg_cnt <= TLB_BATCH_BCAST_PAGES) {
+	    for (int i = 0; i < batch->pg_cnt; i++) {
+		arch_mmu_invalidate_page_bcast(batch->pages[i]);
+	    }
+	} else {
+	    tlb_invalidate_local(batch);
+	    tlb_shootdown(batch, cpu, mask);
+	}
+	
+	arch_dsb();
+    }
+    
+    pgtb_free_bulk(batch->pgtbs, batch->pgtb_cnt);
+    
+    tlb_batch_init(batch, batch->space);
+}
+
+/**
+ * tlb_shootdown_hand
+ * 
+ * performs any shootdowns outstanding for the calling cpu.
+ * this is called upon receiving IPI_TLB_SHOOTDOWN.
+ **/
+void tlb_shootdown_hand(void) {
+    unsigned int cpu = arch_smp_get_cpu_id();
+    
+    for (unsigned int i = 0; i < NR_CPUS; i++) {
+	if ((i != cpu) && shootdown_pending[i][cpu]) {
+	    /* the flag is written after the request */
+	    arch_dmb();
+	    
+	    tlb_invalidate_local(shootdown_req[i]);
+	    arch_dsb();
+	    
+	    shootdown_pending[i][cpu] = false;
+	}
+    }
+}
+
+/**
+ * tlb_get_cpu_mask
+ * 
+ * returns the cpus translating through space
+ * 
+ * @space	address space or NULL
+ * @return bitmask of cpu ids
+ **/
+static unsigned int tlb_get_cpu_mask(struct vm_space *space) {
+    unsigned int ret = 0;
+    
+    if (space != NULL) {
+	for (unsigned int i = 0; i < NR_CPUS; i++) {
+	    if (space->cpu_active[i]) {
+		ret |= (1 << i);
+	    }
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * tlb_invalidate_local
+ * 
+ * performs the invalidations of a batch on the calling cpu only.
+ * 
+ * @batch	batch
+ **/
+static void tlb_invalidate_local(struct tlb_batch *batch) {
+    if (batch->flush_all) {
+	arch_mmu_invalidate();
+    } else {
+	for (int i = 0; i < batch->pg_cnt; i++) {
+	    arch_mmu_invalidate_page(batch->pages[i]);
+	}
+    }
+}
+
+/**
+ * tlb_shootdown
+ * 
+ * sends a batch to the cpus in cpu_mask & waits for them to perform it.
+ * shootdowns & calls sent to the calling cpu meanwhile are serviced while
+ * waiting (see smp_poll_ipis), as their senders may be waiting on us.
+ * 
+ * @batch	batch
+ * @cpu	calling cpu
+ * @cpu_mask	target cpus; must not include the calling cpu
+ **/
+static void tlb_shootdown(struct tlb_batch *batch, unsigned int cpu, unsigned int cpu_mask) {
+    shootdown_req[cpu] = batch;
+    arch_dmb();
+    
+    for (unsigned int i = 0; i < NR_CPUS; i++) {
+	if (cpu_mask & (1 << i)) {
+	    shootdown_pending[cpu][i] = true;
+	}
+    }
+    
+    arch_smp_send_ipi(cpu_mask, IPI_TLB_SHOOTDOWN);
+    
+    for (unsigned int i = 0; i < NR_CPUS; i++) {
+	while (shootdown_pending[cpu][i]) {
+	    smp_poll_ipis();
+	}
+    }
+    
+    arch_dmb();
+}
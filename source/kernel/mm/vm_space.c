@@ -0,0 +1,156 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <arch/arch_mmu.h>
+#include <mm/mmu.h>
+#include <mm/pmm.h>
+#include <mm/pgtb.h>
+#include <mm/tlb.h>
+#include <mm/vma.h>
+#include <memlayout.h>
+#include <types.h>
+#include <errno.h>
+#include <stddef.h>
+
+/* page tables released per pgtb_free_bulk by vm_space_destroy */
+#define VM_SPACE_PGTB_BATCH	32
+
+/**
+ * vm_space_create
+ * 
+ * creates an empty user address space with a zeroed page directory
+ * from the page table pool (see pgd_alloc).
+ * 
+ * @space	address space to initialize
+ * @return errno
+ **/
+int vm_space_create(struct vm_space *space) {
+    int ret = ESUCC;
+    
+    if (space == NULL) {
+	ret = EINVAL;
+    } else if ((space->pg_dir = pgd_alloc()) == 0x0) {
+	ret = ENOMEM;
+    } else {
+	vma_space_init(space);
+	
+	for (int i = 0; i < NR_CPUS; i++) {
+	    space->cpu_active[i] = false;
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * vm_space_destroy
+ * 
+ * tears down a user address space; its pages lose the references held
+ * by its page tables, which are released in bulk along with the page
+ * directory & vmas.
+ * the space must not be active on any cpu.
+ * 
+ * @space	address space
+ * @return errno
+ **/
+int vm_space_destroy(struct vm_space *space) {
+    addr_t	kvaddr	= arch_mmu_get_kern_vaddr();
+    addr_t	pgtbs[VM_SPACE_PGTB_BATCH];
+    addr_t	pg_tb	= 0x0;
+    addr_t	phy	= 0x0;
+    int		cnt	= 0;
+    int		ret	= ESUCC;
+    
+    if (space == NULL || space == &kern_vm_space) {
+	ret = EINVAL;
+    } else {
+	for (int i = 0; i < NR_CPUS && ret == ESUCC; i++) {
+	    if (space->cpu_active[i]) {
+		ret = EINVAL;
+	    }
+	}
+    }
+    
+    if (ret == ESUCC) {
+	for (addr_t addr = 0x0; addr < kvaddr; addr += MLAY_SECT_SZ) {
+	    if ((pg_tb = arch_mmu_pgd_get_pgtb(space->pg_dir, addr)) != 0x0) {
+		/* each holder of a shared table has its own page references */
+		for (unsigned int i = 0; i < arch_mmu_get_pgtb_entry_cnt(); i++) {
+		    if ((phy = arch_mmu_pgtb_get_phy(pg_tb, i)) != 0x0) {
+			pmm_page_put(phy);
+		    }
+		}
+		
+		pgtbs[cnt++] = pg_tb;
+		
+		if (cnt == VM_SPACE_PGTB_BATCH) {
+		    pgtb_free_bulk(pgtbs, cnt);
+		    cnt = 0;
+		}
+	    }
+	}
+	
+	pgtb_free_bulk(pgtbs, cnt);
+	vma_clear(space);
+	pgd_free(space->pg_dir);
+	space->pg_dir = 0x0;
+    }
+    
+    return ret;
+}
+
+/**
+ * vm_space_fork
+ * 
+ * creates a copy on write duplicate of a user address space; the vmas
+ * are copied while the page tables & pages are shared until written
+ * (see mmu_fork_user).
+ * parent must be the calling cpu's current user space.
+ * 
+ * @parent	address space to duplicate
+ * @child	address space to initialize
+ * @return errno
+ **/
+int vm_space_fork(struct vm_space *parent, struct vm_space *child) {
+    struct vma	*vma	= NULL;
+    int		ret	= ESUCC;
+    
+    if (parent == NULL || parent != vm_space_get_current()) {
+	ret = EINVAL;
+    } else if ((ret = vm_space_create(child)) == ESUCC) {
+	for (vma = vma_first(parent); vma != NULL && ret == ESUCC; vma = vma_next(vma)) {
+	    if (vma->flags & VMA_PHYS) {
+		ret = vma_reserve_phys(child, vma->start, (vma->end - vma->start), vma->flags, vma->phy_base);
+	    } else {
+		ret = vma_reserve(child, vma->start, (vma->end - vma->start), vma->flags);
+	    }
+	}
+	
+	if (ret == ESUCC) {
+	    ret = mmu_fork_user(child->pg_dir);
+	}
+	
+	if (ret != ESUCC) {
+	    vm_space_destroy(child);
+	}
+    }
+    
+    return ret;
+}
@@ -0,0 +1,604 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <mm/vma.h>
+#include <mm/pmm.h>
+#include <sync/spinlock.h>
+#include <util/rbtree.h>
+#include <memlayout.h>
+#include <types.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define VMA_PG_MASK	(PG_SZ - 1)
+
+static int vma_insert(struct vm_space *space, addr_t start, size_t size, unsigned int flags, addr_t phy_base);
+static int vma_link(struct vm_space *space, struct vma *vma);
+static int vma_split_into(struct vm_space *space, struct vma *vma, addr_t addr, struct vma *upper);
+static struct vma *vma_lower_bound(struct vm_space *space, addr_t virt_addr);
+static bool vma_gap_search(struct rb_node *node, addr_t lower, addr_t upper, size_t size, addr_t lo, addr_t hi, addr_t *start);
+static bool vma_gap_fits(addr_t lower, addr_t upper, size_t size, addr_t lo, addr_t hi, addr_t *start);
+static bool vma_can_merge(struct vma *prev, struct vma *next);
+static void vma_rb_update(struct rb_node *node);
+static struct vma *vma_alloc(void);
+static void vma_free(struct vma *vma);
+static void vma_free_push(struct vma *vma);
+
+/*
+ * unused vma structures, chained through rb.parent; refilled a page at a time from the pmm.
+ * shared by every address space, so it's held under its own lock rather than the space's.
+ */
+static spinlock_t	vma_free_lock	= SPINLOCK_INIT;
+static struct vma	*vma_free_list	= NULL;
+
+/**
+ * vma_space_init
+ * 
+ * initializes the (empty) vma index of an address space
+ * 
+ * @space	address space
+ **/
+void vma_space_init(struct vm_space *space) {
+    rb_init(&space->vmas, vma_rb_update);
+}
+
+/**
+ * vma_reserve
+ * 
+ * reserves a region of an address space without backing it; anonymous
+ * pages are allocated & mapped upon first access (see mm_handle_fault).
+ * the region is merged with adjacent, compatible vmas.
+ * 
+ * @space	address space
+ * @start	page aligned base virtual address
+ * @size	size of region (in bytes, page aligned)
+ * @flags	VMA_* flags
+ * @return errno
+ **/
+int vma_reserve(struct vm_space *space, addr_t start, size_t size, unsigned int flags) {
+    return vma_insert(space, start, size, (flags & ~VMA_PHYS), 0x0);
+}
+
+/**
+ * vma_reserve_phys
+ * 
+ * reserves a region of an address space backed by resident, physically
+ * contiguous memory (i.e., the initrd); pages are mapped upon first
+ * access, read only until written (see mm_handle_fault).
+ * 
+ * @space	address space
+ * @start	page aligned base virtual address
+ * @size	size of region (in bytes, page aligned)
+ * @flags	VMA_* flags
+ * @phy_base	page aligned physical address backing start
+ * @return errno
+ **/
+int vma_reserve_phys(struct vm_space *space, addr_t start, size_t size, unsigned int flags, addr_t phy_base) {
+    int ret = ESUCC;
+    
+    if (phy_base & VMA_PG_MASK) {
+	ret = EALIGN;
+    } else {
+	ret = vma_insert(space, start, size, ((flags & ~VMA_ANON) | VMA_PHYS), phy_base);
+    }
+    
+    return ret;
+}
+
+/**
+ * vma_release
+ * 
+ * removes a range from an address space, splitting any vma that
+ * straddles either end of it; the pages backing the range are
+ * left untouched (see mmu_unmap_page).
+ * the (at most two) vmas the splits require are allocated first, so
+ * the space is left unaltered if they can't be.
+ * 
+ * @space	address space
+ * @start	page aligned base virtual address
+ * @size	size of range (in bytes, page aligned)
+ * @return errno
+ **/
+int vma_release(struct vm_space *space, addr_t start, size_t size) {
+    struct vma	*vma		= NULL;
+    struct vma	*last		= NULL;
+    struct vma	*next		= NULL;
+    struct vma	*lower_half	= NULL;
+    struct vma	*upper_half	= NULL;
+    addr_t	end		= start + size;
+    int		ret		= ESUCC;
+    
+    if (space == NULL || size == 0 || end < start) {
+	ret = EINVAL;
+    } else if ((start & VMA_PG_MASK) || (size & VMA_PG_MASK)) {
+	ret = EALIGN;
+    } else {
+	vma	= vma_lower_bound(space, start);
+	last	= vma_lower_bound(space, end);
+	
+	if (vma != NULL && vma->start < start && (lower_half = vma_alloc()) == NULL) {
+	    ret = ENOMEM;
+	} else if (last != NULL && last->start < end && (upper_half = vma_alloc()) == NULL) {
+	    ret = ENOMEM;
+	}
+    }
+    
+    if (ret == ESUCC && lower_half != NULL) {
+	/* keep the portion below start */
+	vma_split_into(space, vma, start, lower_half);
+	vma = lower_half;
+    } else if (ret != ESUCC && lower_half != NULL) {
+	vma_free(lower_half);
+    }
+    
+    while (ret == ESUCC && vma != NULL && vma->start < end) {
+	/* keep the portion past end */
+	if (vma->end > end) {
+	    vma_split_into(space, vma, end, upper_half);
+	}
+	
+	next = vma_next(vma);
+	rb_erase(&space->vmas, &vma->rb);
+	vma_free(vma);
+	vma = next;
+    }
+    
+    return ret;
+}
+
+/**
+ * vma_split
+ * 
+ * splits a vma in two at addr; vma keeps the lower portion.
+ * 
+ * @space	address space of vma
+ * @vma		vma to split
+ * @addr	page aligned address within vma (exclusive of start)
+ * @return errno
+ **/
+int vma_split(struct vm_space *space, struct vma *vma, addr_t addr) {
+    struct vma	*upper	= NULL;
+    int		ret	= ESUCC;
+    
+    if (space == NULL || vma == NULL || addr <= vma->start || addr >= vma->end) {
+	ret = EINVAL;
+    } else if (addr & VMA_PG_MASK) {
+	ret = EALIGN;
+    } else if ((upper = vma_alloc()) == NULL) {
+	ret = ENOMEM;
+    } else {
+	ret = vma_split_into(space, vma, addr, upper);
+    }
+    
+    return ret;
+}
+
+/**
+ * vma_merge
+ * 
+ * merges a vma with its neighbours when they are adjacent & share the
+ * same flags (and, for VMA_PHYS, are physically contiguous).
+ * 
+ * @space	address space of vma
+ * @vma		vma to merge
+ * @return the merged vma (vma or its predecessor)
+ **/
+struct vma *vma_merge(struct vm_space *space, struct vma *vma) {
+    struct rb_node	*prev	= NULL;
+    struct vma		*adj	= NULL;
+    struct vma		*ret	= vma;
+    
+    if (space != NULL && vma != NULL) {
+	if ((adj = vma_next(ret)) != NULL && vma_can_merge(ret, adj)) {
+	    rb_erase(&space->vmas, &adj->rb);
+	    ret->end = adj->end;
+	    rb_propagate(&space->vmas, &ret->rb);
+	    vma_free(adj);
+	}
+	
+	if ((prev = rb_prev(&ret->rb)) != NULL && vma_can_merge((adj = rb_entry(prev, struct vma, rb)), ret)) {
+	    rb_erase(&space->vmas, &ret->rb);
+	    adj->end = ret->end;
+	    rb_propagate(&space->vmas, &adj->rb);
+	    vma_free(ret);
+	    ret = adj;
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * vma_find
+ * 
+ * returns the vma containing virt_addr
+ * 
+ * @space	address space
+ * @virt_addr	virtual address
+ * @return vma or NULL if virt_addr is not within a vma
+ **/
+struct vma *vma_find(struct vm_space *space, addr_t virt_addr) {
+    struct vma *ret = NULL;
+    
+    if (space != NULL && (ret = vma_lower_bound(space, virt_addr)) != NULL && ret->start > virt_addr) {
+	ret = NULL;
+    }
+    
+    return ret;
+}
+
+/**
+ * vma_find_gap
+ * 
+ * finds the lowest unreserved range of an address space able to
+ * hold size bytes within [lo, hi).
+ * 
+ * @space	address space
+ * @size	size of range (in bytes, page aligned)
+ * @lo		page aligned lowest acceptable address
+ * @hi		page aligned address the range must end at or below
+ * @start	set to the start of the range
+ * @return errno (ENOMEM if no range fits)
+ **/
+int vma_find_gap(struct vm_space *space, size_t size, addr_t lo, addr_t hi, addr_t *start) {
+    int ret = ESUCC;
+    
+    if (space == NULL || start == NULL || size == 0 || hi <= lo) {
+	ret = EINVAL;
+    } else if ((size & VMA_PG_MASK) || (lo & VMA_PG_MASK) || (hi & VMA_PG_MASK)) {
+	ret = EALIGN;
+    } else if (!vma_gap_search(space->vmas.node, lo, hi, size, lo, hi, start)) {
+	ret = ENOMEM;
+    }
+    
+    return ret;
+}
+
+/**
+ * vma_clear
+ * 
+ * removes every vma of an address space; the pages backing them
+ * are left untouched.
+ * 
+ * @space	address space
+ **/
+void vma_clear(struct vm_space *space) {
+    struct vma *vma = NULL;
+    
+    while (space != NULL && (vma = vma_first(space)) != NULL) {
+	rb_erase(&space->vmas, &vma->rb);
+	vma_free(vma);
+    }
+}
+
+/**
+ * vma_insert
+ * 
+ * creates a vma & merges it with its neighbours where possible
+ * 
+ * @space	address space
+ * @start	page aligned base virtual address
+ * @size	size of region (in bytes, page aligned)
+ * @flags	VMA_* flags
+ * @phy_base	physical address backing start (VMA_PHYS)
+ * @return errno
+ **/
+static int vma_insert(struct vm_space *space, addr_t start, size_t size, unsigned int flags, addr_t phy_base) {
+    struct vma	*vma	= NULL;
+    addr_t	end	= start + size;
+    int		ret	= ESUCC;
+    
+    if (space == NULL || size == 0 || end < start) {
+	ret = EINVAL;
+    } else if ((start & VMA_PG_MASK) || (size & VMA_PG_MASK)) {
+	ret = EALIGN;
+    } else if ((vma = vma_alloc()) == NULL) {
+	ret = ENOMEM;
+    } else {
+	vma->start	= start;
+	vma->end	= end;
+	vma->flags	= flags;
+	vma->phy_base	= phy_base;
+	
+	if ((ret = vma_link(space, vma)) != ESUCC) {
+	    vma_free(vma);
+	} else {
+	    vma_merge(space, vma);
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * vma_split_into
+ * 
+ * splits a vma in two at addr, the upper portion being given an unused
+ * vma; the arguments must have been checked (see vma_split).
+ * 
+ * @space	address space of vma
+ * @vma		vma to split
+ * @addr	page aligned address within vma (exclusive of start)
+ * @upper	unused vma, linked as the upper portion
+ * @return errno
+ **/
+static int vma_split_into(struct vm_space *space, struct vma *vma, addr_t addr, struct vma *upper) {
+    upper->start	= addr;
+    upper->end		= vma->end;
+    upper->flags	= vma->flags;
+    upper->phy_base	= 0x0;
+    
+    if (vma->flags & VMA_PHYS) {
+	upper->phy_base = vma->phy_base + (addr - vma->start);
+    }
+    
+    vma->end = addr;
+    rb_propagate(&space->vmas, &vma->rb);
+    
+    /* the range was just vacated; linking can't fail */
+    return vma_link(space, upper);
+}
+
+/**
+ * vma_link
+ * 
+ * links an initialized vma into the index of space
+ * 
+ * @space	address space
+ * @vma		vma to link
+ * @return errno (EINVAL if vma overlaps an existing vma)
+ **/
+static int vma_link(struct vm_space *space, struct vma *vma) {
+    struct rb_node	**link	= &space->vmas.node;
+    struct rb_node	*parent	= NULL;
+    struct vma		*cur	= NULL;
+    int			ret	= ESUCC;
+    
+    while (*link != NULL && ret == ESUCC) {
+	parent	= *link;
+	cur	= rb_entry(parent, struct vma, rb);
+	
+	if (vma->end <= cur->start) {
+	    link = &parent->left;
+	} else if (vma->start >= cur->end) {
+	    link = &parent->right;
+	} else {
+	    ret = EINVAL;
+	}
+    }
+    
+    if (ret == ESUCC) {
+	rb_link_node(&vma->rb, parent, link);
+	rb_insert_color(&space->vmas, &vma->rb);
+    }
+    
+    return ret;
+}
+
+/**
+ * vma_lower_bound
+ * 
+ * returns the lowest vma ending past virt_addr
+ * 
+ * @space	address space
+ * @virt_addr	virtual address
+ * @return vma or NULL if none
+ **/
+static struct vma *vma_lower_bound(struct vm_space *space, addr_t virt_addr) {
+    struct rb_node	*node	= space->vmas.node;
+    struct vma		*cur	= NULL;
+    struct vma		*ret	= NULL;
+    
+    while (node != NULL) {
+	cur = rb_entry(node, struct vma, rb);
+	
+	if (cur->end > virt_addr) {
+	    ret		= cur;
+	    node	= node->left;
+	} else {
+	    node	= node->right;
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * vma_gap_search
+ * 
+ * searches a subtree for the lowest range able to hold size bytes
+ * within [lo, hi); subtrees whose largest gap is too small are skipped.
+ * 
+ * @node	subtree
+ * @lower	end of the vma preceding the subtree (or lo)
+ * @upper	start of the vma following the subtree (or hi)
+ * @size	size of range (in bytes)
+ * @lo		lowest acceptable address
+ * @hi		address the range must end at or below
+ * @start	set to the start of the range
+ * @return true if found
+ **/
+static bool vma_gap_search(struct rb_node *node, addr_t lower, addr_t upper, size_t size, addr_t lo, addr_t hi, addr_t *start) {
+    struct vma	*vma	= NULL;
+    bool	ret	= false;
+    
+    if (node == NULL) {
+	ret = vma_gap_fits(lower, upper, size, lo, hi, start);
+    } else if (upper > lo && lower < hi) {
+	vma = rb_entry(node, struct vma, rb);
+	
+	/* largest gap bounding or within the subtree */
+	if ((vma->sub_start - lower) >= size || vma->sub_gap >= size || (upper - vma->sub_end) >= size) {
+	    ret = vma_gap_search(node->left, lower, vma->start, size, lo, hi, start);
+	    
+	    if (!ret) {
+		ret = vma_gap_search(node->right, vma->end, upper, size, lo, hi, start);
+	    }
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * vma_gap_fits
+ * 
+ * determines if the unreserved range [lower, upper), clipped to
+ * [lo, hi), is able to hold size bytes.
+ * 
+ * @lower	start of unreserved range
+ * @upper	end of unreserved range
+ * @size	size (in bytes)
+ * @lo		lowest acceptable address
+ * @hi		address the range must end at or below
+ * @start	set to the start of the range if it fits
+ * @return true if it fits
+ **/
+static bool vma_gap_fits(addr_t lower, addr_t upper, size_t size, addr_t lo, addr_t hi, addr_t *start) {
+    bool ret = false;
+    
+    if (lower < lo) {
+	lower = lo;
+    }
+    
+    if (upper > hi) {
+	upper = hi;
+    }
+    
+    if (upper > lower && (upper - lower) >= size) {
+	*start	= lower;
+	ret	= true;
+    }
+    
+    return ret;
+}
+
+/**
+ * vma_can_merge
+ * 
+ * @prev	vma
+ * @next	vma following prev
+ * @return true if prev & next may be combined into a single vma
+ **/
+static bool vma_can_merge(struct vma *prev, struct vma *next) {
+    bool ret = (prev->end == next->start && prev->flags == next->flags);
+    
+    if (ret && (prev->flags & VMA_PHYS)) {
+	ret = ((prev->phy_base + (prev->end - prev->start)) == next->phy_base);
+    }
+    
+    return ret;
+}
+
+/**
+ * vma_rb_update
+ * 
+ * recomputes the subtree values of a vma from its children
+ * (see rb_root->update)
+ * 
+ * @node	rb node of the vma
+ **/
+static void vma_rb_update(struct rb_node *node) {
+    struct vma *vma	= rb_entry(node, struct vma, rb);
+    struct vma *child	= NULL;
+    
+    vma->sub_start	= vma->start;
+    vma->sub_end	= vma->end;
+    vma->sub_gap	= 0;
+    
+    if (node->left != NULL) {
+	child		= rb_entry(node->left, struct vma, rb);
+	vma->sub_start	= child->sub_start;
+	vma->sub_gap	= child->sub_gap;
+	
+	if ((vma->start - child->sub_end) > vma->sub_gap) {
+	    vma->sub_gap = vma->start - child->sub_end;
+	}
+    }
+    
+    if (node->right != NULL) {
+	child		= rb_entry(node->right, struct vma, rb);
+	vma->sub_end	= child->sub_end;
+	
+	if (child->sub_gap > vma->sub_gap) {
+	    vma->sub_gap = child->sub_gap;
+	}
+	
+	if ((child->sub_start - vma->end) > vma->sub_gap) {
+	    vma->sub_gap = child->sub_start - vma->end;
+	}
+    }
+}
+
+/**
+ * vma_alloc
+ * 
+ * allocates an (uninitialized) vma structure
+ * 
+ * @return vma or NULL if out of memory
+ **/
+static struct vma *vma_alloc(void) {
+    struct vma	*ret	= NULL;
+    addr_t	page	= 0x0;
+    
+    spin_lock(&vma_free_lock);
+    
+    if (vma_free_list == NULL && (page = pmm_alloc_page()) != 0x0) {
+	ret = (struct vma *)__va(page);
+	
+	for (size_t i = 0; i < (PG_SZ / sizeof(struct vma)); i++) {
+	    vma_free_push(&ret[i]);
+	}
+    }
+    
+    if ((ret = vma_free_list) != NULL) {
+	vma_free_list = (ret->rb.parent != NULL) ? rb_entry(ret->rb.parent, struct vma, rb) : NULL;
+    }
+    
+    spin_unlock(&vma_free_lock);
+    
+    return ret;
+}
+
+/**
+ * vma_free
+ * 
+ * returns a vma structure (no longer indexed) to the free list
+ * 
+ * @vma		vma
+ **/
+static void vma_free(struct vma *vma) {
+    spin_lock(&vma_free_lock);
+    vma_free_push(vma);
+    spin_unlock(&vma_free_lock);
+}
+
+/**
+ * vma_free_push
+ * 
+ * pushes a vma structure onto the free list; vma_free_lock must be held.
+ * 
+ * @vma		vma
+ **/
+static void vma_free_push(struct vma *vma) {
+    vma->rb.parent	= (vma_free_list != NULL) ? &vma_free_list->rb : NULL;
+    vma_free_list	= vma;
+}
@@ -0,0 +1,275 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <arch/arch_mmu.h>
+#include <mm/vmalloc.h>
+#include <mm/mmu.h>
+#include <mm/pmm.h>
+#include <mm/tlb.h>
+#include <mm/vma.h>
+#include <sync/rwlock.h>
+#include <memlayout.h>
+#include <types.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* pages unmapped per tlb flush by vfree */
+#define VMALLOC_FREE_BATCH	16
+
+static int vmalloc_reserve(size_t size, unsigned int flags, addr_t phy_base, addr_t *virt_addr);
+static void vmalloc_release(addr_t virt_addr, size_t size, bool free_pages);
+static void vmalloc_unreserve(addr_t virt_addr, size_t size);
+static size_t vmalloc_find(addr_t virt_addr, unsigned int flags);
+
+/*
+ * held over any access to the vmas of kern_vm_space (lookups shared); it
+ * isn't held while mapping or unmapping, as tlb shootdowns wait upon the
+ * other cpus.
+ */
+static rwlock_t vmalloc_lock = RWLOCK_INIT;
+
+/**
+ * vmalloc_init
+ * 
+ * initializes the vmalloc & ioremap range; the regions handed out are
+ * tracked as vmas of kern_vm_space.
+ **/
+void vmalloc_init(void) {
+    vma_space_init(&kern_vm_space);
+}
+
+/**
+ * vmalloc
+ * 
+ * allocates a virtually contiguous kernel region backed by
+ * (not necessarily contiguous) pages from the pmm.
+ * 
+ * @size	size of region (in bytes)
+ * @return virtual address of region or NULL on failure
+ **/
+void *vmalloc(size_t size) {
+    addr_t	virt	= 0x0;
+    addr_t	page	= 0x0;
+    size_t	mapped	= 0;
+    int		ret	= ESUCC;
+    
+    size = (size + (PG_SZ - 1)) & PG_MASK;
+    
+    if (size == 0) {
+	ret = EINVAL;
+    } else if ((ret = vmalloc_reserve(size, (VMA_READ | VMA_WRITE), 0x0, &virt)) == ESUCC) {
+	while (ret == ESUCC && mapped < size) {
+	    if ((page = pmm_alloc_page()) == 0x0) {
+		ret = ENOMEM;
+	    } else if ((ret = mmu_map_page(virt + mapped, page, KERNEL)) != ESUCC) {
+		pmm_free_page(page);
+	    } else {
+		mapped += PG_SZ;
+	    }
+	}
+	
+	if (ret != ESUCC) {
+	    vmalloc_release(virt, mapped, true);
+	    vmalloc_unreserve(virt, size);
+	}
+    }
+    
+    return (ret == ESUCC) ? (void *)virt : NULL;
+}
+
+/**
+ * vfree
+ * 
+ * frees a region allocated by vmalloc
+ * 
+ * @virt_addr	virtual address returned by vmalloc
+ **/
+void vfree(void *virt_addr) {
+    size_t size = vmalloc_find((addr_t)virt_addr, 0);
+    
+    if (size > 0) {
+	vmalloc_release((addr_t)virt_addr, size, true);
+	vmalloc_unreserve((addr_t)virt_addr, size);
+    }
+}
+
+/**
+ * ioremap
+ * 
+ * maps a physical (device) region into the vmalloc range
+ * 
+ * @phy_addr	physical address of region
+ * @size	size of region (in bytes)
+ * @return virtual address of phy_addr or NULL on failure
+ **/
+void *ioremap(addr_t phy_addr, size_t size) {
+    addr_t	offset	= phy_addr & (PG_SZ - 1);
+    addr_t	phy	= phy_addr & PG_MASK;
+    addr_t	virt	= 0x0;
+    size_t	mapped	= 0;
+    int		ret	= ESUCC;
+    
+    size = (size + offset + (PG_SZ - 1)) & PG_MASK;
+    
+    if (size == 0) {
+	ret = EINVAL;
+    } else if ((ret = vmalloc_reserve(size, (VMA_READ | VMA_WRITE | VMA_PHYS), phy, &virt)) == ESUCC) {
+	while (ret == ESUCC && mapped < size) {
+	    if ((ret = mmu_map_page(virt + mapped, phy + mapped, DEVICE)) == ESUCC) {
+		mapped += PG_SZ;
+	    }
+	}
+	
+	if (ret != ESUCC) {
+	    vmalloc_release(virt, mapped, false);
+	    vmalloc_unreserve(virt, size);
+	}
+    }
+    
+    return (ret == ESUCC) ? (void *)(virt + offset) : NULL;
+}
+
+/**
+ * iounmap
+ * 
+ * removes a mapping created by ioremap
+ * 
+ * @virt_addr	virtual address returned by ioremap
+ **/
+void iounmap(void *virt_addr) {
+    addr_t	virt	= (addr_t)virt_addr & PG_MASK;
+    size_t	size	= vmalloc_find(virt, VMA_PHYS);
+    
+    if (size > 0) {
+	vmalloc_release(virt, size, false);
+	vmalloc_unreserve(virt, size);
+    }
+}
+
+/**
+ * vmalloc_reserve
+ * 
+ * reserves the lowest free region of the vmalloc range able to hold
+ * size bytes with a guard on either side.
+ * 
+ * @size	size of region (in bytes, page aligned)
+ * @flags	VMA_* flags
+ * @phy_base	physical address backing the region (VMA_PHYS)
+ * @virt_addr	set to the virtual address of the region
+ * @return errno
+ **/
+static int vmalloc_reserve(size_t size, unsigned int flags, addr_t phy_base, addr_t *virt_addr) {
+    addr_t	start	= 0x0;
+    int		ret	= ESUCC;
+    
+    write_lock(&vmalloc_lock);
+    
+    ret = vma_find_gap(&kern_vm_space, size + (2 * VMALLOC_GUARD_SZ), 
+	mlay_get_vmalloc_start(), mlay_get_vmalloc_end(), &start);
+    
+    if (ret == ESUCC) {
+	start += VMALLOC_GUARD_SZ;
+	
+	if (flags & VMA_PHYS) {
+	    ret = vma_reserve_phys(&kern_vm_space, start, size, flags, phy_base);
+	} else {
+	    ret = vma_reserve(&kern_vm_space, start, size, flags);
+	}
+	
+	*virt_addr = start;
+    }
+    
+    write_unlock(&vmalloc_lock);
+    
+    return ret;
+}
+
+/**
+ * vmalloc_release
+ * 
+ * unmaps the pages of a region, a batch at a time, returning them
+ * to the pmm if requested once they are no longer translated.
+ * 
+ * @virt_addr	virtual address of region
+ * @size	size of mapped portion (in bytes, page aligned)
+ * @free_pages	whether the backing pages belong to the pmm
+ **/
+static void vmalloc_release(addr_t virt_addr, size_t size, bool free_pages) {
+    addr_t	pages[VMALLOC_FREE_BATCH];
+    int		cnt	= 0;
+    
+    while (size > 0) {
+	for (cnt = 0; cnt < VMALLOC_FREE_BATCH && (size_t)(cnt * PG_SZ) < size; cnt++) {
+	    pages[cnt] = virt_to_phy(virt_addr + (cnt * PG_SZ));
+	}
+	
+	mmu_invalidate_region(virt_addr, cnt);
+	
+	for (int i = 0; free_pages && i < cnt; i++) {
+	    pmm_free_page(pages[i]);
+	}
+	
+	virt_addr	+= (cnt * PG_SZ);
+	size		-= (cnt * PG_SZ);
+    }
+}
+
+/**
+ * vmalloc_unreserve
+ * 
+ * returns a region reserved by vmalloc_reserve to the vmalloc range.
+ * its guards keep the region from being merged with another, so it's
+ * released whole; no vma is split & vma_release can't fail.
+ * 
+ * @virt_addr	virtual address of region
+ * @size	size of region (in bytes)
+ **/
+static void vmalloc_unreserve(addr_t virt_addr, size_t size) {
+    write_lock(&vmalloc_lock);
+    vma_release(&kern_vm_space, virt_addr, size);
+    write_unlock(&vmalloc_lock);
+}
+
+/**
+ * vmalloc_find
+ * 
+ * looks up the region starting at an address.
+ * 
+ * @virt_addr	virtual address of region
+ * @flags	VMA_PHYS if the region was created by ioremap, else 0
+ * @return size of region (in bytes) or 0 if no such region exists
+ **/
+static size_t vmalloc_find(addr_t virt_addr, unsigned int flags) {
+    struct vma	*vma	= NULL;
+    size_t	ret	= 0;
+    
+    read_lock(&vmalloc_lock);
+    
+    vma = vma_find(&kern_vm_space, virt_addr);
+    
+    if (vma != NULL && vma->start == virt_addr && (vma->flags & VMA_PHYS) == flags) {
+	ret = vma->end - vma->start;
+    }
+    
+    read_unlock(&vmalloc_lock);
+    
+    return ret;
+}
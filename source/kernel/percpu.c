@@ -0,0 +1,73 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * percpu.c replicates the per cpu template for each cpu.
+ */
+#include <arch/arch_percpu.h>
+#include <arch/arch_smp.h>
+#include <mm/mem.h>
+#include <memlayout.h>
+#include <percpu.h>
+#include <types.h>
+#include <errno.h>
+
+/* offset of each cpu's copy from the template */
+addr_t percpu_offset[NR_CPUS];
+
+static unsigned char percpu_areas[NR_CPUS][PERCPU_AREA_SZ] __cacheline_aligned;
+
+/**
+ * percpu_init
+ * 
+ * copies the per cpu template for each cpu & enters the boot cpu's
+ * copy (see percpu_cpu_init); per cpu variables mustn't be accessed
+ * prior.
+ * 
+ * @return errno
+ **/
+int percpu_init(void) {
+    size_t	size	= (size_t)&percpu_end - (size_t)&percpu_start;
+    int		ret	= ESUCC;
+    
+    if (size > PERCPU_AREA_SZ) {
+	ret = ESIZE;
+    } else {
+	for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++) {
+	    memcpy(percpu_areas[cpu], &percpu_start, size);
+	    percpu_offset[cpu] = (addr_t)percpu_areas[cpu] - (addr_t)&percpu_start;
+	}
+	
+	percpu_cpu_init(arch_smp_get_cpu_id());
+    }
+    
+    return ret;
+}
+
+/**
+ * percpu_cpu_init
+ * 
+ * enters the calling cpu's copy of the per cpu template; each
+ * secondary cpu must do so before accessing per cpu variables.
+ * 
+ * @cpu	id of the calling cpu
+ **/
+void percpu_cpu_init(unsigned int cpu) {
+    arch_percpu_set_offset(percpu_offset[cpu]);
+}
@@ -0,0 +1,178 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * smp.c brings the secondary cpus online.
+ */
+#include <mach/mach.h> /* TODO: tmp */
+#include <arch/arch_smp.h>
+#include <sync/barriers.h>
+#include <sync/lock_bench.h>
+#include <sync/lockstat.h>
+#include <sync/rcu.h>
+#include <mm/tlb.h>
+#include <percpu.h>
+#include <smp.h>
+#include <smp_call.h>
+#include <types.h>
+#include <errno.h>
+#include <stdbool.h>
+
+extern void install_ivt();
+
+/* set by each cpu once it's able to service ipis */
+volatile bool smp_cpu_online[NR_CPUS];
+
+/**
+ * smp_init
+ * 
+ * brings the secondary cpus online, one at a time; the boot cpu is
+ * marked online first.
+ * a cpu that doesn't come online within SMP_BOOT_TIMEOUT spins is
+ * reported & skipped.
+ **/
+void smp_init(void) {
+    unsigned int	self	= arch_smp_get_cpu_id();
+    unsigned int	cnt	= 1;
+    
+    smp_cpu_online[self] = true;
+    
+#ifdef CONFIG_SMP
+    cnt = mach_smp_get_cpu_cnt();
+    
+    for (unsigned int cpu = 0; cpu < cnt; cpu++) {
+	int err = ESUCC;
+	
+	if (cpu != self) {
+	    if ((err = mach_smp_boot_cpu(cpu, smp_secondary_start)) != ESUCC) {
+		mach_early_kprintf("cpu %i: boot failed with %i\n", cpu, err);
+	    } else {
+		for (unsigned int i = 0; i < SMP_BOOT_TIMEOUT && !smp_cpu_online[cpu]; i++);
+		
+		if (smp_cpu_online[cpu]) {
+		    mach_early_kprintf("cpu %i online\n", cpu);
+		} else {
+		    mach_early_kprintf("cpu %i: timed out\n", cpu);
+		}
+	    }
+	}
+    }
+#endif
+    
+    mach_early_kprintf("smp: %i of %i cpus online\n", smp_get_online_cnt(), cnt);
+}
+
+/**
+ * smp_secondary_start
+ * 
+ * kernel entry of the secondary cpus (see mach_smp_boot_cpu); entered
+ * with irqs masked, the mmu & caches enabled and sp within the linear map.
+ * the cpu then idles (see smp_idle).
+ * 
+ * @cpu	id of the calling cpu
+ **/
+void smp_secondary_start(unsigned int cpu) {
+    percpu_cpu_init(cpu);
+    
+#ifdef CONFIG_LOCKSTAT
+    lockstat_cpu_init();
+#endif
+    
+    install_ivt();
+    vm_space_enter(&kern_vm_space);
+    
+#ifdef CONFIG_SMP
+    mach_init_irq_cntl_cpu();
+#endif
+    
+    arch_dsb();
+    smp_cpu_online[cpu] = true;
+    arch_dsb();
+    
+#if defined(CONFIG_LOCK_BENCH) && defined(CONFIG_EARLY_KPRINTF)
+    lock_bench_join();
+#endif
+    
+    smp_idle();
+}
+
+/**
+ * smp_idle
+ * 
+ * idles the calling cpu, servicing ipis & passing through a quiescent
+ * state (see rcu.h) each time it wakes; never returns.
+ * irqs must be masked.
+ **/
+void smp_idle(void) {
+    for (;;) {
+	rcu_quiescent_state();
+	arch_smp_idle();
+    }
+}
+
+/**
+ * smp_poll_ipis
+ * 
+ * services the shootdowns & calls outstanding for the calling cpu, as
+ * if their ipis were taken.
+ * a cpu waiting upon others with irqs masked must poll both, as any of
+ * them may in turn be waiting upon it for either.
+ **/
+void smp_poll_ipis(void) {
+    tlb_shootdown_hand();
+    smp_call_hand();
+}
+
+/**
+ * smp_get_online_mask
+ * 
+ * returns the online cpus (see arch_smp_send_ipi).
+ * 
+ * @return bitmask of online cpu ids
+ **/
+unsigned int smp_get_online_mask(void) {
+    unsigned int mask = 0;
+    
+    for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++) {
+	if (smp_cpu_online[cpu]) {
+	    mask |= (1 << cpu);
+	}
+    }
+    
+    return mask;
+}
+
+/**
+ * smp_get_online_cnt
+ * 
+ * returns the number of online cpus.
+ * 
+ * @return online cpu count
+ **/
+unsigned int smp_get_online_cnt(void) {
+    unsigned int cnt = 0;
+    
+    for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++) {
+	if (smp_cpu_online[cpu]) {
+	    cnt++;
+	}
+    }
+    
+    return cnt;
+}
@@ -0,0 +1,290 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * smp_call.c runs functions upon other cpus (see smp_call.h).
+ * each cpu holds a call per target for smp_call_function_*, which is
+ * reused once its previous call has been released; a cpu waiting upon
+ * a call (or its release) services its own calls & shootdowns meanwhile
+ * (see smp_poll_ipis), as their senders may be waiting upon it in turn.
+ */
+#include <arch/arch_smp.h>
+#include <sync/atomic.h>
+#include <sync/barriers.h>
+#include <percpu.h>
+#include <smp.h>
+#include <smp_call.h>
+#include <types.h>
+#include <errno.h>
+#include <stdbool.h>
+
+/**
+ * smp_call_cpu
+ * 
+ * cross call state of a cpu
+ * 
+ * @queue	calls queued upon the cpu, most recent first (struct smp_call *)
+ * @slots	calls made by the cpu, one per target
+ **/
+struct smp_call_cpu {
+    volatile addr_t	queue;
+    struct smp_call	slots[NR_CPUS] __cacheline_aligned;
+};
+
+static DEFINE_PER_CPU(struct smp_call_cpu, smp_call_cpu);
+
+static bool smp_call_queue(unsigned int cpu, struct smp_call *call);
+static void smp_call_wait(struct smp_call *call);
+static struct smp_call *smp_call_prepare(unsigned int self, unsigned int cpu,
+					 void (*func)(void *arg), void *arg, bool wait);
+
+/**
+ * smp_call_function_single
+ * 
+ * runs func upon cpu; upon the calling cpu, it's run at once.
+ * 
+ * @cpu	target cpu id
+ * @func	function
+ * @arg	argument passed to func
+ * @wait	true to wait until func has returned
+ * @return ESUCC, or EINVAL if func is NULL or cpu is offline
+ **/
+int smp_call_function_single(unsigned int cpu, void (*func)(void *arg), void *arg, bool wait) {
+    unsigned int	self	= arch_smp_get_cpu_id();
+    struct smp_call	*call	= NULL;
+    int			ret	= ESUCC;
+    
+    if (func == NULL || !smp_cpu_is_online(cpu)) {
+	ret = EINVAL;
+    } else if (cpu == self) {
+	func(arg);
+    } else {
+	call = smp_call_prepare(self, cpu, func, arg, wait);
+	
+	if (smp_call_queue(cpu, call)) {
+	    arch_smp_send_ipi((1u << cpu), IPI_CALL_FUNC);
+	}
+	
+	if (wait) {
+	    smp_call_wait(call);
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * smp_call_function_many
+ * 
+ * runs func upon the online cpus in cpu_mask, other than the calling
+ * cpu; the targets are raised by a single sgi.
+ * 
+ * @cpu_mask	bitmask of target cpu ids
+ * @func	function
+ * @arg	argument passed to func
+ * @wait	true to wait until func has returned upon every target
+ * @return ESUCC, or EINVAL if func is NULL
+ **/
+int smp_call_function_many(unsigned int cpu_mask, void (*func)(void *arg), void *arg, bool wait) {
+    unsigned int	self	= arch_smp_get_cpu_id();
+    unsigned int	raise	= 0;
+    int			ret	= ESUCC;
+    
+    cpu_mask &= smp_get_online_mask() & ~(1u << self);
+    
+    if (func == NULL) {
+	ret = EINVAL;
+    } else {
+	for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++) {
+	    if ((cpu_mask & (1u << cpu)) &&
+		smp_call_queue(cpu, smp_call_prepare(self, cpu, func, arg, wait))) {
+		raise |= (1u << cpu);
+	    }
+	}
+	
+	if (raise != 0) {
+	    arch_smp_send_ipi(raise, IPI_CALL_FUNC);
+	}
+	
+	if (wait) {
+	    for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++) {
+		if (cpu_mask & (1u << cpu)) {
+		    smp_call_wait(&per_cpu(smp_call_cpu, self).slots[cpu]);
+		}
+	    }
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * smp_call_function
+ * 
+ * runs func upon every other online cpu.
+ * 
+ * @func	function
+ * @arg	argument passed to func
+ * @wait	true to wait until func has returned upon every cpu
+ * @return ESUCC, or EINVAL if func is NULL
+ **/
+int smp_call_function(void (*func)(void *arg), void *arg, bool wait) {
+    return smp_call_function_many(smp_get_online_mask(), func, arg, wait);
+}
+
+/**
+ * smp_call_function_async
+ * 
+ * queues a call owned by the caller upon cpu, without waiting upon it;
+ * any number may be outstanding, so a sender may batch calls upon a
+ * single sgi.  upon the calling cpu, the call is run at once.
+ * a call still busy from a previous use is waited upon first.
+ * 
+ * @cpu	target cpu id
+ * @call	call (see SMP_CALL_INIT); must remain valid while busy
+ * @return ESUCC, or EINVAL if call->func is NULL or cpu is offline
+ **/
+int smp_call_function_async(unsigned int cpu, struct smp_call *call) {
+    int ret = ESUCC;
+    
+    if (call->func == NULL || !smp_cpu_is_online(cpu)) {
+	ret = EINVAL;
+    } else {
+	smp_call_wait(call);
+	
+	if (cpu == arch_smp_get_cpu_id()) {
+	    call->func(call->arg);
+	} else {
+	    call->wait = false;
+	    call->busy = true;
+	    
+	    if (smp_call_queue(cpu, call)) {
+		arch_smp_send_ipi((1u << cpu), IPI_CALL_FUNC);
+	    }
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * smp_call_hand
+ * 
+ * runs the calls queued upon the calling cpu, in the order queued.
+ * this is called upon receiving IPI_CALL_FUNC & while waiting upon a call.
+ **/
+void smp_call_hand(void) {
+    struct smp_call_cpu	*self	= this_cpu_ptr(smp_call_cpu);
+    struct smp_call	*list	= (struct smp_call *)arch_xchg(&self->queue, 0);
+    struct smp_call	*fifo	= NULL;
+    
+    while (list != NULL) {
+	struct smp_call *next = list->next;
+	
+	list->next	= fifo;
+	fifo		= list;
+	list		= next;
+    }
+    
+    while (fifo != NULL) {
+	struct smp_call	*call		= fifo;
+	void		(*func)(void *arg)	= call->func;
+	void		*arg		= call->arg;
+	
+	/* the call may be reused as soon as it's released */
+	fifo = call->next;
+	
+	if (call->wait) {
+	    func(arg);
+	    arch_dmb_ish();
+	    call->busy = false;
+	} else {
+	    arch_dmb_ish();
+	    call->busy = false;
+	    func(arg);
+	}
+    }
+}
+
+/**
+ * smp_call_queue
+ * 
+ * pushes a call upon the queue of cpu.
+ * 
+ * @cpu	target cpu id
+ * @call	call, busy
+ * @return true if the queue was empty, i.e., the target must be raised
+ **/
+static bool smp_call_queue(unsigned int cpu, struct smp_call *call) {
+    volatile addr_t	*queue	= &per_cpu(smp_call_cpu, cpu).queue;
+    addr_t		first	= 0;
+    
+    /* fully ordered; the call is visible to whoever takes the queue */
+    do {
+	first		= *queue;
+	call->next	= (struct smp_call *)first;
+    } while (arch_cmpxchg(queue, first, (addr_t)call) != first);
+    
+    return (first == 0);
+}
+
+/**
+ * smp_call_wait
+ * 
+ * waits until a call is released, servicing the calls & shootdowns
+ * outstanding for the calling cpu meanwhile.
+ * 
+ * @call	call
+ **/
+static void smp_call_wait(struct smp_call *call) {
+    while (call->busy) {
+	smp_poll_ipis();
+	arch_cpu_relax();
+    }
+    
+    /* the effects of func are visible after its release */
+    arch_dmb_ish();
+}
+
+/**
+ * smp_call_prepare
+ * 
+ * claims the calling cpu's call upon cpu, once its previous call has
+ * been released.
+ * 
+ * @self	id of the calling cpu
+ * @cpu	target cpu id
+ * @func	function
+ * @arg	argument passed to func
+ * @wait	true if the caller waits upon func returning
+ * @return call, busy
+ **/
+static struct smp_call *smp_call_prepare(unsigned int self, unsigned int cpu,
+					 void (*func)(void *arg), void *arg, bool wait) {
+    struct smp_call *call = &per_cpu(smp_call_cpu, self).slots[cpu];
+    
+    smp_call_wait(call);
+    
+    call->func	= func;
+    call->arg	= arg;
+    call->wait	= wait;
+    call->busy	= true;
+    
+    return call;
+}
@@ -0,0 +1,148 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * smp_call_bench.c measures the latency of cross calls
+ * (see CONFIG_SMP_CALL_BENCH).
+ */
+#include <mach/mach.h> /* TODO: tmp */
+#include <arch/arch_pmu.h>
+#include <arch/arch_smp.h>
+#include <sync/atomic.h>
+#include <sync/barriers.h>
+#include <util/bits.h>
+#include <smp.h>
+#include <smp_call.h>
+#include <smp_call_bench.h>
+#include <types.h>
+
+#if defined(CONFIG_SMP_CALL_BENCH) && defined(CONFIG_EARLY_KPRINTF)
+
+static void bench_nop(void *arg);
+static void bench_count(void *arg);
+static void smp_call_bench_cpu(unsigned int cpu);
+
+/* asynchronous calls completed by the target */
+static volatile unsigned int bench_done = 0;
+
+static struct smp_call bench_calls[SMP_CALL_BENCH_BATCH];
+
+/**
+ * smp_call_bench
+ * 
+ * boot-time self-check; reports the cycles per call made upon each
+ * other online cpu, both waited upon one at a time (ping-pong) and
+ * queued without waiting, several at once, then per call broadcast to them all.
+ * the other cpus must be idle (see smp_idle).
+ **/
+void smp_call_bench(void) {
+    unsigned int	self	= arch_smp_get_cpu_id();
+    unsigned int	cpus	= smp_get_online_cnt() - 1;
+    unsigned int	start	= 0;
+    unsigned int	cycles	= 0;
+    
+    arch_pmu_cycle_enable();
+    
+    for (unsigned int i = 0; i < SMP_CALL_BENCH_BATCH; i++) {
+	bench_calls[i] = (struct smp_call)SMP_CALL_INIT(bench_count, NULL);
+    }
+    
+    for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++) {
+	if (cpu != self && smp_cpu_is_online(cpu)) {
+	    smp_call_bench_cpu(cpu);
+	}
+    }
+    
+    if (cpus > 0) {
+	start = arch_pmu_get_cycles();
+	
+	for (unsigned int i = 0; i < SMP_CALL_BENCH_ITER; i++) {
+	    smp_call_function(bench_nop, NULL, true);
+	}
+	
+	cycles = arch_pmu_get_cycles() - start;
+	
+	mach_early_kprintf("smp call bench (broadcast): %i cpus, %i calls in %i cycles, %i cycles each\n",
+	    cpus, SMP_CALL_BENCH_ITER, cycles, udiv32(cycles, SMP_CALL_BENCH_ITER));
+    }
+}
+
+/**
+ * smp_call_bench_cpu
+ * 
+ * measures the calls made upon a single cpu.
+ * 
+ * @cpu	target cpu id
+ **/
+static void smp_call_bench_cpu(unsigned int cpu) {
+    unsigned int	min	= 0xFFFFFFFF;
+    unsigned int	max	= 0;
+    unsigned int	total	= 0;
+    unsigned int	start	= 0;
+    unsigned int	cycles	= 0;
+    
+    /* each call is sent & waited upon before the next */
+    for (unsigned int i = 0; i < SMP_CALL_BENCH_ITER; i++) {
+	start = arch_pmu_get_cycles();
+	smp_call_function_single(cpu, bench_nop, NULL, true);
+	cycles = arch_pmu_get_cycles() - start;
+	
+	total += cycles;
+	
+	if (cycles < min) {
+	    min = cycles;
+	}
+	
+	if (cycles > max) {
+	    max = cycles;
+	}
+    }
+    
+    mach_early_kprintf("smp call bench (ping-pong): cpu %i, %i calls, %i cycles each (min %i, max %i)\n",
+	cpu, SMP_CALL_BENCH_ITER, udiv32(total, SMP_CALL_BENCH_ITER), min, max);
+    
+    /* up to SMP_CALL_BENCH_BATCH calls queued, delivered by as few sgis */
+    bench_done = 0;
+    arch_dsb();
+    
+    start = arch_pmu_get_cycles();
+    
+    for (unsigned int i = 0; i < SMP_CALL_BENCH_ITER; i++) {
+	smp_call_function_async(cpu, &bench_calls[i % SMP_CALL_BENCH_BATCH]);
+    }
+    
+    while (bench_done != SMP_CALL_BENCH_ITER) {
+	arch_cpu_relax();
+    }
+    
+    cycles = arch_pmu_get_cycles() - start;
+    
+    mach_early_kprintf("smp call bench (async, %i queued): cpu %i, %i calls in %i cycles, %i cycles each\n",
+	SMP_CALL_BENCH_BATCH, cpu, SMP_CALL_BENCH_ITER, cycles, udiv32(cycles, SMP_CALL_BENCH_ITER));
+}
+
+static void bench_nop(void *arg) {
+    (void)arg;
+}
+
+static void bench_count(void *arg) {
+    (void)arg;
+    bench_done++;
+}
+#endif
@@ -0,0 +1,185 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * lock_bench.c measures spinlock_t & mcs_lock_t under contention
+ * (see CONFIG_LOCK_BENCH).
+ */
+#include <mach/mach.h> /* TODO: tmp */
+#include <arch/arch_pmu.h>
+#include <arch/arch_smp.h>
+#include <arch/arch_sync.h>
+#include <sync/atomic.h>
+#include <sync/barriers.h>
+#include <sync/lock_bench.h>
+#include <sync/mcs_lock.h>
+#include <sync/spinlock.h>
+#include <util/bits.h>
+#include <smp.h>
+#include <types.h>
+
+#if defined(CONFIG_LOCK_BENCH) && defined(CONFIG_EARLY_KPRINTF)
+
+/**
+ * lock_bench_ops
+ * 
+ * lock under measurement
+ * 
+ * @name	description of lock
+ * @lock	acquires the lock
+ * @unlock	releases the lock
+ **/
+struct lock_bench_ops {
+    const char	*name;
+    void	(*lock)(void);
+    void	(*unlock)(void);
+};
+
+static void bench_ticket_lock(void);
+static void bench_ticket_unlock(void);
+static void bench_mcs_lock(void);
+static void bench_mcs_unlock(void);
+static void lock_bench_run(const struct lock_bench_ops *ops);
+
+static const struct lock_bench_ops bench_ops[] = {
+    { "ticket", bench_ticket_lock, bench_ticket_unlock },
+    { "mcs", bench_mcs_lock, bench_mcs_unlock }
+};
+
+#define LOCK_BENCH_CNT	(sizeof(bench_ops) / sizeof(bench_ops[0]))
+
+static spinlock_t	bench_ticket	= SPINLOCK_INIT;
+static mcs_lock_t	bench_mcs	= MCS_LOCK_INIT;
+
+/* written by each holder; the first word of each line counts acquisitions */
+static volatile unsigned int bench_data[LOCK_BENCH_LINES][SMP_CACHE_LINE_SZ / sizeof(unsigned int)] __cacheline_aligned;
+
+/* round being run (from 1) & the cpus that have completed it */
+static volatile unsigned int	bench_round	= 0;
+static volatile unsigned int	bench_done	= 0;
+static spinlock_t		bench_done_lock	= SPINLOCK_INIT;
+
+/**
+ * lock_bench
+ * 
+ * boot-time self-check; each online cpu acquires every lock
+ * LOCK_BENCH_ITER times, writing LOCK_BENCH_LINES lines while holding it,
+ * and the cycles taken per acquisition are reported.
+ * the secondary cpus must be waiting within lock_bench_join.
+ **/
+void lock_bench(void) {
+    unsigned int	cpus	= smp_get_online_cnt();
+    unsigned int	total	= cpus * LOCK_BENCH_ITER;
+    unsigned int	start	= 0;
+    unsigned int	cycles	= 0;
+    
+    arch_pmu_cycle_enable();
+    
+    for (unsigned int round = 1; round <= LOCK_BENCH_CNT; round++) {
+	const struct lock_bench_ops *ops = &bench_ops[round - 1];
+	
+	for (unsigned int i = 0; i < LOCK_BENCH_LINES; i++) {
+	    bench_data[i][0] = 0;
+	}
+	
+	bench_done = 0;
+	arch_dsb();
+	
+	start = arch_pmu_get_cycles();
+	
+	bench_round = round;
+	arch_send_event();
+	
+	lock_bench_run(ops);
+	
+	while (bench_done != cpus) {
+	    arch_wait_event();
+	}
+	
+	cycles = arch_pmu_get_cycles() - start;
+	arch_dmb();
+	
+	mach_early_kprintf("lock bench (%s): %i cpus, %i acquisitions in %i cycles, %i cycles each\n",
+	    ops->name, cpus, total, cycles, udiv32(cycles, total));
+	
+	if (bench_data[0][0] != total) {
+	    mach_early_kprintf("lock bench (%s): %i of %i acquisitions observed\n", 
+		ops->name, bench_data[0][0], total);
+	}
+    }
+}
+
+/**
+ * lock_bench_join
+ * 
+ * takes part in each round of lock_bench as it's started.
+ **/
+void lock_bench_join(void) {
+    for (unsigned int round = 1; round <= LOCK_BENCH_CNT; round++) {
+	while (bench_round != round) {
+	    arch_wait_event();
+	}
+	
+	arch_dmb();
+	lock_bench_run(&bench_ops[round - 1]);
+    }
+}
+
+/**
+ * lock_bench_run
+ * 
+ * runs a round on the calling cpu.
+ * 
+ * @ops	lock under measurement
+ **/
+static void lock_bench_run(const struct lock_bench_ops *ops) {
+    for (unsigned int i = 0; i < LOCK_BENCH_ITER; i++) {
+	ops->lock();
+	
+	for (unsigned int line = 0; line < LOCK_BENCH_LINES; line++) {
+	    bench_data[line][0]++;
+	}
+	
+	ops->unlock();
+    }
+    
+    spin_lock(&bench_done_lock);
+    bench_done++;
+    spin_unlock(&bench_done_lock);
+    
+    arch_send_event();
+}
+
+/* taken bare, as mcs_lock_t is; CONFIG_LOCKSTAT would otherwise be timed too */
+static void bench_ticket_lock(void) {
+    arch_spin_lock(&bench_ticket);
+}
+
+static void bench_ticket_unlock(void) {
+    arch_spin_unlock(&bench_ticket);
+}
+
+static void bench_mcs_lock(void) {
+    mcs_lock(&bench_mcs);
+}
+
+static void bench_mcs_unlock(void) {
+    mcs_unlock(&bench_mcs);
+}
+#endif
@@ -0,0 +1,178 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * lockstat.c records the contention of spinlock_t & of rwlock_t writers
+ * (see CONFIG_LOCKSTAT) & reports the locks waited upon the longest.
+ */
+#include <mach/mach.h> /* TODO: tmp */
+#include <arch/arch_pmu.h>
+#include <sync/atomic.h>
+#include <sync/lockstat.h>
+#include <util/bits.h>
+#include <types.h>
+#include <stdbool.h>
+
+#ifdef CONFIG_LOCKSTAT
+
+/* registered locks, most recently first acquired first */
+static struct lockstat * volatile lockstat_head = NULL;
+
+static unsigned int lockstat_avg(unsigned long long total, unsigned int cnt);
+static bool lockstat_before(struct lockstat *a, struct lockstat *b);
+
+/**
+ * lockstat_avg
+ * 
+ * divides a 64-bit total, scaling both operands down until the
+ * total fits udiv32.
+ * 
+ * @total	total
+ * @cnt		count
+ * @return total / cnt (approximate if total > 32 bits)
+ **/
+static unsigned int lockstat_avg(unsigned long long total, unsigned int cnt) {
+    while ((total >> 32) != 0) {
+	total	>>= 1;
+	cnt	>>= 1;
+    }
+    
+    return udiv32((uint32_t)total, cnt);
+}
+
+/**
+ * lockstat_before
+ * 
+ * orders the locks reported; by total wait, then address.
+ * 
+ * @a		lock
+ * @b		lock (or NULL, which follows every lock)
+ * @return true if a is reported before b
+ **/
+static bool lockstat_before(struct lockstat *a, struct lockstat *b) {
+    return (b == NULL || a->wait_total > b->wait_total ||
+	    (a->wait_total == b->wait_total && (addr_t)a > (addr_t)b));
+}
+
+/**
+ * lockstat_acquired
+ * 
+ * records an acquisition; called by the new holder.
+ * 
+ * @stat	lock's statistics
+ * @start	cycle count when the acquisition began
+ * @contended	true if the lock was held (or waited upon)
+ **/
+void lockstat_acquired(struct lockstat *stat, unsigned int start, bool contended) {
+    unsigned int	now	= arch_pmu_get_cycles();
+    unsigned int	wait	= now - start;
+    
+    if (!stat->registered) {
+	stat->registered = true;
+	
+	do {
+	    stat->next = lockstat_head;
+	} while (arch_cmpxchg((volatile addr_t *)&lockstat_head, (addr_t)stat->next,
+			      (addr_t)stat) != (addr_t)stat->next);
+    }
+    
+    stat->acquired++;
+    stat->hold_start = now;
+    
+    if (contended) {
+	stat->contended++;
+	stat->wait_total += wait;
+	
+	if (wait > stat->wait_max) {
+	    stat->wait_max = wait;
+	}
+    }
+}
+
+/**
+ * lockstat_released
+ * 
+ * records the end of a hold; called by the holder, before releasing.
+ * 
+ * @stat	lock's statistics
+ **/
+void lockstat_released(struct lockstat *stat) {
+    unsigned int hold = arch_pmu_get_cycles() - stat->hold_start;
+    
+    stat->hold_total += hold;
+    
+    if (hold > stat->hold_max) {
+	stat->hold_max = hold;
+    }
+}
+
+/**
+ * lockstat_cpu_init
+ * 
+ * enables the calling cpu's cycle counter, which times its waits & holds.
+ **/
+void lockstat_cpu_init(void) {
+    arch_pmu_cycle_enable();
+}
+
+#ifdef CONFIG_EARLY_KPRINTF
+/**
+ * lockstat_dump
+ * 
+ * reports the cnt locks with the most cycles waited.
+ * the statistics are read without the locks, so a lock in use may
+ * be reported partially updated.
+ * 
+ * @cnt		count of locks to report
+ **/
+void lockstat_dump(unsigned int cnt) {
+    struct lockstat *prev = NULL;
+    
+    mach_early_kprintf("lockstat: top %i locks by cycles waited\n", cnt);
+    
+    for (unsigned int i = 0; i < cnt; i++) {
+	struct lockstat *top = NULL;
+	
+	/* the next lock in order after the one last reported */
+	for (struct lockstat *stat = lockstat_head; stat != NULL; stat = stat->next) {
+	    if ((prev == NULL || lockstat_before(prev, stat)) && lockstat_before(stat, top)) {
+		top = stat;
+	    }
+	}
+	
+	if (top == NULL) {
+	    break;
+	}
+	
+	if (top->name != NULL) {
+	    mach_early_kprintf("%s:", top->name);
+	} else {
+	    mach_early_kprintf("0x%x:", (addr_t)top);
+	}
+	
+	mach_early_kprintf(" %i acquired, %i contended; wait avg %i max %i, hold avg %i max %i\n",
+	    top->acquired, top->contended, lockstat_avg(top->wait_total, top->contended),
+	    top->wait_max, lockstat_avg(top->hold_total, top->acquired), top->hold_max);
+	
+	prev = top;
+    }
+}
+#endif
+
+#endif
@@ -0,0 +1,192 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * mcs_lock.c provides queued (mcs) locks.
+ */
+#include <arch/arch_sync.h>
+#include <sync/atomic.h>
+#include <sync/barriers.h>
+#include <sync/mcs_lock.h>
+#include <mach/mach.h>
+#include <percpu.h>
+#include <types.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * mcs_cpu
+ * 
+ * queue entries of a cpu; locks must be released in the reverse
+ * order they were acquired, as the entries are used as a stack.
+ * 
+ * @nodes	queue entries
+ * @depth	entries in use
+ **/
+struct mcs_cpu {
+    struct mcs_node	nodes[MCS_NODE_CNT];
+    unsigned int	depth;
+};
+
+static DEFINE_PER_CPU(struct mcs_cpu, mcs_cpu);
+
+static void mcs_depth_check(struct mcs_cpu *mcs);
+
+/**
+ * mcs_lock_init
+ * 
+ * initializes a lock as released.
+ * 
+ * @lock	lock
+ **/
+void mcs_lock_init(mcs_lock_t *lock) {
+    lock->tail = 0x0;
+}
+
+/**
+ * mcs_lock
+ * 
+ * acquires a lock; the calling cpu queues its next entry & waits upon
+ * it's own line until the previous holder hands the lock over.
+ * 
+ * @lock	lock
+ **/
+void mcs_lock(mcs_lock_t *lock) {
+    struct mcs_cpu	*mcs	= this_cpu_ptr(mcs_cpu);
+    struct mcs_node	*node	= NULL;
+    struct mcs_node	*prev	= NULL;
+    
+    mcs_depth_check(mcs);
+    node = &mcs->nodes[mcs->depth++];
+    
+    node->next	= NULL;
+    node->locked	= false;
+    
+    /* arch_xchg orders the initialization above before queueing */
+    if ((prev = (struct mcs_node *)arch_xchg(&lock->tail, (addr_t)node)) != NULL) {
+	prev->next = node;
+	
+	while (!node->locked) {
+	    arch_wait_event();
+	}
+	
+	arch_dmb();
+    }
+}
+
+/**
+ * mcs_trylock
+ * 
+ * acquires a lock only if it's free, without queueing.
+ * 
+ * @lock	lock
+ * @return true if acquired
+ **/
+bool mcs_trylock(mcs_lock_t *lock) {
+    struct mcs_cpu	*mcs	= this_cpu_ptr(mcs_cpu);
+    struct mcs_node	*node	= NULL;
+    bool		ret	= false;
+    
+    mcs_depth_check(mcs);
+    node = &mcs->nodes[mcs->depth];
+    
+    node->next	= NULL;
+    node->locked	= false;
+    
+    if (arch_cmpxchg(&lock->tail, 0x0, (addr_t)node) == 0x0) {
+	mcs->depth++;
+	ret = true;
+    }
+    
+    return ret;
+}
+
+/**
+ * mcs_unlock
+ * 
+ * releases a lock, handing it to the next waiter if any.
+ * 
+ * @lock	lock
+ **/
+void mcs_unlock(mcs_lock_t *lock) {
+    struct mcs_cpu	*mcs	= this_cpu_ptr(mcs_cpu);
+    struct mcs_node	*node	= &mcs->nodes[mcs->depth - 1];
+    struct mcs_node	*next	= node->next;
+    
+    if (next == NULL) {
+	/* no waiter; otherwise one is queueing behind node */
+	if (arch_cmpxchg(&lock->tail, (addr_t)node, 0x0) != (addr_t)node) {
+	    while ((next = node->next) == NULL);
+	}
+    }
+    
+    if (next != NULL) {
+	arch_dmb();
+	next->locked = true;
+	arch_send_event();
+    }
+    
+    mcs->depth--;
+}
+
+/**
+ * mcs_lock_irqsave
+ * 
+ * masks irqs on the calling cpu & acquires a lock.
+ * 
+ * @lock	lock
+ * @return previous irq state, for mcs_unlock_irqrestore
+ **/
+unsigned int mcs_lock_irqsave(mcs_lock_t *lock) {
+    unsigned int flags = arch_irq_save();
+    
+    mcs_lock(lock);
+    
+    return flags;
+}
+
+/**
+ * mcs_unlock_irqrestore
+ * 
+ * releases a lock acquired by mcs_lock_irqsave & restores the
+ * previous irq state.
+ * 
+ * @lock	lock
+ * @flags	irq state returned by mcs_lock_irqsave
+ **/
+void mcs_unlock_irqrestore(mcs_lock_t *lock, unsigned int flags) {
+    mcs_unlock(lock);
+    arch_irq_restore(flags);
+}
+
+/**
+ * mcs_depth_check
+ * 
+ * halts the calling cpu if all of its queue entries are in use; more
+ * than MCS_NODE_CNT nested mcs locks would overrun its entries.
+ * 
+ * @mcs		queue entries of the calling cpu
+ **/
+static void mcs_depth_check(struct mcs_cpu *mcs) {
+    if (mcs->depth >= MCS_NODE_CNT) {
+	mach_early_kprintf("[ERROR] mcs_lock: more than %i nested locks\n", MCS_NODE_CNT);
+	
+	while(1);
+    }
+}
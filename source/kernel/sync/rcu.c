@@ -0,0 +1,280 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * rcu.c detects grace periods & invokes the callbacks deferred
+ * through call_rcu (see rcu.h).
+ * a grace period is started by a cpu with callbacks waiting, which
+ * wakes the others; it ends once each cpu online at its start has
+ * reported a quiescent state (rcu_quiescent_state).  the cpus with
+ * callbacks waiting are woken again once it has, so none are left
+ * behind an idle cpu.
+ */
+#include <arch/arch_smp.h>
+#include <arch/arch_sync.h>
+#include <sync/atomic.h>
+#include <sync/rcu.h>
+#include <sync/spinlock.h>
+#include <percpu.h>
+#include <smp.h>
+#include <types.h>
+#include <stdbool.h>
+
+/**
+ * rcu_cpu
+ * 
+ * callbacks of a cpu; only the cpu itself accesses them (irqs masked)
+ * 
+ * @next	callbacks queued since the last quiescent state
+ * @next_tail	link to append to next through
+ * @wait	callbacks waiting upon grace period wait_gp
+ * @wait_gp	grace period that ends wait's
+ **/
+struct rcu_cpu {
+    struct rcu_head	*next;
+    struct rcu_head	**next_tail;
+    struct rcu_head	*wait;
+    unsigned long	wait_gp;
+};
+
+/**
+ * rcu_gp
+ * 
+ * grace period state, shared by the cpus
+ * 
+ * @lock	lock
+ * @cur		last grace period started
+ * @done	last grace period ended (cur if none is in progress)
+ * @req		last grace period requested by a cpu's callbacks
+ * @qs_mask	cpus yet to report a quiescent state within cur
+ * @cb_mask	cpus with callbacks waiting
+ **/
+struct rcu_gp {
+    spinlock_t		lock;
+    unsigned long	cur;
+    unsigned long	done;
+    unsigned long	req;
+    unsigned int	qs_mask;
+    unsigned int	cb_mask;
+};
+
+/**
+ * rcu_sync
+ * 
+ * a synchronize_rcu in progress
+ * 
+ * @head	callback
+ * @done	set by the callback
+ **/
+struct rcu_sync {
+    struct rcu_head	head;
+    volatile bool	done;
+};
+
+static DEFINE_PER_CPU(struct rcu_cpu, rcu_cpu);
+static struct rcu_gp rcu_gp __cacheline_aligned = { .lock = SPINLOCK_INIT };
+
+static bool rcu_gp_after(unsigned long a, unsigned long b);
+static unsigned int rcu_gp_start(unsigned int self);
+static void rcu_invoke(struct rcu_head *head);
+static void rcu_sync_done(struct rcu_head *head);
+
+/**
+ * rcu_gp_after
+ * 
+ * compares grace period numbers, which may wrap
+ * 
+ * @a		grace period
+ * @b		grace period
+ * @return true if a follows b
+ **/
+static bool rcu_gp_after(unsigned long a, unsigned long b) {
+    return ((long)(a - b) > 0);
+}
+
+/**
+ * rcu_gp_start
+ * 
+ * starts a grace period; rcu_gp.lock must be held & the calling cpu
+ * be within a quiescent state, which it reports at once.
+ * 
+ * @self	id of the calling cpu
+ * @return cpus to wake, so they report theirs
+ **/
+static unsigned int rcu_gp_start(unsigned int self) {
+    rcu_gp.cur++;
+    rcu_gp.qs_mask = smp_get_online_mask() & ~(1u << self);
+    
+    if (rcu_gp.qs_mask == 0) {
+	rcu_gp.done = rcu_gp.cur;
+    }
+    
+    return rcu_gp.qs_mask;
+}
+
+/**
+ * rcu_invoke
+ * 
+ * invokes a list of callbacks; each may free the object holding it.
+ * 
+ * @head	first callback (or NULL)
+ **/
+static void rcu_invoke(struct rcu_head *head) {
+    struct rcu_head *next = NULL;
+    
+    while (head != NULL) {
+	next = head->next;
+	head->func(head);
+	head = next;
+    }
+}
+
+/**
+ * rcu_sync_done
+ * 
+ * callback of synchronize_rcu
+ * 
+ * @head	rcu_sync's head
+ **/
+static void rcu_sync_done(struct rcu_head *head) {
+    ((struct rcu_sync *)head)->done = true;
+}
+
+/**
+ * rcu_init
+ * 
+ * initializes the callback lists of every cpu; must follow percpu_init.
+ **/
+void rcu_init(void) {
+    for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++) {
+	struct rcu_cpu *rc = per_cpu_ptr(rcu_cpu, cpu);
+	
+	rc->next	= NULL;
+	rc->next_tail	= &rc->next;
+	rc->wait	= NULL;
+	rc->wait_gp	= 0;
+    }
+}
+
+/**
+ * call_rcu
+ * 
+ * defers func(head) until a grace period has elapsed, so every
+ * read-side critical section that might reference the object holding
+ * head (one unpublished before the call) has ended.
+ * it may be called from irq handlers & read-side critical sections.
+ * 
+ * @head	callback, within the object
+ * @func	callback function
+ **/
+void call_rcu(struct rcu_head *head, void (*func)(struct rcu_head *head)) {
+    unsigned int	flags	= arch_irq_save();
+    struct rcu_cpu	*rc	= this_cpu_ptr(rcu_cpu);
+    
+    head->next		= NULL;
+    head->func		= func;
+    *rc->next_tail	= head;
+    rc->next_tail	= &head->next;
+    
+    arch_irq_restore(flags);
+}
+
+/**
+ * synchronize_rcu
+ * 
+ * waits for a grace period to elapse; the caller mustn't be within
+ * a read-side critical section (it passes through quiescent states
+ * itself while waiting).
+ **/
+void synchronize_rcu(void) {
+    struct rcu_sync sync = { .done = false };
+    
+    call_rcu(&sync.head, rcu_sync_done);
+    
+    while (!sync.done) {
+	rcu_quiescent_state();
+	arch_cpu_relax();
+    }
+}
+
+/**
+ * rcu_quiescent_state
+ * 
+ * reports that the calling cpu holds no references obtained within a
+ * read-side critical section; called when idle & at context switch.
+ * it also advances the cpu's callbacks, starting a grace period for
+ * those newly queued & invoking those whose grace period has ended.
+ **/
+void rcu_quiescent_state(void) {
+    unsigned int	self	= arch_smp_get_cpu_id();
+    struct rcu_cpu	*rc	= this_cpu_ptr(rcu_cpu);
+    struct rcu_head	*done	= NULL;
+    unsigned int	wake	= 0;
+    unsigned int	flags	= spin_lock_irqsave(&rcu_gp.lock);
+    
+    /* the last cpu to report ends the grace period */
+    if (rcu_gp.qs_mask & (1u << self)) {
+	rcu_gp.qs_mask &= ~(1u << self);
+	
+	if (rcu_gp.qs_mask == 0) {
+	    rcu_gp.done	= rcu_gp.cur;
+	    wake	|= rcu_gp.cb_mask;
+	}
+    }
+    
+    /*
+     * callbacks queued before now wait upon the next grace period to
+     * start; one in progress may have started before they were queued.
+     */
+    if (rc->wait == NULL && rc->next != NULL) {
+	rc->wait	= rc->next;
+	rc->wait_gp	= rcu_gp.cur + 1;
+	rc->next	= NULL;
+	rc->next_tail	= &rc->next;
+	
+	if (rcu_gp_after(rc->wait_gp, rcu_gp.req)) {
+	    rcu_gp.req = rc->wait_gp;
+	}
+    }
+    
+    if (rcu_gp.done == rcu_gp.cur && rcu_gp_after(rcu_gp.req, rcu_gp.cur)) {
+	wake |= rcu_gp_start(self);
+    }
+    
+    if (rc->wait != NULL && !rcu_gp_after(rc->wait_gp, rcu_gp.done)) {
+	done		= rc->wait;
+	rc->wait	= NULL;
+    }
+    
+    if (rc->wait != NULL || rc->next != NULL) {
+	rcu_gp.cb_mask |= (1u << self);
+    } else {
+	rcu_gp.cb_mask &= ~(1u << self);
+    }
+    
+    spin_unlock_irqrestore(&rcu_gp.lock, flags);
+    
+    wake &= ~(1u << self);
+    
+    if (wake != 0) {
+	arch_smp_send_ipi(wake, IPI_WAKEUP);
+    }
+    
+    rcu_invoke(done);
+}
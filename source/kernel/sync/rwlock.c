@@ -0,0 +1,216 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * rwlock.c provides reader-writer spinlocks.
+ */
+#include <arch/arch_pmu.h>
+#include <arch/arch_sync.h>
+#include <sync/atomic.h>
+#include <sync/barriers.h>
+#include <sync/lockstat.h>
+#include <sync/rwlock.h>
+#include <types.h>
+#include <stdbool.h>
+
+/**
+ * rwlock_init
+ * 
+ * initializes a lock as released.
+ * 
+ * @lock	lock
+ **/
+void rwlock_init(rwlock_t *lock) {
+    lock->cnt = 0;
+    
+#ifdef CONFIG_LOCKSTAT
+    /* a registered lock keeps it's statistics */
+    if (!lock->stat.registered) {
+	lock->stat = (struct lockstat){ .name = NULL };
+    }
+#endif
+}
+
+/**
+ * read_lock
+ * 
+ * acquires a lock shared with other readers, waiting while a writer
+ * holds or waits upon it.
+ * 
+ * @lock	lock
+ **/
+void read_lock(rwlock_t *lock) {
+    addr_t	cnt	= lock->cnt;
+    bool	held	= false;
+    
+    while (!held) {
+	if (cnt & RWLOCK_WRITER) {
+	    arch_wait_event();
+	    cnt = lock->cnt;
+	} else {
+	    /* another reader may have raced us; retry with what it left */
+	    addr_t prev = arch_cmpxchg(&lock->cnt, cnt, cnt + 1);
+	    
+	    held	= (prev == cnt);
+	    cnt		= prev;
+	}
+    }
+}
+
+/**
+ * read_unlock
+ * 
+ * releases a lock acquired by read_lock; the last reader out
+ * wakes a waiting writer.
+ * 
+ * @lock	lock
+ **/
+void read_unlock(rwlock_t *lock) {
+    addr_t	cnt	= lock->cnt;
+    addr_t	prev	= 0;
+    
+    while ((prev = arch_cmpxchg(&lock->cnt, cnt, cnt - 1)) != cnt) {
+	cnt = prev;
+    }
+    
+    if (cnt == (RWLOCK_WRITER | 1)) {
+	arch_send_event();
+    }
+}
+
+/**
+ * write_lock
+ * 
+ * acquires a lock exclusively; RWLOCK_WRITER is claimed first, holding
+ * off new readers, then the readers within are waited out.
+ * the wait is recorded (CONFIG_LOCKSTAT) as contended if either had to
+ * be waited upon.
+ * 
+ * @lock	lock
+ **/
+void write_lock(rwlock_t *lock) {
+    addr_t		cnt		= lock->cnt;
+    bool		claimed		= false;
+#ifdef CONFIG_LOCKSTAT
+    unsigned int	start		= arch_pmu_get_cycles();
+    bool		contended	= (cnt != 0);
+#endif
+    
+    while (!claimed) {
+	if (cnt & RWLOCK_WRITER) {
+	    arch_wait_event();
+	    cnt = lock->cnt;
+	} else {
+	    addr_t prev = arch_cmpxchg(&lock->cnt, cnt, cnt | RWLOCK_WRITER);
+	    
+	    claimed	= (prev == cnt);
+	    cnt		= prev;
+	}
+    }
+    
+    while (lock->cnt != RWLOCK_WRITER) {
+#ifdef CONFIG_LOCKSTAT
+	contended = true;
+#endif
+	arch_wait_event();
+    }
+    
+    arch_dmb();
+    
+#ifdef CONFIG_LOCKSTAT
+    lockstat_acquired(&lock->stat, start, contended);
+#endif
+}
+
+/**
+ * write_unlock
+ * 
+ * releases a lock acquired by write_lock, waking waiting readers
+ * & writers.
+ * 
+ * @lock	lock
+ **/
+void write_unlock(rwlock_t *lock) {
+#ifdef CONFIG_LOCKSTAT
+    lockstat_released(&lock->stat);
+#endif
+    
+    arch_xchg(&lock->cnt, 0);
+    arch_send_event();
+}
+
+/**
+ * read_lock_irqsave
+ * 
+ * masks irqs on the calling cpu & acquires a lock shared.
+ * 
+ * @lock	lock
+ * @return previous irq state, for read_unlock_irqrestore
+ **/
+unsigned int read_lock_irqsave(rwlock_t *lock) {
+    unsigned int flags = arch_irq_save();
+    
+    read_lock(lock);
+    
+    return flags;
+}
+
+/**
+ * read_unlock_irqrestore
+ * 
+ * releases a lock acquired by read_lock_irqsave & restores the
+ * previous irq state.
+ * 
+ * @lock	lock
+ * @flags	irq state returned by read_lock_irqsave
+ **/
+void read_unlock_irqrestore(rwlock_t *lock, unsigned int flags) {
+    read_unlock(lock);
+    arch_irq_restore(flags);
+}
+
+/**
+ * write_lock_irqsave
+ * 
+ * masks irqs on the calling cpu & acquires a lock exclusively.
+ * 
+ * @lock	lock
+ * @return previous irq state, for write_unlock_irqrestore
+ **/
+unsigned int write_lock_irqsave(rwlock_t *lock) {
+    unsigned int flags = arch_irq_save();
+    
+    write_lock(lock);
+    
+    return flags;
+}
+
+/**
+ * write_unlock_irqrestore
+ * 
+ * releases a lock acquired by write_lock_irqsave & restores the
+ * previous irq state.
+ * 
+ * @lock	lock
+ * @flags	irq state returned by write_lock_irqsave
+ **/
+void write_unlock_irqrestore(rwlock_t *lock, unsigned int flags) {
+    write_unlock(lock);
+    arch_irq_restore(flags);
+}
@@ -0,0 +1,99 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * seqlock.c provides the write side of sequence locks; readers are
+ * lock free (see seqlock.h).
+ */
+#include <arch/arch_sync.h>
+#include <sync/barriers.h>
+#include <sync/seqlock.h>
+#include <sync/spinlock.h>
+#include <types.h>
+
+/**
+ * seqlock_init
+ * 
+ * initializes a lock as released.
+ * 
+ * @sl		lock
+ **/
+void seqlock_init(seqlock_t *sl) {
+    sl->seq = 0;
+    spin_lock_init(&sl->lock);
+}
+
+/**
+ * write_seqlock
+ * 
+ * begins a write; seq is odd until write_sequnlock, so readers
+ * overlapping the write retry.
+ * 
+ * @sl		lock
+ **/
+void write_seqlock(seqlock_t *sl) {
+    spin_lock(&sl->lock);
+    
+    sl->seq++;
+    arch_dmb();
+}
+
+/**
+ * write_sequnlock
+ * 
+ * ends a write begun by write_seqlock.
+ * 
+ * @sl		lock
+ **/
+void write_sequnlock(seqlock_t *sl) {
+    arch_dmb();
+    sl->seq++;
+    
+    spin_unlock(&sl->lock);
+}
+
+/**
+ * write_seqlock_irqsave
+ * 
+ * masks irqs on the calling cpu & begins a write.
+ * 
+ * @sl		lock
+ * @return previous irq state, for write_sequnlock_irqrestore
+ **/
+unsigned int write_seqlock_irqsave(seqlock_t *sl) {
+    unsigned int flags = arch_irq_save();
+    
+    write_seqlock(sl);
+    
+    return flags;
+}
+
+/**
+ * write_sequnlock_irqrestore
+ * 
+ * ends a write begun by write_seqlock_irqsave & restores the
+ * previous irq state.
+ * 
+ * @sl		lock
+ * @flags	irq state returned by write_seqlock_irqsave
+ **/
+void write_sequnlock_irqrestore(seqlock_t *sl, unsigned int flags) {
+    write_sequnlock(sl);
+    arch_irq_restore(flags);
+}
@@ -17,5 +17,144 @@
  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
+ * 
+ * spinlock.c provides ticket spinlocks (see arch_sync.h).
  */
+#include <arch/arch_pmu.h>
+#include <arch/arch_sync.h>
+#include <sync/lockstat.h>
 #include <sync/spinlock.h>
+#include <types.h>
+#include <stdbool.h>
+
+static void spin_acquire(spinlock_t *lock);
+static void spin_release(spinlock_t *lock);
+
+/**
+ * spin_acquire
+ * 
+ * acquires a lock, recording the wait (CONFIG_LOCKSTAT)
+ * 
+ * @lock	lock
+ **/
+static void spin_acquire(spinlock_t *lock) {
+#ifdef CONFIG_LOCKSTAT
+    unsigned int	start		= arch_pmu_get_cycles();
+    bool		contended	= !arch_spin_trylock(lock);
+    
+    if (contended) {
+	arch_spin_lock(lock);
+    }
+    
+    lockstat_acquired(&lock->stat, start, contended);
+#else
+    arch_spin_lock(lock);
+#endif
+}
+
+/**
+ * spin_release
+ * 
+ * releases a lock, recording the hold (CONFIG_LOCKSTAT)
+ * 
+ * @lock	lock
+ **/
+static void spin_release(spinlock_t *lock) {
+#ifdef CONFIG_LOCKSTAT
+    lockstat_released(&lock->stat);
+#endif
+    
+    arch_spin_unlock(lock);
+}
+
+/**
+ * spin_lock_init
+ * 
+ * initializes a lock as released.
+ * 
+ * @lock	lock
+ **/
+void spin_lock_init(spinlock_t *lock) {
+    lock->tickets = 0;
+    
+#ifdef CONFIG_LOCKSTAT
+    /* a registered lock keeps it's statistics */
+    if (!lock->stat.registered) {
+	lock->stat = (struct lockstat){ .name = NULL };
+    }
+#endif
+}
+
+/**
+ * spin_lock
+ * 
+ * acquires a lock; waiting cpus are granted it in the order they
+ * arrived.  irqs are left as is, so the lock mustn't be taken
+ * from an irq handler (see spin_lock_irqsave).
+ * 
+ * @lock	lock
+ **/
+void spin_lock(spinlock_t *lock) {
+    spin_acquire(lock);
+}
+
+/**
+ * spin_trylock
+ * 
+ * acquires a lock only if it's free, without waiting.
+ * 
+ * @lock	lock
+ * @return true if acquired
+ **/
+bool spin_trylock(spinlock_t *lock) {
+    bool ret = arch_spin_trylock(lock);
+    
+#ifdef CONFIG_LOCKSTAT
+    if (ret) {
+	lockstat_acquired(&lock->stat, arch_pmu_get_cycles(), false);
+    }
+#endif
+    
+    return ret;
+}
+
+/**
+ * spin_unlock
+ * 
+ * releases a lock acquired by spin_lock or spin_trylock.
+ * 
+ * @lock	lock
+ **/
+void spin_unlock(spinlock_t *lock) {
+    spin_release(lock);
+}
+
+/**
+ * spin_lock_irqsave
+ * 
+ * masks irqs on the calling cpu & acquires a lock.
+ * 
+ * @lock	lock
+ * @return previous irq state, for spin_unlock_irqrestore
+ **/
+unsigned int spin_lock_irqsave(spinlock_t *lock) {
+    unsigned int flags = arch_irq_save();
+    
+    spin_acquire(lock);
+    
+    return flags;
+}
+
+/**
+ * spin_unlock_irqrestore
+ * 
+ * releases a lock acquired by spin_lock_irqsave & restores the
+ * previous irq state.
+ * 
+ * @lock	lock
+ * @flags	irq state returned by spin_lock_irqsave
+ **/
+void spin_unlock_irqrestore(spinlock_t *lock, unsigned int flags) {
+    spin_release(lock);
+    arch_irq_restore(flags);
+}
@@ -19,10 +19,22 @@
  * THE SOFTWARE.
  */
 .extern vexpress_boot_init	/* vexpress_boot_init.c */
+.extern vexpress_secondary_init	/* vexpress_boot_init.c */
+.extern vexpress_smp_boot	/* vexpress_boot_init.c */
 .extern k_stack			/* kernel.ld */
+.extern kp_start		/* kernel.ld */
+.extern kv_start		/* kernel.ld */
+
+/* VEXPRESS_SYS_BASE + VEXPRESS_SYS_FLAGSSET (vexpress_smp.h) */
+.equ VEXPRESS_SYS_FLAGS, 0x10000030
 
 .global _vexpress_boot
 _vexpress_boot:
+    /* only cpu 0 boots; r0 - r2 are passed on untouched */
+    mrc p15, 0, r4, c0, c0, 5
+    ands r4, r4, #0x3
+    bne vexpress_park
+    
     ldr sp, =k_stack
 	
     /* branch into C, init */
@@ -32,3 +44,54 @@ _vexpress_boot:
 hang:
     b hang
 
+/*
+ * secondary cpus entering the image wait here, as they would within the
+ * boot monitor, until the sys flags hold an entry (see mach_smp_boot_cpu).
+ */
+vexpress_park:
+    wfe
+    ldr r0, =VEXPRESS_SYS_FLAGS
+    ldr r1, [r0]
+    cmp r1, #0
+    beq vexpress_park
+    bx r1
+
+/*
+ * _vexpress_secondary
+ *
+ * physical entry of released secondary cpus (mmu & caches disabled).
+ * each waits for its stack to be published, has vexpress_secondary_init
+ * enable its mmu & caches, moves sp into the linear map & enters the
+ * kernel at the entry vexpress_secondary_init returns.
+ */
+.global _vexpress_secondary
+_vexpress_secondary:
+    cpsid if
+    mrc p15, 0, r4, c0, c0, 5
+    and r4, r4, #0x3
+    ldr r5, =vexpress_smp_boot
+    
+    /* vexpress_smp_boot.stack[cpu] */
+secondary_wait:
+    ldr r0, [r5, r4, lsl #2]
+    cmp r0, #0
+    bne secondary_start
+    wfe
+    b secondary_wait
+    
+secondary_start:
+    mov sp, r0
+    mov r0, r4
+    bl vexpress_secondary_init
+    
+    /* the stack is within ram, linearly mapped at kv_start */
+    ldr r1, =kv_start
+    ldr r2, =kp_start
+    sub r1, r1, r2
+    add sp, sp, r1
+    
+    mov r1, r0
+    mov r0, r4
+    blx r1
+    b hang
+
@@ -19,21 +19,59 @@
  * THE SOFTWARE.
  */
 #include <arch/arm/armv7/armv7_mmu.h>
+#include <arch/arm/armv7/armv7_pmu.h>
 #include <arch/arm/armv7/armv7_syscntl.h>
 #include <arch/arm/armv7/armv7.h>
+#include <arch/arm/cpu/cortex_a9.h>
+#include <mach/vexpress_a9/vexpress_smp.h>
 #include <memlayout.h>
 #include <mm/mem.h>
+#include <util/bits.h>
 #include <types.h>
+#include <errno.h>
 #include <stddef.h>
 
-#define KERN_PGD_ENTRY_CNT	2048
+#if (defined(CONFIG_CACHE_BENCH) || defined(CONFIG_MMU_BENCH)) && defined(CONFIG_EARLY_KPRINTF)
+#include <mach/mach.h>
+#endif
+
+/* the boot identity map spans the user (ttbr0) half, [0, CONFIG_VM_SPLIT) */
+#define BOOT_ID_ENTRY_CNT	(PGD_ENTRY_CNT >> ARMV7_MMU_PG_DIV)
 #define DIV_MULT_MB		20
 
+/* caches brought up by vexpress_boot_init */
+#ifdef CONFIG_CACHE_ENABLE
+#define VEXPRESS_CACHE_FLAGS	CORTEX_A9_CACHE_ALL
+#else
+#define VEXPRESS_CACHE_FLAGS	0
+#endif
+
+/* memcpy bandwidth self-check */
+#define BENCH_BUF_SZ		0x4000
+#define BENCH_ITER		16
+/* virt_to_phy self-check */
+#define MMU_BENCH_ITER		1024
+
 /* init_mmu functions */
 static void init_user_pg_dir(addr_t u_phy_pg_dir);
 static void init_kern_pg_dir(addr_t k_phy_pg_dir, addr_t k_phy_start, size_t k_sz);
-static void init_pg_dir_entry(addr_t *pg_dir, addr_t phy_addr, addr_t virt_addr);
+static void init_pg_dir_entry(addr_t *pg_dir, addr_t phy_addr, addr_t virt_addr, unsigned int attr);
 static void init_enable_mmu(void);
+static void init_map_linear(addr_t k_phy_pg_dir, addr_t atag_fdt_base);
+
+#if defined(CONFIG_CACHE_BENCH) && defined(CONFIG_EARLY_KPRINTF)
+static unsigned char bench_src[BENCH_BUF_SZ];
+static unsigned char bench_dst[BENCH_BUF_SZ];
+
+static void init_cache_bench(const char *stage);
+#endif
+
+#if defined(CONFIG_MMU_BENCH) && defined(CONFIG_EARLY_KPRINTF)
+static void init_mmu_bench(const char *desc, addr_t virt_addr);
+#endif
+
+/* read by secondary cpus; see mach_smp_boot_cpu */
+struct vexpress_smp_boot vexpress_smp_boot;
 
 /* TODO: tmp */
 extern void kernel_init(unsigned int, addr_t, void *, void *, int);
@@ -66,6 +104,25 @@ void vexpress_boot_init(unsigned int r0, int mach, addr_t atag_fdt_base) {
     init_user_pg_dir((addr_t)&k_pgd);
     init_kern_pg_dir((addr_t)&k_pgd, (addr_t)&lmi_start, k_sz);
     init_enable_mmu();
+    init_map_linear((addr_t)&k_pgd, atag_fdt_base);
+    
+    /* bring up the caches */
+    #if defined(CONFIG_CACHE_BENCH) && defined(CONFIG_EARLY_KPRINTF)
+	init_cache_bench("caches off");
+    #endif
+    
+    if (VEXPRESS_CACHE_FLAGS) {
+	cortex_a9_cache_init(VEXPRESS_CACHE_FLAGS);
+    }
+    
+    #if defined(CONFIG_CACHE_BENCH) && defined(CONFIG_EARLY_KPRINTF)
+	init_cache_bench("caches on");
+    #endif
+    
+    #if defined(CONFIG_MMU_BENCH) && defined(CONFIG_EARLY_KPRINTF)
+	init_mmu_bench("identity", (addr_t)&lmi_start);
+	init_mmu_bench("kernel", (addr_t)&k_start);
+    #endif
     
     /* branch to main initialization code */
     //vexpress_init(mach, atag_dt_base);
@@ -75,6 +132,45 @@ void vexpress_boot_init(unsigned int r0, int mach, addr_t atag_fdt_base) {
     //int reg_cnt) {
 }
 
+/**
+ * vexpress_secondary_init
+ * 
+ * C entry of secondary cpus from _vexpress_secondary; enables the mmu
+ * with the boot cpu's translation tables (see mach_smp_boot_cpu) and
+ * brings up the cpu's caches.
+ * the sp still holds a physical address, which remains mapped 1:1.
+ * 
+ * @cpu	id of the calling cpu
+ * @return kernel entry of the cpu
+ **/
+addr_t vexpress_secondary_init(unsigned int cpu) {
+    struct vexpress_smp_boot	*boot	= &vexpress_smp_boot;
+    unsigned int		reg	= 0;
+    
+    (void)cpu;
+    
+    armv7_set_ttbcr(boot->ttbcr);
+    armv7_set_dacr(boot->dacr);
+    armv7_set_ttbr0(boot->ttbr0);
+    armv7_set_ttbr1(boot->ttbr1);
+    
+    /* the tlb isn't defined out of reset */
+    armv7_invalidate_unified_tlb();
+    dsb();
+    isb();
+    
+    reg = armv7_get_sctlr();
+    reg |= ARMV7_SCTLR_AFE | ARMV7_SCTLR_MMU_ENB;
+    armv7_set_sctlr(reg);
+    isb();
+    
+    if (VEXPRESS_CACHE_FLAGS) {
+	cortex_a9_cache_init(VEXPRESS_CACHE_FLAGS);
+    }
+    
+    return boot->entry;
+}
+
 /**
  * init_enable_mmu
  * 
@@ -84,11 +180,12 @@ void vexpress_boot_init(unsigned int r0, int mach, addr_t atag_fdt_base) {
 static void init_enable_mmu(void) {
     unsigned int reg = 0;
     
-    /* set the mmu split */
-    armv7_set_ttbcr(ARMV7_TTBCR_2G_2G);
+    /* set the mmu split (see CONFIG_VM_SPLIT) */
+    armv7_set_ttbcr(ARMV7_MMU_PG_DIV);
 	
-    /* set domains */
-    armv7_set_domain(0, ARMV7_DACR_MNGR);
+    /* set domains; permissions are checked for both */
+    armv7_set_domain(USER_DOMAIN, ARMV7_DACR_CLIENT);
+    armv7_set_domain(KERN_DOMAIN, ARMV7_DACR_CLIENT);
 	
     /* set the control bits and enable mmu */
     reg = armv7_get_sctlr();
@@ -104,7 +201,7 @@ static void init_enable_mmu(void) {
  * init_user_pg_dir
  * 
  * initializes the user (TTB0) page dir as a 1:1 mapping of
- * all physical addresses from [0, 2GiB]
+ * all physical addresses below the split, [0, CONFIG_VM_SPLIT)
  * 
  * @u_pg_dir	physical address of the user page dir
  **/
@@ -112,16 +209,20 @@ static void init_user_pg_dir(addr_t u_phy_pg_dir) {
     addr_t *pg_dir = (addr_t *)u_phy_pg_dir;
 
 	
-    /* map all in 2GiB range */
-    for (int i = 0; i < KERN_PGD_ENTRY_CNT; i++) {
+    /* map all of the user half */
+    for (unsigned int i = 0; i < BOOT_ID_ENTRY_CNT; i++) {
 	addr_t pv_addr = (i << DIV_MULT_MB);
 		
-	/* map 1:1 */
-	init_pg_dir_entry(pg_dir, pv_addr, pv_addr);
+	/* map 1:1; memory from the kernel onwards is ram */
+	if (pv_addr >= (addr_t)&kp_start) {
+	    init_pg_dir_entry(pg_dir, pv_addr, pv_addr, ARMV7_MMU_PGD_SECT_NORMAL);
+	} else {
+	    init_pg_dir_entry(pg_dir, pv_addr, pv_addr, ARMV7_MMU_PGD_SECT_DEVICE);
+	}
     }
 	
     dsb();
-    armv7_set_ttbr0(u_phy_pg_dir);
+    armv7_set_ttbr0(u_phy_pg_dir | ARMV7_MMU_TTBR_FLAGS);
 }
 
 /**
@@ -142,11 +243,43 @@ static void init_kern_pg_dir(addr_t k_phy_pg_dir, addr_t k_phy_start, size_t k_s
 	addr_t p_addr = k_phy_start + (i << DIV_MULT_MB);
 		
 	/* map kernel sections in high mem */
-	init_pg_dir_entry(pg_dir, p_addr, phy_to_kvm(p_addr));
+	init_pg_dir_entry(pg_dir, p_addr, phy_to_kvm(p_addr), ARMV7_MMU_PGD_SECT_NORMAL);
     }
 	
     dsb();
-    armv7_set_ttbr1(k_phy_pg_dir);
+    armv7_set_ttbr1(k_phy_pg_dir | ARMV7_MMU_TTBR_FLAGS);
+}
+
+/**
+ * init_map_linear
+ * 
+ * extends the kernel (TTB1) page dir to map all ram linearly at
+ * kv_start using sections (see __va/__pa).
+ * this requires the mmu be enabled, as the fdt is parsed by high
+ * memory code.
+ * 
+ * @k_phy_pg_dir	physical address of the kernel page dir
+ * @atag_fdt_base	base address of fdt
+ **/
+static void init_map_linear(addr_t k_phy_pg_dir, addr_t atag_fdt_base) {
+    addr_t		*pg_dir		= (addr_t *)k_phy_pg_dir;
+    struct mm_reg	mem_reg		= {0, 0};
+    addr_t		p_addr		= 0x0;
+    
+    if (mlay_get_phy_mem_reg(atag_fdt_base, &mem_reg) == ESUCC) {
+	mlay_clip_linear_reg(&mem_reg);
+	
+	for (p_addr = (mem_reg.base & PGD_SECT_MASK); p_addr < (mem_reg.base + mem_reg.size); 
+	    p_addr += MLAY_SECT_SZ) {
+	    init_pg_dir_entry(pg_dir, p_addr, __va(p_addr), ARMV7_MMU_PGD_SECT_NORMAL);
+	}
+	
+	/* the kernel image sections were rewritten unchanged; nothing else was valid */
+	dsb();
+	armv7_invalidate_unified_tlb();
+	dsb();
+	isb();
+    }
 }
 
 /**
@@ -158,10 +291,87 @@ static void init_kern_pg_dir(addr_t k_phy_pg_dir, addr_t k_phy_start, size_t k_s
  * @pg_dir	pointer to page directory
  * @phy_addr	physical address being mapped to virtual address
  * @virt_addr	virtual address being mapped to physical address
+ * @attr	memory attributes of section
  **/
-static void init_pg_dir_entry(addr_t *pg_dir, addr_t phy_addr, addr_t virt_addr) {
-    unsigned int entry = (phy_addr & PGD_SECT_MASK) | (ARMV7_MMU_ACC_KRW_URW << 10) | ARMV7_MMU_PGD_SECTION;
+static void init_pg_dir_entry(addr_t *pg_dir, addr_t phy_addr, addr_t virt_addr, unsigned int attr) {
+    unsigned int entry = (phy_addr & PGD_SECT_MASK) | (ARMV7_MMU_ACC_KRW_NOU << PGD_SECT_AP_SHIFT) | attr | ARMV7_MMU_PGD_SECTION;
 
     pg_dir[(virt_addr >> DIV_MULT_MB)] = entry;
 }
 
+#if defined(CONFIG_CACHE_BENCH) && defined(CONFIG_EARLY_KPRINTF)
+/**
+ * init_cache_bench
+ * 
+ * boot-time self-check; measures memcpy bandwidth with the
+ * cycle counter and reports it.
+ * 
+ * @stage	description of the current cache state
+ **/
+static void init_cache_bench(const char *stage) {
+    unsigned int total	= BENCH_BUF_SZ * BENCH_ITER;
+    unsigned int start	= 0;
+    unsigned int cycles	= 0;
+    
+    armv7_pmu_cycle_enable();
+    start = armv7_pmu_get_cycles();
+    
+    for (int i = 0; i < BENCH_ITER; i++) {
+	memcpy(bench_dst, bench_src, BENCH_BUF_SZ);
+	dmb();
+    }
+    
+    cycles = armv7_pmu_get_cycles() - start;
+    
+    if (cycles > 0) {
+	mach_early_kprintf("memcpy bandwidth (%s): %i bytes in %i cycles, %i bytes/kcycle\n",
+	    stage, total, cycles, udiv32(total * 1000, cycles));
+    } else {
+	mach_early_kprintf("memcpy bandwidth (%s): cycle counter unavailable\n", stage);
+    }
+}
+#endif
+
+#if defined(CONFIG_MMU_BENCH) && defined(CONFIG_EARLY_KPRINTF)
+/**
+ * init_mmu_bench
+ * 
+ * boot-time self-check; compares the hardware (ATS1CPR) & software
+ * translation paths for an address, reporting cycles per translation.
+ * 
+ * @desc	description of the address
+ * @virt_addr	virtual address to translate
+ **/
+static void init_mmu_bench(const char *desc, addr_t virt_addr) {
+    unsigned int	start	= 0;
+    unsigned int	hw_cyc	= 0;
+    unsigned int	sw_cyc	= 0;
+    addr_t		hw_phy	= 0x0;
+    addr_t		sw_phy	= 0x0;
+    
+    armv7_pmu_cycle_enable();
+    
+    start = armv7_pmu_get_cycles();
+    
+    for (int i = 0; i < MMU_BENCH_ITER; i++) {
+	hw_phy = armv7_mmu_virt_to_phy(virt_addr);
+    }
+    
+    hw_cyc = armv7_pmu_get_cycles() - start;
+    start = armv7_pmu_get_cycles();
+    
+    for (int i = 0; i < MMU_BENCH_ITER; i++) {
+	sw_phy = armv7_mmu_virt_to_phy_sw(virt_addr);
+    }
+    
+    sw_cyc = armv7_pmu_get_cycles() - start;
+    
+    mach_early_kprintf("virt_to_phy (%s) 0x%x: hw 0x%x, %i cycles; sw 0x%x, %i cycles\n",
+	desc, virt_addr, hw_phy, udiv32(hw_cyc, MMU_BENCH_ITER),
+	sw_phy, udiv32(sw_cyc, MMU_BENCH_ITER));
+    
+    if (hw_phy != sw_phy) {
+	mach_early_kprintf("virt_to_phy (%s): translation mismatch\n", desc);
+    }
+}
+#endif
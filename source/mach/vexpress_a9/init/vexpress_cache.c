@@ -0,0 +1,40 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <mach/mach.h>
+#include <arch/arm/pl310.h>
+#include <types.h>
+
+#define VEXPRESS_PL310_AUX_VAL	(PL310_AUX_INST_PREFETCH | PL310_AUX_DATA_PREFETCH | \
+				PL310_AUX_EARLY_BRESP | PL310_AUX_SHARE_OVERRIDE)
+#define VEXPRESS_PL310_AUX_MASK	(~VEXPRESS_PL310_AUX_VAL)
+
+/**
+ * mach_init_outer_cache
+ * 
+ * brings up the ca9x4 tile's PL310 with prefetching & early BRESP
+ * enabled; associativity & way size are left as strapped.
+ * 
+ * @atag_fdt_base	base address of fdt
+ * @return errno
+ **/
+int mach_init_outer_cache(addr_t atag_fdt_base) {
+    return pl310_init(atag_fdt_base, VEXPRESS_PL310_AUX_VAL, VEXPRESS_PL310_AUX_MASK);
+}
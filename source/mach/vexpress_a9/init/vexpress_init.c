@@ -45,7 +45,6 @@
 #define PGD_ENTRY_SZ	4
 
 #define MB		0x100000
-#define MMU_PGTB_SIZE	0x200000
 #define MMU_KPGD_SIZE	0x4000
 
 #define MASK_MB 	0xFFFFF
@@ -53,32 +52,9 @@
 #define DIV_MULT_PGTB	10
 #define DIV_MULT_PG	12
 
-/**
- * init_mmu_entry
- * 
- * defines features of initial
- * mmu entries
- *
- * @perm	permissions
- * @domain	domain
- * @flags	flags
- **/
-struct init_mmu_entry {
-    armv7_mmu_acc_perm	perms;
-    unsigned char	domain;
-    unsigned int	flags;
-};
-
 /* used for kinit_warn/info/print */
 static char buf[512];
 
-/* used for initial mappings */
-static struct init_mmu_entry kdef_ent = {
-    .perms	= ARMV7_MMU_ACC_KRW_NOU,
-    .domain	= 0,
-    .flags	= 0
-};
-
 extern void install_ivt();
 /* helper functions */
 static void move_high_sp(void);
@@ -87,8 +63,6 @@ static int init_get_mem_atag(addr_t atag_fdt_base, struct mm_reg *mem_reg);
 static int init_get_mem_fdt(addr_t atag_fdt_base, struct mm_reg *mem_reg);
 static int init_get_initrd(addr_t atag_fdt_base, struct mm_reg *mem_reg);
 static int init_get_initrd_atag(addr_t atag_base, struct mm_reg *mem_reg);
-static int init_setup_kern_pgtb(struct mm_reg *kern_pgd, struct mm_reg *kern_pgtb, struct init_mmu_entry *ent);
-static int init_map_kern_pgtb(struct mm_reg *kern_pgtb, struct mm_reg *map_reg, struct init_mmu_entry *ent);
  
 /**
  * vexpress_init
@@ -98,14 +72,13 @@ static int init_map_kern_pgtb(struct mm_reg *kern_pgtb, struct mm_reg *map_reg,
  * 
  * this function:
  * performs sanity checks on the memory regions provided by either fdt or atag & kernel linker
- * moves the mmu mappings to page table mappings and maps the kernel & kernel init. regions
  * branches into the main kernel initialization
+ * 
+ * the kernel regions remain covered by the boot section mappings; page tables
+ * are allocated on demand by the mmu interface (see mmu_map_page) rather than
+ * preallocated here.
  **/
 void vexpress_init(unsigned int mach, addr_t atag_fdt_base) {
-    struct mm_reg	mmu_pgtb_reg	= {((kvm_to_phy((addr_t)&k_end) & ~MASK_MB) + MB), MMU_PGTB_SIZE};
-    struct mm_vreg	mmu_pgtb_vreg	= {mmu_pgtb_reg.base, (((addr_t)&k_end & ~MASK_MB) + MB), mmu_pgtb_reg.size};
-    struct mm_reg	mmu_pgd_reg	= {(addr_t)&k_pgd, MMU_KPGD_SIZE};
-    struct mm_reg	kstack_reg	= {(kvm_to_phy((addr_t)&k_stack)) - PG_SZ, PG_SZ};
     struct mm_reg	kinit_reg	= {kvm_to_phy((addr_t)&hmi_start), ((size_t)&hmi_end - (size_t)&hmi_start)};
     struct mm_reg	kern_reg	= {kvm_to_phy((addr_t)&k_start), ((size_t)&k_end - (size_t)&k_start)};
     struct mm_reg	initrd_reg	= {0, 0};
@@ -114,6 +87,9 @@ void vexpress_init(unsigned int mach, addr_t atag_fdt_base) {
     
     /* debug */
     #ifdef CONFIG_INIT_DEBUG
+	struct mm_reg	mmu_pgd_reg	= {(addr_t)&k_pgd, MMU_KPGD_SIZE};
+	struct mm_reg	kstack_reg	= {(kvm_to_phy((addr_t)&k_stack)) - PG_SZ, PG_SZ};
+	
 	mach_early_kprintf("========================= VEXPRESS_A9_QEMU "
 	    "=========================\n");
 	mach_early_kprintf("kernel init reg:\t0x%x\t0x%x\t%i bytes\n",
@@ -128,9 +104,6 @@ void vexpress_init(unsigned int mach, addr_t atag_fdt_base) {
 	mach_early_kprintf("mmu page dir reg:\t0x%x\t0x%x\t%i bytes\n",
 	    mmu_pgd_reg.base, mmu_pgd_reg.base + mmu_pgd_reg.size, 
 	    mmu_pgd_reg.size);
-	mach_early_kprintf("mmu page table reg:\t0x%x\t0x%x\t%i bytes\n", 
-	    mmu_pgtb_reg.base, mmu_pgtb_reg.base + mmu_pgtb_reg.size, 
-	    mmu_pgtb_reg.size);
 	    
 	if (is_using_fdt(atag_fdt_base)) {
 	    mach_early_kprintf("fdt base:\t\t0x%x\n", atag_fdt_base);
@@ -148,13 +121,11 @@ void vexpress_init(unsigned int mach, addr_t atag_fdt_base) {
     if ((err = init_get_mem(atag_fdt_base, &mem_reg)) != ESUCC) {
 	kinit_panic(buf, "init_get_mem() returned %i,"
 	    "no defined memory regions available.", err);
-    } else if (mem_reg.size <= 
-	(kern_reg.size + kinit_reg.size + mmu_pgtb_reg.size)) {
+    } else if (mem_reg.size <= (kern_reg.size + kinit_reg.size)) {
 	kinit_panic(buf, "not enough memory in region!  "
 	    "init_get_mem() returned %i bytes in largest found region, "
 	    "a minimum of %i bytes are required.", 
-	    mem_reg.size, kinit_reg.size + 
-	    kern_reg.size + mmu_pgtb_reg.size);
+	    mem_reg.size, kinit_reg.size + kern_reg.size);
     }
 	
     /* check if initrd exists */
@@ -172,48 +143,6 @@ void vexpress_init(unsigned int mach, addr_t atag_fdt_base) {
 	}
     }
     
-    /* clean (invalidate) pgtb region */
-    memset((void *)mmu_pgtb_reg.base, 0, mmu_pgtb_reg.size);
-    
-    /* map kernel init */
-    if ((err = init_map_kern_pgtb(&mmu_pgtb_reg, &kinit_reg, &kdef_ent)) != ESUCC) {
-	kinit_warn(buf, "init_map_kern_pgtb(kinit_reg) failed with %i.", err);
-    }
-    
-    /* map kernel */
-    if ((err = init_map_kern_pgtb(&mmu_pgtb_reg, &kern_reg, &kdef_ent)) != ESUCC) {
-	kinit_warn(buf, "init_map_kern_pgtb(kern_reg) failed with %i.", err);
-    }
-    
-    /* map kernel stack */
-    if ((err = init_map_kern_pgtb(&mmu_pgtb_reg, &kstack_reg, &kdef_ent)) != ESUCC) {
-	kinit_warn(buf, "init_map_kern_pgtb(kstack_reg) failed with %i.", err);
-    }
-    
-    /* map kernel pgtb */
-    if ((err = init_map_kern_pgtb(&mmu_pgtb_reg, &mmu_pgtb_reg, &kdef_ent)) != ESUCC) {
-	kinit_warn(buf, "init_map_kern_pgtb(mmu_pgtb_reg) failed with %i.", err);
-    }
-    
-    /* map kernel pgd */
-    if ((err = init_map_kern_pgtb(&mmu_pgtb_reg, &mmu_pgd_reg, &kdef_ent)) != ESUCC) {
-	kinit_warn(buf, "init_map_kern_pgtb(mmu_pgd_reg) failed with %i.", err);
-    }
-    
-    /* 
-     * ensure that all data is written prior to adding entries
-     * to active, operating mmu.
-     */
-    dsb();
-    
-    /* create pgd->pgtb mapping for kernel regions */
-    if ((err = init_setup_kern_pgtb(&mmu_pgd_reg, &mmu_pgtb_reg, &kdef_ent)) != ESUCC) {
-	kinit_panic(buf, "init_setup_kern_pgtb() failed with %i; nothing left to do.", err);
-    }
-    
-    /* invalidate tlb */
-    armv7_invalidate_unified_tlb();
-    
     /* set up domains:
      * kernel domain does permission checking (client),
      * user domain does not.
@@ -246,7 +175,7 @@ void vexpress_init(unsigned int mach, addr_t atag_fdt_base) {
     }
 
     /* branch into kernel init */
-    kernel_init(mach, atag_fdt_base, &mmu_pgtb_vreg, NULL, 0);
+    kernel_init(mach, atag_fdt_base, NULL, NULL, 0);
 }
 
 /**
@@ -401,116 +330,6 @@ static int init_get_initrd_atag(addr_t atag_base, struct mm_reg *mem_reg) {
     return ret;
 }
 
-/**
- * init_setup_kern_pgtb
- * 
- * creates the initial pgd->pgtb mapping for the whole kernel region.
- * this assumes that both kern_pgd & pgtb are continuous and 
- * kern_pgd->size >= 16KiB (which is required) & kern_pgtb->size >= (pgtb_cnt * PGTB_SIZE).
- * 
- * @kern_pgd	kernel page directory region
- * @kern_pgtb	kernel page table region
- * @ent		characteristics of entries
- * @pg_div_n	mmu division
- * @return errno
- **/
-static int init_setup_kern_pgtb(struct mm_reg *kern_pgd, struct mm_reg *kern_pgtb, struct init_mmu_entry *ent) {
-    addr_t		virt_addr	= 0;
-    unsigned int 	pgtb_cnt	= 0; /* also, pgd_cnt == pgtb_cnt */
-    unsigned int	i		= 0;
-    int			pg_div_n	= armv7_mmu_get_pg_div();
-    int			ret		= ESUCC;
-    
-    if (kern_pgd != NULL && kern_pgtb != NULL) {
-	if (pg_div_n > 0) {
-	    pgtb_cnt 	= PGD_ENTRY_CNT - (1 << (32 - (pg_div_n + DIV_MULT_MB)));
-	    virt_addr	= (1 << (32 - pg_div_n));
-	} else {
-	    pgtb_cnt 	= PGD_ENTRY_CNT;
-	    virt_addr	= 0x0;
-	}
-	
-	/* create pgtb_cnt number of entries */
-	while ((i < pgtb_cnt) && (ret == ESUCC)) {
-	    struct armv7_mmu_pgd_entry pgd_ent = {
-		.phy_addr	= kern_pgtb->base | (i << DIV_MULT_PGTB),
-		.virt_addr	= virt_addr | (i << DIV_MULT_MB),
-		.domain		= ent->domain,
-		.type		= ARMV7_MMU_PGD_TABLE,
-		.flags		= ent->flags		/* TODO */
-	    };
-	    
-	    ret = armv7_mmu_map_pgd(&pgd_ent);
-	    i++;
-	}
-    } else {
-	ret = EINVAL;
-    }
-    
-    return ret;
-}
-
-/**
- * init_map_kern_pgtb
- * 
- * maps kernel regions into specified kernel page table region.
- * this should be called prior to init_setup_kern_pgtb
- * 
- * @kern_pgtb	continuous physical region used for kernel page tables
- * @map_reg	region to map
- * @ent		characteristics of region
- * @pg_div_n	mmu division
- * @return errno
- **/
-static int init_map_kern_pgtb(struct mm_reg *kern_pgtb, struct mm_reg *map_reg, struct init_mmu_entry *ent) {
-    addr_t		pg_tb		= 0x0;
-    addr_t		phy_addr	= 0x0;
-    addr_t		virt_addr	= 0x0;
-    addr_t		v_start		= 0x0;
-    unsigned int	pg_cnt		= 0;
-    unsigned int	i		= 0;
-    int			pg_div_n	= armv7_mmu_get_pg_div();
-    int 		ret 		= ESUCC;
-    
-    if (kern_pgtb != NULL && map_reg != NULL && ent != NULL) {
-	pg_tb 		= kern_pgtb->base;
-	virt_addr	= phy_to_kvm(map_reg->base);
-	phy_addr	= map_reg->base;
-	
-	/* determines index */
-	if (pg_div_n > 0) {
-	    v_start	= (1 << (32 - (pg_div_n)));
-	}
-	
-	/* get pg_cnt */
-	if (!is_power_of_two(map_reg->size)) {
-	    pg_cnt = clr_lv_msb(map_reg->size) >> (DIV_MULT_PG - 1);
-	} else {
-	    pg_cnt = clr_lv_msb(map_reg->size) >> DIV_MULT_PG;
-	}
-	
-	while ((i < pg_cnt) && (ret == ESUCC)) {
-	    int index = ((virt_addr - v_start) + (i << DIV_MULT_PG)) >> DIV_MULT_MB;
-	    
-	    /* entry */
-	    struct armv7_mmu_pgtb_entry pgtb_ent = {
-		.phy_addr	= phy_addr | (i << DIV_MULT_PG),
-		.virt_addr	= virt_addr | (i << DIV_MULT_PG),
-		.acc_perm	= ent->perms,
-		.type		= ARMV7_MMU_PGTB_SMALL_PG,
-		.flags		= ent->flags			/* TODO */
-	    };
-	    
-	    ret = armv7_mmu_map_new_pgtb((pg_tb | (index << DIV_MULT_PGTB)), &pgtb_ent);
-	    i++;
-	}
-    } else {
-	ret = EINVAL;
-    }
-    
-    return ret;
-}
-
 /**
  * move_high_sp
  * 
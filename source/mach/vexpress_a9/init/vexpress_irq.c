@@ -0,0 +1,44 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <mach/mach.h>
+#include <arch/arm/gic.h>
+#include <types.h>
+
+/**
+ * mach_init_irq_cntl
+ * 
+ * brings up the ca9x4 tile's GIC (distributor & boot cpu interface).
+ * 
+ * @atag_fdt_base	base address of fdt
+ * @return errno
+ **/
+int mach_init_irq_cntl(addr_t atag_fdt_base) {
+    return gic_init(atag_fdt_base);
+}
+
+/**
+ * mach_init_irq_cntl_cpu
+ * 
+ * enables the calling cpu's GIC interface.
+ **/
+void mach_init_irq_cntl_cpu(void) {
+    gic_cpu_init();
+}
@@ -0,0 +1,119 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * vexpress_smp.c releases the secondary cpus of the ca9x4 tile.
+ */
+#include <mach/mach.h>
+#include <mach/vexpress_a9/vexpress_smp.h>
+#include <arch/arm/armv7/armv7.h>
+#include <arch/arm/armv7/armv7_mmu.h>
+#include <arch/arm/armv7/armv7_syscntl.h>
+#include <arch/arm/cpu/cortex_a9.h>
+#include <arch/arch_smp.h>
+#include <mm/cache.h>
+#include <mm/mem.h>
+#include <mm/vmalloc.h>
+#include <memlayout.h>
+#include <types.h>
+#include <errno.h>
+
+#ifdef CONFIG_SMP
+
+/* svc stacks of the secondary cpus (the boot cpu's is k_stack) */
+static unsigned char vexpress_smp_stacks[NR_CPUS][VEXPRESS_SMP_STACK_SZ] __attribute__((aligned(8)));
+
+/* sys registers, mapped by the first mach_smp_boot_cpu */
+static addr_t vexpress_sys_base = 0x0;
+
+/**
+ * mach_smp_get_cpu_cnt
+ * 
+ * returns the number of cpus present, as reported by the scu
+ * (limited to NR_CPUS).
+ * 
+ * @return cpu count
+ **/
+unsigned int mach_smp_get_cpu_cnt(void) {
+    unsigned int cnt = cortex_a9_get_cpu_cnt();
+    
+    if (cnt > NR_CPUS) {
+	cnt = NR_CPUS;
+    }
+    
+    return cnt;
+}
+
+/**
+ * mach_smp_boot_cpu
+ * 
+ * releases a secondary cpu.
+ * the boot state is written back to memory, as the cpu reads it with
+ * it's caches disabled, and the cpu's stack is published last; the
+ * cpu then leaves the boot monitor (or vexpress_park) through the sys
+ * flags, woken by both an event and an sgi (qemu waits within wfi).
+ * the boot state (within .lm_init) is reached through the linear map &
+ * the sys registers through ioremap, as the caller's ttbr0 may hold a
+ * user page directory rather than the boot identity map; the cpu is
+ * always handed the latter to enable its mmu from.
+ * 
+ * @cpu		cpu id
+ * @entry	kernel entry of the cpu, passed its id
+ * @return errno
+ **/
+int mach_smp_boot_cpu(unsigned int cpu, void (*entry)(unsigned int)) {
+    struct vexpress_smp_boot	*boot	= (struct vexpress_smp_boot *)__va(&vexpress_smp_boot);
+    addr_t			top	= 0x0;
+    int				ret	= ESUCC;
+    
+    if (vexpress_sys_base == 0x0) {
+	vexpress_sys_base = (addr_t)ioremap(VEXPRESS_SYS_BASE, PG_SZ);
+    }
+    
+    if (cpu >= mach_smp_get_cpu_cnt() || cpu == arch_smp_get_cpu_id() || entry == NULL) {
+	ret = EINVAL;
+    } else if (vexpress_sys_base == 0x0) {
+	ret = ENOMEM;
+    } else {
+	top = (addr_t)&vexpress_smp_stacks[cpu][VEXPRESS_SMP_STACK_SZ];
+	
+	boot->entry	= (addr_t)entry;
+	boot->ttbcr	= armv7_get_ttbcr();
+	boot->ttbr0	= mlay_get_boot_pgd() | ARMV7_MMU_TTBR_FLAGS;
+	boot->ttbr1	= armv7_get_ttbr1();
+	boot->dacr	= armv7_get_dacr();
+	
+	/* written uncached until the cpu's caches are up */
+	dcache_clean_inval_range((addr_t)vexpress_smp_stacks[cpu], VEXPRESS_SMP_STACK_SZ);
+	dcache_clean_range(__va(mlay_get_kern_pgd()), PGD_ENTRY_CNT * PGD_ENTRY_SZ);
+	
+	boot->stack[cpu] = __pa(top);
+	dcache_clean_range((addr_t)boot, sizeof(struct vexpress_smp_boot));
+	
+	memw(vexpress_sys_base + VEXPRESS_SYS_FLAGSCLR, 0xFFFFFFFF);
+	memw(vexpress_sys_base + VEXPRESS_SYS_FLAGSSET, (addr_t)_vexpress_secondary);
+	
+	dsb();
+	sev();
+	arch_smp_send_ipi((1 << cpu), IPI_WAKEUP);
+    }
+    
+    return ret;
+}
+#endif
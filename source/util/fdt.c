@@ -110,6 +110,71 @@ struct fdt_node *fdt_get_node(const char *name, addr_t fdt_base) {
     return ret;
 }
 
+/**
+ * fdt_get_compatible_node
+ * 
+ * searches for and returns (if found) the first node with a
+ * "compatible" property listing specified compatible string.
+ * @compat	compatible string to search for, i.e., "arm,pl310-cache"
+ * @fdt_base	base address of flattened device tree
+ * @return node if found, null otherwise
+ **/
+struct fdt_node *fdt_get_compatible_node(const char *compat, addr_t fdt_base) {
+    struct fdt_node *ret 	= NULL;
+    struct fdt_node *iter	= NULL;
+    
+    if (compat != NULL && is_using_fdt(fdt_base)) {
+	iter = fdt_get_root_node(fdt_base);
+	
+	while (iter != NULL) {
+	    if (fdt_is_compatible(fdt_base, iter, compat)) {
+		ret = iter;
+		break;
+	    }
+	    
+	    iter = fdt_get_next_node(iter);
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * fdt_is_compatible
+ * 
+ * determines if a node's "compatible" property lists specified
+ * compatible string.
+ * @fdt_base	base address of flattened device tree
+ * @node	node to check
+ * @compat	compatible string
+ * @return true if compatible
+ **/
+bool fdt_is_compatible(addr_t fdt_base, struct fdt_node *node, const char *compat) {
+    struct fdt_property	*prop	= NULL;
+    const char		*str	= NULL;
+    size_t		len	= 0;
+    size_t		off	= 0;
+    bool		ret	= false;
+    
+    if (compat != NULL && (prop = fdt_get_property(fdt_base, node, "compatible")) != NULL) {
+	len = be32_to_cpu(prop->length);
+	
+	/* property is a list of null terminated strings */
+	while (off < len) {
+	    str = &prop->data[off];
+	    
+	    if (strlen(str) == strlen(compat) && strcmp(compat, str) == 0) {
+		ret = true;
+		break;
+	    }
+	    
+	    off += strlen(str) + 1;
+	}
+    }
+    
+    return ret;
+}
+
 /**
  * fdt_get_property
  * 
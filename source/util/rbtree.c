@@ -0,0 +1,419 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <util/rbtree.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+static void rb_update(struct rb_root *root, struct rb_node *node);
+static void rb_replace_child(struct rb_root *root, struct rb_node *old, struct rb_node *new, struct rb_node *parent);
+static void rb_rotate_left(struct rb_root *root, struct rb_node *node);
+static void rb_rotate_right(struct rb_root *root, struct rb_node *node);
+static void rb_erase_color(struct rb_root *root, struct rb_node *node, struct rb_node *parent);
+static bool rb_is_black(struct rb_node *node);
+
+/**
+ * rb_insert_color
+ * 
+ * rebalances the tree after node has been linked (see rb_link_node)
+ * 
+ * @root	tree
+ * @node	newly linked node
+ **/
+void rb_insert_color(struct rb_root *root, struct rb_node *node) {
+    struct rb_node *parent	= NULL;
+    struct rb_node *gparent	= NULL;
+    struct rb_node *uncle	= NULL;
+    
+    /* every ancestor now covers node */
+    rb_propagate(root, node);
+    
+    while ((parent = node->parent) != NULL && parent->color == RB_RED) {
+	/* a red parent is never the root */
+	gparent = parent->parent;
+	
+	if (parent == gparent->left) {
+	    uncle = gparent->right;
+	    
+	    if (uncle != NULL && uncle->color == RB_RED) {
+		parent->color	= RB_BLACK;
+		uncle->color	= RB_BLACK;
+		gparent->color	= RB_RED;
+		node		= gparent;
+	    } else {
+		if (node == parent->right) {
+		    rb_rotate_left(root, parent);
+		    node	= parent;
+		    parent	= node->parent;
+		}
+		
+		parent->color	= RB_BLACK;
+		gparent->color	= RB_RED;
+		rb_rotate_right(root, gparent);
+	    }
+	} else {
+	    uncle = gparent->left;
+	    
+	    if (uncle != NULL && uncle->color == RB_RED) {
+		parent->color	= RB_BLACK;
+		uncle->color	= RB_BLACK;
+		gparent->color	= RB_RED;
+		node		= gparent;
+	    } else {
+		if (node == parent->left) {
+		    rb_rotate_right(root, parent);
+		    node	= parent;
+		    parent	= node->parent;
+		}
+		
+		parent->color	= RB_BLACK;
+		gparent->color	= RB_RED;
+		rb_rotate_left(root, gparent);
+	    }
+	}
+    }
+    
+    root->node->color = RB_BLACK;
+}
+
+/**
+ * rb_erase
+ * 
+ * removes node from the tree & rebalances it
+ * 
+ * @root	tree
+ * @node	node to remove
+ **/
+void rb_erase(struct rb_root *root, struct rb_node *node) {
+    struct rb_node	*child	= NULL;
+    struct rb_node	*parent	= NULL;
+    struct rb_node	*succ	= NULL;
+    int			color	= node->color;
+    
+    if (node->left == NULL || node->right == NULL) {
+	child	= (node->left != NULL) ? node->left : node->right;
+	parent	= node->parent;
+	
+	rb_replace_child(root, node, child, parent);
+	
+	if (child != NULL) {
+	    child->parent = parent;
+	}
+    } else {
+	/* replace node with its successor */
+	for (succ = node->right; succ->left != NULL; succ = succ->left);
+	
+	color	= succ->color;
+	child	= succ->right;
+	
+	if (succ->parent == node) {
+	    parent = succ;
+	} else {
+	    parent		= succ->parent;
+	    parent->left	= child;
+	    
+	    if (child != NULL) {
+		child->parent = parent;
+	    }
+	    
+	    succ->right		= node->right;
+	    succ->right->parent	= succ;
+	}
+	
+	rb_replace_child(root, node, succ, node->parent);
+	succ->parent		= node->parent;
+	succ->left		= node->left;
+	succ->left->parent	= succ;
+	succ->color		= node->color;
+    }
+    
+    /* succ (if used) is an ancestor of parent */
+    rb_propagate(root, parent);
+    
+    if (color == RB_BLACK) {
+	rb_erase_color(root, child, parent);
+    }
+}
+
+/**
+ * rb_propagate
+ * 
+ * re-runs the augmentation callback from node up to the root;
+ * required after changing the values of a node the callback depends upon.
+ * 
+ * @root	tree
+ * @node	first node to update (may be NULL)
+ **/
+void rb_propagate(struct rb_root *root, struct rb_node *node) {
+    if (root->update != NULL) {
+	for (; node != NULL; node = node->parent) {
+	    root->update(node);
+	}
+    }
+}
+
+/**
+ * rb_first
+ * 
+ * @root	tree
+ * @return leftmost node or NULL if empty
+ **/
+struct rb_node *rb_first(struct rb_root *root) {
+    struct rb_node *ret = root->node;
+    
+    while (ret != NULL && ret->left != NULL) {
+	ret = ret->left;
+    }
+    
+    return ret;
+}
+
+/**
+ * rb_last
+ * 
+ * @root	tree
+ * @return rightmost node or NULL if empty
+ **/
+struct rb_node *rb_last(struct rb_root *root) {
+    struct rb_node *ret = root->node;
+    
+    while (ret != NULL && ret->right != NULL) {
+	ret = ret->right;
+    }
+    
+    return ret;
+}
+
+/**
+ * rb_next
+ * 
+ * @node	node
+ * @return in order successor of node or NULL if last
+ **/
+struct rb_node *rb_next(struct rb_node *node) {
+    struct rb_node *ret = NULL;
+    
+    if (node->right != NULL) {
+	for (ret = node->right; ret->left != NULL; ret = ret->left);
+    } else {
+	while ((ret = node->parent) != NULL && node == ret->right) {
+	    node = ret;
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * rb_prev
+ * 
+ * @node	node
+ * @return in order predecessor of node or NULL if first
+ **/
+struct rb_node *rb_prev(struct rb_node *node) {
+    struct rb_node *ret = NULL;
+    
+    if (node->left != NULL) {
+	for (ret = node->left; ret->right != NULL; ret = ret->right);
+    } else {
+	while ((ret = node->parent) != NULL && node == ret->left) {
+	    node = ret;
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * rb_update
+ * 
+ * invokes the augmentation callback of root on node
+ * 
+ * @root	tree
+ * @node	node
+ **/
+static void rb_update(struct rb_root *root, struct rb_node *node) {
+    if (root->update != NULL) {
+	root->update(node);
+    }
+}
+
+/**
+ * rb_replace_child
+ * 
+ * points the child link of parent (or the root) at new instead of old
+ * 
+ * @root	tree
+ * @old	current child
+ * @new	replacement child (may be NULL)
+ * @parent	parent of old or NULL if old is the root
+ **/
+static void rb_replace_child(struct rb_root *root, struct rb_node *old, struct rb_node *new, struct rb_node *parent) {
+    if (parent == NULL) {
+	root->node = new;
+    } else if (parent->left == old) {
+	parent->left = new;
+    } else {
+	parent->right = new;
+    }
+}
+
+/**
+ * rb_rotate_left
+ * 
+ * rotates node down to the left; its right child takes its place.
+ * the set of nodes beneath the position is unchanged, so only the
+ * two rotated nodes require updating.
+ * 
+ * @root	tree
+ * @node	node to rotate
+ **/
+static void rb_rotate_left(struct rb_root *root, struct rb_node *node) {
+    struct rb_node *right = node->right;
+    
+    node->right = right->left;
+    
+    if (right->left != NULL) {
+	right->left->parent = node;
+    }
+    
+    right->parent = node->parent;
+    rb_replace_child(root, node, right, node->parent);
+    
+    right->left		= node;
+    node->parent	= right;
+    
+    rb_update(root, node);
+    rb_update(root, right);
+}
+
+/**
+ * rb_rotate_right
+ * 
+ * rotates node down to the right; its left child takes its place.
+ * 
+ * @root	tree
+ * @node	node to rotate
+ **/
+static void rb_rotate_right(struct rb_root *root, struct rb_node *node) {
+    struct rb_node *left = node->left;
+    
+    node->left = left->right;
+    
+    if (left->right != NULL) {
+	left->right->parent = node;
+    }
+    
+    left->parent = node->parent;
+    rb_replace_child(root, node, left, node->parent);
+    
+    left->right		= node;
+    node->parent	= left;
+    
+    rb_update(root, node);
+    rb_update(root, left);
+}
+
+/**
+ * rb_erase_color
+ * 
+ * restores the black height after a black node has been removed
+ * 
+ * @root	tree
+ * @node	node that took the place of the removed node (may be NULL)
+ * @parent	parent of node
+ **/
+static void rb_erase_color(struct rb_root *root, struct rb_node *node, struct rb_node *parent) {
+    struct rb_node *sibling = NULL;
+    
+    while (node != root->node && rb_is_black(node)) {
+	if (node == parent->left) {
+	    sibling = parent->right;
+	    
+	    if (sibling->color == RB_RED) {
+		sibling->color	= RB_BLACK;
+		parent->color	= RB_RED;
+		rb_rotate_left(root, parent);
+		sibling		= parent->right;
+	    }
+	    
+	    if (rb_is_black(sibling->left) && rb_is_black(sibling->right)) {
+		sibling->color	= RB_RED;
+		node		= parent;
+		parent		= node->parent;
+	    } else {
+		if (rb_is_black(sibling->right)) {
+		    sibling->left->color	= RB_BLACK;
+		    sibling->color		= RB_RED;
+		    rb_rotate_right(root, sibling);
+		    sibling			= parent->right;
+		}
+		
+		sibling->color		= parent->color;
+		parent->color		= RB_BLACK;
+		sibling->right->color	= RB_BLACK;
+		rb_rotate_left(root, parent);
+		node			= root->node;
+	    }
+	} else {
+	    sibling = parent->left;
+	    
+	    if (sibling->color == RB_RED) {
+		sibling->color	= RB_BLACK;
+		parent->color	= RB_RED;
+		rb_rotate_right(root, parent);
+		sibling		= parent->left;
+	    }
+	    
+	    if (rb_is_black(sibling->left) && rb_is_black(sibling->right)) {
+		sibling->color	= RB_RED;
+		node		= parent;
+		parent		= node->parent;
+	    } else {
+		if (rb_is_black(sibling->left)) {
+		    sibling->right->color	= RB_BLACK;
+		    sibling->color		= RB_RED;
+		    rb_rotate_left(root, sibling);
+		    sibling			= parent->left;
+		}
+		
+		sibling->color		= parent->color;
+		parent->color		= RB_BLACK;
+		sibling->left->color	= RB_BLACK;
+		rb_rotate_right(root, parent);
+		node			= root->node;
+	    }
+	}
+    }
+    
+    if (node != NULL) {
+	node->color = RB_BLACK;
+    }
+}
+
+/**
+ * rb_is_black
+ * 
+ * @node	node (NULL leaves are black)
+ * @return true if black
+ **/
+static bool rb_is_black(struct rb_node *node) {
+    return (node == NULL || node->color == RB_BLACK);
+}
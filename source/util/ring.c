@@ -0,0 +1,261 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * ring.c provides the lock-free spsc & mpmc rings (see ring.h).
+ */
+#include <util/ring.h>
+#include <sync/atomic.h>
+#include <sync/barriers.h>
+#include <errno.h>
+#include <types.h>
+
+static bool ring_is_pow2(size_t size);
+
+/**
+ * ring_is_pow2
+ * 
+ * @size	size of a ring
+ * @return true if size is a (non zero) power of 2
+ **/
+static bool ring_is_pow2(size_t size) {
+    return (size != 0 && (size & (size - 1)) == 0);
+}
+
+/**
+ * ring_spsc_init
+ * 
+ * initializes an empty ring
+ * 
+ * @ring	ring
+ * @slots	storage of size pointers
+ * @size	count of slots (power of 2)
+ * @return ESUCC on success, EINVAL if size isn't a power of 2
+ **/
+int ring_spsc_init(struct ring_spsc *ring, void **slots, size_t size) {
+    int ret = EINVAL;
+    
+    if (ring != NULL && slots != NULL && ring_is_pow2(size)) {
+	ring->mask		= (addr_t)(size - 1);
+	ring->slots		= slots;
+	ring->head		= 0;
+	ring->tail_cache	= 0;
+	ring->tail		= 0;
+	ring->head_cache	= 0;
+	ret			= ESUCC;
+    }
+    
+    return ret;
+}
+
+/**
+ * ring_spsc_enqueue_batch
+ * 
+ * enqueues as many of objs as there are free slots for;
+ * only the producer may call it.
+ * 
+ * @ring	ring
+ * @objs	pointers to enqueue
+ * @cnt		count of objs
+ * @return count enqueued (0 if the ring was full)
+ **/
+size_t ring_spsc_enqueue_batch(struct ring_spsc *ring, void * const *objs, size_t cnt) {
+    addr_t	head	= ring->head;
+    addr_t	size	= ring->mask + 1;
+    size_t	ret	= 0;
+    
+    if ((size - (head - ring->tail_cache)) < cnt) {
+	ring->tail_cache = ring->tail;
+	
+	/* the consumer is done reading the slots it handed back */
+	arch_dmb_ish();
+    }
+    
+    ret = (size_t)(size - (head - ring->tail_cache));
+    ret = (ret < cnt) ? ret : cnt;
+    
+    if (ret > 0) {
+	for (size_t i = 0; i < ret; i++) {
+	    ring->slots[(head + i) & ring->mask] = objs[i];
+	}
+	
+	/* slots are written before they're published */
+	arch_dmb_ishst();
+	ring->head = head + ret;
+    }
+    
+    return ret;
+}
+
+/**
+ * ring_spsc_dequeue_batch
+ * 
+ * dequeues up to cnt pointers into objs;
+ * only the consumer may call it.
+ * 
+ * @ring	ring
+ * @objs	receives the pointers dequeued
+ * @cnt		size of objs
+ * @return count dequeued (0 if the ring was empty)
+ **/
+size_t ring_spsc_dequeue_batch(struct ring_spsc *ring, void **objs, size_t cnt) {
+    addr_t	tail	= ring->tail;
+    size_t	ret	= 0;
+    
+    if ((ring->head_cache - tail) < cnt) {
+	ring->head_cache = ring->head;
+	
+	/* the slots are read after head shows them written */
+	arch_dmb_ish();
+    }
+    
+    ret = (size_t)(ring->head_cache - tail);
+    ret = (ret < cnt) ? ret : cnt;
+    
+    if (ret > 0) {
+	for (size_t i = 0; i < ret; i++) {
+	    objs[i] = ring->slots[(tail + i) & ring->mask];
+	}
+	
+	/* reads of the slots complete before they're handed back */
+	arch_dmb_ish();
+	ring->tail = tail + ret;
+    }
+    
+    return ret;
+}
+
+/**
+ * ring_mpmc_init
+ * 
+ * initializes an empty ring
+ * 
+ * @ring	ring
+ * @slots	storage of size pointers
+ * @size	count of slots (power of 2)
+ * @return ESUCC on success, EINVAL if size isn't a power of 2
+ **/
+int ring_mpmc_init(struct ring_mpmc *ring, void **slots, size_t size) {
+    int ret = EINVAL;
+    
+    if (ring != NULL && slots != NULL && ring_is_pow2(size)) {
+	ring->mask		= (addr_t)(size - 1);
+	ring->slots		= slots;
+	ring->prod.head		= 0;
+	ring->prod.tail		= 0;
+	ring->cons.head		= 0;
+	ring->cons.tail		= 0;
+	ret			= ESUCC;
+    }
+    
+    return ret;
+}
+
+/**
+ * ring_mpmc_enqueue_batch
+ * 
+ * enqueues as many of objs as there are free slots for; the batch
+ * is kept contiguous, in order, within the ring.
+ * a producer publishes only once those that reserved before it
+ * have, so one stalled between reserving & publishing holds up the
+ * others (but never the consumers of already published slots).
+ * 
+ * @ring	ring
+ * @objs	pointers to enqueue
+ * @cnt		count of objs
+ * @return count enqueued (0 if the ring was full)
+ **/
+size_t ring_mpmc_enqueue_batch(struct ring_mpmc *ring, void * const *objs, size_t cnt) {
+    addr_t	head	= 0;
+    addr_t	size	= ring->mask + 1;
+    size_t	ret	= 0;
+    
+    do {
+	head = ring->prod.head;
+	
+	/* cons.tail mustn't be older than head; free would underflow */
+	arch_dmb_ish();
+	ret = (size_t)(size - (head - ring->cons.tail));
+	ret = (ret < cnt) ? ret : cnt;
+	
+	/* fully ordered; consumers are done with the slots reserved */
+    } while (ret > 0 && arch_cmpxchg(&ring->prod.head, head, head + ret) != head);
+    
+    if (ret > 0) {
+	for (size_t i = 0; i < ret; i++) {
+	    ring->slots[(head + i) & ring->mask] = objs[i];
+	}
+	
+	while (ring->prod.tail != head) {
+	    /* earlier reservations are still being written */
+	    arch_cpu_relax();
+	}
+	
+	/* slots are written before they're published */
+	arch_dmb_ish();
+	ring->prod.tail = head + ret;
+    }
+    
+    return ret;
+}
+
+/**
+ * ring_mpmc_dequeue_batch
+ * 
+ * dequeues up to cnt pointers into objs, in order.
+ * as with enqueueing, a consumer hands back its slots only once
+ * those that reserved before it have.
+ * 
+ * @ring	ring
+ * @objs	receives the pointers dequeued
+ * @cnt		size of objs
+ * @return count dequeued (0 if the ring was empty)
+ **/
+size_t ring_mpmc_dequeue_batch(struct ring_mpmc *ring, void **objs, size_t cnt) {
+    addr_t	head	= 0;
+    size_t	ret	= 0;
+    
+    do {
+	head = ring->cons.head;
+	
+	/* prod.tail mustn't be older than head; avail would underflow */
+	arch_dmb_ish();
+	ret = (size_t)(ring->prod.tail - head);
+	ret = (ret < cnt) ? ret : cnt;
+	
+	/* fully ordered; the slots are read after prod.tail published them */
+    } while (ret > 0 && arch_cmpxchg(&ring->cons.head, head, head + ret) != head);
+    
+    if (ret > 0) {
+	for (size_t i = 0; i < ret; i++) {
+	    objs[i] = ring->slots[(head + i) & ring->mask];
+	}
+	
+	while (ring->cons.tail != head) {
+	    /* earlier reservations are still being read */
+	    arch_cpu_relax();
+	}
+	
+	/* reads of the slots complete before they're handed back */
+	arch_dmb_ish();
+	ring->cons.tail = head + ret;
+    }
+    
+    return ret;
+}
@@ -0,0 +1,197 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * armv7_mmu_bench.c measures the throughput (entries per second) of the
+ * armv7 descriptor code on the host; populating the kernel half through
+ * the explicit & active interfaces, walking it & unmapping it.
+ * 
+ * usage: armv7_mmu_bench [rounds]
+ */
+#include "host.h"
+#include <arch/arm/armv7/armv7_syscntl.h>
+#include <arch/arm/armv7/armv7_mmu.h>
+#include <arch/arch_mmu.h>
+#include <mm/mmu.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* sections of the kernel half exercised per round */
+#define BENCH_SECT_CNT		512
+#define BENCH_ENTRY_CNT		(BENCH_SECT_CNT * 256)
+
+static addr_t		kern_pgd;
+static addr_t		kern_pgtbs;
+static volatile addr_t	sink;
+
+/**
+ * bench_report
+ * 
+ * prints the throughput of a benchmark
+ * 
+ * @name	benchmark
+ * @entries	entries processed
+ * @ns		elapsed time
+ **/
+static void bench_report(const char *name, unsigned long entries, uint64_t ns) {
+    printf("%-24s %10lu entries %10.3f ms %14.0f entries/s\n", name, entries,
+	   ns / 1e6, ns ? (entries * 1e9) / ns : 0.0);
+}
+
+/**
+ * bench_pgds
+ * 
+ * creates (or releases) the pgd entries of the benchmarked sections
+ * 
+ * @type	PG_DIR or PG_DIR_INVAL
+ **/
+static void bench_pgds(mmu_entry_type_t type) {
+    struct mmu_entry entry;
+    
+    for (unsigned int i = 0; i < BENCH_SECT_CNT; i++) {
+	entry.phy_addr	= (type == PG_DIR) ? kern_pgtbs + (i * PGTB_SZ) : 0x0;
+	entry.virt_addr	= arch_mmu_get_kern_vaddr() + ((addr_t)i << PGD_IDX_SHIFT);
+	entry.type	= type;
+	entry.acc_flags	= KERNEL;
+	
+	if (arch_mmu_create_new_entry(kern_pgd, &entry) != ESUCC) {
+	    fprintf(stderr, "armv7_mmu_bench: pgd entry %u\n", i);
+	    exit(1);
+	}
+    }
+}
+
+/**
+ * bench_map
+ * 
+ * maps (or unmaps) every page of the benchmarked sections
+ * 
+ * @active	true to use the active interface (arch_mmu_create_entry)
+ * @type	PG_TAB or PG_TAB_INVAL
+ * @return elapsed time
+ **/
+static uint64_t bench_map(bool active, mmu_entry_type_t type) {
+    struct mmu_entry	entry;
+    addr_t		kvaddr	= arch_mmu_get_kern_vaddr();
+    uint64_t		start	= host_now_ns();
+    int			ret	= ESUCC;
+    
+    entry.type		= type;
+    entry.acc_flags	= KERNEL;
+    
+    for (unsigned int i = 0; i < BENCH_ENTRY_CNT && ret == ESUCC; i++) {
+	entry.phy_addr	= (type == PG_TAB) ? ((addr_t)(i + 1) << PGTB_IDX_SHIFT) : 0x0;
+	entry.virt_addr	= kvaddr + ((addr_t)i << PGTB_IDX_SHIFT);
+	
+	if (active) {
+	    ret = arch_mmu_create_entry(&entry);
+	} else {
+	    ret = arch_mmu_create_new_entry(kern_pgtbs, &entry);
+	}
+    }
+    
+    if (ret != ESUCC) {
+	fprintf(stderr, "armv7_mmu_bench: map failed (%i)\n", ret);
+	exit(1);
+    }
+    
+    return host_now_ns() - start;
+}
+
+/**
+ * bench_walk
+ * 
+ * translates every page of the benchmarked sections
+ * 
+ * @sw		true to walk through armv7_mmu_walk, otherwise armv7_mmu_virt_to_phy_sw
+ * @return elapsed time
+ **/
+static uint64_t bench_walk(bool sw) {
+    addr_t	kvaddr	= arch_mmu_get_kern_vaddr();
+    addr_t	sum	= 0;
+    uint64_t	start	= host_now_ns();
+    
+    for (unsigned int i = 0; i < BENCH_ENTRY_CNT; i++) {
+	if (sw) {
+	    sum += armv7_mmu_walk(kern_pgd, kvaddr + ((addr_t)i << PGTB_IDX_SHIFT));
+	} else {
+	    sum += armv7_mmu_virt_to_phy_sw(kvaddr + ((addr_t)i << PGTB_IDX_SHIFT));
+	}
+    }
+    
+    sink = sum;
+    
+    return host_now_ns() - start;
+}
+
+/**
+ * bench_scan
+ * 
+ * reads every entry of the benchmarked tables through arch_mmu_pgtb_get_phy
+ * 
+ * @return elapsed time
+ **/
+static uint64_t bench_scan(void) {
+    addr_t	sum	= 0;
+    uint64_t	start	= host_now_ns();
+    
+    for (unsigned int i = 0; i < BENCH_SECT_CNT; i++) {
+	for (unsigned int j = 0; j < 256; j++) {
+	    sum += arch_mmu_pgtb_get_phy(kern_pgtbs + (i * PGTB_SZ), j);
+	}
+    }
+    
+    sink = sum;
+    
+    return host_now_ns() - start;
+}
+
+int main(int argc, char **argv) {
+    unsigned int	rounds	= (argc > 1) ? strtoul(argv[1], NULL, 0) : 8;
+    uint64_t		ns[6]	= { 0 };
+    
+    host_phy_init();
+    
+    kern_pgd	= host_phy_alloc(PGD_ENTRY_CNT * PGD_ENTRY_SZ, 1 << TTBR_ALIGN);
+    kern_pgtbs	= host_phy_alloc(arch_mmu_get_kern_pgtb_reg_sz(), host_pow2(arch_mmu_get_kern_pgtb_reg_sz()));
+    
+    host_mmu_enable(kern_pgd, host_phy_alloc(arch_mmu_get_user_pgd_sz(), arch_mmu_get_user_pgd_alignment()));
+    bench_pgds(PG_DIR);
+    
+    for (unsigned int i = 0; i < rounds; i++) {
+	ns[0] += bench_map(false, PG_TAB);
+	ns[1] += bench_walk(true);
+	ns[2] += bench_walk(false);
+	ns[3] += bench_scan();
+	ns[4] += bench_map(true, PG_TAB_INVAL);
+	ns[5] += bench_map(true, PG_TAB);
+    }
+    
+    bench_pgds(PG_DIR_INVAL);
+    
+    bench_report("map (new entry)", (unsigned long)rounds * BENCH_ENTRY_CNT, ns[0]);
+    bench_report("walk", (unsigned long)rounds * BENCH_ENTRY_CNT, ns[1]);
+    bench_report("virt_to_phy_sw", (unsigned long)rounds * BENCH_ENTRY_CNT, ns[2]);
+    bench_report("pgtb_get_phy", (unsigned long)rounds * BENCH_ENTRY_CNT, ns[3]);
+    bench_report("unmap (active)", (unsigned long)rounds * BENCH_ENTRY_CNT, ns[4]);
+    bench_report("map (active)", (unsigned long)rounds * BENCH_ENTRY_CNT, ns[5]);
+    
+    return 0;
+}
@@ -0,0 +1,494 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * armv7_mmu_test.c checks the armv7 descriptor code on the host; the
+ * tables built through arch_mmu_create_entry/arch_mmu_create_new_entry
+ * by a randomized sequence of maps & unmaps are compared against a flat
+ * oracle through every lookup path.
+ * 
+ * usage: armv7_mmu_test [seed] [ops]
+ */
+#include "host.h"
+#include <arch/arm/armv7/armv7_syscntl.h>
+#include <arch/arm/armv7/armv7_mmu.h>
+#include <arch/arch_mmu.h>
+#include <mm/mmu.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* sections the random sequence is confined to (half per ttbr) */
+#define TEST_SECT_CNT		32
+#define TEST_PG_PER_SECT	256
+#define TEST_VERIFY_INTERVAL	8192
+
+#define CHECK(cond, ...) do {						\
+    checks++;								\
+    if (!(cond)) {							\
+	fprintf(stderr, "armv7_mmu_test: %s:%d: ", __FILE__, __LINE__);	\
+	fprintf(stderr, __VA_ARGS__);					\
+	fprintf(stderr, " (seed %u, op %lu)\n", seed, op);		\
+	exit(1);							\
+    }									\
+} while (0)
+
+/**
+ * test_sect
+ * 
+ * oracle state of a section
+ * 
+ * @virt_addr	virtual base of section
+ * @present	true if the pgd entry refers to it's table
+ * @mapped	count of mapped pages
+ * @phy		physical page of each page (0x0 if unmapped)
+ * @acc		access flags of each page
+ **/
+struct test_sect {
+    addr_t		virt_addr;
+    bool		present;
+    unsigned int	mapped;
+    addr_t		phy[TEST_PG_PER_SECT];
+    mmu_acc_flags_t	acc[TEST_PG_PER_SECT];
+};
+
+static struct test_sect	sects[TEST_SECT_CNT];
+static addr_t		kern_pgd;
+static addr_t		user_pgd;
+static addr_t		kern_pgtbs;
+static addr_t		user_pgtbs;
+static unsigned int	seed;
+static uint32_t		rand_state;
+static unsigned long	op;
+static unsigned long	checks;
+
+/**
+ * test_is_kern
+ * 
+ * @virt_addr	virtual address
+ * @return true if translated by the kernel page directory
+ **/
+static bool test_is_kern(addr_t virt_addr) {
+    return virt_addr >= arch_mmu_get_kern_vaddr();
+}
+
+/**
+ * test_pgtb
+ * 
+ * returns the table of a section; tables of each half are
+ * contiguous, as arch_mmu_create_new_entry expects.
+ * 
+ * @virt_addr	virtual address
+ * @return physical address of table
+ **/
+static addr_t test_pgtb(addr_t virt_addr) {
+    addr_t ret = 0x0;
+    
+    if (test_is_kern(virt_addr)) {
+	ret = kern_pgtbs + (((virt_addr - arch_mmu_get_kern_vaddr()) >> PGD_IDX_SHIFT) * PGTB_SZ);
+    } else {
+	ret = user_pgtbs + ((virt_addr >> PGD_IDX_SHIFT) * PGTB_SZ);
+    }
+    
+    return ret;
+}
+
+/**
+ * test_pgtb_desc
+ * 
+ * expected small page descriptor
+ * 
+ * @phy_addr	physical address
+ * @acc	access flags
+ * @return descriptor
+ **/
+static uint32_t test_pgtb_desc(addr_t phy_addr, mmu_acc_flags_t acc) {
+    uint32_t ret = (uint32_t)phy_addr | ARMV7_MMU_PGTB_SMALL_PG;
+    
+    switch (acc) {
+	case USER:
+	    ret |= (0x3 << PGTB_AP_SHIFT) | ARMV7_MMU_PGTB_NORMAL;
+	    break;
+	case KERN_USER:
+	    ret |= (0x3 << PGTB_AP_SHIFT) | PGTB_APX | ARMV7_MMU_PGTB_NORMAL;
+	    break;
+	case KERNEL:
+	    ret |= (0x1 << PGTB_AP_SHIFT) | ARMV7_MMU_PGTB_NORMAL;
+	    break;
+	case KERNEL_RO:
+	    ret |= (0x1 << PGTB_AP_SHIFT) | PGTB_APX | ARMV7_MMU_PGTB_NORMAL;
+	    break;
+	case DEVICE:
+	    ret |= (0x1 << PGTB_AP_SHIFT) | ARMV7_MMU_PGTB_DEVICE;
+	    break;
+    }
+    
+    return ret;
+}
+
+/**
+ * test_create
+ * 
+ * creates an entry through either the active or the explicit interface
+ * 
+ * @entry	entry
+ * @return errno
+ **/
+static int test_create(struct mmu_entry *entry) {
+    addr_t	base	= 0x0;
+    int		ret	= ESUCC;
+    
+    if (host_rand(&rand_state) & 1) {
+	ret = arch_mmu_create_entry(entry);
+    } else {
+	if (entry->type == PG_DIR || entry->type == PG_DIR_INVAL) {
+	    base = test_is_kern(entry->virt_addr) ? kern_pgd : user_pgd;
+	} else {
+	    base = test_is_kern(entry->virt_addr) ? kern_pgtbs : user_pgtbs;
+	}
+	
+	ret = arch_mmu_create_new_entry(base, entry);
+    }
+    
+    return ret;
+}
+
+/**
+ * test_map
+ * 
+ * maps (or remaps) a page, creating the pgd entry if absent
+ * 
+ * @sect	section
+ * @idx	page index
+ **/
+static void test_map(struct test_sect *sect, unsigned int idx) {
+    static const mmu_acc_flags_t kern_acc[] = { KERNEL, KERNEL_RO, DEVICE };
+    static const mmu_acc_flags_t user_acc[] = { USER, KERN_USER };
+    struct mmu_entry	entry;
+    bool		kern	= test_is_kern(sect->virt_addr);
+    
+    if (!sect->present) {
+	entry.phy_addr	= test_pgtb(sect->virt_addr);
+	entry.virt_addr	= sect->virt_addr;
+	entry.type	= PG_DIR;
+	entry.acc_flags	= kern ? KERNEL : USER;
+	
+	CHECK(test_create(&entry) == ESUCC, "pgd entry of %#lx", (unsigned long)sect->virt_addr);
+	sect->present = true;
+    }
+    
+    entry.phy_addr	= ((host_rand(&rand_state) % 0xFFFFF) + 1) << PGTB_IDX_SHIFT;
+    entry.virt_addr	= sect->virt_addr + (idx << PGTB_IDX_SHIFT);
+    entry.type		= PG_TAB;
+    entry.acc_flags	= kern ? kern_acc[host_rand(&rand_state) % 3] : user_acc[host_rand(&rand_state) % 2];
+    
+    CHECK(test_create(&entry) == ESUCC, "map of %#lx", (unsigned long)entry.virt_addr);
+    
+    if (sect->phy[idx] == 0x0) {
+	sect->mapped++;
+    }
+    
+    sect->phy[idx] = entry.phy_addr;
+    sect->acc[idx] = entry.acc_flags;
+}
+
+/**
+ * test_unmap
+ * 
+ * unmaps a page, releasing the pgd entry once the table is empty
+ * (as mmu_unmap_page does)
+ * 
+ * @sect	section
+ * @idx	page index
+ **/
+static void test_unmap(struct test_sect *sect, unsigned int idx) {
+    struct mmu_entry	entry;
+    addr_t		pgtb	= 0x0;
+    
+    if (sect->present) {
+	entry.phy_addr	= 0x0;
+	entry.virt_addr	= sect->virt_addr + (idx << PGTB_IDX_SHIFT);
+	entry.type	= PG_TAB_INVAL;
+	entry.acc_flags	= test_is_kern(sect->virt_addr) ? KERNEL : USER;
+	
+	CHECK(test_create(&entry) == ESUCC, "unmap of %#lx", (unsigned long)entry.virt_addr);
+	
+	if (sect->phy[idx] != 0x0) {
+	    sect->phy[idx] = 0x0;
+	    sect->mapped--;
+	}
+	
+	pgtb = arch_mmu_get_pgtb(entry.virt_addr);
+	
+	CHECK(pgtb == test_pgtb(sect->virt_addr), "pgtb of %#lx", (unsigned long)entry.virt_addr);
+	CHECK(arch_mmu_pgtb_is_empty(pgtb) == (sect->mapped == 0), "emptiness of %#lx", (unsigned long)pgtb);
+	
+	if (sect->mapped == 0) {
+	    entry.virt_addr	= sect->virt_addr;
+	    entry.type		= PG_DIR_INVAL;
+	    
+	    CHECK(test_create(&entry) == ESUCC, "pgd release of %#lx", (unsigned long)sect->virt_addr);
+	    sect->present = false;
+	}
+    }
+}
+
+/**
+ * test_lookup
+ * 
+ * compares every lookup path against the oracle for an address
+ * 
+ * @sect	section
+ * @idx	page index
+ * @off	offset within the page
+ **/
+static void test_lookup(struct test_sect *sect, unsigned int idx, addr_t off) {
+    addr_t	virt_addr	= sect->virt_addr + (idx << PGTB_IDX_SHIFT) + off;
+    addr_t	pgd		= test_is_kern(virt_addr) ? kern_pgd : user_pgd;
+    addr_t	exp		= 0x0;
+    addr_t	exp_user	= 0x0;
+    addr_t	exp_pgtb	= sect->present ? test_pgtb(virt_addr) : 0x0;
+    uint32_t	*pg_tb		= NULL;
+    
+    if (sect->phy[idx] != 0x0) {
+	exp = sect->phy[idx] | off;
+	
+	if (sect->acc[idx] == USER || sect->acc[idx] == KERN_USER) {
+	    exp_user = exp;
+	}
+    }
+    
+    CHECK(armv7_mmu_walk(pgd, virt_addr) == exp, "walk of %#lx", (unsigned long)virt_addr);
+    CHECK(armv7_mmu_virt_to_phy_sw(virt_addr) == exp, "sw translation of %#lx", (unsigned long)virt_addr);
+    CHECK(virt_to_phy(virt_addr) == exp, "translation of %#lx", (unsigned long)virt_addr);
+    CHECK(armv7_mmu_virt_to_phy_user(virt_addr) == exp_user, "user translation of %#lx", (unsigned long)virt_addr);
+    CHECK(arch_mmu_get_pgtb(virt_addr) == exp_pgtb, "pgtb of %#lx", (unsigned long)virt_addr);
+    CHECK(arch_mmu_pgd_get_pgtb(pgd, virt_addr) == exp_pgtb, "pgd pgtb of %#lx", (unsigned long)virt_addr);
+    
+    if (sect->present) {
+	pg_tb = (uint32_t *)(uintptr_t)exp_pgtb;
+	
+	CHECK(arch_mmu_pgtb_get_phy(exp_pgtb, idx) == sect->phy[idx], "pgtb phy of %#lx", (unsigned long)virt_addr);
+	
+	if (sect->phy[idx] != 0x0) {
+	    CHECK(pg_tb[idx] == test_pgtb_desc(sect->phy[idx], sect->acc[idx]),
+		  "descriptor of %#lx: %#x", (unsigned long)virt_addr, pg_tb[idx]);
+	} else {
+	    CHECK((pg_tb[idx] & PGTB_TYPE_MASK) == 0, "descriptor of %#lx: %#x", (unsigned long)virt_addr, pg_tb[idx]);
+	}
+    }
+}
+
+/**
+ * test_wrprotect
+ * 
+ * write protects a user table, as done when forking
+ * 
+ * @sect	section
+ **/
+static void test_wrprotect(struct test_sect *sect) {
+    if (sect->present && !test_is_kern(sect->virt_addr)) {
+	arch_mmu_pgtb_wrprotect(test_pgtb(sect->virt_addr));
+	
+	for (unsigned int i = 0; i < TEST_PG_PER_SECT; i++) {
+	    if (sect->acc[i] == USER) {
+		sect->acc[i] = KERN_USER;
+	    }
+	}
+    }
+}
+
+/**
+ * test_verify
+ * 
+ * compares every page of every section against the oracle
+ **/
+static void test_verify(void) {
+    for (unsigned int i = 0; i < TEST_SECT_CNT; i++) {
+	for (unsigned int j = 0; j < TEST_PG_PER_SECT; j++) {
+	    test_lookup(&sects[i], j, host_rand(&rand_state) & (PG_SZ - 1));
+	}
+	
+	if (sects[i].present) {
+	    CHECK(arch_mmu_pgtb_is_empty(test_pgtb(sects[i].virt_addr)) == (sects[i].mapped == 0),
+		  "emptiness of %#lx", (unsigned long)sects[i].virt_addr);
+	}
+    }
+}
+
+/**
+ * test_layout
+ * 
+ * checks the size & alignment interface for the configured split
+ **/
+static void test_layout(void) {
+    unsigned int n = __builtin_clz(CONFIG_VM_SPLIT) + 1;
+    
+    CHECK(arch_mmu_get_kern_vaddr() == CONFIG_VM_SPLIT, "kern vaddr");
+    CHECK(arch_mmu_get_user_pgd_sz() == (size_t)((PGD_ENTRY_CNT >> n) * PGD_ENTRY_SZ), "user pgd size");
+    CHECK(arch_mmu_get_user_pgd_alignment() == (1u << (TTBR_ALIGN - n)), "user pgd alignment");
+    CHECK(arch_mmu_get_user_pgtb_reg_sz() == (size_t)((PGD_ENTRY_CNT >> n) * PGTB_SZ), "user pgtb region size");
+    CHECK(arch_mmu_get_kern_pgtb_reg_sz() == (size_t)((PGD_ENTRY_CNT - (PGD_ENTRY_CNT >> n)) * PGTB_SZ), "kern pgtb region size");
+    CHECK(arch_mmu_get_pgtb_sz() == PGTB_SZ, "pgtb size");
+    CHECK(arch_mmu_get_pgtb_entry_cnt() == TEST_PG_PER_SECT, "pgtb entry count");
+}
+
+/**
+ * test_directed
+ * 
+ * checks sections, large pages & the error paths which the random
+ * sequence doesn't reach
+ **/
+static void test_directed(void) {
+    struct armv7_mmu_pgd_entry	pgd_ent		= { 0 };
+    struct armv7_mmu_pgtb_entry	pgtb_ent	= { 0 };
+    addr_t			sect_va		= arch_mmu_get_kern_vaddr() + 0x10000000;
+    addr_t			pgtb		= host_phy_alloc(PGTB_SZ, PGTB_SZ);
+    uint32_t			*pg_tb		= (uint32_t *)(uintptr_t)pgtb;
+    
+    /* section */
+    pgd_ent.phy_addr	= 0x12300000;
+    pgd_ent.virt_addr	= sect_va;
+    pgd_ent.domain	= KERN_DOMAIN;
+    pgd_ent.acc_perm	= ARMV7_MMU_ACC_KRO_URO;
+    pgd_ent.type	= ARMV7_MMU_PGD_SECTION;
+    pgd_ent.flags	= ARMV7_MMU_PGD_SECT_NORMAL;
+    
+    CHECK(armv7_mmu_map_pgd(&pgd_ent) == ESUCC, "section");
+    CHECK(armv7_mmu_walk(kern_pgd, sect_va + 0xABCDE) == 0x123ABCDE, "section walk");
+    CHECK(virt_to_phy(sect_va + 0xABCDE) == 0x123ABCDE, "section translation");
+    CHECK(armv7_mmu_virt_to_phy_user(sect_va + 0x1000) == 0x12301000, "section user translation");
+    CHECK(arch_mmu_get_pgtb(sect_va) == 0x0, "section pgtb");
+    
+    pgd_ent.type = ARMV7_MMU_PGD_INVALID;
+    CHECK(armv7_mmu_map_pgd(&pgd_ent) == ESUCC, "section release");
+    CHECK(armv7_mmu_walk(kern_pgd, sect_va) == 0x0, "released section walk");
+    
+    /* large pages; unsupported by armv7_mmu_map_new_pgtb, so written directly */
+    for (unsigned int i = 0; i < 16; i++) {
+	pg_tb[16 + i] = 0x45670000 | ARMV7_MMU_PGTB_LARGE_PG;
+    }
+    
+    for (unsigned int i = 0; i < 16; i++) {
+	CHECK(arch_mmu_pgtb_get_phy(pgtb, 16 + i) == (0x45670000 | (i << PGTB_IDX_SHIFT)), "large page %u", i);
+    }
+    
+    CHECK(!arch_mmu_pgtb_is_empty(pgtb), "large page emptiness");
+    CHECK(arch_mmu_pgtb_get_phy(pgtb, TEST_PG_PER_SECT) == 0x0, "out of range index");
+    
+    /* errors */
+    pgtb_ent.virt_addr	= sect_va;
+    pgtb_ent.type	= ARMV7_MMU_PGTB_SMALL_PG;
+    
+    CHECK(armv7_mmu_map_pgtb(&pgtb_ent) == ENOTFND, "pgtb entry without a table");
+    CHECK(armv7_mmu_map_pgtb(NULL) == EINVAL, "null pgtb entry");
+    CHECK(armv7_mmu_map_new_pgd(kern_pgd, NULL) == EINVAL, "null pgd entry");
+    
+    pgtb_ent.type = ARMV7_MMU_PGTB_LARGE_PG;
+    CHECK(armv7_mmu_map_new_pgtb(pgtb, &pgtb_ent) == ENOTSUPP, "large page entry");
+    
+    pgd_ent.type = ARMV7_MMU_PGD_SUPER_SECTION;
+    CHECK(armv7_mmu_map_new_pgd(kern_pgd, &pgd_ent) == ENOTSUPP, "super section entry");
+    
+    CHECK(armv7_mmu_set_kern_pgd(kern_pgd + PGTB_SZ, 0) == EALIGN, "unaligned kern pgd");
+    CHECK(armv7_mmu_set_user_pgd(user_pgd + PGTB_SZ, 0) == EALIGN, "unaligned user pgd");
+    
+    armv7_set_sctlr(armv7_get_sctlr() & ~ARMV7_SCTLR_MMU_ENB);
+    
+    pgd_ent.type = ARMV7_MMU_PGD_SECTION;
+    CHECK(armv7_mmu_map_pgd(&pgd_ent) == ENOTENB, "section with the mmu disabled");
+    CHECK(virt_to_phy(sect_va) == sect_va, "translation with the mmu disabled");
+    
+    armv7_set_sctlr(armv7_get_sctlr() | ARMV7_SCTLR_MMU_ENB);
+}
+
+int main(int argc, char **argv) {
+    unsigned long	ops	= 1000000;
+    unsigned int	sect	= 0;
+    unsigned int	idx	= 0;
+    uint32_t		r	= 0;
+    
+    seed = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1;
+    ops  = (argc > 2) ? strtoul(argv[2], NULL, 0) : ops;
+    
+    rand_state = seed ? seed : 0x9E3779B9;
+    
+    host_phy_init();
+    
+    kern_pgd	= host_phy_alloc(PGD_ENTRY_CNT * PGD_ENTRY_SZ, 1 << TTBR_ALIGN);
+    user_pgd	= host_phy_alloc(arch_mmu_get_user_pgd_sz(), arch_mmu_get_user_pgd_alignment());
+    kern_pgtbs	= host_phy_alloc(arch_mmu_get_kern_pgtb_reg_sz(), host_pow2(arch_mmu_get_kern_pgtb_reg_sz()));
+    user_pgtbs	= host_phy_alloc(arch_mmu_get_user_pgtb_reg_sz(), host_pow2(arch_mmu_get_user_pgtb_reg_sz()));
+    
+    host_mmu_enable(kern_pgd, user_pgd);
+    test_layout();
+    
+    /* distinct sections, spread over both halves */
+    for (unsigned int i = 0; i < TEST_SECT_CNT; i++) {
+	bool dup = true;
+	
+	while (dup) {
+	    r = host_rand(&rand_state) % (PGD_ENTRY_CNT / 2);
+	    
+	    if (i & 1) {
+		r += (arch_mmu_get_kern_vaddr() >> PGD_IDX_SHIFT);
+	    }
+	    
+	    dup = false;
+	    
+	    for (unsigned int j = 0; j < i && !dup; j++) {
+		dup = (sects[j].virt_addr == ((addr_t)r << PGD_IDX_SHIFT));
+	    }
+	}
+	
+	sects[i].virt_addr = (addr_t)r << PGD_IDX_SHIFT;
+    }
+    
+    for (op = 0; op < ops; op++) {
+	r	= host_rand(&rand_state);
+	sect	= (r >> 8) % TEST_SECT_CNT;
+	idx	= (r >> 16) % TEST_PG_PER_SECT;
+	
+	switch (r % 100) {
+	    case 0:
+		test_wrprotect(&sects[sect]);
+		break;
+	    case 1 ... 45:
+		test_map(&sects[sect], idx);
+		break;
+	    case 46 ... 79:
+		test_unmap(&sects[sect], idx);
+		break;
+	    default:
+		test_lookup(&sects[sect], idx, host_rand(&rand_state) & (PG_SZ - 1));
+		break;
+	}
+	
+	if ((op % TEST_VERIFY_INTERVAL) == 0) {
+	    test_verify();
+	}
+    }
+    
+    test_verify();
+    test_directed();
+    
+    printf("armv7_mmu_test: seed %u, %lu ops, %lu checks ok\n", seed, ops, checks);
+    
+    return 0;
+}
@@ -0,0 +1,124 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * host.c provides the environment shared by the host tests & benchmarks;
+ * a low (below 4GiB) arena for tables, so they may be referenced by
+ * 32-bit descriptors, and a mocked cpu running with the mmu enabled.
+ */
+#include "host.h"
+#include <arch/arm/armv7/armv7_syscntl.h>
+#include <arch/arm/armv7/armv7_mmu.h>
+#include <sys/mman.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* the kernel linear map is the identity (kp_start is kv_start) */
+addr_t kv_start;
+
+static uintptr_t	phy_base;
+static size_t		phy_used;
+
+/**
+ * host_phy_init
+ * 
+ * maps the arena; aborts on failure.
+ **/
+void host_phy_init(void) {
+    void *mem = mmap(NULL, HOST_PHY_SZ, PROT_READ | PROT_WRITE,
+		     MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    
+    if (mem == MAP_FAILED || ((uintptr_t)mem + HOST_PHY_SZ) > 0xFFFFFFFFu) {
+	fprintf(stderr, "host_phy_init: unable to map a low arena\n");
+	exit(1);
+    }
+    
+    phy_base = (uintptr_t)mem;
+    phy_used = 0;
+}
+
+/**
+ * host_phy_alloc
+ * 
+ * allocates zeroed memory from the arena; aborts when exhausted.
+ * 
+ * @size	size in bytes
+ * @align	alignment (power of 2)
+ * @return address
+ **/
+addr_t host_phy_alloc(size_t size, size_t align) {
+    uintptr_t addr = (phy_base + phy_used + align - 1) & ~(uintptr_t)(align - 1);
+    
+    if ((addr + size) > (phy_base + HOST_PHY_SZ)) {
+	fprintf(stderr, "host_phy_alloc: arena exhausted\n");
+	exit(1);
+    }
+    
+    phy_used = (addr + size) - phy_base;
+    memset((void *)addr, 0, size);
+    
+    return (addr_t)addr;
+}
+
+/**
+ * host_mmu_enable
+ * 
+ * resets the mocked cpu & enables the mmu with the configured split
+ * 
+ * @kern_pgd	kernel page directory
+ * @user_pgd	user page directory
+ **/
+void host_mmu_enable(addr_t kern_pgd, addr_t user_pgd) {
+    mock_cp15_reset();
+    
+    armv7_set_ttbcr(ARMV7_MMU_PG_DIV);
+    armv7_mmu_set_kern_pgd(kern_pgd, ARMV7_MMU_TTBR_FLAGS);
+    armv7_mmu_set_user_pgd(user_pgd, ARMV7_MMU_TTBR_FLAGS);
+    armv7_set_sctlr(armv7_get_sctlr() | ARMV7_SCTLR_MMU_ENB);
+}
+
+/**
+ * host_now_ns
+ * 
+ * @return monotonic time in nanoseconds
+ **/
+uint64_t host_now_ns(void) {
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    
+    return ((uint64_t)ts.tv_sec * 1000000000u) + ts.tv_nsec;
+}
+
+/**
+ * host_rand
+ * 
+ * xorshift32; deterministic across hosts, unlike rand()
+ * 
+ * @state	generator (non-zero)
+ * @return pseudo-random value
+ **/
+uint32_t host_rand(uint32_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    
+    return *state;
+}
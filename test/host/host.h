@@ -0,0 +1,29 @@
+#ifndef HOST_H
+#define HOST_H
+#include <types.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/* size of the arena standing in for physical memory */
+#define HOST_PHY_SZ	0x1000000
+
+/**
+ * host_pow2
+ * 
+ * rounds up to a power of 2; for aligning table regions to their size
+ * (arch_mmu_create_new_entry ors the table offset into the base).
+ * 
+ * @x		value (> 0)
+ * @return power of 2 >= x
+ **/
+inline size_t host_pow2(size_t x) {
+    return (x > 1) ? ((size_t)1 << (64 - __builtin_clzll((unsigned long long)x - 1))) : 1;
+}
+
+void host_phy_init(void);
+addr_t host_phy_alloc(size_t size, size_t align);
+void host_mmu_enable(addr_t kern_pgd, addr_t user_pgd);
+uint64_t host_now_ns(void);
+uint32_t host_rand(uint32_t *state);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef MOCK_ARMV7_H
+#define MOCK_ARMV7_H
+/*
+ * host shadow of arch/arm/armv7/armv7.h; the real header is included for
+ * it's definitions & the instructions it wraps are redirected afterwards.
+ * the inline asm of the real header is never emitted as nothing calls it.
+ */
+#include_next <arch/arm/armv7/armv7.h>
+
+#undef dmb
+#undef dsb
+#undef isb
+#undef dmb_ish
+#undef dmb_ishst
+#undef dsb_ish
+#undef dsb_ishst
+#undef sev
+#undef wfe
+#undef yield
+
+#define dmb()				__atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define dsb()				__atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define isb()				__atomic_signal_fence(__ATOMIC_SEQ_CST)
+#define dmb_ish()			__atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define dmb_ishst()			__atomic_thread_fence(__ATOMIC_RELEASE)
+#define dsb_ish()			__atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define dsb_ishst()			__atomic_thread_fence(__ATOMIC_RELEASE)
+#define sev()				((void)0)
+#define wfe()				((void)0)
+#define yield()				((void)0)
+
+#define armv7_irq_save()		0
+#define armv7_irq_restore(flags)	((void)(flags))
+
+#endif
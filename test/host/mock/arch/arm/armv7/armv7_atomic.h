@@ -0,0 +1,124 @@
+#ifndef MOCK_ARMV7_ATOMIC_H
+#define MOCK_ARMV7_ATOMIC_H
+/*
+ * host shadow of arch/arm/armv7/armv7_atomic.h; the ldrex/strex loops
+ * are replaced by the compiler's __atomic builtins, with the same
+ * types, names & orderings, so code built upon sync/atomic.h may be
+ * run (and raced) on the host.
+ */
+#include <arch/arm/armv7/armv7.h>
+#include <types.h>
+#include <stdbool.h>
+#include <time.h>
+
+#define ATOMIC_INIT(i)		{ .counter = (i) }
+#define ATOMIC64_INIT(i)	{ .counter = (i) }
+
+#define ATOMIC_BITS_SHIFT	5
+#define ATOMIC_BITS_MASK	0x1F
+
+typedef struct {
+    volatile int	counter;
+} atomic_t;
+
+typedef struct {
+    volatile long long	counter;
+} __attribute__((aligned(8))) atomic64_t;
+
+/**
+ * MOCK_ATOMIC_ORDERED
+ *
+ * defines the _relaxed, _acquire, _release & fully ordered forms of
+ * name, each evaluating expr with the memory order mo.
+ **/
+#define MOCK_ATOMIC_FORM(ret_t, name, params, order, expr)	\
+inline ret_t name params {					\
+    const int mo = (order);					\
+								\
+    return (expr);						\
+}
+
+#define MOCK_ATOMIC_ORDERED(ret_t, name, params, expr)				\
+MOCK_ATOMIC_FORM(ret_t, name##_relaxed, params, __ATOMIC_RELAXED, expr)	\
+MOCK_ATOMIC_FORM(ret_t, name##_acquire, params, __ATOMIC_ACQUIRE, expr)	\
+MOCK_ATOMIC_FORM(ret_t, name##_release, params, __ATOMIC_RELEASE, expr)	\
+MOCK_ATOMIC_FORM(ret_t, name, params, __ATOMIC_SEQ_CST, expr)
+
+/**
+ * mock_cmpxchg
+ *
+ * @return previous value (old if replaced)
+ **/
+#define mock_cmpxchg(ptr, old, val, mo) __extension__ ({			\
+    __typeof__(+*(ptr)) __exp = (old);				\
+									\
+    __atomic_compare_exchange_n((ptr), &__exp, (val), false, (mo),	\
+				__ATOMIC_RELAXED);			\
+    __exp;								\
+})
+
+inline int atomic_read(atomic_t *v) {
+    return __atomic_load_n(&v->counter, __ATOMIC_RELAXED);
+}
+
+inline void atomic_set(atomic_t *v, int i) {
+    __atomic_store_n(&v->counter, i, __ATOMIC_RELAXED);
+}
+
+inline long long atomic64_read(atomic64_t *v) {
+    return __atomic_load_n(&v->counter, __ATOMIC_RELAXED);
+}
+
+inline void atomic64_set(atomic64_t *v, long long i) {
+    __atomic_store_n(&v->counter, i, __ATOMIC_RELAXED);
+}
+
+MOCK_ATOMIC_ORDERED(int, atomic_add_return, (int i, atomic_t *v),
+		    __atomic_add_fetch(&v->counter, i, mo))
+MOCK_ATOMIC_ORDERED(int, atomic_fetch_add, (int i, atomic_t *v),
+		    __atomic_fetch_add(&v->counter, i, mo))
+MOCK_ATOMIC_ORDERED(int, atomic_xchg, (atomic_t *v, int i),
+		    __atomic_exchange_n(&v->counter, i, mo))
+MOCK_ATOMIC_ORDERED(int, atomic_cmpxchg, (atomic_t *v, int old, int i),
+		    mock_cmpxchg(&v->counter, old, i, mo))
+MOCK_ATOMIC_ORDERED(long long, atomic64_add_return, (long long i, atomic64_t *v),
+		    __atomic_add_fetch(&v->counter, i, mo))
+MOCK_ATOMIC_ORDERED(long long, atomic64_fetch_add, (long long i, atomic64_t *v),
+		    __atomic_fetch_add(&v->counter, i, mo))
+MOCK_ATOMIC_ORDERED(long long, atomic64_xchg, (atomic64_t *v, long long i),
+		    __atomic_exchange_n(&v->counter, i, mo))
+MOCK_ATOMIC_ORDERED(long long, atomic64_cmpxchg, (atomic64_t *v, long long old, long long i),
+		    mock_cmpxchg(&v->counter, old, i, mo))
+MOCK_ATOMIC_ORDERED(bool, atomic_test_and_set_bit, (unsigned int nr, volatile unsigned int *addr),
+		    (__atomic_fetch_or(addr + (nr >> ATOMIC_BITS_SHIFT),
+				       1u << (nr & ATOMIC_BITS_MASK), mo)
+		     & (1u << (nr & ATOMIC_BITS_MASK))) != 0)
+MOCK_ATOMIC_ORDERED(bool, atomic_test_and_clear_bit, (unsigned int nr, volatile unsigned int *addr),
+		    (__atomic_fetch_and(addr + (nr >> ATOMIC_BITS_SHIFT),
+					~(1u << (nr & ATOMIC_BITS_MASK)), mo)
+		     & (1u << (nr & ATOMIC_BITS_MASK))) != 0)
+MOCK_ATOMIC_ORDERED(addr_t, arch_xchg, (volatile addr_t *ptr, addr_t val),
+		    __atomic_exchange_n(ptr, val, mo))
+MOCK_ATOMIC_ORDERED(addr_t, arch_cmpxchg, (volatile addr_t *ptr, addr_t old, addr_t val),
+		    mock_cmpxchg(ptr, old, val, mo))
+
+inline void arch_wait_event(void) {
+    wfe();
+}
+
+inline void arch_send_event(void) {
+    dsb_ishst();
+    sev();
+}
+
+/*
+ * the thread being waited upon may share the cpu (& be preempted);
+ * sleeping, unlike sched_yield, is certain to let it run.
+ */
+inline void arch_cpu_relax(void) {
+    struct timespec ts = { 0, 1000 };
+    
+    nanosleep(&ts, NULL);
+}
+
+#endif
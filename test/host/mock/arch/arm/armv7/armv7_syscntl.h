@@ -0,0 +1,59 @@
+#ifndef MOCK_ARMV7_SYSCNTL_H
+#define MOCK_ARMV7_SYSCNTL_H
+/*
+ * host shadow of arch/arm/armv7/armv7_syscntl.h; cp15 accesses used by the
+ * mmu code are redirected to mock_cp15, everything else is left as is
+ * (and fails to assemble if used).
+ */
+#include_next <arch/arm/armv7/armv7_syscntl.h>
+
+/**
+ * mock_cp15
+ *
+ * cp15 state of the (single) mocked cpu
+ *
+ * @sctlr	system control register
+ * @ttbcr	translation table base control register
+ * @ttbr0	translation table base register 0
+ * @ttbr1	translation table base register 1
+ * @dacr	domain access control register
+ * @par		physical address register
+ * @mpidr	multiprocessor affinity register
+ * @tlbi	count of tlb invalidations
+ **/
+struct mock_cp15 {
+    unsigned int	sctlr;
+    unsigned int	ttbcr;
+    unsigned int	ttbr0;
+    unsigned int	ttbr1;
+    unsigned int	dacr;
+    unsigned int	par;
+    unsigned int	mpidr;
+    unsigned long	tlbi;
+};
+
+extern struct mock_cp15 mock_cp15;
+
+void mock_cp15_reset(void);
+void mock_cp15_ats(addr_t virt_addr, bool user);
+
+#define armv7_get_sctlr()			(mock_cp15.sctlr)
+#define armv7_set_sctlr(val)			((void)(mock_cp15.sctlr = (val)))
+#define armv7_get_ttbcr()			(mock_cp15.ttbcr)
+#define armv7_set_ttbcr(val)			((void)(mock_cp15.ttbcr = (val)))
+#define armv7_get_ttbr0()			(mock_cp15.ttbr0)
+#define armv7_set_ttbr0(val)			((void)(mock_cp15.ttbr0 = (val)))
+#define armv7_get_ttbr1()			(mock_cp15.ttbr1)
+#define armv7_set_ttbr1(val)			((void)(mock_cp15.ttbr1 = (val)))
+#define armv7_get_dacr()			(mock_cp15.dacr)
+#define armv7_set_dacr(val)			((void)(mock_cp15.dacr = (val)))
+#define armv7_get_mpidr()			(mock_cp15.mpidr)
+#define armv7_get_par()				(mock_cp15.par)
+#define armv7_ats1cpr(virt_addr)		mock_cp15_ats((virt_addr), false)
+#define armv7_ats1cur(virt_addr)		mock_cp15_ats((virt_addr), true)
+#define armv7_invalidate_unified_tlb()		((void)mock_cp15.tlbi++)
+#define armv7_invalidate_unified_tlb_is()	((void)mock_cp15.tlbi++)
+#define armv7_invalidate_unified_tlb_mva(va)	((void)(va), (void)mock_cp15.tlbi++)
+#define armv7_invalidate_unified_tlb_mva_is(va)	((void)(va), (void)mock_cp15.tlbi++)
+
+#endif
@@ -0,0 +1,105 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * mock_cp15.c provides the cp15 state behind the host shadow of
+ * armv7_syscntl.h, along with an address translation operation that
+ * walks the active tables independently of armv7_mmu.c.
+ */
+#include <arch/arm/armv7/armv7_syscntl.h>
+#include <arch/arm/armv7/armv7_mmu.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+struct mock_cp15 mock_cp15;
+
+static bool mock_user_access(uint32_t ap);
+
+/**
+ * mock_cp15_reset
+ * 
+ * resets the mocked cpu; the mmu is disabled.
+ **/
+void mock_cp15_reset(void) {
+    memset(&mock_cp15, 0, sizeof(mock_cp15));
+}
+
+/**
+ * mock_cp15_ats
+ * 
+ * performs a stage 1 translation (ATS1CPR/ATS1CUR) of the active tables,
+ * leaving the result within the PAR; tables are accessed directly as
+ * the host requires the kernel linear map to be the identity.
+ * 
+ * @virt_addr	virtual address
+ * @user	true to apply unprivileged permission checks
+ **/
+void mock_cp15_ats(addr_t virt_addr, bool user) {
+    unsigned int	n	= mock_cp15.ttbcr & TTBCR_N_MASK;
+    uint32_t		*tbl	= NULL;
+    uint32_t		ent	= 0;
+    uint32_t		ap	= 0;
+    unsigned int	par	= ARMV7_PAR_FAULT;
+    
+    if (n > 0 && (virt_addr >> (32 - n)) != 0) {
+	tbl = (uint32_t *)(uintptr_t)(mock_cp15.ttbr1 & TTBR_MASK);
+    } else {
+	tbl = (uint32_t *)(uintptr_t)(mock_cp15.ttbr0 & ~((1u << (TTBR_ALIGN - n)) - 1));
+    }
+    
+    ent = tbl[(virt_addr >> 20) & 0xFFF];
+    
+    if ((ent & 0x3) == 0x2) {
+	ap = ((ent >> 10) & 0x3) | ((ent >> 13) & 0x4);
+	
+	if (ent & PGD_SECT_SUPER) {
+	    par = (ent & 0xFF000000) | ARMV7_PAR_SUPER_SECT;
+	} else {
+	    par = (ent & 0xFFF00000) | (virt_addr & 0x000FF000);
+	}
+    } else if ((ent & 0x3) == 0x1) {
+	tbl = (uint32_t *)(uintptr_t)(ent & 0xFFFFFC00);
+	ent = tbl[(virt_addr >> 12) & 0xFF];
+	ap  = ((ent >> 4) & 0x3) | ((ent >> 7) & 0x4);
+	
+	if (ent & 0x2) {
+	    par = ent & 0xFFFFF000;
+	} else if ((ent & 0x3) == 0x1) {
+	    par = (ent & 0xFFFF0000) | (virt_addr & 0x0000F000);
+	}
+    }
+    
+    if (user && !(par & ARMV7_PAR_FAULT) && !mock_user_access(ap)) {
+	par = ARMV7_PAR_FAULT;
+    }
+    
+    mock_cp15.par = par;
+}
+
+/**
+ * mock_user_access
+ * 
+ * determines if AP[2:0] permits unprivileged access
+ * 
+ * @ap		access permissions
+ * @return true if accessible
+ **/
+static bool mock_user_access(uint32_t ap) {
+    return (ap & 0x2) != 0;
+}
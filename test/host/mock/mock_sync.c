@@ -0,0 +1,57 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * mock_sync.c provides the arch lock & irq primitives (arch_sync.h)
+ * behind sync/spinlock.c on the host; the ticket lock is kept with
+ * the compiler's __atomic builtins & irqs don't exist.
+ */
+#include <arch/arch_sync.h>
+#include <sync/atomic.h>
+#include <sync/spinlock.h>
+#include <types.h>
+#include <stdbool.h>
+
+void arch_spin_lock(struct spinlock *lock) {
+    uint16_t ticket = __atomic_fetch_add(&lock->next, 1, __ATOMIC_RELAXED);
+    
+    while (__atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) != ticket) {
+	arch_cpu_relax();
+    }
+}
+
+bool arch_spin_trylock(struct spinlock *lock) {
+    uint32_t tickets = __atomic_load_n(&lock->tickets, __ATOMIC_RELAXED);
+    
+    return ((tickets >> SPIN_TICKET_SHIFT) == (tickets & SPIN_TICKET_MASK) &&
+	    __atomic_compare_exchange_n(&lock->tickets, &tickets, tickets + (1u << SPIN_TICKET_SHIFT),
+					false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+}
+
+void arch_spin_unlock(struct spinlock *lock) {
+    __atomic_store_n(&lock->owner, (uint16_t)(lock->owner + 1), __ATOMIC_RELEASE);
+}
+
+unsigned int arch_irq_save(void) {
+    return 0;
+}
+
+void arch_irq_restore(unsigned int flags) {
+    (void)flags;
+}
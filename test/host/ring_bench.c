@@ -0,0 +1,269 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * ring_bench.c measures the throughput (items per second) of the
+ * lock-free rings (util/ring.h) on the host; a single thread passing
+ * items through a ring, then producer & consumer threads, for a range
+ * of batch sizes.
+ * mpmc threads preempted between reserving & publishing hold up the
+ * others (as they would an interrupted cpu), so mpmc is raced only
+ * with as many threads as there are cpus.
+ * 
+ * usage: ring_bench [items]
+ */
+#include "host.h"
+#include <util/ring.h>
+#include <sync/atomic.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define BENCH_RING_SZ		1024
+#define BENCH_BATCH_MAX		64
+#define BENCH_THREADS_MAX	4
+
+/**
+ * bench_ring
+ * 
+ * a ring of either kind & the routines driving it
+ * 
+ * @name	name reported
+ * @enqueue	batch enqueue
+ * @dequeue	batch dequeue
+ * @ring	ring
+ **/
+struct bench_ring {
+    const char	*name;
+    size_t	(*enqueue)(void *ring, void * const *objs, size_t cnt);
+    size_t	(*dequeue)(void *ring, void **objs, size_t cnt);
+    void	*ring;
+};
+
+/**
+ * bench_arg
+ * 
+ * @ring	ring
+ * @batch	batch size
+ * @items	items to pass (per producer, or in total per consumer side)
+ **/
+struct bench_arg {
+    struct bench_ring	*ring;
+    size_t		batch;
+    unsigned long	items;
+};
+
+static struct ring_spsc		spsc;
+static struct ring_mpmc		mpmc;
+static void			*slots[BENCH_RING_SZ];
+static unsigned long		received;
+static volatile uintptr_t	sink;
+
+/* adapt either ring to struct bench_ring */
+static size_t bench_spsc_enqueue(void *ring, void * const *objs, size_t cnt) {
+    return ring_spsc_enqueue_batch(ring, objs, cnt);
+}
+
+static size_t bench_spsc_dequeue(void *ring, void **objs, size_t cnt) {
+    return ring_spsc_dequeue_batch(ring, objs, cnt);
+}
+
+static size_t bench_mpmc_enqueue(void *ring, void * const *objs, size_t cnt) {
+    return ring_mpmc_enqueue_batch(ring, objs, cnt);
+}
+
+static size_t bench_mpmc_dequeue(void *ring, void **objs, size_t cnt) {
+    return ring_mpmc_dequeue_batch(ring, objs, cnt);
+}
+
+/**
+ * bench_report
+ * 
+ * prints the throughput of a benchmark
+ * 
+ * @name	ring
+ * @threads	producers & consumers ("1" when single threaded)
+ * @batch	batch size
+ * @items	items passed
+ * @ns		elapsed time
+ **/
+static void bench_report(const char *name, const char *threads, size_t batch, unsigned long items, uint64_t ns) {
+    printf("%-6s %-6s batch %-3zu %10lu items %10.3f ms %14.0f items/s\n", name, threads, batch,
+	   items, ns / 1e6, ns ? (items * 1e9) / ns : 0.0);
+}
+
+/**
+ * bench_single
+ * 
+ * passes items through a ring from a single thread, a batch at a time
+ * 
+ * @ring	ring
+ * @batch	batch size
+ * @items	items to pass
+ * @return elapsed time
+ **/
+static uint64_t bench_single(struct bench_ring *ring, size_t batch, unsigned long items) {
+    void	*objs[BENCH_BATCH_MAX];
+    uint64_t	start	= host_now_ns();
+    
+    for (size_t i = 0; i < batch; i++) {
+	objs[i] = (void *)(uintptr_t)(i + 1);
+    }
+    
+    for (unsigned long i = 0; i < items; i += batch) {
+	ring->enqueue(ring->ring, objs, batch);
+	ring->dequeue(ring->ring, objs, batch);
+    }
+    
+    sink = (uintptr_t)objs[0];
+    
+    return host_now_ns() - start;
+}
+
+/**
+ * bench_prod
+ * 
+ * enqueues arg->items, a batch at a time
+ * 
+ * @arg		bench_arg
+ * @return NULL
+ **/
+static void *bench_prod(void *arg) {
+    struct bench_arg	*a	= arg;
+    void		*objs[BENCH_BATCH_MAX];
+    size_t		done	= 0;
+    
+    for (size_t i = 0; i < a->batch; i++) {
+	objs[i] = (void *)(uintptr_t)(i + 1);
+    }
+    
+    for (unsigned long i = 0; i < a->items; i += a->batch) {
+	for (size_t j = 0; j < a->batch; j += done) {
+	    if ((done = a->ring->enqueue(a->ring->ring, objs + j, a->batch - j)) == 0) {
+		arch_cpu_relax();
+	    }
+	}
+    }
+    
+    return NULL;
+}
+
+/**
+ * bench_cons
+ * 
+ * dequeues, a batch at a time, until arg->items have been received
+ * (by every consumer)
+ * 
+ * @arg		bench_arg
+ * @return NULL
+ **/
+static void *bench_cons(void *arg) {
+    struct bench_arg	*a	= arg;
+    void		*objs[BENCH_BATCH_MAX];
+    size_t		done	= 0;
+    
+    while (__atomic_load_n(&received, __ATOMIC_RELAXED) < a->items) {
+	if ((done = a->ring->dequeue(a->ring->ring, objs, a->batch)) == 0) {
+	    arch_cpu_relax();
+	} else {
+	    __atomic_fetch_add(&received, done, __ATOMIC_RELAXED);
+	}
+    }
+    
+    sink = (uintptr_t)objs[0];
+    
+    return NULL;
+}
+
+/**
+ * bench_threads
+ * 
+ * passes items from prods producers to cons consumers
+ * 
+ * @ring	ring
+ * @prods	count of producers
+ * @cons	count of consumers
+ * @batch	batch size
+ * @items	items to pass (in total)
+ * @return elapsed time
+ **/
+static uint64_t bench_threads(struct bench_ring *ring, unsigned int prods, unsigned int cons,
+			      size_t batch, unsigned long items) {
+    pthread_t		threads[BENCH_THREADS_MAX * 2];
+    struct bench_arg	prod_arg	= { ring, batch, items / prods };
+    struct bench_arg	cons_arg	= { ring, batch, items };
+    uint64_t		start		= 0;
+    
+    received	= 0;
+    start	= host_now_ns();
+    
+    for (unsigned int i = 0; i < (prods + cons); i++) {
+	if (pthread_create(&threads[i], NULL, (i < prods) ? bench_prod : bench_cons,
+			   (i < prods) ? &prod_arg : &cons_arg) != 0) {
+	    fprintf(stderr, "ring_bench: pthread_create\n");
+	    exit(1);
+	}
+    }
+    
+    for (unsigned int i = 0; i < (prods + cons); i++) {
+	pthread_join(threads[i], NULL);
+    }
+    
+    return host_now_ns() - start;
+}
+
+int main(int argc, char **argv) {
+    unsigned long	items		= (argc > 1) ? strtoul(argv[1], NULL, 0) : 4000000;
+    long		cpus		= sysconf(_SC_NPROCESSORS_ONLN);
+    size_t		batches[]	= { 1, 8, 32, BENCH_BATCH_MAX };
+    struct bench_ring	rings[]		= {
+	{ "spsc", bench_spsc_enqueue, bench_spsc_dequeue, &spsc },
+	{ "mpmc", bench_mpmc_enqueue, bench_mpmc_dequeue, &mpmc }
+    };
+    
+    /* whole batches, evenly divided among producers */
+    items = (items / (BENCH_BATCH_MAX * 2)) * (BENCH_BATCH_MAX * 2);
+    items = items ? items : (BENCH_BATCH_MAX * 2);
+    
+    if (cpus < 4) {
+	printf("ring_bench: %li cpu(s) online, mpmc runs needing more threads are skipped\n", cpus);
+    }
+    
+    for (unsigned int r = 0; r < (sizeof(rings) / sizeof(rings[0])); r++) {
+	for (unsigned int b = 0; b < (sizeof(batches) / sizeof(batches[0])); b++) {
+	    ring_spsc_init(&spsc, slots, BENCH_RING_SZ);
+	    ring_mpmc_init(&mpmc, slots, BENCH_RING_SZ);
+	    bench_report(rings[r].name, "1", batches[b], items, bench_single(&rings[r], batches[b], items));
+	    
+	    if (rings[r].ring == &spsc || cpus >= 2) {
+		bench_report(rings[r].name, "1p/1c", batches[b], items,
+			     bench_threads(&rings[r], 1, 1, batches[b], items));
+	    }
+	    
+	    if (rings[r].ring == &mpmc && cpus >= 4) {
+		bench_report(rings[r].name, "2p/2c", batches[b], items,
+			     bench_threads(&rings[r], 2, 2, batches[b], items));
+	    }
+	}
+    }
+    
+    return 0;
+}
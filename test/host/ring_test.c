@@ -0,0 +1,356 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * ring_test.c checks the lock-free rings (util/ring.h) on the host;
+ * the edge cases single threaded, then producer & consumer threads
+ * racing with random batch sizes, every pointer being checked to
+ * arrive exactly once & in its producer's order.
+ * 
+ * usage: ring_test [seed] [items]
+ */
+#include "host.h"
+#include <util/ring.h>
+#include <sync/atomic.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* size of the rings raced (small, so they're often full or empty) */
+#define TEST_RING_SZ		64
+#define TEST_BATCH_MAX		16
+#define TEST_MPMC_PRODS		3
+#define TEST_MPMC_CONS		3
+
+/* an item is its producer & sequence number, from 1 (never NULL) */
+#define TEST_ITEM_SHIFT		24
+#define TEST_ITEM_MASK		((1ul << TEST_ITEM_SHIFT) - 1)
+#define TEST_ITEM(prod, seq)	((void *)(((uintptr_t)(prod) << TEST_ITEM_SHIFT) | (seq)))
+
+#define CHECK(cond, ...) do {						\
+    __atomic_fetch_add(&checks, 1, __ATOMIC_RELAXED);			\
+    if (!(cond)) {							\
+	fprintf(stderr, "ring_test: %s:%d: ", __FILE__, __LINE__);	\
+	fprintf(stderr, __VA_ARGS__);					\
+	fprintf(stderr, " (seed %u)\n", seed);				\
+	exit(1);							\
+    }									\
+} while (0)
+
+/**
+ * test_thread
+ * 
+ * state of a producer or consumer thread
+ * 
+ * @thread	thread
+ * @id		producer (or consumer) number
+ * @rand	xorshift32 state
+ * @last	last sequence number received of each producer (consumers)
+ **/
+struct test_thread {
+    pthread_t		thread;
+    unsigned int	id;
+    uint32_t		rand;
+    unsigned long	last[TEST_MPMC_PRODS];
+};
+
+static unsigned int		seed;
+static unsigned long		items;
+static unsigned long		checks;
+static unsigned char		*seen;
+static unsigned long		received;
+static struct ring_spsc		spsc;
+static struct ring_mpmc		mpmc;
+static void			*slots[TEST_RING_SZ];
+
+/**
+ * test_batch
+ * 
+ * @t		thread
+ * @return random batch size in [1, TEST_BATCH_MAX]
+ **/
+static size_t test_batch(struct test_thread *t) {
+    return (host_rand(&t->rand) % TEST_BATCH_MAX) + 1;
+}
+
+/**
+ * test_receive
+ * 
+ * checks a dequeued item; it must be new & follow the last one this
+ * consumer received of its producer.
+ * 
+ * @t		consumer
+ * @item	item
+ **/
+static void test_receive(struct test_thread *t, void *item) {
+    uintptr_t		val	= (uintptr_t)item;
+    unsigned int	prod	= val >> TEST_ITEM_SHIFT;
+    unsigned long	seq	= val & TEST_ITEM_MASK;
+    
+    CHECK(prod < TEST_MPMC_PRODS && seq >= 1 && seq <= items, "bad item %#lx", (unsigned long)val);
+    CHECK(seq > t->last[prod], "producer %u: %lu received after %lu", prod, seq, t->last[prod]);
+    CHECK(seen[(prod * items) + seq - 1]++ == 0, "producer %u: %lu received twice", prod, seq);
+    
+    t->last[prod] = seq;
+}
+
+/**
+ * test_edges
+ * 
+ * single threaded checks; sizes, full & empty rings, partial batches
+ * & indices wrapping.
+ **/
+static void test_edges(void) {
+    void	*in[TEST_RING_SZ + 8];
+    void	*out[TEST_RING_SZ + 8];
+    
+    for (unsigned int i = 0; i < (TEST_RING_SZ + 8); i++) {
+	in[i] = TEST_ITEM(0, i + 1);
+    }
+    
+    CHECK(ring_spsc_init(&spsc, slots, 0) == EINVAL, "size 0 accepted");
+    CHECK(ring_spsc_init(&spsc, slots, 48) == EINVAL, "size 48 accepted");
+    CHECK(ring_mpmc_init(&mpmc, slots, 3) == EINVAL, "size 3 accepted");
+    CHECK(ring_spsc_init(&spsc, slots, 1) == ESUCC, "size 1 refused");
+    CHECK(ring_spsc_enqueue(&spsc, in[0]) && !ring_spsc_enqueue(&spsc, in[1]), "size 1 capacity");
+    
+    CHECK(ring_spsc_init(&spsc, slots, TEST_RING_SZ) == ESUCC, "spsc init");
+    CHECK(ring_mpmc_init(&mpmc, slots, TEST_RING_SZ) == ESUCC, "mpmc init");
+    
+    /* start just short of wrapping, so the indices wrap mid batch */
+    spsc.head = spsc.tail = spsc.head_cache = spsc.tail_cache = (addr_t)-5;
+    mpmc.prod.head = mpmc.prod.tail = mpmc.cons.head = mpmc.cons.tail = (addr_t)-5;
+    
+    CHECK(ring_spsc_dequeue_batch(&spsc, out, 4) == 0, "spsc empty dequeue");
+    CHECK(ring_spsc_enqueue_batch(&spsc, in, TEST_RING_SZ + 8) == TEST_RING_SZ, "spsc partial enqueue");
+    CHECK(ring_spsc_count(&spsc) == TEST_RING_SZ, "spsc count %zu", ring_spsc_count(&spsc));
+    CHECK(!ring_spsc_enqueue(&spsc, in[0]), "spsc full enqueue");
+    CHECK(ring_spsc_dequeue_batch(&spsc, out, 10) == 10, "spsc dequeue");
+    CHECK(ring_spsc_enqueue_batch(&spsc, in + TEST_RING_SZ, 8) == 8, "spsc refill");
+    CHECK(ring_spsc_dequeue_batch(&spsc, out + 10, TEST_RING_SZ + 8) == TEST_RING_SZ - 2, "spsc drain");
+    
+    for (unsigned int i = 0; i < (TEST_RING_SZ + 8); i++) {
+	CHECK(out[i] == in[i], "spsc slot %u out of order", i);
+    }
+    
+    memset(out, 0, sizeof(out));
+    
+    CHECK(ring_mpmc_dequeue_batch(&mpmc, out, 4) == 0, "mpmc empty dequeue");
+    CHECK(ring_mpmc_enqueue_batch(&mpmc, in, TEST_RING_SZ + 8) == TEST_RING_SZ, "mpmc partial enqueue");
+    CHECK(ring_mpmc_count(&mpmc) == TEST_RING_SZ, "mpmc count %zu", ring_mpmc_count(&mpmc));
+    CHECK(!ring_mpmc_enqueue(&mpmc, in[0]), "mpmc full enqueue");
+    CHECK(ring_mpmc_dequeue_batch(&mpmc, out, 10) == 10, "mpmc dequeue");
+    CHECK(ring_mpmc_enqueue_batch(&mpmc, in + TEST_RING_SZ, 8) == 8, "mpmc refill");
+    CHECK(ring_mpmc_dequeue_batch(&mpmc, out + 10, TEST_RING_SZ + 8) == TEST_RING_SZ - 2, "mpmc drain");
+    
+    for (unsigned int i = 0; i < (TEST_RING_SZ + 8); i++) {
+	CHECK(out[i] == in[i], "mpmc slot %u out of order", i);
+    }
+}
+
+/**
+ * test_spsc_prod
+ * 
+ * enqueues items in random batches
+ * 
+ * @arg		test_thread
+ * @return NULL
+ **/
+static void *test_spsc_prod(void *arg) {
+    struct test_thread	*t	= arg;
+    void		*batch[TEST_BATCH_MAX];
+    unsigned long	seq	= 1;
+    size_t		cnt	= 0;
+    size_t		done	= 0;
+    
+    while (seq <= items) {
+	cnt = test_batch(t);
+	cnt = ((items - seq + 1) < cnt) ? (items - seq + 1) : cnt;
+	
+	for (size_t i = 0; i < cnt; i++) {
+	    batch[i] = TEST_ITEM(0, seq + i);
+	}
+	
+	for (size_t i = 0; i < cnt; i += done) {
+	    if ((done = ring_spsc_enqueue_batch(&spsc, batch + i, cnt - i)) == 0) {
+		arch_cpu_relax();
+	    }
+	}
+	
+	seq += cnt;
+    }
+    
+    return NULL;
+}
+
+/**
+ * test_spsc_cons
+ * 
+ * dequeues items in random batches until all have been received
+ * 
+ * @arg		test_thread
+ * @return NULL
+ **/
+static void *test_spsc_cons(void *arg) {
+    struct test_thread	*t	= arg;
+    void		*batch[TEST_BATCH_MAX];
+    unsigned long	cnt	= 0;
+    size_t		done	= 0;
+    
+    while (cnt < items) {
+	if ((done = ring_spsc_dequeue_batch(&spsc, batch, test_batch(t))) == 0) {
+	    arch_cpu_relax();
+	}
+	
+	for (size_t i = 0; i < done; i++) {
+	    CHECK(batch[i] == TEST_ITEM(0, cnt + i + 1), "spsc item %lu out of order", cnt + i + 1);
+	    seen[cnt + i]++;
+	}
+	
+	cnt += done;
+    }
+    
+    return NULL;
+}
+
+/**
+ * test_mpmc_prod
+ * 
+ * enqueues this producer's items in random batches
+ * 
+ * @arg		test_thread
+ * @return NULL
+ **/
+static void *test_mpmc_prod(void *arg) {
+    struct test_thread	*t	= arg;
+    void		*batch[TEST_BATCH_MAX];
+    unsigned long	seq	= 1;
+    size_t		cnt	= 0;
+    size_t		done	= 0;
+    
+    while (seq <= items) {
+	cnt = test_batch(t);
+	cnt = ((items - seq + 1) < cnt) ? (items - seq + 1) : cnt;
+	
+	for (size_t i = 0; i < cnt; i++) {
+	    batch[i] = TEST_ITEM(t->id, seq + i);
+	}
+	
+	for (size_t i = 0; i < cnt; i += done) {
+	    if ((done = ring_mpmc_enqueue_batch(&mpmc, batch + i, cnt - i)) == 0) {
+		arch_cpu_relax();
+	    }
+	}
+	
+	seq += cnt;
+    }
+    
+    return NULL;
+}
+
+/**
+ * test_mpmc_cons
+ * 
+ * dequeues items in random batches until every producer's have
+ * been received (by any consumer)
+ * 
+ * @arg		test_thread
+ * @return NULL
+ **/
+static void *test_mpmc_cons(void *arg) {
+    struct test_thread	*t	= arg;
+    void		*batch[TEST_BATCH_MAX];
+    size_t		done	= 0;
+    
+    while (__atomic_load_n(&received, __ATOMIC_RELAXED) < (items * TEST_MPMC_PRODS)) {
+	if ((done = ring_mpmc_dequeue_batch(&mpmc, batch, test_batch(t))) == 0) {
+	    arch_cpu_relax();
+	}
+	
+	for (size_t i = 0; i < done; i++) {
+	    test_receive(t, batch[i]);
+	}
+	
+	__atomic_fetch_add(&received, done, __ATOMIC_RELAXED);
+    }
+    
+    return NULL;
+}
+
+/**
+ * test_run
+ * 
+ * runs producer & consumer threads to completion
+ * 
+ * @prods	count of producers
+ * @prod	producer routine
+ * @cons	count of consumers
+ * @con		consumer routine
+ **/
+static void test_run(unsigned int prods, void *(*prod)(void *), unsigned int cons, void *(*con)(void *)) {
+    struct test_thread threads[TEST_MPMC_PRODS + TEST_MPMC_CONS];
+    
+    memset(threads, 0, sizeof(threads));
+    memset(seen, 0, items * TEST_MPMC_PRODS);
+    received = 0;
+    
+    for (unsigned int i = 0; i < (prods + cons); i++) {
+	threads[i].id	= (i < prods) ? i : (i - prods);
+	threads[i].rand	= (seed * 2654435761u) ^ (i + 1);
+	threads[i].rand	= threads[i].rand ? threads[i].rand : 1;
+	
+	CHECK(pthread_create(&threads[i].thread, NULL, (i < prods) ? prod : con, &threads[i]) == 0,
+	      "pthread_create");
+    }
+    
+    for (unsigned int i = 0; i < (prods + cons); i++) {
+	pthread_join(threads[i].thread, NULL);
+    }
+    
+    for (unsigned long i = 0; i < (items * prods); i++) {
+	CHECK(seen[i] == 1, "producer %lu: %lu received %u times", i / items, (i % items) + 1, seen[i]);
+    }
+}
+
+int main(int argc, char **argv) {
+    seed	= (argc > 1) ? strtoul(argv[1], NULL, 0) : 1;
+    items	= (argc > 2) ? strtoul(argv[2], NULL, 0) : 200000;
+    
+    if (items == 0 || items > TEST_ITEM_MASK || (seen = malloc(items * TEST_MPMC_PRODS)) == NULL) {
+	fprintf(stderr, "ring_test: bad item count %lu\n", items);
+	return 1;
+    }
+    
+    test_edges();
+    
+    CHECK(ring_spsc_init(&spsc, slots, TEST_RING_SZ) == ESUCC, "spsc init");
+    test_run(1, test_spsc_prod, 1, test_spsc_cons);
+    CHECK(ring_spsc_count(&spsc) == 0, "spsc not drained");
+    
+    CHECK(ring_mpmc_init(&mpmc, slots, TEST_RING_SZ) == ESUCC, "mpmc init");
+    test_run(TEST_MPMC_PRODS, test_mpmc_prod, TEST_MPMC_CONS, test_mpmc_cons);
+    CHECK(ring_mpmc_count(&mpmc) == 0, "mpmc not drained");
+    
+    free(seen);
+    printf("ring_test: seed %u, %lu items, %lu checks ok\n", seed, items, checks);
+    
+    return 0;
+}
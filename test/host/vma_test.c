@@ -0,0 +1,536 @@
+/* Copyright (C) 2017 Jacob Paulsen <jspaulse@ius.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * vma_test.c checks the vma index (mm/vma.h) & the augmented red-black
+ * tree beneath it (util/rbtree.h) on the host; random reserves, releases,
+ * splits, merges & gap searches are applied both to an address space
+ * and to a flat, sorted array of vmas, which must agree after each.
+ * the tree's shape, colours & subtree values are checked throughout.
+ * 
+ * usage: vma_test [seed] [ops]
+ */
+#include "host.h"
+#include <mm/vma.h>
+#include <util/rbtree.h>
+#include <memlayout.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* pages of the window operated upon; small, so vmas often meet */
+#define TEST_WIN_PGS		1024
+#define TEST_WIN_BASE		((addr_t)0x10000000)
+#define TEST_WIN_END		(TEST_WIN_BASE + (TEST_WIN_PGS * PG_SZ))
+#define TEST_MAX_VMAS		TEST_WIN_PGS
+#define TEST_RESERVE_PGS	16
+#define TEST_RELEASE_PGS	32
+#define TEST_GAP_PGS		64
+
+#define CHECK(cond, ...) do {						\
+    checks++;								\
+    if (!(cond)) {							\
+	fprintf(stderr, "vma_test: %s:%d: ", __FILE__, __LINE__);	\
+	fprintf(stderr, __VA_ARGS__);					\
+	fprintf(stderr, " (seed %u, op %lu)\n", seed, op);		\
+	exit(1);							\
+    }									\
+} while (0)
+
+/**
+ * test_vma
+ * 
+ * a vma of the oracle
+ * 
+ * @start	base virtual address
+ * @end		virtual address past the last byte
+ * @flags	VMA_* flags
+ * @phy_base	physical address backing start (VMA_PHYS)
+ **/
+struct test_vma {
+    addr_t		start;
+    addr_t		end;
+    unsigned int	flags;
+    addr_t		phy_base;
+};
+
+static unsigned int		seed;
+static unsigned long		ops;
+static unsigned long		op;
+static unsigned long		checks;
+static uint32_t			rand_state;
+static struct vm_space		space;
+static struct test_vma		model[TEST_MAX_VMAS];
+static unsigned int		model_cnt;
+static bool			pmm_fail;
+
+/**
+ * pmm_alloc_page
+ * 
+ * stands in for the pmm; vma structures are carved from the arena,
+ * unless pmm_fail is set.
+ * 
+ * @return physical (host) address of a zeroed page or 0x0
+ **/
+addr_t pmm_alloc_page(void) {
+    return (pmm_fail) ? 0x0 : host_phy_alloc(PG_SZ, PG_SZ);
+}
+
+/**
+ * test_page
+ * 
+ * @return random page aligned address within the window (or its end)
+ **/
+static addr_t test_page(void) {
+    return TEST_WIN_BASE + ((host_rand(&rand_state) % (TEST_WIN_PGS + 1)) * PG_SZ);
+}
+
+/**
+ * model_lower_bound
+ * 
+ * @addr	virtual address
+ * @return index of the lowest vma ending past addr (model_cnt if none)
+ **/
+static unsigned int model_lower_bound(addr_t addr) {
+    unsigned int i = 0;
+    
+    while (i < model_cnt && model[i].end <= addr) {
+	i++;
+    }
+    
+    return i;
+}
+
+/**
+ * model_remove
+ * 
+ * @idx		index of vma to remove
+ **/
+static void model_remove(unsigned int idx) {
+    memmove(&model[idx], &model[idx + 1], (model_cnt - idx - 1) * sizeof(struct test_vma));
+    model_cnt--;
+}
+
+/**
+ * model_split
+ * 
+ * @idx		index of vma to split
+ * @addr	address within it (exclusive of start)
+ **/
+static void model_split(unsigned int idx, addr_t addr) {
+    memmove(&model[idx + 1], &model[idx], (model_cnt - idx) * sizeof(struct test_vma));
+    model_cnt++;
+    
+    model[idx].end		= addr;
+    model[idx + 1].start	= addr;
+    model[idx + 1].phy_base	= 0x0;
+    
+    if (model[idx].flags & VMA_PHYS) {
+	model[idx + 1].phy_base = model[idx].phy_base + (addr - model[idx].start);
+    }
+}
+
+/**
+ * model_can_merge
+ * 
+ * @prev	vma
+ * @next	vma following prev
+ * @return true if they may be combined (see vma_merge)
+ **/
+static bool model_can_merge(struct test_vma *prev, struct test_vma *next) {
+    return (prev->end == next->start && prev->flags == next->flags &&
+	    (!(prev->flags & VMA_PHYS) || (prev->phy_base + (prev->end - prev->start)) == next->phy_base));
+}
+
+/**
+ * model_merge
+ * 
+ * @idx		index of vma to merge with its neighbours
+ * @return index of the merged vma
+ **/
+static unsigned int model_merge(unsigned int idx) {
+    if ((idx + 1) < model_cnt && model_can_merge(&model[idx], &model[idx + 1])) {
+	model[idx].end = model[idx + 1].end;
+	model_remove(idx + 1);
+    }
+    
+    if (idx > 0 && model_can_merge(&model[idx - 1], &model[idx])) {
+	model[idx - 1].end = model[idx].end;
+	model_remove(idx);
+	idx--;
+    }
+    
+    return idx;
+}
+
+/**
+ * model_insert
+ * 
+ * @start	base virtual address
+ * @size	size (in bytes)
+ * @flags	VMA_* flags, as stored
+ * @phy_base	physical address backing start
+ * @return errno, as vma_reserve (EINVAL on overlap)
+ **/
+static int model_insert(addr_t start, size_t size, unsigned int flags, addr_t phy_base) {
+    unsigned int	idx	= model_lower_bound(start);
+    int			ret	= ESUCC;
+    
+    if (idx < model_cnt && model[idx].start < (start + size)) {
+	ret = EINVAL;
+    } else {
+	memmove(&model[idx + 1], &model[idx], (model_cnt - idx) * sizeof(struct test_vma));
+	model_cnt++;
+	
+	model[idx] = (struct test_vma){ start, start + size, flags, phy_base };
+	model_merge(idx);
+    }
+    
+    return ret;
+}
+
+/**
+ * model_release
+ * 
+ * @start	base virtual address
+ * @size	size (in bytes)
+ **/
+static void model_release(addr_t start, size_t size) {
+    addr_t		end	= start + size;
+    unsigned int	idx	= model_lower_bound(start);
+    
+    if (idx < model_cnt && model[idx].start < start) {
+	model_split(idx++, start);
+    }
+    
+    while (idx < model_cnt && model[idx].start < end) {
+	if (model[idx].end > end) {
+	    model_split(idx, end);
+	}
+	
+	model_remove(idx);
+    }
+}
+
+/**
+ * model_find_gap
+ * 
+ * @size	size (in bytes)
+ * @lo		lowest acceptable address
+ * @hi		address the range must end at or below
+ * @start	set to the start of the lowest fitting range
+ * @return true if found
+ **/
+static bool model_find_gap(size_t size, addr_t lo, addr_t hi, addr_t *start) {
+    addr_t	lower	= lo;
+    addr_t	upper	= 0x0;
+    bool	ret	= false;
+    
+    for (unsigned int i = 0; i <= model_cnt && !ret; i++) {
+	upper = (i < model_cnt && model[i].start < hi) ? model[i].start : hi;
+	
+	if (upper > lower && (upper - lower) >= size) {
+	    *start	= lower;
+	    ret		= true;
+	} else if (i < model_cnt && model[i].end > lower) {
+	    lower = model[i].end;
+	}
+    }
+    
+    return ret;
+}
+
+/**
+ * test_check_node
+ * 
+ * checks a subtree; order, parent links, colours & subtree values.
+ * 
+ * @node	subtree
+ * @parent	expected parent
+ * @return black height of the subtree
+ **/
+static unsigned int test_check_node(struct rb_node *node, struct rb_node *parent) {
+    struct vma		*vma	= NULL;
+    struct vma		*child	= NULL;
+    addr_t		sub_start;
+    addr_t		sub_end;
+    size_t		sub_gap	= 0;
+    unsigned int	left	= 0;
+    unsigned int	right	= 0;
+    unsigned int	ret	= 1;
+    
+    if (node != NULL) {
+	vma = rb_entry(node, struct vma, rb);
+	
+	CHECK(node->parent == parent, "vma %#lx: bad parent", (unsigned long)vma->start);
+	CHECK(node->color == RB_RED || node->color == RB_BLACK, "vma %#lx: bad colour", (unsigned long)vma->start);
+	CHECK(node->color == RB_BLACK || parent == NULL || parent->color == RB_BLACK,
+	      "vma %#lx: red child of red", (unsigned long)vma->start);
+	CHECK(vma->start < vma->end, "vma %#lx: empty", (unsigned long)vma->start);
+	
+	left	= test_check_node(node->left, node);
+	right	= test_check_node(node->right, node);
+	
+	CHECK(left == right, "vma %#lx: black heights %u & %u", (unsigned long)vma->start, left, right);
+	
+	sub_start	= vma->start;
+	sub_end		= vma->end;
+	
+	if (node->left != NULL) {
+	    child	= rb_entry(node->left, struct vma, rb);
+	    sub_start	= child->sub_start;
+	    sub_gap	= child->sub_gap;
+	    
+	    CHECK(child->sub_end <= vma->start, "vma %#lx: left subtree overlaps", (unsigned long)vma->start);
+	    sub_gap	= ((vma->start - child->sub_end) > sub_gap) ? (vma->start - child->sub_end) : sub_gap;
+	}
+	
+	if (node->right != NULL) {
+	    child	= rb_entry(node->right, struct vma, rb);
+	    sub_end	= child->sub_end;
+	    
+	    CHECK(child->sub_start >= vma->end, "vma %#lx: right subtree overlaps", (unsigned long)vma->start);
+	    sub_gap	= (child->sub_gap > sub_gap) ? child->sub_gap : sub_gap;
+	    sub_gap	= ((child->sub_start - vma->end) > sub_gap) ? (child->sub_start - vma->end) : sub_gap;
+	}
+	
+	CHECK(vma->sub_start == sub_start && vma->sub_end == sub_end && vma->sub_gap == sub_gap,
+	      "vma %#lx: stale subtree values", (unsigned long)vma->start);
+	
+	ret = left + (node->color == RB_BLACK);
+    }
+    
+    return ret;
+}
+
+/**
+ * test_check
+ * 
+ * checks the tree & that its vmas, in order, are those of the model
+ **/
+static void test_check(void) {
+    struct vma		*vma	= NULL;
+    unsigned int	i	= 0;
+    
+    CHECK(space.vmas.node == NULL || space.vmas.node->color == RB_BLACK, "red root");
+    test_check_node(space.vmas.node, NULL);
+    
+    for (vma = vma_first(&space); vma != NULL; vma = vma_next(vma), i++) {
+	CHECK(i < model_cnt, "more vmas than the model's %u", model_cnt);
+	CHECK(vma->start == model[i].start && vma->end == model[i].end &&
+	      vma->flags == model[i].flags && vma->phy_base == model[i].phy_base,
+	      "vma %u: [%#lx, %#lx) flags %#x phy %#lx, model [%#lx, %#lx) flags %#x phy %#lx", i,
+	      (unsigned long)vma->start, (unsigned long)vma->end, vma->flags, (unsigned long)vma->phy_base,
+	      (unsigned long)model[i].start, (unsigned long)model[i].end, model[i].flags,
+	      (unsigned long)model[i].phy_base);
+    }
+    
+    CHECK(i == model_cnt, "%u vmas, model %u", i, model_cnt);
+}
+
+/**
+ * test_edges
+ * 
+ * argument checks & an empty space
+ **/
+static void test_edges(void) {
+    addr_t start = 0x0;
+    
+    CHECK(vma_reserve(&space, TEST_WIN_BASE + 1, PG_SZ, VMA_READ) == EALIGN, "unaligned start");
+    CHECK(vma_reserve(&space, TEST_WIN_BASE, PG_SZ + 1, VMA_READ) == EALIGN, "unaligned size");
+    CHECK(vma_reserve(&space, TEST_WIN_BASE, 0, VMA_READ) == EINVAL, "empty reserve");
+    CHECK(vma_reserve_phys(&space, TEST_WIN_BASE, PG_SZ, VMA_READ, 0x123) == EALIGN, "unaligned phy");
+    CHECK(vma_release(&space, TEST_WIN_BASE, 0) == EINVAL, "empty release");
+    CHECK(vma_find_gap(&space, 0, TEST_WIN_BASE, TEST_WIN_END, &start) == EINVAL, "empty gap");
+    CHECK(vma_find_gap(&space, PG_SZ, TEST_WIN_END, TEST_WIN_BASE, &start) == EINVAL, "inverted bounds");
+    CHECK(vma_find_gap(&space, PG_SZ + 1, TEST_WIN_BASE, TEST_WIN_END, &start) == EALIGN, "unaligned gap");
+    CHECK(vma_find_gap(&space, PG_SZ, TEST_WIN_BASE, TEST_WIN_END, &start) == ESUCC &&
+	  start == TEST_WIN_BASE, "empty space gap");
+    CHECK(vma_find(&space, TEST_WIN_BASE) == NULL, "empty space find");
+    CHECK(vma_first(&space) == NULL, "empty space first");
+}
+
+/**
+ * test_nomem
+ * 
+ * exhausts the unused vmas & checks that operations needing another
+ * fail without altering the space; releases needing splits included.
+ **/
+static void test_nomem(void) {
+    addr_t	scratch	= TEST_WIN_END + PG_SZ;
+    int		ret	= ESUCC;
+    
+    CHECK(vma_reserve(&space, TEST_WIN_BASE, 8 * PG_SZ, VMA_READ) == ESUCC, "reserve");
+    CHECK(vma_reserve(&space, TEST_WIN_BASE + (10 * PG_SZ), 2 * PG_SZ, VMA_READ) == ESUCC, "reserve");
+    model_insert(TEST_WIN_BASE, 8 * PG_SZ, VMA_READ, 0x0);
+    model_insert(TEST_WIN_BASE + (10 * PG_SZ), 2 * PG_SZ, VMA_READ, 0x0);
+    
+    pmm_fail = true;
+    
+    /* isolated pages past the window, until no vma remains */
+    for (unsigned int i = 0; i < PG_SZ && ret == ESUCC; i++, scratch += (2 * PG_SZ)) {
+	if ((ret = vma_reserve(&space, scratch, PG_SZ, VMA_READ)) == ESUCC) {
+	    model_insert(scratch, PG_SZ, VMA_READ, 0x0);
+	}
+    }
+    
+    CHECK(ret == ENOMEM, "vmas never exhausted (%i)", ret);
+    CHECK(vma_release(&space, TEST_WIN_BASE + PG_SZ, PG_SZ) == ENOMEM, "release within a vma");
+    CHECK(vma_release(&space, TEST_WIN_BASE, PG_SZ) == ENOMEM, "release of a vma's start");
+    CHECK(vma_release(&space, TEST_WIN_BASE, 11 * PG_SZ) == ENOMEM, "release of a vma & another's start");
+    CHECK(vma_split(&space, vma_first(&space), TEST_WIN_BASE + PG_SZ) == ENOMEM, "split");
+    test_check();
+    
+    /* whole vmas need no split */
+    CHECK(vma_release(&space, TEST_WIN_END, scratch - TEST_WIN_END) == ESUCC, "release of whole vmas");
+    model_release(TEST_WIN_END, scratch - TEST_WIN_END);
+    test_check();
+    
+    pmm_fail = false;
+    
+    CHECK(vma_release(&space, TEST_WIN_BASE + PG_SZ, PG_SZ) == ESUCC, "release within a vma");
+    model_release(TEST_WIN_BASE + PG_SZ, PG_SZ);
+    test_check();
+}
+
+/**
+ * test_op
+ * 
+ * applies a random operation to the space & the model
+ **/
+static void test_op(void) {
+    unsigned int	kind	= host_rand(&rand_state) % 100;
+    addr_t		start	= test_page();
+    size_t		size	= 0;
+    unsigned int	flags	= (host_rand(&rand_state) & 1) ? (VMA_READ | VMA_WRITE) : VMA_READ;
+    addr_t		phy	= 0x0;
+    addr_t		lo	= 0x0;
+    addr_t		hi	= 0x0;
+    addr_t		found	= 0x0;
+    addr_t		expect	= 0x0;
+    struct vma		*vma	= NULL;
+    unsigned int	idx	= 0;
+    int			ret	= ESUCC;
+    
+    if (kind < 30) {
+	size	= ((host_rand(&rand_state) % TEST_RESERVE_PGS) + 1) * PG_SZ;
+	ret	= vma_reserve(&space, start, size, flags | VMA_ANON);
+	
+	CHECK(ret == model_insert(start, size, flags | VMA_ANON, 0x0), "reserve [%#lx, +%#zx) returned %i",
+	      (unsigned long)start, size, ret);
+    } else if (kind < 40) {
+	/* often physically contiguous with a neighbour, so they merge */
+	size	= ((host_rand(&rand_state) % TEST_RESERVE_PGS) + 1) * PG_SZ;
+	phy	= (host_rand(&rand_state) & 3) ? (start - TEST_WIN_BASE) : (test_page() - TEST_WIN_BASE);
+	ret	= vma_reserve_phys(&space, start, size, flags, phy);
+	
+	CHECK(ret == model_insert(start, size, flags | VMA_PHYS, phy), "reserve_phys [%#lx, +%#zx) returned %i",
+	      (unsigned long)start, size, ret);
+    } else if (kind < 65) {
+	size = ((host_rand(&rand_state) % TEST_RELEASE_PGS) + 1) * PG_SZ;
+	
+	CHECK(vma_release(&space, start, size) == ESUCC, "release [%#lx, +%#zx)", (unsigned long)start, size);
+	model_release(start, size);
+    } else if (kind < 75 && model_cnt > 0) {
+	idx = host_rand(&rand_state) % model_cnt;
+	
+	if ((model[idx].end - model[idx].start) > PG_SZ) {
+	    start = model[idx].start + (((host_rand(&rand_state) % (((model[idx].end - model[idx].start) / PG_SZ) - 1)) + 1) * PG_SZ);
+	    
+	    CHECK((vma = vma_find(&space, start)) != NULL, "split: %#lx not found", (unsigned long)start);
+	    CHECK(vma_split(&space, vma, start) == ESUCC, "split at %#lx", (unsigned long)start);
+	    CHECK(vma_split(&space, vma, vma->start) == EINVAL, "split at start accepted");
+	    model_split(idx, start);
+	}
+    } else if (kind < 80 && model_cnt > 0) {
+	idx = host_rand(&rand_state) % model_cnt;
+	
+	CHECK((vma = vma_find(&space, model[idx].start)) != NULL, "merge: %#lx not found",
+	      (unsigned long)model[idx].start);
+	
+	vma = vma_merge(&space, vma);
+	idx = model_merge(idx);
+	
+	CHECK(vma->start == model[idx].start, "merged into %#lx, model %#lx",
+	      (unsigned long)vma->start, (unsigned long)model[idx].start);
+    } else if (kind < 98) {
+	size	= ((host_rand(&rand_state) % TEST_GAP_PGS) + 1) * PG_SZ;
+	lo	= test_page();
+	hi	= test_page();
+	
+	if (lo > hi) {
+	    found = lo, lo = hi, hi = found;
+	}
+	
+	if (lo == hi) {
+	    CHECK(vma_find_gap(&space, size, lo, hi, &found) == EINVAL, "gap in empty bounds");
+	} else if (model_find_gap(size, lo, hi, &expect)) {
+	    CHECK(vma_find_gap(&space, size, lo, hi, &found) == ESUCC && found == expect,
+		  "gap %#zx in [%#lx, %#lx): %#lx, model %#lx", size, (unsigned long)lo, (unsigned long)hi,
+		  (unsigned long)found, (unsigned long)expect);
+	} else {
+	    CHECK(vma_find_gap(&space, size, lo, hi, &found) == ENOMEM, "gap %#zx in [%#lx, %#lx) found at %#lx",
+		  size, (unsigned long)lo, (unsigned long)hi, (unsigned long)found);
+	}
+    } else if (kind == 99 && (host_rand(&rand_state) % 16) == 0) {
+	vma_clear(&space);
+	model_cnt = 0;
+    }
+    
+    /* a lookup or two after every operation */
+    for (unsigned int i = 0; i < 2; i++) {
+	start	= test_page() + (host_rand(&rand_state) % PG_SZ);
+	idx	= model_lower_bound(start);
+	vma	= vma_find(&space, start);
+	
+	if (idx < model_cnt && model[idx].start <= start) {
+	    CHECK(vma != NULL && vma->start == model[idx].start, "find %#lx", (unsigned long)start);
+	} else {
+	    CHECK(vma == NULL, "find %#lx returned [%#lx, %#lx)", (unsigned long)start,
+		  (unsigned long)vma->start, (unsigned long)vma->end);
+	}
+    }
+    
+    test_check();
+}
+
+int main(int argc, char **argv) {
+    seed	= (argc > 1) ? strtoul(argv[1], NULL, 0) : 1;
+    ops		= (argc > 2) ? strtoul(argv[2], NULL, 0) : 200000;
+    
+    rand_state = (seed * 2654435761u) | 1;
+    
+    host_phy_init();
+    vma_space_init(&space);
+    
+    test_edges();
+    test_nomem();
+    
+    for (op = 0; op < ops; op++) {
+	test_op();
+    }
+    
+    vma_clear(&space);
+    CHECK(vma_first(&space) == NULL, "space not cleared");
+    
+    printf("vma_test: seed %u, %lu ops, %lu checks ok\n", seed, ops, checks);
+    
+    return 0;
+}
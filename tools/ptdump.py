@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+#
+# ptdump.py
+#
+# decodes the translation table export printed at boot by CONFIG_MMU_DUMP
+# ("ptdump: " lines of a console log) and diffs the exports of two runs.
+#
+#   ptdump.py show <log>
+#   ptdump.py diff <old log> <new log>
+#
+import argparse
+import struct
+import sys
+
+PREFIX = 'ptdump: '
+VERSION = 1
+REC_FMT = '<IIIBBBBBBxx'
+CNT_FMT = '<IIIII'
+
+DESC_NAMES = ['supersection', 'section', 'large', 'small']
+AP_NAMES = ['none', 'krw', 'krw/uro', 'krw/urw', 'resv', 'kro', 'kro/uro', 'kro/uro']
+MEM_NAMES = ['strongly-ordered', 'device', 'normal-nc', 'normal-wt', 'normal-wb',
+             'normal-wbwa', 'normal-other']
+FLAG_NAMES = [(0x2, 's'), (0x1, 'xn'), (0x4, 'ng')]
+
+
+class Range:
+    def __init__(self, rec):
+        (self.va, self.pa, self.size, self.ttbr, self.type, self.ap,
+         self.domain, self.mem, self.flags) = struct.unpack(REC_FMT, rec)
+
+    def attrs(self):
+        return (self.pa, self.size, self.type, self.ap, self.domain, self.mem, self.flags)
+
+    def __str__(self):
+        flags = ''.join(' ' + name for bit, name in FLAG_NAMES if self.flags & bit)
+        return 'ttbr%d 0x%08x-0x%08x -> 0x%08x %8dK %-12s %-8s d%-2d %s%s' % (
+            self.ttbr, self.va, self.va + self.size - 1, self.pa, self.size >> 10,
+            DESC_NAMES[self.type], AP_NAMES[self.ap], self.domain, MEM_NAMES[self.mem], flags)
+
+
+class Dump:
+    def __init__(self, ranges, counts):
+        self.ranges = ranges
+        self.counts = counts
+
+    def key_map(self):
+        return {(r.ttbr, r.va): r for r in self.ranges}
+
+
+def parse(path):
+    """ returns the last complete export of a console log """
+    ret = None
+    ranges = None
+    counts = None
+    total = 0
+
+    with open(path, 'r', errors='replace') as log:
+        for line in log:
+            idx = line.find(PREFIX)
+
+            if idx < 0:
+                continue
+
+            fields = line[idx + len(PREFIX):].split()
+
+            if len(fields) != 2:
+                continue
+            elif fields[0] == 'begin':
+                if int(fields[1]) != VERSION:
+                    sys.exit('%s: unsupported export version %s' % (path, fields[1]))
+
+                ranges, counts, total = [], None, 0
+            elif ranges is None:
+                continue
+            elif fields[0] == 'r' or fields[0] == 'c':
+                data = bytes.fromhex(fields[1])
+                total += sum(data)
+
+                if fields[0] == 'r':
+                    ranges.append(Range(data))
+                else:
+                    counts = struct.unpack(CNT_FMT, data)
+            elif fields[0] == 'end':
+                if struct.unpack('<I', bytes.fromhex(fields[1]))[0] != (total & 0xFFFFFFFF):
+                    sys.exit('%s: export checksum mismatch' % path)
+
+                ret = Dump(ranges, counts)
+                ranges = None
+
+    if ret is None:
+        sys.exit('%s: no complete export found' % path)
+
+    return ret
+
+
+def count_str(counts):
+    return ', '.join('%s %d' % (name, cnt) for name, cnt in zip(DESC_NAMES + ['page tables'], counts))
+
+
+def show(args):
+    dump = parse(args.log)
+
+    for r in dump.ranges:
+        print(r)
+
+    print('%d ranges; %s' % (len(dump.ranges), count_str(dump.counts)))
+
+
+def diff(args):
+    old = parse(args.old)
+    new = parse(args.new)
+    om = old.key_map()
+    nm = new.key_map()
+
+    for key in sorted(set(om) | set(nm)):
+        if key not in nm:
+            print('- %s' % om[key])
+        elif key not in om:
+            print('+ %s' % nm[key])
+        elif om[key].attrs() != nm[key].attrs():
+            print('- %s' % om[key])
+            print('+ %s' % nm[key])
+
+    print('ranges: %d -> %d' % (len(old.ranges), len(new.ranges)))
+
+    for name, o, n in zip(DESC_NAMES + ['page tables'], old.counts, new.counts):
+        print('%s: %d -> %d (%+d)' % (name, o, n, n - o))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='decode & diff CONFIG_MMU_DUMP exports')
+    sub = parser.add_subparsers(dest='cmd', required=True)
+
+    cmd = sub.add_parser('show', help='print the ranges of a log')
+    cmd.add_argument('log')
+    cmd.set_defaults(func=show)
+
+    cmd = sub.add_parser('diff', help='print the ranges that differ between two logs')
+    cmd.add_argument('old')
+    cmd.add_argument('new')
+    cmd.set_defaults(func=diff)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == '__main__':
+    main()